@@ -13,6 +13,7 @@
 #include <fcntl.h>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <math.h>
 #include <signal.h>
 #include <stdio.h>
@@ -32,6 +33,7 @@
 #include <glm/gtx/vector_angle.hpp>
 
 #include <QtCore/QCoreApplication>
+#include <QtCore/QDataStream>
 #include <QtCore/QJsonArray>
 #include <QtCore/QJsonDocument>
 #include <QtCore/QJsonObject>
@@ -51,6 +53,7 @@
 #include <StdDev.h>
 #include <UUID.h>
 
+#include "AudioLimiter.h"
 #include "AudioRingBuffer.h"
 #include "AudioMixerClientData.h"
 #include "AudioMixerDatagramProcessor.h"
@@ -78,6 +81,10 @@ bool AudioMixer::_printStreamStats = false;
 
 bool AudioMixer::_enableFilter = true;
 
+bool AudioMixer::_enableCodecs = true;
+
+bool AudioMixer::_enableSoftLimiter = false;
+
 AudioMixer::AudioMixer(const QByteArray& packet) :
     ThreadedAssignment(packet),
     _trailingSleepRatio(1.0f),
@@ -87,6 +94,8 @@ AudioMixer::AudioMixer(const QByteArray& packet) :
     _numStatFrames(0),
     _sumListeners(0),
     _sumMixes(0),
+    _sumMixedListeners(0),
+    _sumSkippedListeners(0),
     _lastPerSecondCallbackTime(usecTimestampNow()),
     _sendAudioStreamStats(false),
     _datagramsReadPerCallStats(0, READ_DATAGRAMS_STATS_WINDOW_SECONDS),
@@ -101,6 +110,18 @@ AudioMixer::AudioMixer(const QByteArray& packet) :
 const float ATTENUATION_BEGINS_AT_DISTANCE = 1.0f;
 const float RADIUS_OF_HEAD = 0.076f;
 
+// past this many clusters, sources join the closest cluster however far away it is
+const int MAX_SUBMIXES_PER_PEER_MIXER = 16;
+
+float distanceAttenuationCoefficient(float distance, float attenuationPerDoublingInDistance) {
+    if (distance < ATTENUATION_BEGINS_AT_DISTANCE) {
+        return 1.0f;
+    }
+    float distanceCoefficient = 1 - (logf(distance / ATTENUATION_BEGINS_AT_DISTANCE) / logf(2.0f)
+                                     * attenuationPerDoublingInDistance);
+    return glm::max(distanceCoefficient, 0.0f);
+}
+
 int AudioMixer::addStreamToMixForListeningNodeWithStream(AudioMixerClientData* listenerNodeData,
                                                          const QUuid& streamUUID,
                                                          PositionalAudioStream* streamToAdd,
@@ -206,12 +227,7 @@ int AudioMixer::addStreamToMixForListeningNodeWithStream(AudioMixerClientData* l
     
     if (distanceBetween >= ATTENUATION_BEGINS_AT_DISTANCE) {
         // calculate the distance coefficient using the distance to this node
-        float distanceCoefficient = 1 - (logf(distanceBetween / ATTENUATION_BEGINS_AT_DISTANCE) / logf(2.0f)
-                                         * attenuationPerDoublingInDistance);
-        
-        if (distanceCoefficient < 0) {
-            distanceCoefficient = 0;
-        }
+        float distanceCoefficient = distanceAttenuationCoefficient(distanceBetween, attenuationPerDoublingInDistance);
         
         // multiply the current attenuation coefficient by the distance coefficient
         attenuationCoefficient *= distanceCoefficient;
@@ -254,6 +270,9 @@ int AudioMixer::addStreamToMixForListeningNodeWithStream(AudioMixerClientData* l
     
     AudioRingBuffer::ConstIterator streamPopOutput = streamToAdd->getLastPopOutput();
     
+    // the pre-mix holds this stream alone, its filter state is kept per listener and source
+    memset(_preMixSamples, 0, sizeof(_preMixSamples));
+    
     if (!streamToAdd->isStereo()) {
         // this is a mono stream, which means it gets full attenuation and spatialization
         
@@ -315,7 +334,7 @@ int AudioMixer::addStreamToMixForListeningNodeWithStream(AudioMixerClientData* l
             AudioRingBuffer::ConstIterator delayStreamSourceSamples = streamPopOutput - numSamplesDelay;
 
             for (int i = 0; i < numSamplesDelay; i++) {
-                int16_t originalHistoricalSample = *delayStreamSourceSamples;
+                float originalHistoricalSample = *delayStreamSourceSamples;
 
                 _preMixSamples[delayedChannelHistoricalAudioOutputIndex] += originalHistoricalSample 
                                                                                  * attenuationAndWeakChannelRatioAndFade;
@@ -326,9 +345,9 @@ int AudioMixer::addStreamToMixForListeningNodeWithStream(AudioMixerClientData* l
 
         // Here's where we copy the MONO input to the STEREO output, and account for delay and weak side attenuation
         for (int inputSample = 0; inputSample < inputSampleCount; inputSample++) {
-            int16_t originalSample = streamPopOutput[inputSample];
-            int16_t leftSideSample = originalSample * leftSideAttenuation;
-            int16_t rightSideSample = originalSample * rightSideAttenuation;
+            float originalSample = streamPopOutput[inputSample];
+            float leftSideSample = originalSample * leftSideAttenuation;
+            float rightSideSample = originalSample * rightSideAttenuation;
 
             // since we might be delayed, don't write beyond our maxOutputIndex
             if (leftDestinationIndex <= maxOutputIndex) {
@@ -348,8 +367,7 @@ int AudioMixer::addStreamToMixForListeningNodeWithStream(AudioMixerClientData* l
        float attenuationAndFade = attenuationCoefficient * repeatedFrameFadeFactor;
 
         for (int s = 0; s < NETWORK_BUFFER_LENGTH_SAMPLES_STEREO; s++) {
-            _preMixSamples[s] = glm::clamp(_preMixSamples[s] + (int)(streamPopOutput[s / stereoDivider] * attenuationAndFade),
-                                            MIN_SAMPLE_VALUE, MAX_SAMPLE_VALUE);
+            _preMixSamples[s] += streamPopOutput[s / stereoDivider] * attenuationAndFade;
         }
     }
 
@@ -419,9 +437,9 @@ int AudioMixer::addStreamToMixForListeningNodeWithStream(AudioMixerClientData* l
         penumbraFilter.render(_preMixSamples, _preMixSamples, NETWORK_BUFFER_LENGTH_SAMPLES_STEREO / 2);
     }
     
-    // Actually mix the _preMixSamples into the _mixSamples here.
+    // Actually mix the _preMixSamples into the _mixSamples here, nothing is clipped until the mix is done
     for (int s = 0; s < NETWORK_BUFFER_LENGTH_SAMPLES_STEREO; s++) {
-        _mixSamples[s] = glm::clamp(_mixSamples[s] + _preMixSamples[s], MIN_SAMPLE_VALUE, MAX_SAMPLE_VALUE);
+        _mixSamples[s] += _preMixSamples[s];
     }
 
     return 1;
@@ -432,35 +450,202 @@ int AudioMixer::prepareMixForListeningNode(Node* node) {
     AudioMixerClientData* listenerNodeData = static_cast<AudioMixerClientData*>(node->getLinkedData());
     
     // zero out the client mix for this node
-    memset(_preMixSamples, 0, sizeof(_preMixSamples));
     memset(_mixSamples, 0, sizeof(_mixSamples));
 
-    // loop through all other nodes that have sufficient audio to mix
+    // loop through the streams that have audio to mix this frame
     int streamsMixed = 0;
-    foreach (const SharedNodePointer& otherNode, NodeList::getInstance()->getNodeHash()) {
-        if (otherNode->getLinkedData()) {
-            AudioMixerClientData* otherNodeClientData = (AudioMixerClientData*) otherNode->getLinkedData();
+    foreach (const AudibleStream& audibleStream, _audibleStreams) {
+        if (audibleStream.sourceNode.data() != node || audibleStream.stream->shouldLoopbackForNode()) {
+            streamsMixed += addStreamToMixForListeningNodeWithStream(listenerNodeData, audibleStream.streamUUID,
+                                                                     audibleStream.stream, nodeAudioStream);
+        }
+    }
+    
+    if (streamsMixed > 0) {
+        AudioLimiter::render(_mixSamples, _clientMixSamples, NETWORK_BUFFER_LENGTH_SAMPLES_STEREO, _enableSoftLimiter);
+    }
+    return streamsMixed;
+}
 
-            // enumerate the ARBs attached to the otherNode and add all that should be added to mix
+void AudioMixer::addAudibleStreamsForNode(const SharedNodePointer& node) {
+    AudioMixerClientData* nodeData = static_cast<AudioMixerClientData*>(node->getLinkedData());
 
-            const QHash<QUuid, PositionalAudioStream*>& otherNodeAudioStreams = otherNodeClientData->getAudioStreams();
-            QHash<QUuid, PositionalAudioStream*>::ConstIterator i;
-            for (i = otherNodeAudioStreams.constBegin(); i != otherNodeAudioStreams.constEnd(); i++) {
-                PositionalAudioStream* otherNodeStream = i.value();
-                QUuid streamUUID = i.key();
-                
-                if (otherNodeStream->getType() == PositionalAudioStream::Microphone) {
-                    streamUUID = otherNode->getUUID();
+    const QHash<QUuid, PositionalAudioStream*>& nodeAudioStreams = nodeData->getAudioStreams();
+    QHash<QUuid, PositionalAudioStream*>::ConstIterator i;
+    for (i = nodeAudioStreams.constBegin(); i != nodeAudioStreams.constEnd(); i++) {
+        PositionalAudioStream* stream = i.value();
+
+        // these are the same checks addStreamToMixForListeningNodeWithStream bails on before it looks at the listener
+        if (!stream->lastPopSucceeded()) {
+            if (!_streamSettings._repetitionWithFade || stream->getLastPopOutput().isNull()
+                || calculateRepeatedFrameFadeFactor(stream->getConsecutiveNotMixedCount() - 1) == 0.0f) {
+                continue;
+            }
+        }
+
+        if (stream->getLastPopOutputLoudness() == 0.0f) {
+            continue;
+        }
+
+        AudibleStream audibleStream;
+        audibleStream.sourceNode = node;
+        audibleStream.streamUUID = (stream->getType() == PositionalAudioStream::Microphone) ? node->getUUID() : i.key();
+        audibleStream.stream = stream;
+        audibleStream.maxAudibleDistance = stream->getLastPopOutputTrailingLoudness() / _minAudibilityThreshold;
+
+        _audibleStreams.append(audibleStream);
+    }
+}
+
+bool AudioMixer::hasAudibleStreamsForListeningNode(Node* node) const {
+    AvatarAudioStream* listeningNodeStream = static_cast<AudioMixerClientData*>(node->getLinkedData())->getAvatarAudioStream();
+
+    foreach (const AudibleStream& audibleStream, _audibleStreams) {
+        if (audibleStream.sourceNode.data() == node) {
+            if (audibleStream.stream->shouldLoopbackForNode()) {
+                return true;
+            }
+        } else if (glm::distance(audibleStream.stream->getPosition(), listeningNodeStream->getPosition())
+                   < audibleStream.maxAudibleDistance) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void AudioMixer::sendSubmixToPeerMixers(const QVector<SharedNodePointer>& nodes) {
+    NodeList* nodeList = NodeList::getInstance();
+    
+    QList<SharedNodePointer> peerMixers;
+    foreach (const SharedNodePointer& node, nodes) {
+        if (node->getType() == NodeType::AudioMixer && node->getActiveSocket()) {
+            peerMixers << node;
+        }
+    }
+    
+    if (peerMixers.isEmpty()) {
+        _submixSequenceNumbers.clear();
+        return;
+    }
+    
+    // only our own agents go into the submixes, streams from other audio-mixers would echo back and forth between us
+    QVector<const AudibleStream*> sources;
+    for (int i = 0; i < _audibleStreams.size(); i++) {
+        if (_audibleStreams.at(i).sourceNode->getType() == NodeType::Agent) {
+            sources << &_audibleStreams.at(i);
+        }
+    }
+    
+    // a cluster from the last frame keeps its first source for as long as that source is audible, so the peers keep
+    // mixing it as the same stream
+    QVector<SubmixCluster> clusters;
+    QVector<bool> clustered(sources.size(), false);
+    for (int i = 0; i < sources.size(); i++) {
+        if (_submixSequenceNumbers.contains(sources[i]->streamUUID)) {
+            SubmixCluster cluster;
+            cluster.streamUUID = sources[i]->streamUUID;
+            cluster.firstSourcePosition = sources[i]->stream->getPosition();
+            cluster.positionSum = cluster.firstSourcePosition;
+            cluster.streams << sources[i]->stream;
+            clusters << cluster;
+            clustered[i] = true;
+        }
+    }
+    
+    // every other source joins the closest cluster it is near enough to, or starts one of its own
+    for (int i = 0; i < sources.size(); i++) {
+        if (clustered[i]) {
+            continue;
+        }
+        const glm::vec3& position = sources[i]->stream->getPosition();
+        int closestCluster = -1;
+        float closestDistance = 0.0f;
+        for (int j = 0; j < clusters.size(); j++) {
+            float distance = glm::distance(position, clusters[j].firstSourcePosition);
+            if (closestCluster == -1 || distance < closestDistance) {
+                closestCluster = j;
+                closestDistance = distance;
+            }
+        }
+        if (closestCluster == -1 || (closestDistance > ATTENUATION_BEGINS_AT_DISTANCE
+                                     && clusters.size() < MAX_SUBMIXES_PER_PEER_MIXER)) {
+            SubmixCluster cluster;
+            cluster.streamUUID = sources[i]->streamUUID;
+            cluster.firstSourcePosition = position;
+            cluster.positionSum = glm::vec3(0.0f);
+            clusters << cluster;
+            closestCluster = clusters.size() - 1;
+        }
+        clusters[closestCluster].positionSum += position;
+        clusters[closestCluster].streams << sources[i]->stream;
+    }
+    
+    QHash<QUuid, quint16> nextSequenceNumbers;
+    foreach (const SubmixCluster& cluster, clusters) {
+        // the sources of a cluster are within the distance where attenuation begins of its first source, so the peers
+        // attenuating the submix by the listener's distance to the cluster is about what each source would get;
+        // the submix itself only carries the fades and injector attenuations the mix would apply
+        memset(_submixSamples, 0, sizeof(_submixSamples));
+        foreach (PositionalAudioStream* stream, cluster.streams) {
+            float attenuation = 1.0f;
+            if (!stream->lastPopSucceeded()) {
+                attenuation *= calculateRepeatedFrameFadeFactor(stream->getConsecutiveNotMixedCount() - 1);
+            }
+            if (stream->getType() == PositionalAudioStream::Injector) {
+                attenuation *= static_cast<InjectedAudioStream*>(stream)->getAttenuationRatio();
+            }
+            
+            AudioRingBuffer::ConstIterator streamPopOutput = stream->getLastPopOutput();
+            if (stream->isStereo()) {
+                for (int s = 0; s < NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL; s++) {
+                    _submixSamples[s] += (streamPopOutput[2 * s] + streamPopOutput[2 * s + 1]) * attenuation * 0.5f;
                 }
-                 
-                if (*otherNode != *node || otherNodeStream->shouldLoopbackForNode()) {
-                    streamsMixed += addStreamToMixForListeningNodeWithStream(listenerNodeData, streamUUID, 
-                                                                                otherNodeStream, nodeAudioStream);
+            } else {
+                for (int s = 0; s < NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL; s++) {
+                    _submixSamples[s] += streamPopOutput[s] * attenuation;
                 }
             }
         }
+        
+        // pack the submix the same way AudioInjector packs injected audio, named after the first source of the cluster
+        QByteArray submixPacket = byteArrayWithPopulatedHeader(PacketTypeInjectAudio);
+        QDataStream packetStream(&submixPacket, QIODevice::Append);
+        
+        // the sequence number is read back in host byte order, so copy it over a placeholder
+        quint16 sequenceNumber = _submixSequenceNumbers.value(cluster.streamUUID, 0);
+        int numPreSequenceNumberBytes = submixPacket.size();
+        packetStream << (quint16)0;
+        memcpy(submixPacket.data() + numPreSequenceNumberBytes, &sequenceNumber, sizeof(quint16));
+        
+        packetStream << cluster.streamUUID;
+        packetStream << false; // the submix is mono
+        packetStream << (uchar)0; // never loop the submix back
+        
+        // the submix is placed at the middle of its sources
+        glm::vec3 submixPosition = cluster.positionSum / (float)cluster.streams.size();
+        glm::quat submixOrientation;
+        packetStream.writeRawData(reinterpret_cast<const char*>(&submixPosition), sizeof(submixPosition));
+        packetStream.writeRawData(reinterpret_cast<const char*>(&submixOrientation), sizeof(submixOrientation));
+        
+        float radius = 0.0f;
+        packetStream << radius;
+        packetStream << std::numeric_limits<quint8>::max(); // the injector attenuations are already applied
+        packetStream << (quint8)AudioCodec::PCM;
+        
+        int16_t submixOutput[NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL];
+        for (int s = 0; s < NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL; s++) {
+            submixOutput[s] = glm::clamp(_submixSamples[s], MIN_SAMPLE_VALUE, MAX_SAMPLE_VALUE);
+        }
+        packetStream.writeRawData(reinterpret_cast<const char*>(submixOutput), sizeof(submixOutput));
+        
+        foreach (const SharedNodePointer& peerMixer, peerMixers) {
+            nodeList->writeDatagram(submixPacket, peerMixer);
+        }
+        nextSequenceNumbers.insert(cluster.streamUUID, sequenceNumber + 1);
     }
-    return streamsMixed;
+    
+    // clusters that weren't sent this frame are left to starve on the peers, which drop them like any other injector
+    _submixSequenceNumbers = nextSequenceNumbers;
 }
 
 void AudioMixer::readPendingDatagram(const QByteArray& receivedPacket, const HifiSockAddr& senderSockAddr) {
@@ -472,13 +657,15 @@ void AudioMixer::readPendingDatagram(const QByteArray& receivedPacket, const Hif
         if (mixerPacketType == PacketTypeMicrophoneAudioNoEcho
             || mixerPacketType == PacketTypeMicrophoneAudioWithEcho
             || mixerPacketType == PacketTypeInjectAudio
+            || mixerPacketType == PacketTypeSilentInjectAudio
             || mixerPacketType == PacketTypeSilentAudioFrame
             || mixerPacketType == PacketTypeAudioStreamStats) {
             
             nodeList->findNodeAndUpdateWithDataFromPacket(receivedPacket);
         } else if (mixerPacketType == PacketTypeMuteEnvironment) {
-            QByteArray packet = receivedPacket;
-            populatePacketHeader(packet, PacketTypeMuteEnvironment);
+            // our header may not be the same size as the sender's
+            QByteArray packet = byteArrayWithPopulatedHeader(PacketTypeMuteEnvironment);
+            packet.append(receivedPacket.mid(numBytesForPacketHeader(receivedPacket)));
             
             foreach (const SharedNodePointer& node, nodeList->getNodeHash()) {
                 if (node->getType() == NodeType::Agent && node->getActiveSocket() && node->getLinkedData() && node != nodeList->sendingNodeForPacket(receivedPacket)) {
@@ -501,6 +688,8 @@ void AudioMixer::sendStatsPacket() {
     statsObject["performance_throttling_ratio"] = _performanceThrottlingRatio;
 
     statsObject["average_listeners_per_frame"] = (float) _sumListeners / (float) _numStatFrames;
+    statsObject["average_mixed_listeners_per_frame"] = (float) _sumMixedListeners / (float) _numStatFrames;
+    statsObject["average_skipped_listeners_per_frame"] = (float) _sumSkippedListeners / (float) _numStatFrames;
     
     if (_sumListeners > 0) {
         statsObject["average_mixes_per_listener"] = (float) _sumMixes / (float) _sumListeners;
@@ -511,6 +700,8 @@ void AudioMixer::sendStatsPacket() {
     ThreadedAssignment::addPacketStatsAndSendStatsPacket(statsObject);
     _sumListeners = 0;
     _sumMixes = 0;
+    _sumMixedListeners = 0;
+    _sumSkippedListeners = 0;
     _numStatFrames = 0;
 
 
@@ -587,7 +778,9 @@ void AudioMixer::run() {
     _datagramProcessingThread = new QThread(this);
     
     // create an AudioMixerDatagramProcessor and move it to that thread
-    AudioMixerDatagramProcessor* datagramProcessor = new AudioMixerDatagramProcessor(nodeList->getNodeSocket(), thread());
+    AudioMixerDatagramProcessor* datagramProcessor = new AudioMixerDatagramProcessor(nodeList->getNodeSocket(),
+                                                                                     nodeList->getBatchedNodeSocket(),
+                                                                                     thread());
     datagramProcessor->moveToThread(_datagramProcessingThread);
     
     // remove the NodeList as the parent of the node socket
@@ -609,6 +802,9 @@ void AudioMixer::run() {
     _datagramProcessingThread->start();
     
     nodeList->addNodeTypeToInterestSet(NodeType::Agent);
+    
+    // other audio-mixers in the domain are sent a submix of our agents every frame, see sendSubmixToPeerMixers
+    nodeList->addNodeTypeToInterestSet(NodeType::AudioMixer);
 
     nodeList->linkedDataCreateCallback = attachNewNodeDataToNode;
     
@@ -705,7 +901,12 @@ void AudioMixer::run() {
             _lastPerSecondCallbackTime = now;
         }
         
-        foreach (const SharedNodePointer& node, nodeList->getNodeHash()) {
+        NodeTablePointer nodeTable = nodeList->getNodeTable();
+        const QVector<SharedNodePointer>& nodes = nodeTable->nodes;
+        
+        // pop a frame from every stream before any mixing so that we know which streams are audible this frame
+        _audibleStreams.clear();
+        foreach (const SharedNodePointer& node, nodes) {
             if (node->getLinkedData()) {
                 AudioMixerClientData* nodeData = (AudioMixerClientData*)node->getLinkedData();
 
@@ -713,11 +914,31 @@ void AudioMixer::run() {
                 // a pointer to the popped data is stored as a member in InboundAudioStream.
                 // That's how the popped audio data will be read for mixing (but only if the pop was successful)
                 nodeData->checkBuffersBeforeFrameSend();
+                
+                addAudibleStreamsForNode(node);
+            }
+        }
+        
+        // everything this frame sends goes out in as few socket calls as possible
+        nodeList->beginDatagramBatch();
+        
+        sendSubmixToPeerMixers(nodes);
+        
+        foreach (const SharedNodePointer& node, nodes) {
+            if (node->getLinkedData()) {
+                AudioMixerClientData* nodeData = (AudioMixerClientData*)node->getLinkedData();
             
                 if (node->getType() == NodeType::Agent && node->getActiveSocket()
                     && nodeData->getAvatarAudioStream()) {
 
-                    int streamsMixed = prepareMixForListeningNode(node.data());
+                    // listeners with nothing audible in range get a silent frame without any mixing work
+                    int streamsMixed = 0;
+                    if (hasAudibleStreamsForListeningNode(node.data())) {
+                        streamsMixed = prepareMixForListeningNode(node.data());
+                        ++_sumMixedListeners;
+                    } else {
+                        ++_sumSkippedListeners;
+                    }
 
                     char* dataAt;
                     if (streamsMixed > 0) {
@@ -757,9 +978,13 @@ void AudioMixer::run() {
                             dataAt += sizeof(bool);
                         }
                         
-                        // pack mixed audio samples
-                        memcpy(dataAt, _mixSamples, NETWORK_BUFFER_LENGTH_BYTES_STEREO);
-                        dataAt += NETWORK_BUFFER_LENGTH_BYTES_STEREO;
+                        // pack the codec this listener gets its mix in, then the encoded mixed audio samples
+                        AudioCodec* downstreamEncoder = nodeData->getDownstreamEncoder(_enableCodecs);
+                        quint8 codecType = downstreamEncoder->getType();
+                        memcpy(dataAt, &codecType, sizeof(quint8));
+                        dataAt += sizeof(quint8);
+
+                        dataAt += downstreamEncoder->encode(_clientMixSamples, NETWORK_BUFFER_LENGTH_SAMPLES_STEREO, 2, dataAt);
                     } else {
                         // pack header
                         int numBytesPacketHeader = populatePacketHeader(clientMixBuffer, PacketTypeSilentAudioFrame);
@@ -791,6 +1016,8 @@ void AudioMixer::run() {
             }
         }
         
+        nodeList->flushDatagramBatch();
+        
         ++_numStatFrames;
         
         QCoreApplication::processEvents();
@@ -986,6 +1213,22 @@ void AudioMixer::parseSettingsObject(const QJsonObject &settingsObject) {
             qDebug() << "Filter enabled";
         }
         
+        const QString CODECS_KEY = "enable_codecs";
+        if (audioEnvGroupObject[CODECS_KEY].isBool()) {
+            _enableCodecs = audioEnvGroupObject[CODECS_KEY].toBool();
+        }
+        if (_enableCodecs) {
+            qDebug() << "Mixed audio will be encoded with the codec each listener prefers";
+        }
+        
+        const QString SOFT_LIMITER_KEY = "enable_soft_limiter";
+        if (audioEnvGroupObject[SOFT_LIMITER_KEY].isBool()) {
+            _enableSoftLimiter = audioEnvGroupObject[SOFT_LIMITER_KEY].toBool();
+        }
+        if (_enableSoftLimiter) {
+            qDebug() << "Soft limiter enabled";
+        }
+        
         const QString AUDIO_ZONES = "zones";
         if (audioEnvGroupObject[AUDIO_ZONES].isObject()) {
             const QJsonObject& zones = audioEnvGroupObject[AUDIO_ZONES].toObject();
@@ -50,13 +50,44 @@ private:
     /// prepares and sends a mix to one Node
     int prepareMixForListeningNode(Node* node);
 
+    /// adds the streams of one Node that have a frame worth mixing this frame to _audibleStreams
+    void addAudibleStreamsForNode(const SharedNodePointer& node);
+
+    /// returns true if any of this frame's audible streams is close enough to be heard by the listening Node
+    bool hasAudibleStreamsForListeningNode(Node* node) const;
+
+    /// sends mono submixes of the audible streams from our own agents to every other audio-mixer in the domain, one for
+    /// each cluster of sources that are close together, placed at the cluster and mixed there like an injected stream
+    void sendSubmixToPeerMixers(const QVector<SharedNodePointer>& nodes);
+
     // used on a per stream basis to run the filter on before mixing, large enough to handle the historical
     // data from a phase delay as well as an entire network buffer
-    int16_t _preMixSamples[NETWORK_BUFFER_LENGTH_SAMPLES_STEREO + (SAMPLE_PHASE_DELAY_AT_90 * 2)];
+    float _preMixSamples[NETWORK_BUFFER_LENGTH_SAMPLES_STEREO + (SAMPLE_PHASE_DELAY_AT_90 * 2)];
     
-    // client samples capacity is larger than what will be sent to optimize mixing
-    // we are MMX adding 4 samples at a time so we need client samples to have an extra 4
-    int16_t _mixSamples[NETWORK_BUFFER_LENGTH_SAMPLES_STEREO + (SAMPLE_PHASE_DELAY_AT_90 * 2)];
+    // the streams are mixed at full precision and only saturated to 16 bits once, into _clientMixSamples
+    float _mixSamples[NETWORK_BUFFER_LENGTH_SAMPLES_STEREO + (SAMPLE_PHASE_DELAY_AT_90 * 2)];
+    int16_t _clientMixSamples[NETWORK_BUFFER_LENGTH_SAMPLES_STEREO];
+
+    // a stream that popped an audible frame this frame, and how far away it can still be heard
+    struct AudibleStream {
+        SharedNodePointer sourceNode;
+        QUuid streamUUID;
+        PositionalAudioStream* stream;
+        float maxAudibleDistance;
+    };
+    QVector<AudibleStream> _audibleStreams;
+
+    // the sources that go into one submix for the peer audio-mixers, sent as a stream named after its first source
+    struct SubmixCluster {
+        QUuid streamUUID;
+        glm::vec3 firstSourcePosition;
+        glm::vec3 positionSum;
+        QVector<PositionalAudioStream*> streams;
+    };
+
+    // accumulates a submix sent to peer audio-mixers before it is packed as 16-bit samples
+    int32_t _submixSamples[NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL];
+    QHash<QUuid, quint16> _submixSequenceNumbers; // the next sequence number of each submix sent last frame
 
     void perSecondActions();
 
@@ -74,6 +105,8 @@ private:
     int _numStatFrames;
     int _sumListeners;
     int _sumMixes;
+    int _sumMixedListeners;
+    int _sumSkippedListeners;
     
     QHash<QString, AABox> _audioZones;
     struct ZonesSettings {
@@ -93,6 +126,8 @@ private:
 
     static bool _printStreamStats;
     static bool _enableFilter;
+    static bool _enableCodecs;
+    static bool _enableSoftLimiter;
     
     quint64 _lastPerSecondCallbackTime;
 
@@ -23,6 +23,7 @@
 AudioMixerClientData::AudioMixerClientData() :
     _audioStreams(),
     _outgoingMixedAudioSequenceNumber(0),
+    _downstreamEncoder(NULL),
     _downstreamAudioStreamStats()
 {
 }
@@ -38,6 +39,8 @@ AudioMixerClientData::~AudioMixerClientData() {
     foreach(PerListenerSourcePairData* pairData, _listenerSourcePairData) {
         delete pairData;
     }
+
+    delete _downstreamEncoder;
 }
 
 AvatarAudioStream* AudioMixerClientData::getAvatarAudioStream() const {
@@ -48,6 +51,20 @@ AvatarAudioStream* AudioMixerClientData::getAvatarAudioStream() const {
     return NULL;
 }
 
+AudioCodec* AudioMixerClientData::getDownstreamEncoder(bool allowCodecs) {
+    AudioCodec::Type codecType = AudioCodec::PCM;
+    AvatarAudioStream* avatarAudioStream = getAvatarAudioStream();
+    if (allowCodecs && avatarAudioStream) {
+        codecType = AudioCodec::preferredTypeForMask(avatarAudioStream->getAcceptedCodecsMask());
+    }
+
+    if (!_downstreamEncoder || _downstreamEncoder->getType() != codecType) {
+        delete _downstreamEncoder;
+        _downstreamEncoder = AudioCodec::create(codecType);
+    }
+    return _downstreamEncoder;
+}
+
 int AudioMixerClientData::parseData(const QByteArray& packet) {
     PacketType packetType = packetTypeForPacket(packet);
     if (packetType == PacketTypeAudioStreamStats) {
@@ -83,7 +100,7 @@ int AudioMixerClientData::parseData(const QByteArray& packet) {
             } else {
                 matchingStream = _audioStreams.value(nullUUID);
             }
-        } else if (packetType == PacketTypeInjectAudio) {
+        } else if (packetType == PacketTypeInjectAudio || packetType == PacketTypeSilentInjectAudio) {
             // this is injected audio
 
             // grab the stream identifier for this injected audio
@@ -53,6 +53,9 @@ public:
     void incrementOutgoingMixedAudioSequenceNumber() { _outgoingMixedAudioSequenceNumber++; }
     quint16 getOutgoingSequenceNumber() const { return _outgoingMixedAudioSequenceNumber; }
 
+    /// returns the encoder for the mix sent to this node, switching codecs if the node's accepted codecs changed
+    AudioCodec* getDownstreamEncoder(bool allowCodecs);
+
     void printUpstreamDownstreamStats() const;
 
     PerListenerSourcePairData* getListenerSourcePairData(const QUuid& sourceUUID);
@@ -67,6 +70,9 @@ private:
 
     quint16 _outgoingMixedAudioSequenceNumber;
 
+    // encoder state is kept per listener since ADPCM carries its predictor from one mixed frame to the next
+    AudioCodec* _downstreamEncoder;
+
     AudioStreamStats _downstreamAudioStreamStats;
 };
 
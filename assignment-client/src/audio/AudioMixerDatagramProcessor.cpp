@@ -16,8 +16,10 @@
 
 #include "AudioMixerDatagramProcessor.h"
 
-AudioMixerDatagramProcessor::AudioMixerDatagramProcessor(QUdpSocket& nodeSocket, QThread* previousNodeSocketThread) :
+AudioMixerDatagramProcessor::AudioMixerDatagramProcessor(QUdpSocket& nodeSocket, BatchedDatagramSocket& batchedNodeSocket,
+                                                         QThread* previousNodeSocketThread) :
     _nodeSocket(nodeSocket),
+    _batchedNodeSocket(batchedNodeSocket),
     _previousNodeSocketThread(previousNodeSocketThread)
 {
     
@@ -33,14 +35,8 @@ void AudioMixerDatagramProcessor::readPendingDatagrams() {
     HifiSockAddr senderSockAddr;
     static QByteArray incomingPacket;
     
-    // read everything that is available
-    while (_nodeSocket.hasPendingDatagrams()) {
-        incomingPacket.resize(_nodeSocket.pendingDatagramSize());
-        
-        // just get this packet off the stack
-        _nodeSocket.readDatagram(incomingPacket.data(), incomingPacket.size(),
-                                  senderSockAddr.getAddressPointer(), senderSockAddr.getPortPointer());
-        
+    // read everything that is available, a batch at a time
+    while (_batchedNodeSocket.readDatagram(incomingPacket, senderSockAddr)) {
         // emit the signal to tell AudioMixer it needs to process a packet
         emit packetRequiresProcessing(incomingPacket, senderSockAddr);
     }
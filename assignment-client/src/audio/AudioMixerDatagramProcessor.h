@@ -15,10 +15,13 @@
 #include <qobject.h>
 #include <qudpsocket.h>
 
+#include <BatchedDatagramSocket.h>
+
 class AudioMixerDatagramProcessor : public QObject {
     Q_OBJECT
 public:
-    AudioMixerDatagramProcessor(QUdpSocket& nodeSocket, QThread* previousNodeSocketThread);
+    AudioMixerDatagramProcessor(QUdpSocket& nodeSocket, BatchedDatagramSocket& batchedNodeSocket,
+                                QThread* previousNodeSocketThread);
     ~AudioMixerDatagramProcessor();
 public slots:
     void readPendingDatagrams();
@@ -26,6 +29,7 @@ signals:
     void packetRequiresProcessing(const QByteArray& receivedPacket, const HifiSockAddr& senderSockAddr);
 private:
     QUdpSocket& _nodeSocket;
+    BatchedDatagramSocket& _batchedNodeSocket;
     QThread* _previousNodeSocketThread;
 };
 
@@ -14,7 +14,8 @@
 #include "AvatarAudioStream.h"
 
 AvatarAudioStream::AvatarAudioStream(bool isStereo, const InboundAudioStream::Settings& settings) :
-    PositionalAudioStream(PositionalAudioStream::Microphone, isStereo, settings)
+    PositionalAudioStream(PositionalAudioStream::Microphone, isStereo, settings),
+    _acceptedCodecsMask(AudioCodec::maskForType(AudioCodec::PCM))
 {
 }
 
@@ -44,12 +45,20 @@ int AvatarAudioStream::parseStreamProperties(PacketType type, const QByteArray&
             _isStereo = isStereo;
         }
 
+        // read the codec the audio data was encoded with and the codecs we can use for the mix sent back
+        quint8 codecType = packetAfterSeqNum.at(readBytes);
+        readBytes += sizeof(quint8);
+        setCodec(AudioCodec::isValidType(codecType) ? (AudioCodec::Type)codecType : AudioCodec::PCM, isStereo ? 2 : 1);
+
+        _acceptedCodecsMask = packetAfterSeqNum.at(readBytes);
+        readBytes += sizeof(quint8);
+
         // read the positional data
         readBytes += parsePositionalData(packetAfterSeqNum.mid(readBytes));
 
         // calculate how many samples are in this packet
         int numAudioBytes = packetAfterSeqNum.size() - readBytes;
-        numAudioSamples = numAudioBytes / sizeof(int16_t);
+        numAudioSamples = numSamplesForEncodedBytes(numAudioBytes);
     }
     
     return readBytes;
@@ -20,12 +20,17 @@ class AvatarAudioStream : public PositionalAudioStream {
 public:
     AvatarAudioStream(bool isStereo, const InboundAudioStream::Settings& settings);
 
+    /// the codecs this node can decode, as advertised in its microphone audio packets
+    quint8 getAcceptedCodecsMask() const { return _acceptedCodecsMask; }
+
 private:
     // disallow copying of AvatarAudioStream objects
     AvatarAudioStream(const AvatarAudioStream&);
     AvatarAudioStream& operator= (const AvatarAudioStream&);
 
     int parseStreamProperties(PacketType type, const QByteArray& packetAfterSeqNum, int& numAudioSamples);
+
+    quint8 _acceptedCodecsMask;
 };
 
 #endif // hifi_AvatarAudioStream_h
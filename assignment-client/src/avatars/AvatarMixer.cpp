@@ -122,7 +122,12 @@ void AvatarMixer::broadcastAvatarData() {
     AvatarMixerClientData* nodeData = NULL;
     AvatarMixerClientData* otherNodeData = NULL;
     
-    foreach (const SharedNodePointer& node, nodeList->getNodeHash()) {
+    // one snapshot of the node list for the whole frame, the inner loop runs once per listener
+    NodeTablePointer nodeTable = nodeList->getNodeTable();
+    
+    nodeList->beginDatagramBatch();
+    
+    foreach (const SharedNodePointer& node, nodeTable->nodes) {
         if (node->getLinkedData() && node->getType() == NodeType::Agent && node->getActiveSocket()
             && (nodeData = reinterpret_cast<AvatarMixerClientData*>(node->getLinkedData()))->getMutex().tryLock()) {
             ++_sumListeners;
@@ -135,7 +140,7 @@ void AvatarMixer::broadcastAvatarData() {
             
             // this is an AGENT we have received head data from
             // send back a packet with other active node data to this node
-            foreach (const SharedNodePointer& otherNode, nodeList->getNodeHash()) {
+            foreach (const SharedNodePointer& otherNode, nodeTable->nodes) {
                 if (otherNode->getLinkedData() && otherNode->getUUID() != node->getUUID()
                     && (otherNodeData = reinterpret_cast<AvatarMixerClientData*>(otherNode->getLinkedData()))->getMutex().tryLock()) {
                     
@@ -211,6 +216,8 @@ void AvatarMixer::broadcastAvatarData() {
         }
     }
     
+    nodeList->flushDatagramBatch();
+    
     _lastFrameTimestamp = QDateTime::currentMSecsSinceEpoch();
 }
 
@@ -12,6 +12,7 @@
 #ifndef hifi_EntityNodeData_h
 #define hifi_EntityNodeData_h
 
+#include <DeletedEntityLog.h>
 #include <PacketHeaders.h>
 
 #include "../octree/OctreeQueryNode.h"
@@ -19,16 +20,15 @@
 class EntityNodeData : public OctreeQueryNode {
 public:
     EntityNodeData() :
-        OctreeQueryNode(),
-        _lastDeletedEntitiesSentAt(0) { }
+        OctreeQueryNode() { }
 
     virtual PacketType getMyPacketType() const { return PacketTypeEntityData; }
 
-    quint64 getLastDeletedEntitiesSentAt() const { return _lastDeletedEntitiesSentAt; }
-    void setLastDeletedEntitiesSentAt(quint64 sentAt) { _lastDeletedEntitiesSentAt = sentAt; }
+    /// where this node has got to in the tree's deleted entity log
+    DeletedEntityCursor& getDeletedEntitiesCursor() { return _deletedEntitiesCursor; }
 
 private:
-    quint64 _lastDeletedEntitiesSentAt;
+    DeletedEntityCursor _deletedEntitiesCursor;
 };
 
 #endif // hifi_EntityNodeData_h
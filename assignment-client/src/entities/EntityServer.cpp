@@ -9,8 +9,14 @@
 //  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
 //
 
+#include <limits>
+
 #include <QTimer>
+
+#include <AACube.h>
 #include <EntityTree.h>
+#include <OctalCode.h>
+#include <UUID.h>
 
 #include "EntityServer.h"
 #include "EntityServerConsts.h"
@@ -20,7 +26,10 @@ const char* MODEL_SERVER_NAME = "Entity";
 const char* MODEL_SERVER_LOGGING_TARGET_NAME = "entity-server";
 const char* LOCAL_MODELS_PERSIST_FILE = "resources/models.svo";
 
-EntityServer::EntityServer(const QByteArray& packet) : OctreeServer(packet) {
+EntityServer::EntityServer(const QByteArray& packet) :
+    OctreeServer(packet),
+    _lastRegionLoadsAt(0)
+{
     // nothing special to do here...
 }
 
@@ -36,6 +45,7 @@ OctreeQueryNode* EntityServer::createOctreeQueryNode() {
 Octree* EntityServer::createTree() {
     EntityTree* tree = new EntityTree(true);
     tree->addNewlyCreatedHook(this);
+    tree->setIsSharedWithOtherServers(canTransferRegions());
     return tree;
 }
 
@@ -79,10 +89,8 @@ bool EntityServer::hasSpecialPacketToSend(const SharedNodePointer& node) {
     // check to see if any new entities have been added since we last sent to this node...
     EntityNodeData* nodeData = static_cast<EntityNodeData*>(node->getLinkedData());
     if (nodeData) {
-        quint64 deletedEntitiesSentAt = nodeData->getLastDeletedEntitiesSentAt();
-
         EntityTree* tree = static_cast<EntityTree*>(_tree);
-        shouldSendDeletedEntities = tree->hasEntitiesDeletedSince(deletedEntitiesSentAt);
+        shouldSendDeletedEntities = tree->hasEntitiesDeletedSince(nodeData->getDeletedEntitiesCursor());
     }
 
     return shouldSendDeletedEntities;
@@ -94,24 +102,20 @@ int EntityServer::sendSpecialPacket(const SharedNodePointer& node, OctreeQueryNo
 
     EntityNodeData* nodeData = static_cast<EntityNodeData*>(node->getLinkedData());
     if (nodeData) {
-        quint64 deletedEntitiesSentAt = nodeData->getLastDeletedEntitiesSentAt();
-        quint64 deletePacketSentAt = usecTimestampNow();
-
         EntityTree* tree = static_cast<EntityTree*>(_tree);
         bool hasMoreToSend = true;
 
         // TODO: is it possible to send too many of these packets? what if you deleted 1,000,000 entities?
         packetsSent = 0;
         while (hasMoreToSend) {
-            hasMoreToSend = tree->encodeEntitiesDeletedSince(queryNode->getSequenceNumber(), deletedEntitiesSentAt,
+            hasMoreToSend = tree->encodeEntitiesDeletedSince(queryNode->getSequenceNumber(),
+                                                nodeData->getDeletedEntitiesCursor(),
                                                 outputBuffer, MAX_PACKET_SIZE, packetLength);
 
             NodeList::getInstance()->writeDatagram((char*) outputBuffer, packetLength, SharedNodePointer(node));
             queryNode->packetSent(outputBuffer, packetLength);
             packetsSent++;
         }
-
-        nodeData->setLastDeletedEntitiesSentAt(deletePacketSentAt);
     }
 
     // TODO: caller is expecting a packetLength, what if we send more than one packet??
@@ -122,17 +126,206 @@ void EntityServer::pruneDeletedEntities() {
     EntityTree* tree = static_cast<EntityTree*>(_tree);
     if (tree->hasAnyDeletedEntities()) {
 
-        quint64 earliestLastDeletedEntitiesSent = usecTimestampNow() + 1; // in the future
+        // the deletions before the cursor furthest behind have been sent to everyone. Clients that start reading
+        // while this looks at the cursors would be missed, so they wait until the deletions are forgotten.
+        tree->lockForPruningDeletedEntities();
+        quint64 earliestDeletedEntitiesCursor = std::numeric_limits<quint64>::max();
         foreach (const SharedNodePointer& otherNode, NodeList::getInstance()->getNodeHash()) {
-            if (otherNode->getLinkedData()) {
+            // other entity servers we transfer regions with never query us, so they'd hold deletes back forever
+            if (otherNode->getLinkedData() && otherNode->getType() != getMyNodeType()) {
                 EntityNodeData* nodeData = static_cast<EntityNodeData*>(otherNode->getLinkedData());
-                quint64 nodeLastDeletedEntitiesSentAt = nodeData->getLastDeletedEntitiesSentAt();
-                if (nodeLastDeletedEntitiesSentAt < earliestLastDeletedEntitiesSent) {
-                    earliestLastDeletedEntitiesSent = nodeLastDeletedEntitiesSentAt;
+                quint64 nodeDeletedEntitiesCursor = nodeData->getDeletedEntitiesCursor().getSequence();
+                if (nodeDeletedEntitiesCursor < earliestDeletedEntitiesCursor) {
+                    earliestDeletedEntitiesCursor = nodeDeletedEntitiesCursor;
                 }
             }
         }
-        tree->forgetEntitiesDeletedBefore(earliestLastDeletedEntitiesSent);
+        tree->forgetEntitiesDeletedBefore(earliestDeletedEntitiesCursor);
+        tree->unlockForPruningDeletedEntities();
+    }
+}
+
+
+// one unit of load for every hundred entities each connected client has to be sent
+const float ENTITIES_PER_CLIENT_LOAD = 100.0f;
+
+static AACube cubeForOctalCode(const unsigned char* octalCode) {
+    VoxelPositionSize details;
+    voxelDetailsForCode(octalCode, details);
+    return AACube(glm::vec3(details.x, details.y, details.z), details.s);
+}
+
+void EntityServer::findEntitiesInRegion(const unsigned char* regionCode, QVector<EntityItem*>& foundEntities) {
+    EntityTree* tree = static_cast<EntityTree*>(_tree);
+    AACube regionCube = cubeForOctalCode(regionCode);
+
+    QVector<EntityItem*> touchingEntities;
+    tree->findEntities(regionCube, touchingEntities);
+
+    foundEntities.clear();
+    foreach (EntityItem* entity, touchingEntities) {
+        if (regionCube.contains(entity->getPosition())) {
+            foundEntities << entity;
+        }
+    }
+}
+
+void EntityServer::calculateRegionLoads(const unsigned char* rootCode, float* regionLoads) {
+    quint64 now = usecTimestampNow();
+    quint64 editedSince = (_lastRegionLoadsAt > 0) ? _lastRegionLoadsAt : now;
+    float elapsedSeconds = std::max(1.0f, (float)(now - editedSince) / (float)USECS_PER_SECOND);
+    float loadPerEntity = getCurrentClientCount() / ENTITIES_PER_CLIENT_LOAD;
+    _lastRegionLoadsAt = now;
+
+    _tree->lockForRead();
+    for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+        unsigned char* childCode = childOctalCode(rootCode, i);
+        QVector<EntityItem*> entities;
+        findEntitiesInRegion(childCode, entities);
+        delete[] childCode;
+
+        int editedEntities = 0;
+        foreach (EntityItem* entity, entities) {
+            if (entity->getLastEdited() > editedSince) {
+                editedEntities++;
+            }
+        }
+        regionLoads[i] += (editedEntities / elapsedSeconds) + (entities.size() * loadPerEntity);
+    }
+    _tree->unlock();
+}
+
+bool EntityServer::encodeRegionForTransfer(const unsigned char* regionCode, QVector<QByteArray>& buffers) {
+    // copy the region's entities into a tree of their own, so that what we send is exactly what the region owns and
+    // not everything that happens to overlap its cube
+    EntityTree regionTree;
+    _regionBeingTransferred = cubeForOctalCode(regionCode);
+    _entitiesBeingTransferred.clear();
+
+    _tree->lockForRead();
+    QVector<EntityItem*> entities;
+    findEntitiesInRegion(regionCode, entities);
+    foreach (EntityItem* entity, entities) {
+        EntityItemProperties properties = entity->getProperties();
+        properties.markAllChanged();
+        properties.setLastEdited(entity->getLastEdited());
+        regionTree.addEntity(entity->getEntityItemID(), properties);
+        _entitiesBeingTransferred.insert(entity->getEntityItemID(), entity->getLastEdited());
+    }
+    _tree->unlock();
+
+    OctreeElementBag elementBag;
+    OctreeElementExtraEncodeData extraEncodeData;
+    elementBag.insert(regionTree.getRoot());
+
+    OctreePacketData packetData(false, MAX_SUBTREE_TRANSFER_BUFFER_SIZE);
+    while (!elementBag.isEmpty()) {
+        OctreeElement* subTree = elementBag.extract();
+
+        EncodeBitstreamParams params(INT_MAX, IGNORE_VIEW_FRUSTUM, WANT_COLOR, NO_EXISTS_BITS);
+        params.extraEncodeData = &extraEncodeData;
+        int bytesWritten = regionTree.encodeTreeBitstream(subTree, &packetData, elementBag, params);
+
+        // if the subTree couldn't fit, finish this buffer and try it again in a fresh one, unless it didn't fit in a
+        // fresh one either
+        if (bytesWritten == 0 && (params.stopReason == EncodeBitstreamParams::DIDNT_FIT)) {
+            if (!packetData.hasContent()) {
+                qDebug() << "Region" << octalCodeToHexString(regionCode) << "has an element too large to transfer.";
+                regionTree.releaseSceneEncodeData(&extraEncodeData);
+                buffers.clear();
+                _entitiesBeingTransferred.clear();
+                return false;
+            }
+            buffers << QByteArray((const char*)packetData.getFinalizedData(), packetData.getFinalizedSize());
+            packetData.reset();
+            elementBag.insert(subTree);
+        }
+    }
+    if (packetData.hasContent()) {
+        buffers << QByteArray((const char*)packetData.getFinalizedData(), packetData.getFinalizedSize());
     }
+    regionTree.releaseSceneEncodeData(&extraEncodeData);
+    return true;
 }
 
+void EntityServer::readTransferredRegion(const QVector<QByteArray>& buffers) {
+    // entities we already have are only replaced by newer edits, as when loading the persist file
+    _tree->lockForWrite();
+    foreach (const QByteArray& buffer, buffers) {
+        ReadBitstreamToTreeParams args(WANT_COLOR, NO_EXISTS_BITS, NULL, 0, SharedNodePointer(), false,
+                                       versionForPacketType(PacketTypeEntityData));
+        _tree->readBitstreamToTree(reinterpret_cast<const unsigned char*>(buffer.constData()), buffer.size(), args);
+    }
+    _tree->unlock();
+}
+
+// the keys we give the new owner of a region for entities it has to delete: the entity ID, then whether the entity is
+// gone, or is still ours and only the new owner's copy is stale, in which case its viewers aren't told
+static QByteArray keyForDeletedEntity(const EntityItemID& entityID, bool isGone) {
+    return entityID.id.toRfc4122() + (isGone ? '\1' : '\0');
+}
+
+void EntityServer::forgetTransferredContent(QList<QByteArray>& deletedKeys) {
+    // The new owner sends the entities to its viewers now, so they are not reported as deleted. The edits we applied
+    // while the transfer was in flight didn't make it to the new owner: edited entities still in the region stay to
+    // follow it there, which replaces the owner's older copy, and the owner deletes its copy of those that were deleted
+    // or moved out of the region
+    EntityTree* tree = static_cast<EntityTree*>(_tree);
+    QSet<EntityItemID> entitiesToForget;
+
+    _tree->lockForWrite();
+    QHash<EntityItemID, quint64>::const_iterator transferred = _entitiesBeingTransferred.constBegin();
+    while (transferred != _entitiesBeingTransferred.constEnd()) {
+        EntityItem* entity = tree->findEntityByEntityItemID(transferred.key());
+        if (!entity) {
+            deletedKeys << keyForDeletedEntity(transferred.key(), true);
+        } else if (entity->getLastEdited() == transferred.value()) {
+            entitiesToForget << transferred.key();
+        } else if (!_regionBeingTransferred.contains(entity->getPosition())) {
+            deletedKeys << keyForDeletedEntity(transferred.key(), false);
+        }
+        ++transferred;
+    }
+    tree->deleteEntities(entitiesToForget, false);
+    _tree->unlock();
+    _entitiesBeingTransferred.clear();
+}
+
+void EntityServer::deleteTransferredContent(const QList<QByteArray>& deletedKeys) {
+    if (deletedKeys.isEmpty()) {
+        return;
+    }
+
+    QSet<EntityItemID> goneEntities;
+    QSet<EntityItemID> staleEntities;
+    foreach (const QByteArray& key, deletedKeys) {
+        if (key.size() != NUM_BYTES_RFC4122_UUID + 1) {
+            continue;
+        }
+        EntityItemID entityID(QUuid::fromRfc4122(key.left(NUM_BYTES_RFC4122_UUID)));
+        if (key.at(NUM_BYTES_RFC4122_UUID)) {
+            goneEntities << entityID;
+        } else {
+            staleEntities << entityID;
+        }
+    }
+
+    // our viewers may have been sent the entities that are gone after the sender told its viewers they were deleted
+    EntityTree* tree = static_cast<EntityTree*>(_tree);
+    _tree->lockForWrite();
+    if (!goneEntities.isEmpty()) {
+        tree->deleteEntities(goneEntities);
+    }
+    if (!staleEntities.isEmpty()) {
+        tree->deleteEntities(staleEntities, false);
+    }
+    _tree->unlock();
+}
+
+bool EntityServer::hasContentInRegion(const unsigned char* regionCode) {
+    QVector<EntityItem*> entities;
+    _tree->lockForRead();
+    findEntitiesInRegion(regionCode, entities);
+    _tree->unlock();
+    return !entities.isEmpty();
+}
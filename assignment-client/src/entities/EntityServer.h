@@ -40,12 +40,26 @@ public:
     virtual bool hasSpecialPacketToSend(const SharedNodePointer& node);
     virtual int sendSpecialPacket(const SharedNodePointer& node, OctreeQueryNode* queryNode, int& packetsSent);
 
+    virtual bool canTransferRegions() const { return true; }
+    virtual void calculateRegionLoads(const unsigned char* rootCode, float* regionLoads);
+    virtual bool encodeRegionForTransfer(const unsigned char* regionCode, QVector<QByteArray>& buffers);
+    virtual void readTransferredRegion(const QVector<QByteArray>& buffers);
+    virtual void forgetTransferredContent(QList<QByteArray>& deletedKeys);
+    virtual void deleteTransferredContent(const QList<QByteArray>& deletedKeys);
+    virtual bool hasContentInRegion(const unsigned char* regionCode);
+
     virtual void entityCreated(const EntityItem& newEntity, const SharedNodePointer& senderNode);
 
 public slots:
     void pruneDeletedEntities();
 
 private:
+    /// entities are owned by the server whose region holds their position
+    void findEntitiesInRegion(const unsigned char* regionCode, QVector<EntityItem*>& foundEntities);
+
+    AACube _regionBeingTransferred;
+    QHash<EntityItemID, quint64> _entitiesBeingTransferred; // when each was last edited as it was encoded
+    quint64 _lastRegionLoadsAt;
 };
 
 #endif // hifi_EntityServer_h
@@ -9,8 +9,11 @@
 //  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
 //
 
+#include <algorithm>
 #include <limits>
+
 #include <PacketHeaders.h>
+#include <ParallelBatch.h>
 #include <PerfStat.h>
 
 #include "OctreeServer.h"
@@ -20,6 +23,30 @@
 static QUuid DEFAULT_NODE_ID_REF;
 const quint64 TOO_LONG_SINCE_LAST_NACK = 1 * USECS_PER_SECOND;
 
+// the most queued edit packets we apply under one write lock, bounds how long the send threads wait on a busy editor
+const int MAX_EDIT_PACKETS_PER_WRITE_LOCK = 50;
+
+// below this many packets a burst is decoded on the processing thread alone
+const int MIN_EDIT_PACKETS_FOR_THREAD_POOL = 4;
+
+// the packets of a burst being decoded ahead of the write lock, each packet is an item of the batch
+class EditPacketDecodeBatch : public ParallelBatch {
+public:
+    Octree* tree;
+    QVector<NetworkPacket> packets; // shares the packet data with the burst, so the tree sees the same edit pointers
+
+protected:
+    virtual void runItem(int index) {
+        const QByteArray& packet = packets.at(index).getByteArray();
+        PacketType packetType = packetTypeForPacket(packet);
+        if (tree->handlesEditPacketType(packetType)) {
+            // the edits start after the sequence number and the sent time, the same as in processEditPacket()
+            int editDataOffset = numBytesForPacketHeader(packet) + sizeof(unsigned short int) + sizeof(quint64);
+            tree->decodeEditPacket(packetType, packet, editDataOffset);
+        }
+    }
+};
+
 OctreeInboundPacketProcessor::OctreeInboundPacketProcessor(OctreeServer* myServer) :
     _myServer(myServer),
     _receivedPacketCount(0),
@@ -72,7 +99,67 @@ void OctreeInboundPacketProcessor::midProcess() {
     }
 }
 
+bool OctreeInboundPacketProcessor::process() {
+    if (_packets.size() == 0) {
+        _waitingOnPacketsMutex.lock();
+        _hasPackets.wait(&_waitingOnPacketsMutex, getMaxWait());
+        _waitingOnPacketsMutex.unlock();
+    }
+    preProcess();
+    while (_packets.size() > 0) {
+        // take a burst of packets off the queue and apply all of them under one write lock, so a client streaming
+        // edits doesn't have us trade the tree back and forth with the send threads for every single edit
+        lock();
+        int burstSize = std::min(_packets.size(), MAX_EDIT_PACKETS_PER_WRITE_LOCK);
+        QVector<NetworkPacket> burst = _packets.mid(0, burstSize);
+        _packets.remove(0, burstSize);
+        foreach (const NetworkPacket& packet, burst) {
+            _nodePacketCounts[packet.getNode()->getUUID()]--;
+        }
+        unlock();
+
+        // decoding doesn't touch the tree, so it's done before taking the lock and spread over the thread pool
+        decodeEditPacketsAhead(burst);
+
+        quint64 startLock = usecTimestampNow();
+        _myServer->getOctree()->lockForWrite();
+        quint64 lockWaitTime = usecTimestampNow() - startLock;
+        _myServer->getOctree()->startEditBurst();
+        foreach (const NetworkPacket& packet, burst) {
+            processEditPacket(packet.getNode(), packet.getByteArray(), lockWaitTime);
+            lockWaitTime = 0; // the whole wait is charged to the first packet of the burst
+        }
+        _myServer->getOctree()->finishEditBurst();
+        _myServer->getOctree()->unlock();
+
+        midProcess();
+    }
+    postProcess();
+    return isStillRunning();  // keep running till they terminate us
+}
+
+void OctreeInboundPacketProcessor::decodeEditPacketsAhead(const QVector<NetworkPacket>& burst) {
+    Octree* tree = _myServer->getOctree();
+    if (_shuttingDown || !tree->canDecodeEditPacketsAhead()) {
+        return;
+    }
+    EditPacketDecodeBatch* batch = new EditPacketDecodeBatch();
+    SharedParallelBatchPointer sharedBatch(batch);
+    batch->tree = tree;
+    batch->packets = burst;
+    ParallelBatch::runInThreadPool(sharedBatch, burst.size(), burst.size() >= MIN_EDIT_PACKETS_FOR_THREAD_POOL);
+}
+
 void OctreeInboundPacketProcessor::processPacket(const SharedNodePointer& sendingNode, const QByteArray& packet) {
+    quint64 startLock = usecTimestampNow();
+    _myServer->getOctree()->lockForWrite();
+    quint64 lockWaitTime = usecTimestampNow() - startLock;
+    processEditPacket(sendingNode, packet, lockWaitTime);
+    _myServer->getOctree()->unlock();
+}
+
+void OctreeInboundPacketProcessor::processEditPacket(const SharedNodePointer& sendingNode, const QByteArray& packet,
+                                                     quint64 lockWaitTime) {
     if (_shuttingDown) {
         qDebug() << "OctreeInboundPacketProcessor::processPacket() while shutting down... ignoring incoming packet";
         return;
@@ -101,7 +188,6 @@ void OctreeInboundPacketProcessor::processPacket(const SharedNodePointer& sendin
         quint64 transitTime = arrivedAt - sentAt;
         int editsInPacket = 0;
         quint64 processTime = 0;
-        quint64 lockWaitTime = 0;
 
         if (debugProcessPacket || _myServer->wantsDebugReceiving()) {
             qDebug() << "PROCESSING THREAD: got '" << packetType << "' packet - " << _receivedPacketCount
@@ -139,8 +225,6 @@ void OctreeInboundPacketProcessor::processPacket(const SharedNodePointer& sendin
                         packetType, packetData, packet.size(), editData, atByte, maxSize);
             }
 
-            quint64 startLock = usecTimestampNow();
-            _myServer->getOctree()->lockForWrite();
             quint64 startProcess = usecTimestampNow();
             int editDataBytesRead = _myServer->getOctree()->processEditPacketData(packetType,
                                                                                   reinterpret_cast<const unsigned char*>(packet.data()),
@@ -152,14 +236,10 @@ void OctreeInboundPacketProcessor::processPacket(const SharedNodePointer& sendin
                                 << "editDataBytesRead=" << editDataBytesRead;
             }
 
-            _myServer->getOctree()->unlock();
             quint64 endProcess = usecTimestampNow();
 
             editsInPacket++;
-            quint64 thisProcessTime = endProcess - startProcess;
-            quint64 thisLockWaitTime = startProcess - startLock;
-            processTime += thisProcessTime;
-            lockWaitTime += thisLockWaitTime;
+            processTime += endProcess - startProcess;
 
             // skip to next voxel edit record in the packet
             editData += editDataBytesRead;
@@ -78,6 +78,9 @@ public:
 
 protected:
 
+    /// applies queued edit packets in bursts, each burst under a single write lock on the tree
+    virtual bool process();
+
     virtual void processPacket(const SharedNodePointer& sendingNode, const QByteArray& packet);
 
     virtual unsigned long getMaxWait() const;
@@ -88,6 +91,12 @@ private:
     int sendNackPackets();
 
 private:
+    /// lets the tree decode the edits in a burst of packets before it is locked, on the thread pool
+    void decodeEditPacketsAhead(const QVector<NetworkPacket>& burst);
+
+    /// applies the edits in one packet, the caller must hold the tree's write lock
+    void processEditPacket(const SharedNodePointer& sendingNode, const QByteArray& packet, quint64 lockWaitTime);
+
     void trackInboundPacket(const QUuid& nodeUUID, unsigned short int sequence, quint64 transitTime, 
             int voxelsInPacket, quint64 processTime, quint64 lockWaitTime);
 
@@ -14,7 +14,8 @@
 #include "OctreeQueryNode.h"
 #include <cstring>
 #include <cstdio>
-#include "OctreeSendThread.h"
+#include "OctreeSendTask.h"
+#include "OctreeSendWorkerPool.h"
 
 OctreeQueryNode::OctreeQueryNode() :
     _viewSent(false),
@@ -33,7 +34,8 @@ OctreeQueryNode::OctreeQueryNode() :
     _viewFrustumJustStoppedChanging(true),
     _currentPacketIsColor(true),
     _currentPacketIsCompressed(false),
-    _octreeSendThread(NULL),
+    _octreeSendTask(),
+    _sendWorkerPool(NULL),
     _lastClientBoundaryLevelAdjust(0),
     _lastClientOctreeSizeScale(DEFAULT_OCTREE_SIZE_SCALE),
     _lodChanged(false),
@@ -48,7 +50,7 @@ OctreeQueryNode::OctreeQueryNode() :
 
 OctreeQueryNode::~OctreeQueryNode() {
     _isShuttingDown = true;
-    if (_octreeSendThread) {
+    if (_octreeSendTask) {
         forceNodeShutdown();
     }
     
@@ -59,44 +61,39 @@ OctreeQueryNode::~OctreeQueryNode() {
 void OctreeQueryNode::nodeKilled() {
     _isShuttingDown = true;
     elementBag.unhookNotifications(); // if our node is shutting down, then we no longer need octree element notifications
-    if (_octreeSendThread) {
-        // just tell our thread we want to shutdown, this is asynchronous, and fast, we don't need or want it to block
-        // while the thread actually shuts down
-        _octreeSendThread->setIsShuttingDown();
+    if (_octreeSendTask) {
+        // just tell our task we want to shutdown, this is asynchronous, and fast, the worker that runs it next will
+        // drop it and let us know through sendTaskFinished()
+        _octreeSendTask->setIsShuttingDown();
     }
 }
 
 void OctreeQueryNode::forceNodeShutdown() {
     _isShuttingDown = true;
     elementBag.unhookNotifications(); // if our node is shutting down, then we no longer need octree element notifications
-    if (_octreeSendThread) {
-        // we really need to force our thread to shutdown, this is synchronous, we will block while the thread actually 
-        // shuts down because we really need it to shutdown, and it's ok if we wait for it to complete
-        OctreeSendThread* sendThread = _octreeSendThread;
-        _octreeSendThread = NULL;
-        sendThread->setIsShuttingDown();
-        sendThread->terminate();
-        delete sendThread;
+    if (_octreeSendTask) {
+        // we really need our task to stop, this is synchronous, we will block while a worker finishes running it
+        // because we really need it to stop, and it's ok if we wait for it to complete
+        SharedSendTaskPointer sendTask = _octreeSendTask;
+        _octreeSendTask.clear();
+        _sendWorkerPool->removeTask(sendTask);
     }
 }
 
-void OctreeQueryNode::sendThreadFinished() {
-    // We've been notified by our thread that it is shutting down. So we can clean up our reference to it, and
-    // delete the actual thread object. Cleaning up our thread will correctly unroll all refereces to shared
+void OctreeQueryNode::sendTaskFinished() {
+    // We've been notified that our task is done. Letting go of it correctly unrolls all references to shared
     // pointers to our node as well as the octree server assignment
-    if (_octreeSendThread) {
-        OctreeSendThread* sendThread = _octreeSendThread;
-        _octreeSendThread = NULL;
-        delete sendThread;
-    }
+    _octreeSendTask.clear();
 }
 
-void OctreeQueryNode::initializeOctreeSendThread(const SharedAssignmentPointer& myAssignment, const SharedNodePointer& node) {
-    _octreeSendThread = new OctreeSendThread(myAssignment, node);
-    
-    // we want to be notified when the thread finishes
-    connect(_octreeSendThread, &GenericThread::finished, this, &OctreeQueryNode::sendThreadFinished);
-    _octreeSendThread->initialize(true);
+void OctreeQueryNode::initializeOctreeSendTask(const SharedAssignmentPointer& myAssignment, const SharedNodePointer& node,
+                                               OctreeSendWorkerPool* sendWorkerPool) {
+    _octreeSendTask = SharedSendTaskPointer(new OctreeSendTask(myAssignment, node), &OctreeSendTask::deleteTask);
+    _sendWorkerPool = sendWorkerPool;
+
+    // we want to be notified when the task finishes
+    connect(_octreeSendTask.data(), &OctreeSendTask::finished, this, &OctreeQueryNode::sendTaskFinished);
+    _sendWorkerPool->addTask(_octreeSendTask);
 }
 
 bool OctreeQueryNode::packetIsDuplicate() const {
@@ -106,7 +103,7 @@ bool OctreeQueryNode::packetIsDuplicate() const {
     }
     // since our packets now include header information, like sequence number, and createTime, we can't just do a memcmp
     // of the entire packet, we need to compare only the packet content...
-    int numBytesPacketHeader = numBytesForPacketHeaderGivenPacketType(_myPacketType);
+    int numBytesPacketHeader = numBytesForPacketHeader(reinterpret_cast<const char*>(_octreePacket));
     
     if (_lastOctreePacketLength == getPacketLength()) {
         if (memcmp(_lastOctreePacket + (numBytesPacketHeader + OCTREE_PACKET_EXTRA_HEADERS_SIZE),
@@ -25,8 +25,10 @@
 #include <ThreadedAssignment.h> // for SharedAssignmentPointer
 #include "SentPacketHistory.h"
 #include <qqueue.h>
+#include <QSharedPointer>
 
-class OctreeSendThread;
+class OctreeSendTask;
+class OctreeSendWorkerPool;
 
 class OctreeQueryNode : public OctreeQuery {
     Q_OBJECT
@@ -89,8 +91,9 @@ public:
     
     OctreeSceneStats stats;
     
-    void initializeOctreeSendThread(const SharedAssignmentPointer& myAssignment, const SharedNodePointer& node);
-    bool isOctreeSendThreadInitalized() { return _octreeSendThread; }
+    void initializeOctreeSendTask(const SharedAssignmentPointer& myAssignment, const SharedNodePointer& node,
+                                  OctreeSendWorkerPool* sendWorkerPool);
+    bool isOctreeSendTaskInitalized() { return _octreeSendTask; }
     
     void dumpOutOfView();
     
@@ -114,7 +117,7 @@ public:
     const QByteArray* getNextNackedPacket();
 
 private slots:
-    void sendThreadFinished();
+    void sendTaskFinished();
     
 private:
     OctreeQueryNode(const OctreeQueryNode &);
@@ -141,7 +144,8 @@ private:
     bool _currentPacketIsColor;
     bool _currentPacketIsCompressed;
 
-    OctreeSendThread* _octreeSendThread;
+    QSharedPointer<OctreeSendTask> _octreeSendTask;
+    OctreeSendWorkerPool* _sendWorkerPool;
 
     // watch for LOD changes
     int _lastClientBoundaryLevelAdjust;
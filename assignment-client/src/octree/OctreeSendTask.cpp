@@ -1,5 +1,5 @@
 //
-//  OctreeSendThread.cpp
+//  OctreeSendTask.cpp
 //  assignment-client/src/octree
 //
 //  Created by Brad Hefta-Gaub on 8/21/13.
@@ -9,60 +9,68 @@
 //  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
 //
 
+#include <QtCore/QThread>
+
 #include <NodeList.h>
 #include <PacketHeaders.h>
 #include <PerfStat.h>
 #include <SharedUtil.h>
 
-#include "OctreeSendThread.h"
+#include "OctreeSendTask.h"
 #include "OctreeServer.h"
 #include "OctreeServerConsts.h"
 
-quint64 startSceneSleepTime = 0;
-quint64 endSceneSleepTime = 0;
-
-OctreeSendThread::OctreeSendThread(const SharedAssignmentPointer& myAssignment, const SharedNodePointer& node) :
+OctreeSendTask::OctreeSendTask(const SharedAssignmentPointer& myAssignment, const SharedNodePointer& node) :
     _myAssignment(myAssignment),
     _myServer(static_cast<OctreeServer*>(myAssignment.data())),
     _node(node),
     _nodeUUID(node->getUUID()),
     _packetData(),
     _nodeMissingCount(0),
-    _isShuttingDown(false)
+    _isShuttingDown(0),
+    _lastRunLockWaitUsecs(0)
 {
     QString safeServerName("Octree");
     if (_myServer) {
         safeServerName = _myServer->getMyServerName();
     }
     qDebug() << qPrintable(safeServerName)  << "server [" << _myServer << "]: client connected "
-                                            "- starting sending thread [" << this << "]";
+                                            "- starting send task [" << this << "]";
 
     OctreeServer::clientConnected();
 }
 
-OctreeSendThread::~OctreeSendThread() {
+OctreeSendTask::~OctreeSendTask() {
     QString safeServerName("Octree");
     if (_myServer) {
         safeServerName = _myServer->getMyServerName();
     }
     
     qDebug() << qPrintable(safeServerName)  << "server [" << _myServer << "]: client disconnected "
-                                            "- ending sending thread [" << this << "]";
+                                            "- ending send task [" << this << "]";
 
     OctreeServer::clientDisconnected();
-    OctreeServer::stopTrackingThread(this);
 
     _node.clear();
     _myAssignment.clear();
 }
 
-void OctreeSendThread::setIsShuttingDown() {
-    _isShuttingDown = true;
+void OctreeSendTask::deleteTask(OctreeSendTask* task) {
+    if (QThread::currentThread() == task->thread()) {
+        delete task;
+    } else {
+        task->deleteLater();
+    }
+}
+
+void OctreeSendTask::setIsShuttingDown() {
+    _isShuttingDown.storeRelease(1);
 }
 
+bool OctreeSendTask::run(int sendIntervals) {
+    _lastRunLockWaitUsecs = 0;
 
-bool OctreeSendThread::process() {
-    if (_isShuttingDown) {
+    if (isShuttingDown()) {
         return false; // exit early if we're shutting down
     }
 
@@ -71,10 +79,6 @@ bool OctreeSendThread::process() {
         return false; // exit early if it's not, it means the server is shutting down
     }
 
-    OctreeServer::didProcess(this);
-
-    quint64  start = usecTimestampNow();
-
     // don't do any send processing until the initial load of the octree is complete...
     if (_myServer->isInitialLoadComplete()) {
         if (_node) {
@@ -84,43 +88,19 @@ bool OctreeSendThread::process() {
             // Sometimes the node data has not yet been linked, in which case we can't really do anything
             if (nodeData && !nodeData->isShuttingDown()) {
                 bool viewFrustumChanged = nodeData->updateCurrentViewFrustum();
-                packetDistributor(nodeData, viewFrustumChanged);
+                packetDistributor(nodeData, viewFrustumChanged, sendIntervals);
             }
         }
     }
 
-    if (_isShuttingDown) {
-        return false; // exit early if we're shutting down
-    }
-
-    // Only sleep if we're still running and we got the lock last time we tried, otherwise try to get the lock asap
-    if (isStillRunning()) {
-        // dynamically sleep until we need to fire off the next set of octree elements
-        int elapsed = (usecTimestampNow() - start);
-        int usecToSleep =  OCTREE_SEND_INTERVAL_USECS - elapsed;
-
-        if (usecToSleep > 0) {
-            PerformanceWarning warn(false,"OctreeSendThread... usleep()",false,&_usleepTime,&_usleepCalls);
-            usleep(usecToSleep);
-        } else {
-            const int MIN_USEC_TO_SLEEP = 1;
-            usleep(MIN_USEC_TO_SLEEP);
-        }
-    }
-
-    return isStillRunning();  // keep running till they terminate us
+    return !isShuttingDown();
 }
 
-quint64 OctreeSendThread::_usleepTime = 0;
-quint64 OctreeSendThread::_usleepCalls = 0;
-
-quint64 OctreeSendThread::_totalBytes = 0;
-quint64 OctreeSendThread::_totalWastedBytes = 0;
-quint64 OctreeSendThread::_totalPackets = 0;
+quint64 OctreeSendTask::_totalBytes = 0;
+quint64 OctreeSendTask::_totalWastedBytes = 0;
+quint64 OctreeSendTask::_totalPackets = 0;
 
-int OctreeSendThread::handlePacketSend(OctreeQueryNode* nodeData, int& trueBytesSent, int& truePacketsSent) {
-    OctreeServer::didHandlePacketSend(this);
-                 
+int OctreeSendTask::handlePacketSend(OctreeQueryNode* nodeData, int& trueBytesSent, int& truePacketsSent) {
     // if we're shutting down, then exit early       
     if (nodeData->isShuttingDown()) {
         return 0;
@@ -178,12 +158,10 @@ int OctreeSendThread::handlePacketSend(OctreeQueryNode* nodeData, int& trueBytes
             }
 
             // actually send it
-            OctreeServer::didCallWriteDatagram(this);
             NodeList::getInstance()->writeDatagram((char*) statsMessage, statsMessageLength, _node);
             packetSent = true;
         } else {
             // not enough room in the packet, send two packets
-            OctreeServer::didCallWriteDatagram(this);
             NodeList::getInstance()->writeDatagram((char*) statsMessage, statsMessageLength, _node);
 
             // since a stats message is only included on end of scene, don't consider any of these bytes "wasted", since
@@ -212,7 +190,6 @@ int OctreeSendThread::handlePacketSend(OctreeQueryNode* nodeData, int& trueBytes
             truePacketsSent++;
             packetsSent++;
 
-            OctreeServer::didCallWriteDatagram(this);
             NodeList::getInstance()->writeDatagram((char*)nodeData->getPacket(), nodeData->getPacketLength(), _node);
             packetSent = true;
 
@@ -241,7 +218,6 @@ int OctreeSendThread::handlePacketSend(OctreeQueryNode* nodeData, int& trueBytes
         // If there's actually a packet waiting, then send it.
         if (nodeData->isPacketWaiting() && !nodeData->isShuttingDown()) {
             // just send the voxel packet
-            OctreeServer::didCallWriteDatagram(this);
             NodeList::getInstance()->writeDatagram((char*)nodeData->getPacket(), nodeData->getPacketLength(), _node);
             packetSent = true;
 
@@ -280,18 +256,16 @@ int OctreeSendThread::handlePacketSend(OctreeQueryNode* nodeData, int& trueBytes
 }
 
 /// Version of voxel distributor that sends the deepest LOD level at once
-int OctreeSendThread::packetDistributor(OctreeQueryNode* nodeData, bool viewFrustumChanged) {
-        
-    OctreeServer::didPacketDistributor(this);
-
+int OctreeSendTask::packetDistributor(OctreeQueryNode* nodeData, bool viewFrustumChanged, int sendIntervals) {
     // if shutting down, exit early
     if (nodeData->isShuttingDown()) {
         return 0;
     }
     
-    // calculate max number of packets that can be sent during this interval
+    // calculate max number of packets that can be sent during the intervals this run covers
     int clientMaxPacketsPerInterval = std::max(1, (nodeData->getMaxOctreePacketsPerSecond() / INTERVALS_PER_SECOND));
-    int maxPacketsPerInterval = std::min(clientMaxPacketsPerInterval, _myServer->getPacketsPerClientPerInterval());
+    int maxPacketsPerInterval = std::min(clientMaxPacketsPerInterval, _myServer->getPacketsPerClientPerInterval())
+        * sendIntervals;
 
     int truePacketsSent = 0;
     int trueBytesSent = 0;
@@ -351,12 +325,6 @@ int OctreeSendThread::packetDistributor(OctreeQueryNode* nodeData, bool viewFrus
         nodeData->setLastRootTimestamp(_myServer->getOctree()->getRoot()->getLastChanged());
         _myServer->getOctree()->releaseSceneEncodeData(&nodeData->extraEncodeData);
 
-        // TODO: add these to stats page
-        //::endSceneSleepTime = _usleepTime;
-        //unsigned long sleepTime = ::endSceneSleepTime - ::startSceneSleepTime;
-        //unsigned long encodeTime = nodeData->stats.getTotalEncodeTime();
-        //unsigned long elapsedTime = nodeData->stats.getElapsedTime();
-
         int packetsJustSent = handlePacketSend(nodeData, trueBytesSent, truePacketsSent);
         packetsSentThisInterval += packetsJustSent;
 
@@ -365,11 +333,10 @@ int OctreeSendThread::packetDistributor(OctreeQueryNode* nodeData, bool viewFrus
             nodeData->elementBag.deleteAll();
         }
 
-        // TODO: add these to stats page
-        //::startSceneSleepTime = _usleepTime;
-        
-        // start tracking our stats
+        // start tracking our stats, the jurisdiction only changes under the tree's write lock
+        _myServer->getOctree()->lockForRead();
         nodeData->stats.sceneStarted(isFullScene, viewFrustumChanged, _myServer->getOctree()->getRoot(), _myServer->getJurisdiction());
+        _myServer->getOctree()->unlock();
 
         // This is the start of "resending" the scene.
         bool dontRestartSceneOnMove = false; // this is experimental
@@ -452,6 +419,7 @@ int OctreeSendThread::packetDistributor(OctreeQueryNode* nodeData, bool viewFrus
                 _myServer->getOctree()->lockForRead();
                 quint64 lockWaitEnd = usecTimestampNow();
                 lockWaitElapsedUsec = (float)(lockWaitEnd - lockWaitStart);
+                _lastRunLockWaitUsecs += lockWaitEnd - lockWaitStart;
 
                 quint64 encodeStart = usecTimestampNow();
 
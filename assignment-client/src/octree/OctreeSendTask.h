@@ -0,0 +1,76 @@
+//
+//  OctreeSendTask.h
+//  assignment-client/src/octree
+//
+//  Created by Brad Hefta-Gaub on 8/21/13.
+//  Copyright 2013 High Fidelity, Inc.
+//
+//  Object for sending voxels to a client, run by the send worker pool
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_OctreeSendTask_h
+#define hifi_OctreeSendTask_h
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QObject>
+#include <QtCore/QSharedPointer>
+
+#include <NetworkPacket.h>
+#include <OctreeElementBag.h>
+
+#include "OctreeQueryNode.h"
+
+class OctreeServer;
+
+/// Sends voxel packets to a single client, one send interval at a time. The tasks of all clients are run by the
+/// server's OctreeSendWorkerPool rather than each on a thread of its own.
+class OctreeSendTask : public QObject {
+    Q_OBJECT
+public:
+    OctreeSendTask(const SharedAssignmentPointer& myAssignment, const SharedNodePointer& node);
+    virtual ~OctreeSendTask();
+
+    void setIsShuttingDown();
+    bool isShuttingDown() const { return _isShuttingDown.loadAcquire(); }
+
+    /// Sends what our client should get for sendIntervals send intervals, one unless the pool got to us late.
+    /// Returns false once the task is done and shouldn't be run again.
+    bool run(int sendIntervals);
+
+    /// how long the last run() waited on the tree's lock
+    quint64 getLastRunLockWaitUsecs() const { return _lastRunLockWaitUsecs; }
+
+    /// deleter for shared pointers to tasks, the last reference may be dropped on a worker but the task goes away on
+    /// the thread it was created on, along with its references to the node and the assignment
+    static void deleteTask(OctreeSendTask* task);
+
+    static quint64 _totalBytes;
+    static quint64 _totalWastedBytes;
+    static quint64 _totalPackets;
+
+signals:
+    /// emitted from the worker that found the task done
+    void finished();
+
+private:
+    SharedAssignmentPointer _myAssignment;
+    OctreeServer* _myServer;
+    SharedNodePointer _node;
+    QUuid _nodeUUID;
+
+    int handlePacketSend(OctreeQueryNode* nodeData, int& trueBytesSent, int& truePacketsSent);
+    int packetDistributor(OctreeQueryNode* nodeData, bool viewFrustumChanged, int sendIntervals);
+
+    OctreePacketData _packetData;
+    
+    int _nodeMissingCount;
+    QAtomicInt _isShuttingDown; // set by whoever removes the task, read by the worker running it
+    quint64 _lastRunLockWaitUsecs;
+};
+
+typedef QSharedPointer<OctreeSendTask> SharedSendTaskPointer;
+
+#endif // hifi_OctreeSendTask_h
@@ -0,0 +1,252 @@
+//
+//  OctreeSendWorkerPool.cpp
+//  assignment-client/src/octree
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <algorithm>
+
+#include <QtCore/QLocale>
+
+#include <SharedUtil.h>
+
+#include "OctreeServerConsts.h"
+#include "OctreeSendWorkerPool.h"
+
+// upper bounds of the histogram buckets, the last bucket takes everything longer
+const quint64 BUCKET_LIMITS_USECS[UsecsHistogram::NUMBER_OF_BUCKETS - 1] = {
+    100, 250, 500, 1000, 2500, 5000, 10000, 25000
+};
+
+// a task that comes up late is given the packets of the intervals it missed, but no more than this many intervals
+const int MAX_CATCH_UP_INTERVALS = 3;
+
+void UsecsHistogram::addSample(quint64 usecs) {
+    int bucket = 0;
+    while (bucket < NUMBER_OF_BUCKETS - 1 && usecs >= BUCKET_LIMITS_USECS[bucket]) {
+        bucket++;
+    }
+    _bucketCounts[bucket]++;
+}
+
+void UsecsHistogram::reset() {
+    for (int i = 0; i < NUMBER_OF_BUCKETS; i++) {
+        _bucketCounts[i] = 0;
+    }
+}
+
+quint64 UsecsHistogram::getSampleCount() const {
+    quint64 sampleCount = 0;
+    for (int i = 0; i < NUMBER_OF_BUCKETS; i++) {
+        sampleCount += _bucketCounts[i];
+    }
+    return sampleCount;
+}
+
+QString UsecsHistogram::getBucketName(int bucket) {
+    quint64 limit = BUCKET_LIMITS_USECS[std::min(bucket, NUMBER_OF_BUCKETS - 2)];
+    QString limitString = (limit < USECS_PER_MSEC) ? QString("%1us").arg(limit)
+        : QString("%1ms").arg((float)limit / USECS_PER_MSEC);
+    return ((bucket < NUMBER_OF_BUCKETS - 1) ? "<" : ">=") + limitString;
+}
+
+OctreeSendWorker::OctreeSendWorker(OctreeSendWorkerPool* pool) :
+    _pool(pool),
+    _runTimes(),
+    _lockWaitTimes(),
+    _lateRuns(0)
+{
+}
+
+void OctreeSendWorker::getStats(UsecsHistogram& runTimes, UsecsHistogram& lockWaitTimes, quint64& lateRuns) {
+    QMutexLocker locker(&_statsMutex);
+    runTimes = _runTimes;
+    lockWaitTimes = _lockWaitTimes;
+    lateRuns = _lateRuns;
+}
+
+void OctreeSendWorker::resetStats() {
+    QMutexLocker locker(&_statsMutex);
+    _runTimes.reset();
+    _lockWaitTimes.reset();
+    _lateRuns = 0;
+}
+
+bool OctreeSendWorker::process() {
+    quint64 dueAt = 0;
+    SharedSendTaskPointer task = _pool->takeDueTask(dueAt);
+    if (!task) {
+        return false; // the pool is stopping
+    }
+
+    quint64 start = usecTimestampNow();
+
+    // a task we got to late sends what it would have sent in the intervals it missed, so when the pool falls behind
+    // every client's updates slow down evenly instead of the clients at the back of the queue starving
+    int sendIntervals = std::min(MAX_CATCH_UP_INTERVALS, 1 + (int)((start - dueAt) / OCTREE_SEND_INTERVAL_USECS));
+
+    bool keepRunning = task->run(sendIntervals);
+
+    quint64 end = usecTimestampNow();
+    _statsMutex.lock();
+    if (sendIntervals > 1) {
+        _lateRuns++;
+    }
+    _runTimes.addSample(end - start);
+    _lockWaitTimes.addSample(task->getLastRunLockWaitUsecs());
+    _statsMutex.unlock();
+
+    // the next run is an interval after this one was due, or after it started if it already made up for lost time
+    quint64 nextDueAt = ((sendIntervals > 1) ? start : dueAt) + OCTREE_SEND_INTERVAL_USECS;
+    _pool->returnTask(task, nextDueAt, keepRunning);
+
+    return isStillRunning();
+}
+
+OctreeSendWorkerPool::OctreeSendWorkerPool(int workerCount) :
+    _isStopping(false)
+{
+    for (int i = 0; i < workerCount; i++) {
+        OctreeSendWorker* worker = new OctreeSendWorker(this);
+        worker->initialize(true);
+        _workers.append(worker);
+    }
+}
+
+OctreeSendWorkerPool::~OctreeSendWorkerPool() {
+    _mutex.lock();
+    _isStopping = true;
+    _runQueue.clear();
+    _taskQueued.wakeAll();
+    _mutex.unlock();
+
+    foreach (OctreeSendWorker* worker, _workers) {
+        worker->terminate();
+        delete worker;
+    }
+}
+
+void OctreeSendWorkerPool::addTask(const SharedSendTaskPointer& task) {
+    QMutexLocker locker(&_mutex);
+    _runQueue.insert(usecTimestampNow(), task);
+    _taskQueued.wakeOne();
+}
+
+void OctreeSendWorkerPool::removeTask(const SharedSendTaskPointer& task) {
+    // a worker that is running the task won't queue it again once it's shutting down
+    task->setIsShuttingDown();
+
+    QMutexLocker locker(&_mutex);
+    QMultiMap<quint64, SharedSendTaskPointer>::iterator queuedTask = _runQueue.begin();
+    while (queuedTask != _runQueue.end()) {
+        if (queuedTask.value() == task) {
+            queuedTask = _runQueue.erase(queuedTask);
+        } else {
+            ++queuedTask;
+        }
+    }
+
+    while (_runningTasks.contains(task.data())) {
+        _taskReturned.wait(&_mutex);
+    }
+}
+
+int OctreeSendWorkerPool::getTaskCount() {
+    QMutexLocker locker(&_mutex);
+    return _runQueue.size() + _runningTasks.size();
+}
+
+quint64 OctreeSendWorkerPool::getLateRuns() {
+    quint64 lateRuns = 0;
+    foreach (OctreeSendWorker* worker, _workers) {
+        UsecsHistogram runTimes;
+        UsecsHistogram lockWaitTimes;
+        quint64 workerLateRuns;
+        worker->getStats(runTimes, lockWaitTimes, workerLateRuns);
+        lateRuns += workerLateRuns;
+    }
+    return lateRuns;
+}
+
+void OctreeSendWorkerPool::resetStats() {
+    foreach (OctreeSendWorker* worker, _workers) {
+        worker->resetStats();
+    }
+}
+
+QString OctreeSendWorkerPool::getStatsString() {
+    const int NAME_WIDTH = 20;
+    const int COLUMN_WIDTH = 9;
+    QLocale locale(QLocale::English);
+
+    QString statsString = QString(NAME_WIDTH, ' ');
+    for (int bucket = 0; bucket < UsecsHistogram::NUMBER_OF_BUCKETS; bucket++) {
+        statsString += UsecsHistogram::getBucketName(bucket).rightJustified(COLUMN_WIDTH, ' ');
+    }
+    statsString += QString("late runs").rightJustified(COLUMN_WIDTH + 3, ' ') + "\r\n";
+
+    for (int i = 0; i < _workers.size(); i++) {
+        UsecsHistogram runTimes;
+        UsecsHistogram lockWaitTimes;
+        quint64 lateRuns;
+        _workers[i]->getStats(runTimes, lockWaitTimes, lateRuns);
+
+        statsString += QString("  worker %1 run time").arg(i).leftJustified(NAME_WIDTH, ' ');
+        for (int bucket = 0; bucket < UsecsHistogram::NUMBER_OF_BUCKETS; bucket++) {
+            statsString += locale.toString(runTimes.getBucketCount(bucket)).rightJustified(COLUMN_WIDTH, ' ');
+        }
+        statsString += locale.toString(lateRuns).rightJustified(COLUMN_WIDTH + 3, ' ') + "\r\n";
+
+        statsString += QString("           lock wait").leftJustified(NAME_WIDTH, ' ');
+        for (int bucket = 0; bucket < UsecsHistogram::NUMBER_OF_BUCKETS; bucket++) {
+            statsString += locale.toString(lockWaitTimes.getBucketCount(bucket)).rightJustified(COLUMN_WIDTH, ' ');
+        }
+        statsString += "\r\n";
+    }
+    return statsString;
+}
+
+SharedSendTaskPointer OctreeSendWorkerPool::takeDueTask(quint64& dueAt) {
+    QMutexLocker locker(&_mutex);
+    while (!_isStopping) {
+        if (_runQueue.isEmpty()) {
+            _taskQueued.wait(&_mutex);
+            continue;
+        }
+
+        QMultiMap<quint64, SharedSendTaskPointer>::iterator nextTask = _runQueue.begin();
+        quint64 now = usecTimestampNow();
+        if (nextTask.key() > now) {
+            // sleep until it's due, or until a task that's due sooner is queued
+            _taskQueued.wait(&_mutex, (nextTask.key() - now) / USECS_PER_MSEC + 1);
+            continue;
+        }
+
+        dueAt = nextTask.key();
+        SharedSendTaskPointer task = nextTask.value();
+        _runQueue.erase(nextTask);
+        _runningTasks.insert(task.data());
+        return task;
+    }
+    return SharedSendTaskPointer();
+}
+
+void OctreeSendWorkerPool::returnTask(SharedSendTaskPointer& task, quint64 nextDueAt, bool keepRunning) {
+    QMutexLocker locker(&_mutex);
+    _runningTasks.remove(task.data());
+
+    if (keepRunning && !task->isShuttingDown() && !_isStopping) {
+        _runQueue.insert(nextDueAt, task);
+        _taskQueued.wakeOne();
+    } else {
+        // let the owner of the task know while we still hold it, the owner's reference may be the last one after that
+        emit task->finished();
+    }
+
+    task.clear();
+    _taskReturned.wakeAll();
+}
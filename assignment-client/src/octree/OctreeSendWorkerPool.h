@@ -0,0 +1,110 @@
+//
+//  OctreeSendWorkerPool.h
+//  assignment-client/src/octree
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_OctreeSendWorkerPool_h
+#define hifi_OctreeSendWorkerPool_h
+
+#include <QtCore/QMultiMap>
+#include <QtCore/QMutex>
+#include <QtCore/QSet>
+#include <QtCore/QVector>
+#include <QtCore/QWaitCondition>
+
+#include <GenericThread.h>
+
+#include "OctreeSendTask.h"
+
+class OctreeSendWorkerPool;
+
+/// Counts times in usecs in a few fixed buckets, cheap enough to update on every run of a send task
+class UsecsHistogram {
+public:
+    static const int NUMBER_OF_BUCKETS = 9;
+
+    UsecsHistogram() { reset(); }
+
+    void addSample(quint64 usecs);
+    void reset();
+
+    quint64 getBucketCount(int bucket) const { return _bucketCounts[bucket]; }
+    quint64 getSampleCount() const;
+
+    /// the short name of a bucket, like "<1ms"
+    static QString getBucketName(int bucket);
+
+private:
+    quint64 _bucketCounts[NUMBER_OF_BUCKETS];
+};
+
+/// One of the threads of the pool, runs whichever send task is due next
+class OctreeSendWorker : public GenericThread {
+    Q_OBJECT
+public:
+    OctreeSendWorker(OctreeSendWorkerPool* pool);
+
+    /// copies the stats, which the worker updates as it runs tasks
+    void getStats(UsecsHistogram& runTimes, UsecsHistogram& lockWaitTimes, quint64& lateRuns);
+    void resetStats();
+
+protected:
+    virtual bool process();
+
+private:
+    OctreeSendWorkerPool* _pool;
+
+    QMutex _statsMutex;
+    UsecsHistogram _runTimes;
+    UsecsHistogram _lockWaitTimes;
+    quint64 _lateRuns;
+};
+
+/// Runs the send tasks of all the clients of an octree server on a fixed number of threads. Each task is due once per
+/// send interval, and the workers always take the task that has been due the longest, so when the pool can't keep
+/// up every client slows down by the same amount.
+class OctreeSendWorkerPool {
+public:
+    OctreeSendWorkerPool(int workerCount);
+    ~OctreeSendWorkerPool();
+
+    /// starts running a task, its first run is due now
+    void addTask(const SharedSendTaskPointer& task);
+
+    /// stops running a task, waits for a worker that's in the middle of running it to finish
+    void removeTask(const SharedSendTaskPointer& task);
+
+    int getWorkerCount() const { return _workers.size(); }
+    int getTaskCount();
+
+    quint64 getLateRuns();
+    void resetStats();
+
+    /// a table of run time and lock wait histograms for each worker, for the server's status page
+    QString getStatsString();
+
+private:
+    friend class OctreeSendWorker;
+
+    /// blocks until a task is due and returns it, or returns a null pointer once the pool is stopping
+    SharedSendTaskPointer takeDueTask(quint64& dueAt);
+
+    /// gives a task back after running it, it's queued again unless it's done. Clears the caller's reference.
+    void returnTask(SharedSendTaskPointer& task, quint64 nextDueAt, bool keepRunning);
+
+    QMutex _mutex;
+    QWaitCondition _taskQueued;
+    QWaitCondition _taskReturned;
+    QMultiMap<quint64, SharedSendTaskPointer> _runQueue; // keyed by when the task is due
+    QSet<OctreeSendTask*> _runningTasks;
+    bool _isStopping;
+
+    QVector<OctreeSendWorker*> _workers;
+};
+
+#endif // hifi_OctreeSendWorkerPool_h
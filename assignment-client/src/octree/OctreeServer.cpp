@@ -9,8 +9,11 @@
 //  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
 //
 
+#include <QDataStream>
+#include <QFile>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QThread>
 #include <QTimer>
 #include <QUuid>
 
@@ -234,8 +237,12 @@ OctreeServer::OctreeServer(const QByteArray& packet) :
     _verboseDebug(false),
     _jurisdiction(NULL),
     _jurisdictionSender(NULL),
+    _subtreeTransferSender(NULL),
+    _nextSubtreeTransferID(0),
+    _hasOutgoingSubtreeTransfer(false),
     _octreeInboundPacketProcessor(NULL),
     _persistThread(NULL),
+    _sendWorkerPool(NULL),
     _started(time(0)),
     _startedUSecs(usecTimestampNow())
 {
@@ -268,6 +275,11 @@ OctreeServer::~OctreeServer() {
         _jurisdictionSender->deleteLater();
     }
 
+    if (_subtreeTransferSender) {
+        _subtreeTransferSender->terminate();
+        _subtreeTransferSender->deleteLater();
+    }
+
     if (_octreeInboundPacketProcessor) {
         _octreeInboundPacketProcessor->terminate();
         _octreeInboundPacketProcessor->deleteLater();
@@ -278,6 +290,10 @@ OctreeServer::~OctreeServer() {
         _persistThread->deleteLater();
     }
 
+    // every client's send task was removed from the pool in aboutToFinish(), or we wouldn't be here
+    delete _sendWorkerPool;
+    _sendWorkerPool = NULL;
+
     delete _jurisdiction;
     _jurisdiction = NULL;
     
@@ -329,6 +345,7 @@ bool OctreeServer::handleHTTPRequest(HTTPConnection* connection, const QUrl& url
             showStats = true;
         } else if (url.path() == "/resetStats") {
             _octreeInboundPacketProcessor->resetStats();
+            _sendWorkerPool->resetStats();
             resetSendingStats();
             showStats = true;
         }
@@ -413,9 +430,9 @@ bool OctreeServer::handleHTTPRequest(HTTPConnection* connection, const QUrl& url
         statsString += QString("<b>%1 Outbound Packet Statistics... "
                                 "<a href='/resetStats'>[RESET]</a></b>\r\n").arg(getMyServerName());
 
-        quint64 totalOutboundPackets = OctreeSendThread::_totalPackets;
-        quint64 totalOutboundBytes = OctreeSendThread::_totalBytes;
-        quint64 totalWastedBytes = OctreeSendThread::_totalWastedBytes;
+        quint64 totalOutboundPackets = OctreeSendTask::_totalPackets;
+        quint64 totalOutboundBytes = OctreeSendTask::_totalBytes;
+        quint64 totalWastedBytes = OctreeSendTask::_totalWastedBytes;
         quint64 totalBytesOfOctalCodes = OctreePacketData::getTotalBytesOfOctalCodes();
         quint64 totalBytesOfBitMasks = OctreePacketData::getTotalBytesOfBitMasks();
         quint64 totalBytesOfColor = OctreePacketData::getTotalBytesOfColor();
@@ -423,16 +440,10 @@ bool OctreeServer::handleHTTPRequest(HTTPConnection* connection, const QUrl& url
         statsString += QString("          Total Clients Connected: %1 clients\r\n")
             .arg(locale.toString((uint)getCurrentClientCount()).rightJustified(COLUMN_WIDTH, ' '));
 
-        quint64 oneSecondAgo = usecTimestampNow() - USECS_PER_SECOND;
-        
-        statsString += QString("            process() last second: %1 clients\r\n")
-            .arg(locale.toString((uint)howManyThreadsDidProcess(oneSecondAgo)).rightJustified(COLUMN_WIDTH, ' '));
-        statsString += QString("  packetDistributor() last second: %1 clients\r\n")
-            .arg(locale.toString((uint)howManyThreadsDidPacketDistributor(oneSecondAgo)).rightJustified(COLUMN_WIDTH, ' '));
-        statsString += QString("   handlePacketSend() last second: %1 clients\r\n")
-            .arg(locale.toString((uint)howManyThreadsDidHandlePacketSend(oneSecondAgo)).rightJustified(COLUMN_WIDTH, ' '));
-        statsString += QString("      writeDatagram() last second: %1 clients\r\n\r\n")
-            .arg(locale.toString((uint)howManyThreadsDidCallWriteDatagram(oneSecondAgo)).rightJustified(COLUMN_WIDTH, ' '));
+        statsString += QString("             Send Workers Running: %1 workers\r\n\r\n")
+            .arg(locale.toString((uint)_sendWorkerPool->getWorkerCount()).rightJustified(COLUMN_WIDTH, ' '));
+        statsString += _sendWorkerPool->getStatsString();
+        statsString += "\r\n";
 
         float averageLoopTime = getAverageLoopTime();
         statsString += QString().sprintf("           Average packetLoop() time:      %7.2f msecs"
@@ -840,14 +851,14 @@ void OctreeServer::readPendingDatagram(const QByteArray& receivedPacket, const H
             if (matchingNode) {
                 nodeList->updateNodeWithDataFromPacket(matchingNode, receivedPacket);
                 OctreeQueryNode* nodeData = (OctreeQueryNode*)matchingNode->getLinkedData();
-                if (nodeData && !nodeData->isOctreeSendThreadInitalized()) {
+                if (nodeData && !nodeData->isOctreeSendTaskInitalized()) {
                     
-                    // NOTE: this is an important aspect of the proper ref counting. The send threads/node data need to 
+                    // NOTE: this is an important aspect of the proper ref counting. The send tasks/node data need to 
                     // know that the OctreeServer/Assignment will not get deleted on it while it's still active. The 
                     // solution is to get the shared pointer for the current assignment. We need to make sure this is the 
                     // same SharedAssignmentPointer that was ref counted by the assignment client.                    
                     SharedAssignmentPointer sharedAssignment = AssignmentClient::getCurrentAssignment();
-                    nodeData->initializeOctreeSendThread(sharedAssignment, matchingNode);
+                    nodeData->initializeOctreeSendTask(sharedAssignment, matchingNode, _sendWorkerPool);
                 }
             }
         } else if (packetType == PacketTypeOctreeDataNack) {
@@ -861,6 +872,15 @@ void OctreeServer::readPendingDatagram(const QByteArray& receivedPacket, const H
             }
         } else if (packetType == PacketTypeJurisdictionRequest) {
             _jurisdictionSender->queueReceivedPacket(matchingNode, receivedPacket);
+        } else if (packetType == PacketTypeJurisdictionHandoff) {
+            // only the domain-server decides who owns what
+            if (senderSockAddr == nodeList->getDomainHandler().getSockAddr()) {
+                handleJurisdictionHandoff(receivedPacket);
+            }
+        } else if (packetType == PacketTypeOctreeSubtreeTransfer) {
+            handleSubtreeTransfer(receivedPacket, matchingNode);
+        } else if (packetType == PacketTypeOctreeSubtreeTransferAck) {
+            handleSubtreeTransferAck(receivedPacket, matchingNode);
         } else if (_octreeInboundPacketProcessor && getOctree()->handlesEditPacketType(packetType)) {
             _octreeInboundPacketProcessor->queueReceivedPacket(matchingNode, receivedPacket);
         } else {
@@ -964,7 +984,12 @@ void OctreeServer::run() {
             qDebug("jurisdictionEndNodes=%s", jurisdictionEndNodes);
         }
 
-        if (jurisdictionRoot || jurisdictionEndNodes) {
+        // a spare server owns no part of the tree until the domain-server hands it a region
+        const char* JURISDICTION_SPARE = "--jurisdictionSpare";
+        if (cmdOptionExists(_argc, _argv, JURISDICTION_SPARE)) {
+            qDebug("jurisdictionSpare=true");
+            _jurisdiction = new JurisdictionMap("00", "00");
+        } else if (jurisdictionRoot || jurisdictionEndNodes) {
             _jurisdiction = new JurisdictionMap(jurisdictionRoot, jurisdictionEndNodes);
         }
     }
@@ -1020,6 +1045,15 @@ void OctreeServer::run() {
 
         qDebug("persistFilename=%s", _persistFilename);
 
+        // once the domain-server has moved regions around, the persist file only holds what we owned when we stopped,
+        // so the jurisdiction saved next to it wins over the configured one
+        _jurisdictionFilename = QString(_persistFilename) + ".jurisdiction";
+        if (canTransferRegions() && QFile::exists(_jurisdictionFilename)) {
+            qDebug() << "reading jurisdiction from" << _jurisdictionFilename;
+            delete _jurisdiction;
+            _jurisdiction = new JurisdictionMap(_jurisdictionFilename.toLocal8Bit().constData());
+        }
+
         // now set up PersistThread
         _persistThread = new OctreePersistThread(_tree, _persistFilename);
         if (_persistThread) {
@@ -1062,6 +1096,25 @@ void OctreeServer::run() {
     qDebug("packetsPerSecondTotalMax=%s _packetsTotalPerInterval=%d", 
                     packetsPerSecondTotalMax, _packetsTotalPerInterval);
 
+    // Check to see if the user passed in a command line option for the number of send workers, one per core by default
+    int sendWorkerCount = std::max(1, QThread::idealThreadCount());
+    const char* SEND_WORKERS = "--sendWorkers";
+    const char* sendWorkers = getCmdOption(_argc, _argv, SEND_WORKERS);
+    if (sendWorkers) {
+        sendWorkerCount = std::max(1, atoi(sendWorkers));
+    }
+    qDebug("sendWorkers=%s sendWorkerCount=%d", sendWorkers, sendWorkerCount);
+    _sendWorkerPool = new OctreeSendWorkerPool(sendWorkerCount);
+
+    // Check to see if the user passed in a command line option for the zlib level of compressed packets, lower levels
+    // trade bandwidth for send task time
+    const char* COMPRESSION_LEVEL = "--compressionLevel";
+    const char* compressionLevel = getCmdOption(_argc, _argv, COMPRESSION_LEVEL);
+    if (compressionLevel) {
+        OctreePacketData::setCompressionLevel(std::min(9, std::max(1, atoi(compressionLevel))));
+    }
+    qDebug("compressionLevel=%s packet compression level=%d", compressionLevel, OctreePacketData::getCompressionLevel());
+
     HifiSockAddr senderSockAddr;
 
     // set up our jurisdiction broadcaster...
@@ -1071,6 +1124,13 @@ void OctreeServer::run() {
     _jurisdictionSender = new JurisdictionSender(_jurisdiction, getMyNodeType());
     _jurisdictionSender->initialize(true);
 
+    if (canTransferRegions()) {
+        // servers of our type hand regions to each other directly
+        nodeList->addNodeTypeToInterestSet(getMyNodeType());
+        _subtreeTransferSender = new PacketSender(SUBTREE_TRANSFER_PACKETS_PER_SECOND);
+        _subtreeTransferSender->initialize(true);
+    }
+
     // set up our OctreeServerPacketProcessor
     _octreeInboundPacketProcessor = new OctreeInboundPacketProcessor(this);
     _octreeInboundPacketProcessor->initialize(true);
@@ -1262,15 +1322,9 @@ void OctreeServer::sendStatsPacket() {
     statsObject1[baseName + QString(".0.4.persistFileLoadTime")] = getFileLoadTime();
     statsObject1[baseName + QString(".0.5.clients")] = getCurrentClientCount();
     
-    quint64 oneSecondAgo = usecTimestampNow() - USECS_PER_SECOND;
-    
-    statsObject1[baseName + QString(".0.6.threads.1.processing")] = (double)howManyThreadsDidProcess(oneSecondAgo);
-    statsObject1[baseName + QString(".0.6.threads.2.packetDistributor")] = 
-        (double)howManyThreadsDidPacketDistributor(oneSecondAgo);
-    statsObject1[baseName + QString(".0.6.threads.3.handlePacektSend")] = 
-        (double)howManyThreadsDidHandlePacketSend(oneSecondAgo);
-    statsObject1[baseName + QString(".0.6.threads.4.writeDatagram")] = 
-        (double)howManyThreadsDidCallWriteDatagram(oneSecondAgo);    
+    statsObject1[baseName + QString(".0.6.sendWorkers.1.workers")] = (double)_sendWorkerPool->getWorkerCount();
+    statsObject1[baseName + QString(".0.6.sendWorkers.2.tasks")] = (double)_sendWorkerPool->getTaskCount();
+    statsObject1[baseName + QString(".0.6.sendWorkers.3.lateRuns")] = (double)_sendWorkerPool->getLateRuns();
     
     statsObject1[baseName + QString(".1.1.octree.elementCount")] = (double)OctreeElement::getNodeCount();
     statsObject1[baseName + QString(".1.2.octree.internalElementCount")] = (double)OctreeElement::getInternalNodeCount();
@@ -1280,9 +1334,9 @@ void OctreeServer::sendStatsPacket() {
 
     static QJsonObject statsObject2;
 
-    statsObject2[baseName + QString(".2.outbound.data.totalPackets")] = (double)OctreeSendThread::_totalPackets;
-    statsObject2[baseName + QString(".2.outbound.data.totalBytes")] = (double)OctreeSendThread::_totalBytes;
-    statsObject2[baseName + QString(".2.outbound.data.totalBytesWasted")] = (double)OctreeSendThread::_totalWastedBytes;
+    statsObject2[baseName + QString(".2.outbound.data.totalPackets")] = (double)OctreeSendTask::_totalPackets;
+    statsObject2[baseName + QString(".2.outbound.data.totalBytes")] = (double)OctreeSendTask::_totalBytes;
+    statsObject2[baseName + QString(".2.outbound.data.totalBytesWasted")] = (double)OctreeSendTask::_totalWastedBytes;
     statsObject2[baseName + QString(".2.outbound.data.totalBytesOctalCodes")] = 
         (double)OctreePacketData::getTotalBytesOfOctalCodes();
     statsObject2[baseName + QString(".2.outbound.data.totalBytesBitMasks")] = 
@@ -1317,85 +1371,595 @@ void OctreeServer::sendStatsPacket() {
         (double)_octreeInboundPacketProcessor->getAverageLockWaitTimePerElement();
 
     NodeList::getInstance()->sendStatsToDomainServer(statsObject3);
+
+    if (canTransferRegions()) {
+        sendJurisdictionLoadToDomainServer();
+        checkSubtreeTransfers();
+    }
 }
 
-QMap<OctreeSendThread*, quint64> OctreeServer::_threadsDidProcess;
-QMap<OctreeSendThread*, quint64> OctreeServer::_threadsDidPacketDistributor;
-QMap<OctreeSendThread*, quint64> OctreeServer::_threadsDidHandlePacketSend;
-QMap<OctreeSendThread*, quint64> OctreeServer::_threadsDidCallWriteDatagram;
+const quint64 SUBTREE_TRANSFER_TIMEOUT_USECS = 30 * USECS_PER_SECOND;
 
-QMutex OctreeServer::_threadsDidProcessMutex;
-QMutex OctreeServer::_threadsDidPacketDistributorMutex;
-QMutex OctreeServer::_threadsDidHandlePacketSendMutex;
-QMutex OctreeServer::_threadsDidCallWriteDatagramMutex;
+static QByteArray byteArrayForOctalCode(const unsigned char* octalCode) {
+    return QByteArray(reinterpret_cast<const char*>(octalCode),
+                      bytesRequiredForCodeLength(numberOfThreeBitSectionsInCode(octalCode)));
+}
 
+static const unsigned char* octalCodeForByteArray(const QByteArray& octalCode) {
+    return reinterpret_cast<const unsigned char*>(octalCode.constData());
+}
 
-void OctreeServer::didProcess(OctreeSendThread* thread) {
-    QMutexLocker locker(&_threadsDidProcessMutex);
-    _threadsDidProcess[thread] = usecTimestampNow();
+static bool isValidOctalCode(const QByteArray& octalCode) {
+    const unsigned char MAX_SECTIONS_IN_SINGLE_BYTE_LENGTH = 254;
+    return !octalCode.isEmpty() && (unsigned char)octalCode[0] <= MAX_SECTIONS_IN_SINGLE_BYTE_LENGTH
+        && (int)bytesRequiredForCodeLength(octalCode[0]) == octalCode.size();
 }
 
-void OctreeServer::didPacketDistributor(OctreeSendThread* thread) {
-    QMutexLocker locker(&_threadsDidPacketDistributorMutex);
-    _threadsDidPacketDistributor[thread] = usecTimestampNow();
+QByteArray OctreeServer::getJurisdictionRoot() const {
+    if (!_jurisdiction) {
+        // no jurisdiction means we own the whole tree
+        return QByteArray(1, 0);
+    }
+    return byteArrayForOctalCode(_jurisdiction->getRootOctalCode());
 }
 
-void OctreeServer::didHandlePacketSend(OctreeSendThread* thread) {
-    QMutexLocker locker(&_threadsDidHandlePacketSendMutex);
-    _threadsDidHandlePacketSend[thread] = usecTimestampNow();
+QList<QByteArray> OctreeServer::getJurisdictionEndNodes() const {
+    QList<QByteArray> endNodes;
+    if (_jurisdiction) {
+        for (int i = 0; i < _jurisdiction->getEndNodeCount(); i++) {
+            endNodes << byteArrayForOctalCode(_jurisdiction->getEndNodeOctalCode(i));
+        }
+    }
+    return endNodes;
 }
 
-void OctreeServer::didCallWriteDatagram(OctreeSendThread* thread) {
-    QMutexLocker locker(&_threadsDidCallWriteDatagramMutex);
-    _threadsDidCallWriteDatagram[thread] = usecTimestampNow();
+void OctreeServer::updateJurisdiction(const QByteArray& rootCode, const QList<QByteArray>& endNodes) {
+    if (!_jurisdiction) {
+        JurisdictionMap* jurisdiction = new JurisdictionMap(getMyNodeType());
+        _tree->lockForWrite();
+        _jurisdiction = jurisdiction;
+        _tree->unlock();
+        _jurisdictionSender->setJurisdiction(_jurisdiction);
+    }
+
+    std::vector<unsigned char*> endNodeCodes;
+    foreach (const QByteArray& endNode, endNodes) {
+        endNodeCodes.push_back(const_cast<unsigned char*>(octalCodeForByteArray(endNode)));
+    }
+
+    // send threads and the inbound packet processor check the jurisdiction under the tree lock, the jurisdiction
+    // sender packs it under its own
+    _tree->lockForWrite();
+    _jurisdictionSender->lockJurisdiction();
+    _jurisdiction->copyContents(const_cast<unsigned char*>(octalCodeForByteArray(rootCode)), endNodeCodes);
+    _jurisdictionSender->unlockJurisdiction();
+    _tree->unlock();
+
+    qDebug() << qPrintable(_safeServerName) << "jurisdiction is now root" << octalCodeToHexString(octalCodeForByteArray(rootCode))
+        << "with" << endNodes.size() << "end nodes";
+
+    if (!_jurisdictionFilename.isEmpty()) {
+        _jurisdiction->writeToFile(_jurisdictionFilename.toLocal8Bit().constData());
+    }
 }
 
+void OctreeServer::sendJurisdictionLoadToDomainServer() {
+    NodeList* nodeList = NodeList::getInstance();
+    QByteArray rootCode = getJurisdictionRoot();
 
-void OctreeServer::stopTrackingThread(OctreeSendThread* thread) {
-    QMutexLocker lockerA(&_threadsDidProcessMutex);
-    QMutexLocker lockerB(&_threadsDidPacketDistributorMutex);
-    QMutexLocker lockerC(&_threadsDidHandlePacketSendMutex);
-    QMutexLocker lockerD(&_threadsDidCallWriteDatagramMutex);
+    QVector<float> regionLoads(NUMBER_OF_CHILDREN, 0.0f);
+    if (!_jurisdiction || !_jurisdiction->isEmpty()) {
+        calculateRegionLoads(octalCodeForByteArray(rootCode), regionLoads.data());
+    }
 
-    _threadsDidProcess.remove(thread);
-    _threadsDidPacketDistributor.remove(thread);
-    _threadsDidHandlePacketSend.remove(thread);
-    _threadsDidCallWriteDatagram.remove(thread);
+    QByteArray loadPacket = byteArrayWithPopulatedHeader(PacketTypeJurisdictionLoad);
+    QDataStream packetStream(&loadPacket, QIODevice::Append);
+    packetStream << rootCode << getJurisdictionEndNodes() << regionLoads;
+
+    nodeList->writeUnverifiedDatagram(loadPacket, nodeList->getDomainHandler().getSockAddr());
 }
 
-int howManyThreadsDidSomething(QMutex& mutex, QMap<OctreeSendThread*, quint64>& something, quint64 since) {
-    int count = 0;
-    if (mutex.tryLock()) {
-        if (since == 0) {
-            count = something.size();
+void OctreeServer::handleJurisdictionHandoff(const QByteArray& packet) {
+    QDataStream packetStream(packet);
+    packetStream.skipRawData(numBytesForPacketHeader(packet));
+
+    QByteArray regionCode;
+    QUuid recipientUUID;
+    packetStream >> regionCode >> recipientUUID;
+
+    if (!isValidOctalCode(regionCode)) {
+        return;
+    }
+
+    if (!canTransferRegions() || _hasOutgoingSubtreeTransfer) {
+        qDebug() << "Ignoring jurisdiction handoff while another transfer is in progress.";
+        return;
+    }
+
+    // we can only hand off a region we own all of
+    const unsigned char* region = octalCodeForByteArray(regionCode);
+    if (_jurisdiction) {
+        bool isOurRoot = compareOctalCodes(region, _jurisdiction->getRootOctalCode()) == EXACT_MATCH;
+        if (_jurisdiction->isEmpty()
+            || (!isOurRoot && _jurisdiction->isMyJurisdiction(region, CHECK_NODE_ONLY) != JurisdictionMap::WITHIN)) {
+            qDebug() << "Ignoring jurisdiction handoff of region" << octalCodeToHexString(region)
+                << "that is not ours.";
+            return;
+        }
+    }
+
+    SharedNodePointer recipient = NodeList::getInstance()->nodeWithUUID(recipientUUID);
+    if (!recipient || recipient->getType() != getMyNodeType() || !recipient->getActiveSocket()) {
+        qDebug() << "Ignoring jurisdiction handoff to unknown server" << uuidStringWithoutCurlyBraces(recipientUUID);
+        return;
+    }
+
+    startSubtreeTransfer(regionCode, recipient, HandoffTransfer);
+}
+
+void OctreeServer::startSubtreeTransfer(const QByteArray& regionCode, const SharedNodePointer& recipient,
+                                        SubtreeTransferType type) {
+    const unsigned char* region = octalCodeForByteArray(regionCode);
+
+    QVector<QByteArray> buffers;
+    if (!encodeRegionForTransfer(region, buffers)) {
+        qDebug() << qPrintable(_safeServerName) << "can't send region" << octalCodeToHexString(region);
+        return;
+    }
+
+    // end nodes inside the region stay someone else's after the recipient takes it over
+    QList<QByteArray> endNodesInRegion;
+    if (type == HandoffTransfer) {
+        foreach (const QByteArray& endNode, getJurisdictionEndNodes()) {
+            if (isAncestorOf(region, octalCodeForByteArray(endNode))) {
+                endNodesInRegion << endNode;
+            }
+        }
+    }
+
+    // what the recipient has to delete since it was last sent content goes along with whatever follows
+    QList<QByteArray> deletedKeys = _deletedKeysForOwners.value(recipient->getUUID());
+
+    // the region is described once in the first packet, the buffers follow it and the deleted keys follow them in
+    // packets of their own, so an empty region still takes the one packet the recipient needs to take it over
+    quint32 transferID = _nextSubtreeTransferID;
+    int keyPacketCount = (deletedKeys.size() + DELETED_KEYS_PER_SUBTREE_TRANSFER_PACKET - 1)
+        / DELETED_KEYS_PER_SUBTREE_TRANSFER_PACKET;
+    quint16 bufferCount = buffers.size();
+    quint16 packetCount = 1 + bufferCount + keyPacketCount;
+
+    QVector<QByteArray> packets(packetCount);
+    for (int i = 0; i < packetCount; i++) {
+        QByteArray& transferPacket = packets[i];
+        transferPacket = byteArrayWithPopulatedHeader(PacketTypeOctreeSubtreeTransfer);
+        QDataStream packetStream(&transferPacket, QIODevice::Append);
+        packetStream << transferID << (quint8)TransferPacketMessage << (quint16)i << packetCount;
+
+        if (i == 0) {
+            packetStream << (quint8)type << regionCode << endNodesInRegion << bufferCount;
+        } else if (i <= bufferCount) {
+            packetStream << buffers[i - 1] << QList<QByteArray>();
         } else {
-            QMap<OctreeSendThread*, quint64>::const_iterator i = something.constBegin();
-            while (i != something.constEnd()) {
-                if (i.value() > since) {
-                    count++;
-                }
-                ++i;
+            int firstKey = (i - 1 - bufferCount) * DELETED_KEYS_PER_SUBTREE_TRANSFER_PACKET;
+            packetStream << QByteArray() << deletedKeys.mid(firstKey, DELETED_KEYS_PER_SUBTREE_TRANSFER_PACKET);
+        }
+    }
+
+    if (packets[0].size() > MAX_PACKET_SIZE) {
+        qDebug() << qPrintable(_safeServerName) << "can't send region" << octalCodeToHexString(region)
+            << "with" << endNodesInRegion.size() << "end nodes, they don't fit in a packet";
+        return;
+    }
+
+    _nextSubtreeTransferID++;
+    _outgoingSubtreeTransfer.transferID = transferID;
+    _outgoingSubtreeTransfer.type = type;
+    _outgoingSubtreeTransfer.regionCode = regionCode;
+    _outgoingSubtreeTransfer.recipientUUID = recipient->getUUID();
+    _outgoingSubtreeTransfer.deletedKeys = _deletedKeysForOwners.take(recipient->getUUID());
+    _outgoingSubtreeTransfer.packets = packets;
+    _outgoingSubtreeTransfer.packetsAcked.fill(false, packetCount);
+    _outgoingSubtreeTransfer.isCommitted = false;
+    _outgoingSubtreeTransfer.endNodesBeforeCommit.clear();
+    _outgoingSubtreeTransfer.startedAt = usecTimestampNow();
+    _hasOutgoingSubtreeTransfer = true;
+
+    qDebug() << qPrintable(_safeServerName) << "sending region" << octalCodeToHexString(region) << "in"
+        << buffers.size() << "buffers with" << _outgoingSubtreeTransfer.deletedKeys.size() << "deletions to"
+        << uuidStringWithoutCurlyBraces(recipient->getUUID());
+
+    foreach (const QByteArray& transferPacket, packets) {
+        _subtreeTransferSender->queuePacketForSending(recipient, transferPacket);
+    }
+}
+
+void OctreeServer::handleSubtreeTransfer(const QByteArray& packet, const SharedNodePointer& sendingNode) {
+    if (!sendingNode || sendingNode->getType() != getMyNodeType() || !canTransferRegions()) {
+        return;
+    }
+
+    QDataStream packetStream(packet);
+    packetStream.skipRawData(numBytesForPacketHeader(packet));
+
+    quint32 transferID;
+    quint8 message;
+    packetStream >> transferID >> message;
+    if (packetStream.status() != QDataStream::Ok) {
+        return;
+    }
+
+    const QUuid& senderUUID = sendingNode->getUUID();
+    QHash<QUuid, IncomingSubtreeTransfer>::iterator incoming = _incomingSubtreeTransfers.find(senderUUID);
+    bool isCurrent = incoming != _incomingSubtreeTransfers.end() && incoming->transferID == transferID;
+    bool wasCommitted = _committedSubtreeTransfers.contains(senderUUID)
+        && _committedSubtreeTransfers.value(senderUUID) == transferID;
+
+    if (message == CommitMessage) {
+        if (isCurrent && incoming->isPrepared && incoming->accepted) {
+            commitIncomingSubtreeTransfer(*incoming, senderUUID);
+            _incomingSubtreeTransfers.erase(incoming);
+            wasCommitted = true;
+        }
+        // our ack may have been lost, the sender keeps committing until it hears one
+        if (wasCommitted) {
+            sendSubtreeTransferAck(sendingNode, transferID, CommittedAck);
+        }
+        return;
+    }
+
+    if (message == AbortMessage) {
+        if (isCurrent) {
+            qDebug() << qPrintable(_safeServerName) << "dropping region"
+                << octalCodeToHexString(octalCodeForByteArray(incoming->regionCode)) << "that"
+                << uuidStringWithoutCurlyBraces(senderUUID) << "gave up sending";
+            _incomingSubtreeTransfers.erase(incoming);
+        }
+        return;
+    }
+
+    if (message != TransferPacketMessage) {
+        return;
+    }
+
+    quint16 packetIndex;
+    quint16 packetCount;
+    packetStream >> packetIndex >> packetCount;
+    if (packetStream.status() != QDataStream::Ok || packetIndex >= packetCount) {
+        return;
+    }
+
+    // a late resend of a transfer we already took only needs acking, one of a transfer the sender has since given up
+    // on must not replace the one it is sending now
+    if (_committedSubtreeTransfers.contains(senderUUID) && transferID <= _committedSubtreeTransfers.value(senderUUID)) {
+        sendSubtreeTransferAck(sendingNode, transferID, PacketReceivedAck, packetIndex);
+        return;
+    }
+    if (incoming != _incomingSubtreeTransfers.end() && transferID < incoming->transferID) {
+        return;
+    }
+
+    quint8 type = 0;
+    QByteArray regionCode;
+    QList<QByteArray> endNodesInRegion;
+    quint16 bufferCount = 0;
+    QByteArray buffer;
+    QList<QByteArray> deletedKeys;
+    if (packetIndex == 0) {
+        packetStream >> type >> regionCode >> endNodesInRegion >> bufferCount;
+        if (type > MigrationTransfer || !isValidOctalCode(regionCode) || bufferCount >= packetCount) {
+            return;
+        }
+        foreach (const QByteArray& endNode, endNodesInRegion) {
+            if (!isValidOctalCode(endNode)) {
+                return;
+            }
+        }
+    } else {
+        packetStream >> buffer >> deletedKeys;
+    }
+    if (packetStream.status() != QDataStream::Ok) {
+        return;
+    }
+
+    // the sender only has one transfer going at a time, one with a new ID replaces whatever it sent before
+    if (!isCurrent || incoming->packetsReceived.size() != packetCount) {
+        IncomingSubtreeTransfer newTransfer;
+        newTransfer.transferID = transferID;
+        newTransfer.type = HandoffTransfer;
+        newTransfer.bufferCount = 0;
+        newTransfer.buffers.resize(packetCount);
+        newTransfer.packetsReceived.fill(false, packetCount);
+        newTransfer.packetsReceivedCount = 0;
+        newTransfer.isPrepared = false;
+        newTransfer.accepted = false;
+        incoming = _incomingSubtreeTransfers.insert(senderUUID, newTransfer);
+    }
+
+    IncomingSubtreeTransfer& transfer = *incoming;
+    transfer.lastHeardAt = usecTimestampNow();
+    if (!transfer.packetsReceived[packetIndex]) {
+        transfer.packetsReceived[packetIndex] = true;
+        transfer.packetsReceivedCount++;
+        if (packetIndex == 0) {
+            transfer.type = (SubtreeTransferType)type;
+            transfer.regionCode = regionCode;
+            transfer.endNodesInRegion = endNodesInRegion;
+            transfer.bufferCount = bufferCount;
+        } else {
+            transfer.buffers[packetIndex] = buffer;
+            transfer.deletedKeys << deletedKeys;
+        }
+    }
+    sendSubtreeTransferAck(sendingNode, transferID, PacketReceivedAck, packetIndex);
+
+    if (transfer.isPrepared || transfer.packetsReceivedCount < transfer.packetsReceived.size()) {
+        return;
+    }
+
+    const unsigned char* region = octalCodeForByteArray(transfer.regionCode);
+    transfer.accepted = true;
+
+    if (transfer.type == HandoffTransfer) {
+        // we take a region if we own nothing yet, or if it is one of our end nodes being merged back into us, and
+        // only one at a time since what we own changes when it's committed
+        transfer.accepted = _jurisdiction && (_jurisdiction->isEmpty() || _jurisdiction->findEndNode(region) >= 0);
+        QHash<QUuid, IncomingSubtreeTransfer>::const_iterator other = _incomingSubtreeTransfers.constBegin();
+        for (; other != _incomingSubtreeTransfers.constEnd(); ++other) {
+            if (other.key() != senderUUID && other->type == HandoffTransfer && other->isPrepared && other->accepted) {
+                transfer.accepted = false;
             }
         }
-        mutex.unlock();
     }
-    return count;
+    transfer.isPrepared = true;
+
+    qDebug() << qPrintable(_safeServerName) << (transfer.accepted ? "is ready to take" : "refused") << "region"
+        << octalCodeToHexString(region) << "from" << uuidStringWithoutCurlyBraces(senderUUID);
+
+    sendSubtreeTransferAck(sendingNode, transferID, PreparedAck, transfer.accepted);
 }
 
+void OctreeServer::commitIncomingSubtreeTransfer(const IncomingSubtreeTransfer& transfer, const QUuid& senderUUID) {
+    const unsigned char* region = octalCodeForByteArray(transfer.regionCode);
+
+    readTransferredRegion(transfer.buffers.mid(1, transfer.bufferCount));
+    deleteTransferredContent(transfer.deletedKeys);
+
+    if (transfer.type == HandoffTransfer) {
+        // deletions we were holding for the sender are ours to make if it hands the region back before they were sent
+        deleteTransferredContent(_deletedKeysForOwners.take(senderUUID));
+
+        QByteArray rootCode;
+        QList<QByteArray> endNodes;
+        if (_jurisdiction->isEmpty()) {
+            rootCode = transfer.regionCode;
+            endNodes = transfer.endNodesInRegion;
+        } else {
+            rootCode = getJurisdictionRoot();
+            endNodes = getJurisdictionEndNodes();
+            endNodes.removeAll(transfer.regionCode);
+            endNodes << transfer.endNodesInRegion;
+        }
+        updateJurisdiction(rootCode, endNodes);
+
+        // anything we handed off that overlaps the region is ours again
+        QHash<QByteArray, QUuid>::iterator handedOff = _handedOffRegions.begin();
+        while (handedOff != _handedOffRegions.end()) {
+            const unsigned char* handedOffRegion = octalCodeForByteArray(handedOff.key());
+            if (isAncestorOf(region, handedOffRegion) || isAncestorOf(handedOffRegion, region)) {
+                handedOff = _handedOffRegions.erase(handedOff);
+            } else {
+                ++handedOff;
+            }
+        }
+    }
 
-int OctreeServer::howManyThreadsDidProcess(quint64 since) {
-    return howManyThreadsDidSomething(_threadsDidProcessMutex, _threadsDidProcess, since);
+    _committedSubtreeTransfers.insert(senderUUID, transfer.transferID);
+
+    qDebug() << qPrintable(_safeServerName) << "took region" << octalCodeToHexString(region) << "from"
+        << uuidStringWithoutCurlyBraces(senderUUID);
 }
 
-int OctreeServer::howManyThreadsDidPacketDistributor(quint64 since) {
-    return howManyThreadsDidSomething(_threadsDidPacketDistributorMutex, _threadsDidPacketDistributor, since);
+void OctreeServer::sendSubtreeTransferAck(const SharedNodePointer& node, quint32 transferID,
+                                          SubtreeTransferAckMessage message, quint16 value) {
+    QByteArray ackPacket = byteArrayWithPopulatedHeader(PacketTypeOctreeSubtreeTransferAck);
+    QDataStream ackStream(&ackPacket, QIODevice::Append);
+    ackStream << transferID << (quint8)message << value;
+
+    NodeList::getInstance()->writeDatagram(ackPacket, node);
 }
 
-int OctreeServer::howManyThreadsDidHandlePacketSend(quint64 since) {
-    return howManyThreadsDidSomething(_threadsDidHandlePacketSendMutex, _threadsDidHandlePacketSend, since);
+static QByteArray subtreeTransferMessagePacket(quint32 transferID, quint8 message) {
+    QByteArray messagePacket = byteArrayWithPopulatedHeader(PacketTypeOctreeSubtreeTransfer);
+    QDataStream messageStream(&messagePacket, QIODevice::Append);
+    messageStream << transferID << message;
+    return messagePacket;
 }
 
-int OctreeServer::howManyThreadsDidCallWriteDatagram(quint64 since) {
-    return howManyThreadsDidSomething(_threadsDidCallWriteDatagramMutex, _threadsDidCallWriteDatagram, since);
+void OctreeServer::handleSubtreeTransferAck(const QByteArray& packet, const SharedNodePointer& sendingNode) {
+    if (!sendingNode || !_hasOutgoingSubtreeTransfer || sendingNode->getUUID() != _outgoingSubtreeTransfer.recipientUUID) {
+        return;
+    }
+
+    QDataStream packetStream(packet);
+    packetStream.skipRawData(numBytesForPacketHeader(packet));
+
+    quint32 transferID;
+    quint8 message;
+    quint16 value;
+    packetStream >> transferID >> message >> value;
+
+    if (packetStream.status() != QDataStream::Ok || transferID != _outgoingSubtreeTransfer.transferID) {
+        return;
+    }
+
+    const QByteArray& regionCode = _outgoingSubtreeTransfer.regionCode;
+    const unsigned char* region = octalCodeForByteArray(regionCode);
+
+    if (message == PacketReceivedAck) {
+        if (value < _outgoingSubtreeTransfer.packetsAcked.size()) {
+            _outgoingSubtreeTransfer.packetsAcked[value] = true;
+        }
+        return;
+    }
+
+    if (message == PreparedAck) {
+        if (_outgoingSubtreeTransfer.isCommitted) {
+            // a resend of the one we already acted on
+            return;
+        }
+
+        if (!value) {
+            qDebug() << qPrintable(_safeServerName) << "region" << octalCodeToHexString(region) << "was refused by"
+                << uuidStringWithoutCurlyBraces(sendingNode->getUUID());
+            NodeList::getInstance()->writeDatagram(subtreeTransferMessagePacket(transferID, AbortMessage), sendingNode);
+            _hasOutgoingSubtreeTransfer = false;
+            _deletedKeysForOwners[sendingNode->getUUID()] << _outgoingSubtreeTransfer.deletedKeys;
+            return;
+        }
+
+        // we let go of the region before telling the recipient to take it, so at no point do we both claim it; the
+        // content stays with us until the recipient says it has taken over, and edits to it keep applying here
+        _outgoingSubtreeTransfer.isCommitted = true;
+        if (_outgoingSubtreeTransfer.type == HandoffTransfer) {
+            QByteArray rootCode = getJurisdictionRoot();
+            _outgoingSubtreeTransfer.endNodesBeforeCommit = getJurisdictionEndNodes();
+
+            QList<QByteArray> endNodes;
+            if (regionCode == rootCode) {
+                // we handed off everything, an end node at our root leaves us owning nothing
+                endNodes << rootCode;
+            } else {
+                foreach (const QByteArray& endNode, _outgoingSubtreeTransfer.endNodesBeforeCommit) {
+                    if (!isAncestorOf(region, octalCodeForByteArray(endNode))) {
+                        endNodes << endNode;
+                    }
+                }
+                endNodes << regionCode;
+            }
+            updateJurisdiction(rootCode, endNodes);
+        }
+
+        NodeList::getInstance()->writeDatagram(subtreeTransferMessagePacket(transferID, CommitMessage), sendingNode);
+        return;
+    }
+
+    if (message != CommittedAck || !_outgoingSubtreeTransfer.isCommitted) {
+        return;
+    }
+    _hasOutgoingSubtreeTransfer = false;
+
+    qDebug() << qPrintable(_safeServerName) << "handed region" << octalCodeToHexString(region) << "to"
+        << uuidStringWithoutCurlyBraces(sendingNode->getUUID());
+
+    // whatever changed in the region while the transfer was in flight is sent on with the next migration
+    QList<QByteArray> deletedKeys;
+    forgetTransferredContent(deletedKeys);
+    if (!deletedKeys.isEmpty()) {
+        _deletedKeysForOwners[sendingNode->getUUID()] << deletedKeys;
+    }
+
+    if (_outgoingSubtreeTransfer.type == HandoffTransfer) {
+        _handedOffRegions.insert(regionCode, sendingNode->getUUID());
+    }
 }
 
+void OctreeServer::checkSubtreeTransfers() {
+    quint64 now = usecTimestampNow();
+
+    if (_hasOutgoingSubtreeTransfer) {
+        OutgoingSubtreeTransfer& outgoing = _outgoingSubtreeTransfer;
+        SharedNodePointer recipient = NodeList::getInstance()->nodeWithUUID(outgoing.recipientUUID);
+        const unsigned char* region = octalCodeForByteArray(outgoing.regionCode);
+
+        if (!outgoing.isCommitted && (!recipient || now - outgoing.startedAt > SUBTREE_TRANSFER_TIMEOUT_USECS)) {
+            qDebug() << qPrintable(_safeServerName) << "giving up on transfer of region" << octalCodeToHexString(region);
+            if (recipient) {
+                NodeList::getInstance()->writeDatagram(subtreeTransferMessagePacket(outgoing.transferID, AbortMessage),
+                                                       recipient);
+            }
+            _hasOutgoingSubtreeTransfer = false;
+            if (!outgoing.deletedKeys.isEmpty()) {
+                _deletedKeysForOwners[outgoing.recipientUUID] << outgoing.deletedKeys;
+            }
+
+        } else if (outgoing.isCommitted && !recipient) {
+            // once we let go of a region we keep committing for as long as the recipient is around, if it went away
+            // the region and the content we kept are ours again
+            qDebug() << qPrintable(_safeServerName) << "taking back region" << octalCodeToHexString(region)
+                << "from a server that went away";
+            if (outgoing.type == HandoffTransfer) {
+                updateJurisdiction(getJurisdictionRoot(), outgoing.endNodesBeforeCommit);
+            }
+            _hasOutgoingSubtreeTransfer = false;
+
+        } else if (outgoing.isCommitted) {
+            NodeList::getInstance()->writeDatagram(subtreeTransferMessagePacket(outgoing.transferID, CommitMessage),
+                                                   recipient);
+
+        } else {
+            for (int i = 0; i < outgoing.packets.size(); i++) {
+                if (!outgoing.packetsAcked[i]) {
+                    _subtreeTransferSender->queuePacketForSending(recipient, outgoing.packets[i]);
+                }
+            }
+        }
+    }
+
+    // a transfer whose sender stopped talking to us is dropped, which is all it takes to roll it back since we only
+    // take a region over once it is committed
+    QHash<QUuid, IncomingSubtreeTransfer>::iterator incoming = _incomingSubtreeTransfers.begin();
+    while (incoming != _incomingSubtreeTransfers.end()) {
+        SharedNodePointer sender = NodeList::getInstance()->nodeWithUUID(incoming.key());
+        if (!sender || now - incoming->lastHeardAt > SUBTREE_TRANSFER_TIMEOUT_USECS) {
+            incoming = _incomingSubtreeTransfers.erase(incoming);
+            continue;
+        }
+
+        // the sender can't commit or abort without hearing whether we're prepared
+        if (incoming->isPrepared) {
+            sendSubtreeTransferAck(sender, incoming->transferID, PreparedAck, incoming->accepted);
+        }
+        ++incoming;
+    }
+
+    QHash<QUuid, quint32>::iterator committed = _committedSubtreeTransfers.begin();
+    while (committed != _committedSubtreeTransfers.end()) {
+        if (!NodeList::getInstance()->nodeWithUUID(committed.key())) {
+            committed = _committedSubtreeTransfers.erase(committed);
+        } else {
+            ++committed;
+        }
+    }
+
+    if (_hasOutgoingSubtreeTransfer) {
+        return;
+    }
+
+    // deletions for a server that is gone have nothing left to delete
+    QHash<QUuid, QList<QByteArray> >::iterator deletedKeys = _deletedKeysForOwners.begin();
+    while (deletedKeys != _deletedKeysForOwners.end()) {
+        if (!NodeList::getInstance()->nodeWithUUID(deletedKeys.key())) {
+            deletedKeys = _deletedKeysForOwners.erase(deletedKeys);
+        } else {
+            ++deletedKeys;
+        }
+    }
+
+    // content that was added to a region after we handed it off, or that moved into one or was edited while it was
+    // being handed off, follows the region to its owner one region at a time, along with the deletions for that owner
+    QHash<QByteArray, QUuid>::iterator handedOff = _handedOffRegions.begin();
+    while (handedOff != _handedOffRegions.end()) {
+        SharedNodePointer owner = NodeList::getInstance()->nodeWithUUID(handedOff.value());
+        if (!owner) {
+            handedOff = _handedOffRegions.erase(handedOff);
+            continue;
+        }
+
+        if (owner->getActiveSocket() && (_deletedKeysForOwners.contains(owner->getUUID())
+                                         || hasContentInRegion(octalCodeForByteArray(handedOff.key())))) {
+            startSubtreeTransfer(handedOff.key(), owner, MigrationTransfer);
+            break;
+        }
+        ++handedOff;
+    }
+}
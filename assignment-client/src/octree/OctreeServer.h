@@ -22,7 +22,8 @@
 #include <EnvironmentData.h>
 
 #include "OctreePersistThread.h"
-#include "OctreeSendThread.h"
+#include "OctreeSendTask.h"
+#include "OctreeSendWorkerPool.h"
 #include "OctreeServerConsts.h"
 #include "OctreeInboundPacketProcessor.h"
 
@@ -75,6 +76,32 @@ public:
     virtual bool hasSpecialPacketToSend(const SharedNodePointer& node) { return false; }
     virtual int sendSpecialPacket(const SharedNodePointer& node, OctreeQueryNode* queryNode, int& packetsSent) { return 0; }
 
+    // subclasses that can hand regions of their tree to other servers of the same type implement these methods, which
+    // lets the domain-server split and merge jurisdictions between live servers based on the loads they report
+    virtual bool canTransferRegions() const { return false; }
+
+    /// adds the load of each of the NUMBER_OF_CHILDREN child regions of rootCode to regionLoads, measured in edits per
+    /// second plus one for every hundred items encoded per connected client
+    virtual void calculateRegionLoads(const unsigned char* rootCode, float* regionLoads) { }
+
+    /// encodes what we hold in the region into self contained octree bitstream buffers, remembering what was encoded
+    /// \return false if the region can't be encoded into buffers, in which case it can't be transferred
+    virtual bool encodeRegionForTransfer(const unsigned char* regionCode, QVector<QByteArray>& buffers) { return true; }
+
+    /// reads buffers another server made with encodeRegionForTransfer() into our tree
+    virtual void readTransferredRegion(const QVector<QByteArray>& buffers) { }
+
+    /// removes what the last encodeRegionForTransfer() encoded once the other server has it, without telling viewers.
+    /// Content changed since it was encoded is kept, to follow the region to the other server like content that lands in
+    /// it later, and keys for content the other server has to delete since are added to deletedKeys
+    virtual void forgetTransferredContent(QList<QByteArray>& deletedKeys) { }
+
+    /// deletes the content a server that sent us a region reported with forgetTransferredContent()
+    virtual void deleteTransferredContent(const QList<QByteArray>& deletedKeys) { }
+
+    /// true if we hold anything in the region, used to move content that lands in regions we have handed off
+    virtual bool hasContentInRegion(const unsigned char* regionCode) { return false; }
+
     static void attachQueryNodeToNode(Node* newNode);
     
     static float SKIP_TIME; // use this for trackXXXTime() calls for non-times
@@ -103,17 +130,8 @@ public:
     static void trackProcessWaitTime(float time);
     static float getAverageProcessWaitTime() { return _averageProcessWaitTime.getAverage(); }
     
-    // these methods allow us to track which threads got to various states
-    static void didProcess(OctreeSendThread* thread);
-    static void didPacketDistributor(OctreeSendThread* thread);
-    static void didHandlePacketSend(OctreeSendThread* thread);
-    static void didCallWriteDatagram(OctreeSendThread* thread);
-    static void stopTrackingThread(OctreeSendThread* thread);
-
-    static int howManyThreadsDidProcess(quint64 since = 0);
-    static int howManyThreadsDidPacketDistributor(quint64 since = 0);
-    static int howManyThreadsDidHandlePacketSend(quint64 since = 0);
-    static int howManyThreadsDidCallWriteDatagram(quint64 since = 0);
+    /// runs the send tasks of all our clients
+    OctreeSendWorkerPool* getSendWorkerPool() { return _sendWorkerPool; }
 
     bool handleHTTPRequest(HTTPConnection* connection, const QUrl& url, bool skipSubHandler);
 
@@ -140,6 +158,66 @@ protected:
     QString getStatusLink();
 
     void setupDatagramProcessingThread();
+
+    enum SubtreeTransferType {
+        HandoffTransfer, // the region and our jurisdiction over it move to the recipient
+        MigrationTransfer // content that landed in a region we already handed off follows it to the new owner
+    };
+
+    // a transfer is committed in two phases: the sender lets go of the region once the recipient has every packet and
+    // is prepared to take it, and the recipient only takes it over when told the sender has let go
+    enum SubtreeTransferMessage {
+        TransferPacketMessage, // one of the transfer's packets, the first describes the region
+        CommitMessage, // the sender has let go of the region
+        AbortMessage // the sender gave up before letting go, the recipient drops what it has
+    };
+
+    enum SubtreeTransferAckMessage {
+        PacketReceivedAck,
+        PreparedAck, // every packet arrived, carries whether the recipient will take the region
+        CommittedAck // the recipient has taken the region over
+    };
+
+    struct OutgoingSubtreeTransfer {
+        quint32 transferID;
+        SubtreeTransferType type;
+        QByteArray regionCode;
+        QUuid recipientUUID;
+        QList<QByteArray> deletedKeys;
+        QVector<QByteArray> packets; // resent until acked
+        QVector<bool> packetsAcked;
+        bool isCommitted;
+        QList<QByteArray> endNodesBeforeCommit; // to take the region back if the recipient goes away
+        quint64 startedAt;
+    };
+
+    struct IncomingSubtreeTransfer {
+        quint32 transferID;
+        SubtreeTransferType type;
+        QByteArray regionCode;
+        QList<QByteArray> endNodesInRegion;
+        quint16 bufferCount;
+        QVector<QByteArray> buffers; // by packet index, the description and deleted key packets leave theirs empty
+        QList<QByteArray> deletedKeys;
+        QVector<bool> packetsReceived;
+        int packetsReceivedCount;
+        bool isPrepared;
+        bool accepted;
+        quint64 lastHeardAt;
+    };
+
+    void sendJurisdictionLoadToDomainServer();
+    void handleJurisdictionHandoff(const QByteArray& packet);
+    void startSubtreeTransfer(const QByteArray& regionCode, const SharedNodePointer& recipient, SubtreeTransferType type);
+    void handleSubtreeTransfer(const QByteArray& packet, const SharedNodePointer& sendingNode);
+    void handleSubtreeTransferAck(const QByteArray& packet, const SharedNodePointer& sendingNode);
+    void commitIncomingSubtreeTransfer(const IncomingSubtreeTransfer& transfer, const QUuid& senderUUID);
+    void sendSubtreeTransferAck(const SharedNodePointer& node, quint32 transferID, SubtreeTransferAckMessage message,
+                                quint16 value = 0);
+    void checkSubtreeTransfers();
+    void updateJurisdiction(const QByteArray& rootCode, const QList<QByteArray>& endNodes);
+    QList<QByteArray> getJurisdictionEndNodes() const;
+    QByteArray getJurisdictionRoot() const;
     
     int _argc;
     const char** _argv;
@@ -159,8 +237,18 @@ protected:
     bool _verboseDebug;
     JurisdictionMap* _jurisdiction;
     JurisdictionSender* _jurisdictionSender;
+    QString _jurisdictionFilename;
+    PacketSender* _subtreeTransferSender;
+    quint32 _nextSubtreeTransferID;
+    bool _hasOutgoingSubtreeTransfer;
+    OutgoingSubtreeTransfer _outgoingSubtreeTransfer;
+    QHash<QUuid, IncomingSubtreeTransfer> _incomingSubtreeTransfers;
+    QHash<QUuid, quint32> _committedSubtreeTransfers; // the last transfer taken from each server, to ack its commit again
+    QHash<QByteArray, QUuid> _handedOffRegions;
+    QHash<QUuid, QList<QByteArray> > _deletedKeysForOwners; // sent with the next transfer to each server we handed to
     OctreeInboundPacketProcessor* _octreeInboundPacketProcessor;
     OctreePersistThread* _persistThread;
+    OctreeSendWorkerPool* _sendWorkerPool;
 
     static OctreeServer* _instance;
 
@@ -213,16 +301,6 @@ protected:
     static int _longProcessWait;
     static int _shortProcessWait;
     static int _noProcessWait;
-
-    static QMap<OctreeSendThread*, quint64> _threadsDidProcess;
-    static QMap<OctreeSendThread*, quint64> _threadsDidPacketDistributor;
-    static QMap<OctreeSendThread*, quint64> _threadsDidHandlePacketSend;
-    static QMap<OctreeSendThread*, quint64> _threadsDidCallWriteDatagram;
-
-    static QMutex _threadsDidProcessMutex;
-    static QMutex _threadsDidPacketDistributorMutex;
-    static QMutex _threadsDidHandlePacketSendMutex;
-    static QMutex _threadsDidCallWriteDatagramMutex;
 };
 
 #endif // hifi_OctreeServer_h
@@ -21,4 +21,13 @@ const int INTERVALS_PER_SECOND = 60;
 const int OCTREE_SEND_INTERVAL_USECS = (1000 * 1000)/INTERVALS_PER_SECOND;
 const int SENDING_TIME_TO_SPARE = 5 * 1000; // usec of sending interval to spare for calculating voxels
 
+const int SUBTREE_TRANSFER_PACKETS_PER_SECOND = 1000;
+// the transfer ID, message, packet index and count and the sizes of the buffer and deleted key list in each packet, the
+// region's octal codes only go in the first packet which carries no buffer
+const int SUBTREE_TRANSFER_PACKET_FIELD_BYTES = sizeof(quint32) + sizeof(quint8) + 2 * sizeof(quint16) + 2 * sizeof(quint32);
+const int MAX_SUBTREE_TRANSFER_BUFFER_SIZE = MAX_PACKET_SIZE - MAX_PACKET_HEADER_BYTES - SUBTREE_TRANSFER_PACKET_FIELD_BYTES;
+// deleted content keys are sent in packets of their own after the buffers, this many fill about as much of a packet
+// as a buffer does with keys of up to 17 bytes
+const int DELETED_KEYS_PER_SUBTREE_TRANSFER_PACKET = 48;
+
 #endif // hifi_OctreeServerConsts_h
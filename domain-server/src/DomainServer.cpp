@@ -50,7 +50,9 @@ DomainServer::DomainServer(int argc, char* argv[]) :
     _hostname(),
     _webAuthenticationStateSet(),
     _cookieSessionHash(),
-    _settingsManager()
+    _settingsManager(),
+    _jurisdictionBalancer(NULL),
+    _lastLocalID(NULL_LOCAL_ID)
 {
     LogUtils::init();
 
@@ -246,6 +248,16 @@ void DomainServer::setupNodeListAndAssignments(const QUuid& sessionUUID) {
 
     // add whatever static assignments that have been parsed to the queue
     addStaticAssignmentsToQueue();
+    
+    const QString ENABLE_REBALANCING_KEY_PATH = "entity_server_sharding.enable_rebalancing";
+    const QString SPLIT_LOAD_KEY_PATH = "entity_server_sharding.split_load";
+    const QString MERGE_LOAD_KEY_PATH = "entity_server_sharding.merge_load";
+    
+    if (_settingsManager.valueOrDefaultValueForKeyPath(ENABLE_REBALANCING_KEY_PATH).toBool()) {
+        float splitLoad = _settingsManager.valueOrDefaultValueForKeyPath(SPLIT_LOAD_KEY_PATH).toFloat();
+        float mergeLoad = _settingsManager.valueOrDefaultValueForKeyPath(MERGE_LOAD_KEY_PATH).toFloat();
+        _jurisdictionBalancer = new JurisdictionBalancer(splitLoad, mergeLoad, this);
+    }
 }
 
 bool DomainServer::didSetupAccountManagerWithAccessToken() {
@@ -588,8 +600,13 @@ void DomainServer::handleConnectRequest(const QByteArray& packet, const HifiSock
         }
         
 
+        // a node we already know keeps its local ID, a new one gets the next free one
+        SharedNodePointer existingNode = LimitedNodeList::getInstance()->nodeWithUUID(nodeUUID);
+        LocalID localID = existingNode ? existingNode->getLocalID() : nextLocalID();
+
         SharedNodePointer newNode = LimitedNodeList::getInstance()->addOrUpdateNode(nodeUUID, nodeType,
-                                                                                    publicSockAddr, localSockAddr);
+                                                                                    publicSockAddr, localSockAddr,
+                                                                                    localID);
         // when the newNode is created the linked data is also created
         // if this was a static assignment set the UUID, set the sendingSockAddr
         DomainServerNodeData* nodeData = reinterpret_cast<DomainServerNodeData*>(newNode->getLinkedData());
@@ -787,9 +804,9 @@ void DomainServer::sendDomainListToNode(const SharedNodePointer& node, const Hif
 
     QByteArray broadcastPacket = byteArrayWithPopulatedHeader(PacketTypeDomainList);
 
-    // always send the node their own UUID back
+    // always send the node their own UUID and local ID back
     QDataStream broadcastDataStream(&broadcastPacket, QIODevice::Append);
-    broadcastDataStream << node->getUUID();
+    broadcastDataStream << node->getUUID() << node->getLocalID();
 
     int numBroadcastPacketLeadBytes = broadcastDataStream.device()->pos();
 
@@ -810,12 +827,23 @@ void DomainServer::sendDomainListToNode(const SharedNodePointer& node, const Hif
         int dataMTU = MAX_PACKET_SIZE;
 
         if (nodeData->isAuthenticated()) {
+            // when the domain runs more than one audio-mixer each agent only gets to know the one it is handed to
+            QUuid agentAudioMixerUUID;
+            if (node->getType() == NodeType::Agent && nodeInterestList.contains(NodeType::AudioMixer)) {
+                agentAudioMixerUUID = audioMixerUUIDForAgent(node);
+            }
+            
             // if this authenticated node has any interest types, send back those nodes as well
             foreach (const SharedNodePointer& otherNode, nodeList->getNodeHash()) {
 
                 // reset our nodeByteArray and nodeDataStream
                 QByteArray nodeByteArray;
                 QDataStream nodeDataStream(&nodeByteArray, QIODevice::Append);
+                
+                if (otherNode->getType() == NodeType::AudioMixer && !agentAudioMixerUUID.isNull()
+                    && otherNode->getUUID() != agentAudioMixerUUID) {
+                    continue;
+                }
 
                 if (otherNode->getUUID() != node->getUUID() && nodeInterestList.contains(otherNode->getType())) {
 
@@ -861,6 +889,59 @@ void DomainServer::sendDomainListToNode(const SharedNodePointer& node, const Hif
     }
 }
 
+QUuid DomainServer::audioMixerUUIDForAgent(const SharedNodePointer& agentNode) {
+    DomainServerNodeData* agentData = reinterpret_cast<DomainServerNodeData*>(agentNode->getLinkedData());
+    
+    // count the agents handed to each live audio-mixer so a new agent can go to the least loaded one
+    QHash<QUuid, int> agentsPerAudioMixer;
+    LimitedNodeList* nodeList = LimitedNodeList::getInstance();
+    
+    foreach (const SharedNodePointer& node, nodeList->getNodeHash()) {
+        if (node->getType() == NodeType::AudioMixer) {
+            agentsPerAudioMixer.insert(node->getUUID(), 0);
+        }
+    }
+    
+    if (agentsPerAudioMixer.contains(agentData->getAudioMixerUUID())) {
+        // keep agents on the audio-mixer they already have for as long as it is alive
+        return agentData->getAudioMixerUUID();
+    }
+    
+    foreach (const SharedNodePointer& node, nodeList->getNodeHash()) {
+        if (node->getType() == NodeType::Agent && node != agentNode && node->getLinkedData()) {
+            QUuid otherAudioMixerUUID = reinterpret_cast<DomainServerNodeData*>(node->getLinkedData())->getAudioMixerUUID();
+            if (agentsPerAudioMixer.contains(otherAudioMixerUUID)) {
+                ++agentsPerAudioMixer[otherAudioMixerUUID];
+            }
+        }
+    }
+    
+    QUuid leastLoadedAudioMixerUUID;
+    int fewestAgents = 0;
+    QHash<QUuid, int>::const_iterator it = agentsPerAudioMixer.constBegin();
+    while (it != agentsPerAudioMixer.constEnd()) {
+        if (leastLoadedAudioMixerUUID.isNull() || it.value() < fewestAgents) {
+            leastLoadedAudioMixerUUID = it.key();
+            fewestAgents = it.value();
+        }
+        ++it;
+    }
+    
+    agentData->setAudioMixerUUID(leastLoadedAudioMixerUUID);
+    return leastLoadedAudioMixerUUID;
+}
+
+LocalID DomainServer::nextLocalID() {
+    // local IDs are handed out in order and wrap around, so one that was just freed isn't reused right away while
+    // other nodes may still have it in their lists
+    LimitedNodeList* nodeList = LimitedNodeList::getInstance();
+    do {
+        ++_lastLocalID;
+    } while (_lastLocalID == NULL_LOCAL_ID || nodeList->nodeWithLocalID(_lastLocalID));
+    
+    return _lastLocalID;
+}
+
 void DomainServer::readAvailableDatagrams() {
     LimitedNodeList* nodeList = LimitedNodeList::getInstance();
 
@@ -1234,6 +1315,14 @@ void DomainServer::processDatagram(const QByteArray& receivedPacket, const HifiS
                 
                 break;
             }
+            case PacketTypeJurisdictionLoad: {
+                if (_jurisdictionBalancer) {
+                    SharedNodePointer matchingNode = nodeList->sendingNodeForPacket(receivedPacket);
+                    _jurisdictionBalancer->processLoadPacket(receivedPacket, matchingNode, senderSockAddr);
+                }
+                
+                break;
+            }
             case PacketTypeStunResponse:
                 nodeList->processSTUNResponse(receivedPacket);
                 break;
@@ -1894,6 +1983,10 @@ void DomainServer::nodeKilled(SharedNodePointer node) {
     _connectingICEPeers.remove(node->getUUID());
     _connectedICEPeers.remove(node->getUUID());
 
+    if (_jurisdictionBalancer) {
+        _jurisdictionBalancer->nodeKilled(node);
+    }
+
     DomainServerNodeData* nodeData = reinterpret_cast<DomainServerNodeData*>(node->getLinkedData());
 
     if (nodeData) {
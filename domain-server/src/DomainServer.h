@@ -27,6 +27,7 @@
 
 #include "DomainServerSettingsManager.h"
 #include "DomainServerWebSessionData.h"
+#include "JurisdictionBalancer.h"
 #include "ShutdownEventListener.h"
 #include "WalletTransaction.h"
 
@@ -97,6 +98,8 @@ private:
     NodeSet nodeInterestListFromPacket(const QByteArray& packet, int numPreceedingBytes);
     void sendDomainListToNode(const SharedNodePointer& node, const HifiSockAddr& senderSockAddr,
                               const NodeSet& nodeInterestList);
+    QUuid audioMixerUUIDForAgent(const SharedNodePointer& agentNode);
+    LocalID nextLocalID();
     
     void parseAssignmentConfigs(QSet<Assignment::Type>& excludedTypes);
     void addStaticAssignmentToAssignmentHash(Assignment* newAssignment);
@@ -151,6 +154,10 @@ private:
     QHash<QUuid, HifiSockAddr> _connectedICEPeers;
     
     DomainServerSettingsManager _settingsManager;
+    
+    JurisdictionBalancer* _jurisdictionBalancer;
+    
+    LocalID _lastLocalID;
 };
 
 
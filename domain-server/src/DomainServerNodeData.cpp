@@ -25,7 +25,8 @@ DomainServerNodeData::DomainServerNodeData() :
     _paymentIntervalTimer(),
     _statsJSONObject(),
     _sendingSockAddr(),
-    _isAuthenticated(true)
+    _isAuthenticated(true),
+    _audioMixerUUID()
 {
     _paymentIntervalTimer.start();
 }
@@ -47,6 +47,10 @@ public:
     bool isAuthenticated() const { return _isAuthenticated; }
     
     QHash<QUuid, QUuid>& getSessionSecretHash() { return _sessionSecretHash; }
+    
+    /// the audio-mixer this agent is handed when the domain has more than one
+    void setAudioMixerUUID(const QUuid& audioMixerUUID) { _audioMixerUUID = audioMixerUUID; }
+    const QUuid& getAudioMixerUUID() const { return _audioMixerUUID; }
 private:
     QJsonObject mergeJSONStatsFromNewObject(const QJsonObject& newObject, QJsonObject destinationObject);
     
@@ -58,6 +62,7 @@ private:
     QJsonObject _statsJSONObject;
     HifiSockAddr _sendingSockAddr;
     bool _isAuthenticated;
+    QUuid _audioMixerUUID;
 };
 
 #endif // hifi_DomainServerNodeData_h
@@ -0,0 +1,194 @@
+//
+//  JurisdictionBalancer.cpp
+//  domain-server/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <QtCore/QDataStream>
+#include <QtCore/QDebug>
+#include <QtCore/QTimer>
+
+#include <LimitedNodeList.h>
+#include <OctalCode.h>
+#include <PacketHeaders.h>
+#include <SharedUtil.h>
+#include <UUID.h>
+
+#include "JurisdictionBalancer.h"
+
+const int REBALANCE_INTERVAL_MSECS = 5 * 1000;
+
+// loads reported before the last handoff settled don't reflect it yet
+const quint64 HANDOFF_SETTLE_USECS = 15 * USECS_PER_SECOND;
+const quint64 STALE_LOAD_USECS = 5 * USECS_PER_SECOND;
+
+const int NUMBER_OF_REGIONS = 8;
+
+JurisdictionBalancer::JurisdictionBalancer(float splitLoad, float mergeLoad, QObject* parent) :
+    QObject(parent),
+    _splitLoad(splitLoad),
+    _mergeLoad(mergeLoad),
+    _serverLoads(),
+    _lastHandoffAt(0)
+{
+    QTimer* rebalanceTimer = new QTimer(this);
+    connect(rebalanceTimer, &QTimer::timeout, this, &JurisdictionBalancer::rebalance);
+    rebalanceTimer->start(REBALANCE_INTERVAL_MSECS);
+
+    qDebug() << "Rebalancing entity-server jurisdictions, split load is" << _splitLoad << "merge load is" << _mergeLoad;
+}
+
+void JurisdictionBalancer::processLoadPacket(const QByteArray& packet, const SharedNodePointer& sendingNode,
+                                             const HifiSockAddr& senderSockAddr) {
+    if (!sendingNode || sendingNode->getType() != NodeType::EntityServer) {
+        return;
+    }
+
+    QDataStream packetStream(packet);
+    packetStream.skipRawData(numBytesForPacketHeader(packet));
+
+    ServerLoad serverLoad;
+    packetStream >> serverLoad.rootCode >> serverLoad.endNodes >> serverLoad.regionLoads;
+
+    if (packetStream.status() != QDataStream::Ok || serverLoad.rootCode.isEmpty()
+        || serverLoad.regionLoads.size() != NUMBER_OF_REGIONS) {
+        return;
+    }
+
+    serverLoad.totalLoad = 0.0f;
+    foreach (float regionLoad, serverLoad.regionLoads) {
+        serverLoad.totalLoad += regionLoad;
+    }
+    serverLoad.sockAddr = senderSockAddr;
+    serverLoad.reportedAt = usecTimestampNow();
+
+    _serverLoads.insert(sendingNode->getUUID(), serverLoad);
+}
+
+void JurisdictionBalancer::nodeKilled(const SharedNodePointer& node) {
+    _serverLoads.remove(node->getUUID());
+}
+
+void JurisdictionBalancer::rebalance() {
+    quint64 now = usecTimestampNow();
+
+    QHash<QUuid, ServerLoad>::iterator serverLoad = _serverLoads.begin();
+    while (serverLoad != _serverLoads.end()) {
+        if (now - serverLoad->reportedAt > STALE_LOAD_USECS) {
+            serverLoad = _serverLoads.erase(serverLoad);
+        } else {
+            ++serverLoad;
+        }
+    }
+
+    if (now - _lastHandoffAt < HANDOFF_SETTLE_USECS) {
+        return;
+    }
+
+    if (!splitBusiestServer()) {
+        mergeQuietServers();
+    }
+}
+
+bool JurisdictionBalancer::splitBusiestServer() {
+    QUuid busiestUUID;
+    QUuid spareUUID;
+    float busiestLoad = _splitLoad;
+
+    for (QHash<QUuid, ServerLoad>::const_iterator i = _serverLoads.constBegin(); i != _serverLoads.constEnd(); ++i) {
+        if (i->isSpare()) {
+            spareUUID = i.key();
+        } else if (i->totalLoad > busiestLoad) {
+            busiestLoad = i->totalLoad;
+            busiestUUID = i.key();
+        }
+    }
+
+    if (busiestUUID.isNull() || spareUUID.isNull()) {
+        return false;
+    }
+
+    // hand off the child region that comes closest to taking half of the load, as long as none of it is already
+    // someone else's
+    const ServerLoad& busiest = _serverLoads[busiestUUID];
+    const unsigned char* rootCode = reinterpret_cast<const unsigned char*>(busiest.rootCode.constData());
+
+    QByteArray bestRegion;
+    float bestDifference = busiestLoad;
+    for (int i = 0; i < NUMBER_OF_REGIONS; i++) {
+        if (busiest.regionLoads[i] <= 0.0f) {
+            continue;
+        }
+
+        unsigned char* childCode = childOctalCode(rootCode, i);
+        QByteArray regionCode(reinterpret_cast<const char*>(childCode),
+                              bytesRequiredForCodeLength(numberOfThreeBitSectionsInCode(childCode)));
+        delete[] childCode;
+
+        bool isHandedOff = false;
+        foreach (const QByteArray& endNode, busiest.endNodes) {
+            if (isAncestorOf(reinterpret_cast<const unsigned char*>(endNode.constData()),
+                             reinterpret_cast<const unsigned char*>(regionCode.constData()))) {
+                isHandedOff = true;
+                break;
+            }
+        }
+
+        float difference = fabsf(busiest.regionLoads[i] - (busiestLoad / 2.0f));
+        if (!isHandedOff && difference < bestDifference) {
+            bestDifference = difference;
+            bestRegion = regionCode;
+        }
+    }
+
+    if (bestRegion.isEmpty()) {
+        return false;
+    }
+
+    sendHandoff(busiestUUID, bestRegion, spareUUID);
+    return true;
+}
+
+bool JurisdictionBalancer::mergeQuietServers() {
+    for (QHash<QUuid, ServerLoad>::const_iterator child = _serverLoads.constBegin();
+         child != _serverLoads.constEnd(); ++child) {
+        if (child->isSpare()) {
+            continue;
+        }
+
+        // the parent is the server that has the child's root as one of its end nodes
+        for (QHash<QUuid, ServerLoad>::const_iterator parent = _serverLoads.constBegin();
+             parent != _serverLoads.constEnd(); ++parent) {
+            if (parent == child || parent->isSpare() || !parent->endNodes.contains(child->rootCode)) {
+                continue;
+            }
+
+            if (child->totalLoad + parent->totalLoad < _mergeLoad) {
+                sendHandoff(child.key(), child->rootCode, parent.key());
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+void JurisdictionBalancer::sendHandoff(const QUuid& donorUUID, const QByteArray& regionCode, const QUuid& recipientUUID) {
+    qDebug() << "Asking entity-server" << uuidStringWithoutCurlyBraces(donorUUID) << "to hand region"
+        << octalCodeToHexString(reinterpret_cast<const unsigned char*>(regionCode.constData())) << "to"
+        << uuidStringWithoutCurlyBraces(recipientUUID);
+
+    QByteArray handoffPacket = byteArrayWithPopulatedHeader(PacketTypeJurisdictionHandoff);
+    QDataStream packetStream(&handoffPacket, QIODevice::Append);
+    packetStream << regionCode << recipientUUID;
+
+    LimitedNodeList::getInstance()->writeUnverifiedDatagram(handoffPacket, _serverLoads[donorUUID].sockAddr);
+
+    // what the servers reported so far doesn't include this handoff
+    _lastHandoffAt = usecTimestampNow();
+    _serverLoads.clear();
+}
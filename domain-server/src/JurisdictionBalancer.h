@@ -0,0 +1,61 @@
+//
+//  JurisdictionBalancer.h
+//  domain-server/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_JurisdictionBalancer_h
+#define hifi_JurisdictionBalancer_h
+
+#include <QtCore/QHash>
+#include <QtCore/QObject>
+#include <QtCore/QUuid>
+#include <QtCore/QVector>
+
+#include <HifiSockAddr.h>
+#include <Node.h>
+
+/// Splits and merges the jurisdictions of the running entity-servers based on the loads they report. A server that is
+/// too busy hands about half of its region to a spare server, and a region is handed back to the server it came from
+/// once the two of them are quiet enough to share one. The servers move the content themselves, we only pick who
+/// hands what to whom, one handoff at a time.
+class JurisdictionBalancer : public QObject {
+    Q_OBJECT
+public:
+    JurisdictionBalancer(float splitLoad, float mergeLoad, QObject* parent = 0);
+
+    void processLoadPacket(const QByteArray& packet, const SharedNodePointer& sendingNode,
+                           const HifiSockAddr& senderSockAddr);
+    void nodeKilled(const SharedNodePointer& node);
+
+public slots:
+    void rebalance();
+
+private:
+    struct ServerLoad {
+        QByteArray rootCode;
+        QList<QByteArray> endNodes;
+        QVector<float> regionLoads;
+        float totalLoad;
+        HifiSockAddr sockAddr;
+        quint64 reportedAt;
+
+        /// a spare server reports an end node at its root, it owns nothing
+        bool isSpare() const { return endNodes.contains(rootCode); }
+    };
+
+    bool splitBusiestServer();
+    bool mergeQuietServers();
+    void sendHandoff(const QUuid& donorUUID, const QByteArray& regionCode, const QUuid& recipientUUID);
+
+    float _splitLoad;
+    float _mergeLoad;
+    QHash<QUuid, ServerLoad> _serverLoads;
+    quint64 _lastHandoffAt;
+};
+
+#endif // hifi_JurisdictionBalancer_h
@@ -1863,9 +1863,13 @@ void Application::init() {
     _voxels.setVoxelsAsPoints(false);
     _voxels.setDisableFastVoxelPipeline(false);
     _voxels.init();
+    // the avatar and entity collision checks against the voxels run every frame
+    _voxels.getTree()->setUseOccupancyMap(true);
 
     _entities.init();
     _entities.setViewFrustum(getViewFrustum());
+    // the octree packet processor commits entity data once per batch of packets, see OctreePacketProcessor::postProcess()
+    _entities.setDeferCommits(true);
 
     _entityCollisionSystem.init(&_entityEditSender, _entities.getTree(), _voxels.getTree(), &_audio, &_avatarManager);
 
@@ -47,8 +47,6 @@
 
 static const float AUDIO_CALLBACK_MSECS = (float) NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL / (float)SAMPLE_RATE * 1000.0;
 
-static const int NUMBER_OF_NOISE_SAMPLE_FRAMES = 300;
-
 static const int FRAMES_AVAILABLE_STATS_WINDOW_SECONDS = 10;
 static const int APPROXIMATELY_30_SECONDS_OF_AUDIO_PACKETS = (int)(30.0f * 1000.0f / AUDIO_CALLBACK_MSECS);
 
@@ -80,11 +78,9 @@ Audio::Audio(QObject* parent) :
     _timeSinceLastClip(-1.0),
     _dcOffset(0),
     _noiseGateMeasuredFloor(0),
-    _noiseGateSampleCounter(0),
-    _noiseGateOpen(false),
     _noiseGateEnabled(true),
+    _voiceActivityDetector(SAMPLE_RATE),
     _audioSourceInjectEnabled(false),
-    _noiseGateFramesToClose(0),
     _totalInputAudioSamples(0),
     _collisionSoundMagnitude(0.0f),
     _collisionSoundFrequency(0.0f),
@@ -114,6 +110,7 @@ Audio::Audio(QObject* parent) :
     _statsEnabled(false),
     _statsShowInjectedStreams(false),
     _outgoingAvatarAudioSequenceNumber(0),
+    _upstreamEncoder(),
     _audioInputMsecsReadStats(MSECS_PER_SECOND / (float)AUDIO_CALLBACK_MSECS * CALLBACK_ACCELERATOR_RATIO, FRAMES_AVAILABLE_STATS_WINDOW_SECONDS),
     _inputRingBufferMsecsAvailableStats(1, FRAMES_AVAILABLE_STATS_WINDOW_SECONDS),
     _audioOutputMsecsUnplayedStats(1, FRAMES_AVAILABLE_STATS_WINDOW_SECONDS),
@@ -123,8 +120,6 @@ Audio::Audio(QObject* parent) :
 {
     // clear the array of locally injected samples
     memset(_localProceduralSamples, 0, NETWORK_BUFFER_LENGTH_BYTES_PER_CHANNEL);
-    // Create the noise sample array
-    _noiseSampleFrames = new float[NUMBER_OF_NOISE_SAMPLE_FRAMES];
     
     connect(&_receivedAudioStream, &MixedProcessedAudioStream::addedSilence, this, &Audio::addStereoSilenceToScope, Qt::DirectConnection);
     connect(&_receivedAudioStream, &MixedProcessedAudioStream::addedLastFrameRepeatedWithFade, this, &Audio::addLastFrameRepeatedWithFadeToScope, Qt::DirectConnection);
@@ -166,6 +161,7 @@ void Audio::resetStats() {
 
 void Audio::audioMixerKilled() {
     _outgoingAvatarAudioSequenceNumber = 0;
+    _upstreamEncoder.reset();
     resetStats();
 }
 
@@ -565,7 +561,8 @@ void Audio::handleAudioInput() {
     // NOTE: we assume PacketTypeMicrophoneAudioWithEcho has same size headers as
     // PacketTypeMicrophoneAudioNoEcho.  If not, then networkAudioSamples will be pointing to the wrong place for writing
     // audio samples with echo.
-    static int leadingBytes = numBytesPacketHeader + sizeof(quint16) + sizeof(glm::vec3) + sizeof(glm::quat) + sizeof(quint8);
+    static int leadingBytes = numBytesPacketHeader + sizeof(quint16) + sizeof(glm::vec3) + sizeof(glm::quat)
+        + sizeof(quint8) + sizeof(quint8) + sizeof(quint8);
     static int16_t* networkAudioSamples = (int16_t*)(audioDataPacket + leadingBytes);
 
     float inputToNetworkInputRatio = calculateDeviceToNetworkInputRatio(_numInputCallbackBytes);
@@ -652,41 +649,16 @@ void Audio::handleAudioInput() {
                              inputSamplesRequired,  numNetworkSamples,
                              _inputFormat, _desiredInputFormat);
             
-            // only impose the noise gate and perform tone injection if we sending mono audio
+            // only remove the DC offset and check for clipping if we are sending mono audio
             if (!_isStereoInput) {
-                
-                //
-                //  Impose Noise Gate
-                //
-                //  The Noise Gate is used to reject constant background noise by measuring the noise
-                //  floor observed at the microphone and then opening the 'gate' to allow microphone
-                //  signals to be transmitted when the microphone samples average level exceeds a multiple
-                //  of the noise floor.
-                //
-                //  NOISE_GATE_HEIGHT:  How loud you have to speak relative to noise background to open the gate.
-                //                      Make this value lower for more sensitivity and less rejection of noise.
-                //  NOISE_GATE_WIDTH:   The number of samples in an audio frame for which the height must be exceeded
-                //                      to open the gate.
-                //  NOISE_GATE_CLOSE_FRAME_DELAY:  Once the noise is below the gate height for the frame, how many frames
-                //                      will we wait before closing the gate.
-                //  NOISE_GATE_FRAMES_TO_AVERAGE:  How many audio frames should we average together to compute noise floor.
-                //                      More means better rejection but also can reject continuous things like singing.
-                // NUMBER_OF_NOISE_SAMPLE_FRAMES:  How often should we re-evaluate the noise floor?
-                
-                
                 float loudness = 0;
                 float thisSample = 0;
-                int samplesOverNoiseGate = 0;
                 
-                const float NOISE_GATE_HEIGHT = 7.0f;
-                const int NOISE_GATE_WIDTH = 5;
-                const int NOISE_GATE_CLOSE_FRAME_DELAY = 5;
-                const int NOISE_GATE_FRAMES_TO_AVERAGE = 5;
                 const float DC_OFFSET_AVERAGING = 0.99f;
                 const float CLIPPING_THRESHOLD = 0.90f;
                 
                 //
-                //  Check clipping, adjust DC offset, and check if should open noise gate
+                //  Check clipping and adjust DC offset
                 //
                 float measuredDcOffset = 0.0f;
                 //  Increment the time since the last clip
@@ -702,10 +674,6 @@ void Audio::handleAudioInput() {
                         _timeSinceLastClip = 0.0f;
                     }
                     loudness += thisSample;
-                    //  Noise Reduction:  Count peaks above the average loudness
-                    if (_noiseGateEnabled && (thisSample > (_noiseGateMeasuredFloor * NOISE_GATE_HEIGHT))) {
-                        samplesOverNoiseGate++;
-                    }
                 }
                 
                 measuredDcOffset /= NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL;
@@ -717,43 +685,6 @@ void Audio::handleAudioInput() {
                 }
                 
                 _lastInputLoudness = fabs(loudness / NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL);
-                
-                //  If Noise Gate is enabled, check and turn the gate on and off
-                if (!_audioSourceInjectEnabled && _noiseGateEnabled) {
-                    float averageOfAllSampleFrames = 0.0f;
-                    _noiseSampleFrames[_noiseGateSampleCounter++] = _lastInputLoudness;
-                    if (_noiseGateSampleCounter == NUMBER_OF_NOISE_SAMPLE_FRAMES) {
-                        float smallestSample = FLT_MAX;
-                        for (int i = 0; i <= NUMBER_OF_NOISE_SAMPLE_FRAMES - NOISE_GATE_FRAMES_TO_AVERAGE; i += NOISE_GATE_FRAMES_TO_AVERAGE) {
-                            float thisAverage = 0.0f;
-                            for (int j = i; j < i + NOISE_GATE_FRAMES_TO_AVERAGE; j++) {
-                                thisAverage += _noiseSampleFrames[j];
-                                averageOfAllSampleFrames += _noiseSampleFrames[j];
-                            }
-                            thisAverage /= NOISE_GATE_FRAMES_TO_AVERAGE;
-                            
-                            if (thisAverage < smallestSample) {
-                                smallestSample = thisAverage;
-                            }
-                        }
-                        averageOfAllSampleFrames /= NUMBER_OF_NOISE_SAMPLE_FRAMES;
-                        _noiseGateMeasuredFloor = smallestSample;
-                        _noiseGateSampleCounter = 0;
-                        
-                    }
-                    if (samplesOverNoiseGate > NOISE_GATE_WIDTH) {
-                        _noiseGateOpen = true;
-                        _noiseGateFramesToClose = NOISE_GATE_CLOSE_FRAME_DELAY;
-                    } else {
-                        if (--_noiseGateFramesToClose == 0) {
-                            _noiseGateOpen = false;
-                        }
-                    }
-                    if (!_noiseGateOpen) {
-                        memset(networkAudioSamples, 0, NETWORK_BUFFER_LENGTH_BYTES_PER_CHANNEL);
-                        _lastInputLoudness = 0;
-                    }
-                }
             } else {
                 float loudness = 0.0f;
                 
@@ -763,6 +694,19 @@ void Audio::handleAudioInput() {
                 
                 _lastInputLoudness = fabs(loudness / NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL);
             }
+
+            //  With noise reduction on, frames the voice activity detector doesn't hear speech in go out as silent
+            //  frames. The injected tone is always sent.
+            if (!_audioSourceInjectEnabled && _noiseGateEnabled) {
+                int numChannels = _isStereoInput ? 2 : 1;
+                bool isTransmitting = _voiceActivityDetector.processFrame(networkAudioSamples, numNetworkSamples,
+                                                                          numChannels);
+                _noiseGateMeasuredFloor = _voiceActivityDetector.getComfortNoiseLevel();
+                if (!isTransmitting) {
+                    memset(networkAudioSamples, 0, numNetworkBytes);
+                    _lastInputLoudness = 0;
+                }
+            }
         } else {
             // our input loudness is 0, since we're muted
             _lastInputLoudness = 0;
@@ -833,6 +777,10 @@ void Audio::handleAudioInput() {
                 // set the mono/stereo byte
                 *currentPacketPtr++ = isStereo;
 
+                // set the codec our samples are encoded with and the codecs we can decode the mix with
+                *currentPacketPtr++ = (quint8)_upstreamEncoder.getType();
+                *currentPacketPtr++ = SUPPORTED_AUDIO_CODECS_MASK;
+
                 // memcpy the three float positions
                 memcpy(currentPacketPtr, &headPosition, sizeof(headPosition));
                 currentPacketPtr += (sizeof(headPosition));
@@ -841,8 +789,12 @@ void Audio::handleAudioInput() {
                 memcpy(currentPacketPtr, &headOrientation, sizeof(headOrientation));
                 currentPacketPtr += sizeof(headOrientation);
 
-                // audio samples have already been packed (written to networkAudioSamples)
-                currentPacketPtr += numNetworkBytes;
+                // audio samples have already been written to networkAudioSamples, encode them in place
+                static char encodedAudioData[MAX_PACKET_SIZE];
+                int numEncodedBytes = _upstreamEncoder.encode(networkAudioSamples, numNetworkSamples,
+                                                              _isStereoInput ? 2 : 1, encodedAudioData);
+                memcpy(currentPacketPtr, encodedAudioData, numEncodedBytes);
+                currentPacketPtr += numEncodedBytes;
             }
 
             // first time this is 0
@@ -860,6 +812,12 @@ void Audio::handleAudioInput() {
             nodeList->writeDatagram(audioDataPacket, packetBytes, audioMixer);
             _outgoingAvatarAudioSequenceNumber++;
 
+            if (packetType == PacketTypeSilentAudioFrame) {
+                _uplinkStats.silentFrameSent(packetBytes);
+            } else {
+                _uplinkStats.audioFrameSent(packetBytes);
+            }
+
             Application::getInstance()->getBandwidthMeter()->outputStream(BandwidthMeter::AUDIO)
                 .updateValue(packetBytes);
         }
@@ -1132,6 +1090,7 @@ void Audio::toggleMute() {
 
 void Audio::toggleAudioNoiseReduction() {
     _noiseGateEnabled = !_noiseGateEnabled;
+    _voiceActivityDetector.reset();
 }
 
 void Audio::toggleStereoInput() {
@@ -1509,10 +1468,10 @@ void Audio::renderStats(const float* color, int width, int height) {
         return;
     }
 
-    const int linesWhenCentered = _statsShowInjectedStreams ? 34 : 27;
+    const int linesWhenCentered = _statsShowInjectedStreams ? 35 : 28;
     const int CENTERED_BACKGROUND_HEIGHT = STATS_HEIGHT_PER_LINE * linesWhenCentered;
 
-    int lines = _statsShowInjectedStreams ? _audioMixerInjectedStreamAudioStatsMap.size() * 7 + 27 : 27;
+    int lines = _statsShowInjectedStreams ? _audioMixerInjectedStreamAudioStatsMap.size() * 7 + 28 : 28;
     int statsHeight = STATS_HEIGHT_PER_LINE * lines;
 
 
@@ -1605,6 +1564,16 @@ void Audio::renderStats(const float* color, int width, int height) {
     verticalOffset += STATS_HEIGHT_PER_LINE;
     drawText(horizontalOffset, verticalOffset, scale, rotation, font, stringBuffer, color);
 
+    const quint64 BYTES_PER_KILOBYTE = 1024;
+    sprintf(stringBuffer, "   Voice activity (overall) | audio: %llu (%llukB), silent: %llu (%llukB), %5.1f%% silent",
+        (unsigned long long)_uplinkStats.getAudioFrames(),
+        (unsigned long long)(_uplinkStats.getAudioBytes() / BYTES_PER_KILOBYTE),
+        (unsigned long long)_uplinkStats.getSilentFrames(),
+        (unsigned long long)(_uplinkStats.getSilentBytes() / BYTES_PER_KILOBYTE),
+        _uplinkStats.getSilentFrameRatio() * 100.0f);
+    verticalOffset += STATS_HEIGHT_PER_LINE;
+    drawText(horizontalOffset, verticalOffset, scale, rotation, font, stringBuffer, color);
+
     verticalOffset += STATS_HEIGHT_PER_LINE;    // blank line
 
     char upstreamMicLabelString[] = "Upstream mic audio stats (received and reported by audio-mixer):";
@@ -16,6 +16,7 @@
 #include <vector>
 
 #include "InterfaceConfig.h"
+#include "AudioCodec.h"
 #include "AudioStreamStats.h"
 #include "Recorder.h"
 #include "RingBufferHistory.h"
@@ -28,6 +29,8 @@
 #include "AudioGain.h"
 #include "AudioFilter.h"
 #include "AudioFilterBank.h"
+#include "AudioUplinkStats.h"
+#include "VoiceActivityDetector.h"
 
 #include <QAudio>
 #include <QAudioInput>
@@ -215,13 +218,10 @@ private:
     float _timeSinceLastClip;
     float _dcOffset;
     float _noiseGateMeasuredFloor;
-    float* _noiseSampleFrames;
-    int _noiseGateSampleCounter;
-    bool _noiseGateOpen;
     bool _noiseGateEnabled;
+    VoiceActivityDetector _voiceActivityDetector;
     bool _audioSourceInjectEnabled;
     
-    int _noiseGateFramesToClose;
     int _totalInputAudioSamples;
     
     float _collisionSoundMagnitude;
@@ -351,6 +351,8 @@ private:
     QHash<QUuid, AudioStreamStats> _audioMixerInjectedStreamAudioStatsMap;
 
     quint16 _outgoingAvatarAudioSequenceNumber;
+    AudioCodecADPCM _upstreamEncoder;
+    AudioUplinkStats _uplinkStats;
     
     MovingMinMaxAvg<float> _audioInputMsecsReadStats;
     MovingMinMaxAvg<float> _inputRingBufferMsecsAvailableStats;
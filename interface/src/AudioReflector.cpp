@@ -636,45 +636,54 @@ int AudioReflector::analyzePathsSingleStep() {
 
     QVector<AudioPath*>* pathsLists[] = { &_inboundAudioPaths, &_localAudioPaths };
 
+    // cast the next ray of every active path in one batch, the paths are stepped in the same order afterwards
+    QVector<AudioPath*> castingPaths;
+    QVector<OctreeRayQuery> rays;
+
     for(unsigned int i = 0; i < sizeof(pathsLists) / sizeof(pathsLists[0]); i++) {
 
         QVector<AudioPath*>& pathList = *pathsLists[i];
 
         foreach(AudioPath* const& path, pathList) {
-    
-            glm::vec3 start = path->lastPoint;
-            glm::vec3 direction = path->lastDirection;
-            OctreeElement* elementHit; // output from findRayIntersection
-            float distance; // output from findRayIntersection
-            BoxFace face; // output from findRayIntersection
-
             if (!path->finalized) {
                 activePaths++;
-            
+
                 if (path->bounceCount > ABSOLUTE_MAXIMUM_BOUNCE_COUNT) {
                     path->finalized = true;
-                } else if (_voxels->findRayIntersection(start, direction, elementHit, distance, face)) {
-                    // TODO: we need to decide how we want to handle locking on the ray intersection, if we force lock,
-                    // we get an accurate picture, but it could prevent rendering of the voxels. If we trylock (default), 
-                    // we might not get ray intersections where they may exist, but we can't really detect that case...
-                    // add last parameter of Octree::Lock to force locking
-                    handlePathPoint(path, distance, elementHit, face);
-
                 } else {
-                    // If we didn't intersect, but this was a diffusion ray, then we will go ahead and cast a short ray out
-                    // from our last known point, in the last known direction, and leave that sound source hanging there
-                    if (path->isDiffusion) {
-                        const float MINIMUM_RANDOM_DISTANCE = 0.25f;
-                        const float MAXIMUM_RANDOM_DISTANCE = 0.5f;
-                        float distance = randFloatInRange(MINIMUM_RANDOM_DISTANCE, MAXIMUM_RANDOM_DISTANCE);
-                        handlePathPoint(path, distance, NULL, UNKNOWN_FACE);
-                    } else {
-                        path->finalized = true; // if it doesn't intersect, then it is finished
-                    }
+                    castingPaths.append(path);
+                    rays.append(OctreeRayQuery(path->lastPoint, path->lastDirection));
                 }
             }
         }
     }
+
+    // TODO: we need to decide how we want to handle locking on the ray intersection, if we force lock,
+    // we get an accurate picture, but it could prevent rendering of the voxels. If we trylock (default),
+    // we might not get ray intersections where they may exist, but we can't really detect that case...
+    // add last parameter of Octree::Lock to force locking
+    _voxels->findRayIntersections(rays);
+
+    for (int i = 0; i < castingPaths.size(); i++) {
+        AudioPath* path = castingPaths[i];
+        const OctreeRayQuery& ray = rays[i];
+
+        if (ray.intersects) {
+            handlePathPoint(path, ray.distance, ray.element, ray.face);
+
+        } else {
+            // If we didn't intersect, but this was a diffusion ray, then we will go ahead and cast a short ray out
+            // from our last known point, in the last known direction, and leave that sound source hanging there
+            if (path->isDiffusion) {
+                const float MINIMUM_RANDOM_DISTANCE = 0.25f;
+                const float MAXIMUM_RANDOM_DISTANCE = 0.5f;
+                float distance = randFloatInRange(MINIMUM_RANDOM_DISTANCE, MAXIMUM_RANDOM_DISTANCE);
+                handlePathPoint(path, distance, NULL, UNKNOWN_FACE);
+            } else {
+                path->finalized = true; // if it doesn't intersect, then it is finished
+            }
+        }
+    }
     return activePaths;
 }
 
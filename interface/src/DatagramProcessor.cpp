@@ -141,7 +141,7 @@ void DatagramProcessor::processDatagrams() {
                     glm::vec3 position;
                     float radius;
                     
-                    int headerSize = numBytesForPacketHeaderGivenPacketType(PacketTypeMuteEnvironment);
+                    int headerSize = numBytesForPacketHeader(incomingPacket);
                     memcpy(&position, incomingPacket.constData() + headerSize, sizeof(glm::vec3));
                     memcpy(&radius, incomingPacket.constData() + headerSize + sizeof(glm::vec3), sizeof(float));
                     
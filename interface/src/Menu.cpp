@@ -1230,13 +1230,13 @@ void Menu::displayAddressNotFoundMessage() {
 }
 
 void Menu::muteEnvironment() {
-    int headerSize = numBytesForPacketHeaderGivenPacketType(PacketTypeMuteEnvironment);
-    int packetSize = headerSize + sizeof(glm::vec3) + sizeof(float);
+    int maxHeaderSize = numBytesForPacketHeaderGivenPacketType(PacketTypeMuteEnvironment);
 
     glm::vec3 position = Application::getInstance()->getAvatar()->getPosition();
 
-    char* packet = (char*)malloc(packetSize);
-    populatePacketHeader(packet, PacketTypeMuteEnvironment);
+    char* packet = (char*)malloc(maxHeaderSize + sizeof(glm::vec3) + sizeof(float));
+    int headerSize = populatePacketHeader(packet, PacketTypeMuteEnvironment);
+    int packetSize = headerSize + sizeof(glm::vec3) + sizeof(float);
     memcpy(packet + headerSize, &position, sizeof(glm::vec3));
     memcpy(packet + headerSize + sizeof(glm::vec3), &MUTE_RADIUS, sizeof(float));
 
@@ -69,7 +69,9 @@ Avatar::Avatar() :
     _moving(false),
     _collisionGroups(0),
     _initialized(false),
-    _shouldRenderBillboard(true)
+    _shouldRenderBillboard(true),
+    _isSimulatingSkeleton(false),
+    _isPosingSkeleton(false)
 {
     // we may have been created in the network thread, but we live in the main thread
     moveToThread(Application::getInstance()->thread());
@@ -114,7 +116,14 @@ float Avatar::getLODDistance() const {
 
 void Avatar::simulate(float deltaTime) {
     PerformanceTimer perfTimer("simulate");
-    
+    if (beginSimulation(deltaTime)) {
+        PerformanceTimer perfTimer("pose");
+        _skeletonModel.updatePose();
+    }
+    finishSimulation(deltaTime);
+}
+
+bool Avatar::beginSimulation(float deltaTime) {
     // update the avatar's position according to its referential
     if (_referential) {
         if (_referential->hasExtraData()) {
@@ -164,18 +173,30 @@ void Avatar::simulate(float deltaTime) {
     }
     _skeletonModel.setLODDistance(getLODDistance());
     
-    if (!_shouldRenderBillboard && inViewFrustum) {
+    _isSimulatingSkeleton = !_shouldRenderBillboard && inViewFrustum;
+    _isPosingSkeleton = false;
+    if (_isSimulatingSkeleton) {
+        PerformanceTimer perfTimer("skeleton");
+        if (_hasNewJointRotations) {
+            for (int i = 0; i < _jointData.size(); i++) {
+                const JointData& data = _jointData.at(i);
+                _skeletonModel.setJointState(i, data.valid, data.rotation);
+            }
+        }
+        _isPosingSkeleton = _skeletonModel.beginSimulation(deltaTime, _hasNewJointRotations);
+        _hasNewJointRotations = false;
+    }
+    return _isPosingSkeleton;
+}
+
+void Avatar::finishSimulation(float deltaTime) {
+    if (_isSimulatingSkeleton) {
         {
             PerformanceTimer perfTimer("skeleton");
-            if (_hasNewJointRotations) {
-                for (int i = 0; i < _jointData.size(); i++) {
-                    const JointData& data = _jointData.at(i);
-                    _skeletonModel.setJointState(i, data.valid, data.rotation);
-                }
+            if (_isPosingSkeleton) {
+                _skeletonModel.finishSimulation(deltaTime);
             }
-            _skeletonModel.simulate(deltaTime, _hasNewJointRotations);
             simulateAttachments(deltaTime);
-            _hasNewJointRotations = false;
         }
         {
             PerformanceTimer perfTimer("head");
@@ -76,6 +76,11 @@ public:
 
     void init();
     void simulate(float deltaTime);
+
+    /// Runs the part of a simulation that comes before posing the skeleton. Returns true if the skeleton model is to be
+    /// posed, by calling its updatePose or by adding it to a PoseBatch, before finishSimulation.
+    bool beginSimulation(float deltaTime);
+    void finishSimulation(float deltaTime);
     
     enum RenderMode { NORMAL_RENDER_MODE, SHADOW_RENDER_MODE, MIRROR_RENDER_MODE };
     
@@ -241,6 +246,8 @@ private:
     bool _initialized;
     QScopedPointer<Texture> _billboardTexture;
     bool _shouldRenderBillboard;
+    bool _isSimulatingSkeleton; // in view and not a billboard, set by beginSimulation
+    bool _isPosingSkeleton;
     bool _isLookAtTarget;
 
     void renderBillboard();
@@ -72,7 +72,8 @@ void AvatarManager::updateOtherAvatars(float deltaTime) {
     glm::vec3 mouseOrigin = applicationInstance->getMouseRayOrigin();
     glm::vec3 mouseDirection = applicationInstance->getMouseRayDirection();
 
-    // simulate avatars
+    // simulate avatars, posing all of their skeletons in one batch
+    QVector<Avatar*> simulatingAvatars;
     AvatarHash::iterator avatarIterator = _avatarHash.begin();
     while (avatarIterator != _avatarHash.end()) {
         AvatarSharedPointer sharedAvatar = avatarIterator.value();
@@ -86,14 +87,25 @@ void AvatarManager::updateOtherAvatars(float deltaTime) {
         }
         if (!shouldKillAvatar(sharedAvatar)) {
             // this avatar's mixer is still around, go ahead and simulate it
-            avatar->simulate(deltaTime);
-            avatar->setMouseRay(mouseOrigin, mouseDirection);
+            if (avatar->beginSimulation(deltaTime)) {
+                _poseBatch.addModel(&avatar->getSkeletonModel());
+            }
+            simulatingAvatars.append(avatar);
             ++avatarIterator;
         } else {
             // the mixer that owned this avatar is gone, give it to the vector of fades and kill it
             avatarIterator = erase(avatarIterator);
         }
     }
+
+    {
+        PerformanceTimer perfTimer("poses");
+        _poseBatch.run();
+    }
+    foreach (Avatar* avatar, simulatingAvatars) {
+        avatar->finishSimulation(deltaTime);
+        avatar->setMouseRay(mouseOrigin, mouseDirection);
+    }
     
     // simulate avatar fades
     simulateAvatarFades(deltaTime);
@@ -19,6 +19,7 @@
 #include <AvatarHashMap.h>
 
 #include "Avatar.h"
+#include "renderer/PoseBatch.h"
 
 class MyAvatar;
 
@@ -63,6 +64,7 @@ private:
     
     QVector<AvatarSharedPointer> _avatarFades;
     QSharedPointer<MyAvatar> _myAvatar;
+    PoseBatch _poseBatch;
     
     QVector<AvatarManager::LocalLight> _localLights;
 };
@@ -76,13 +76,17 @@ void SkeletonModel::setJointStates(QVector<JointState> states) {
 const float PALM_PRIORITY = DEFAULT_PRIORITY;
 const float LEAN_PRIORITY = DEFAULT_PRIORITY;
 
-void SkeletonModel::simulate(float deltaTime, bool fullUpdate) {
+bool SkeletonModel::beginSimulation(float deltaTime, bool fullUpdate) {
     setTranslation(_owningAvatar->getPosition());
     static const glm::quat refOrientation = glm::angleAxis(PI, glm::vec3(0.0f, 1.0f, 0.0f));
     setRotation(_owningAvatar->getOrientation() * refOrientation);
     setScale(glm::vec3(1.0f, 1.0f, 1.0f) * _owningAvatar->getScale() * MODEL_SCALE);
     setBlendshapeCoefficients(_owningAvatar->getHead()->getBlendshapeCoefficients());
-    
+
+    return Model::beginSimulation(deltaTime, fullUpdate);
+}
+
+void SkeletonModel::simulate(float deltaTime, bool fullUpdate) {
     Model::simulate(deltaTime, fullUpdate);
     
     if (!isActive() || !_owningAvatar->isMyAvatar()) {
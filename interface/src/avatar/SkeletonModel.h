@@ -33,6 +33,7 @@ public:
     void setJointStates(QVector<JointState> states);
 
     void simulate(float deltaTime, bool fullUpdate = true);
+    virtual bool beginSimulation(float deltaTime, bool fullUpdate = true);
 
     /// \param jointIndex index of hand joint
     /// \param shapes[out] list in which is stored pointers to hand shapes
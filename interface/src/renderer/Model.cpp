@@ -16,11 +16,13 @@
 #include <glm/gtx/transform.hpp>
 #include <glm/gtx/norm.hpp>
 
+#include <BlendshapeBlender.h>
 #include <CapsuleShape.h>
 #include <GeometryUtil.h>
 #include <PerfStat.h>
 #include <PhysicsEntity.h>
 #include <ShapeCollider.h>
+#include <SimdSupport.h>
 #include <SphereShape.h>
 
 #include "Application.h"
@@ -787,7 +789,8 @@ class Blender : public QRunnable {
 public:
 
     Blender(Model* model, int blendNumber, const QWeakPointer<NetworkGeometry>& geometry,
-        const QVector<FBXMesh>& meshes, const QVector<float>& blendshapeCoefficients);
+        const QSharedPointer<BlendshapeBlender>& blendshapeBlender, const QVector<FBXMesh>& meshes,
+        const QVector<float>& blendshapeCoefficients);
     
     virtual void run();
 
@@ -796,15 +799,18 @@ private:
     QPointer<Model> _model;
     int _blendNumber;
     QWeakPointer<NetworkGeometry> _geometry;
+    QSharedPointer<BlendshapeBlender> _blendshapeBlender;
     QVector<FBXMesh> _meshes;
     QVector<float> _blendshapeCoefficients;
 };
 
 Blender::Blender(Model* model, int blendNumber, const QWeakPointer<NetworkGeometry>& geometry,
-        const QVector<FBXMesh>& meshes, const QVector<float>& blendshapeCoefficients) :
+        const QSharedPointer<BlendshapeBlender>& blendshapeBlender, const QVector<FBXMesh>& meshes,
+        const QVector<float>& blendshapeCoefficients) :
     _model(model),
     _blendNumber(blendNumber),
     _geometry(geometry),
+    _blendshapeBlender(blendshapeBlender),
     _meshes(meshes),
     _blendshapeCoefficients(blendshapeCoefficients) {
 }
@@ -812,31 +818,8 @@ Blender::Blender(Model* model, int blendNumber, const QWeakPointer<NetworkGeomet
 void Blender::run() {
     QVector<glm::vec3> vertices, normals;
     if (!_model.isNull()) {
-        int offset = 0;
-        foreach (const FBXMesh& mesh, _meshes) {
-            if (mesh.blendshapes.isEmpty()) {
-                continue;
-            }
-            vertices += mesh.vertices;
-            normals += mesh.normals;
-            glm::vec3* meshVertices = vertices.data() + offset;
-            glm::vec3* meshNormals = normals.data() + offset;
-            offset += mesh.vertices.size();
-            const float NORMAL_COEFFICIENT_SCALE = 0.01f;
-            for (int i = 0, n = qMin(_blendshapeCoefficients.size(), mesh.blendshapes.size()); i < n; i++) {
-                float vertexCoefficient = _blendshapeCoefficients.at(i);
-                if (vertexCoefficient < EPSILON) {
-                    continue;
-                }
-                float normalCoefficient = vertexCoefficient * NORMAL_COEFFICIENT_SCALE;
-                const FBXBlendshape& blendshape = mesh.blendshapes.at(i);
-                for (int j = 0; j < blendshape.indices.size(); j++) {
-                    int index = blendshape.indices.at(j);
-                    meshVertices[index] += blendshape.vertices.at(j) * vertexCoefficient;
-                    meshNormals[index] += blendshape.normals.at(j) * normalCoefficient;
-                }
-            }
-        }
+        // only the blendshapes whose coefficients changed since the last blend of this model are applied
+        _blendshapeBlender->blend(_meshes, _blendshapeCoefficients, vertices, normals);
     }
     // post the result to the geometry cache, which will dispatch to the model if still alive
     QMetaObject::invokeMethod(Application::getInstance()->getGeometryCache(), "setBlendedVertices",
@@ -904,32 +887,34 @@ void Model::snapToRegistrationPoint() {
 }
 
 void Model::simulate(float deltaTime, bool fullUpdate) {
+    if (beginSimulation(deltaTime, fullUpdate)) {
+        updatePose();
+        finishSimulation(deltaTime);
+    }
+}
+
+bool Model::beginSimulation(float deltaTime, bool fullUpdate) {
     fullUpdate = updateGeometry() || fullUpdate || (_scaleToFit && !_scaledToFit)
                     || (_snapModelToRegistrationPoint && !_snappedToRegistrationPoint);
                     
-    if (isActive() && fullUpdate) {
-        _calculatedMeshBoxesValid = false; // if we have to simulate, we need to assume our mesh boxes are all invalid
+    if (!(isActive() && fullUpdate)) {
+        return false;
+    }
+    _calculatedMeshBoxesValid = false; // if we have to simulate, we need to assume our mesh boxes are all invalid
 
-        // check for scale to fit
-        if (_scaleToFit && !_scaledToFit) {
-            scaleToFit();
-        }
-        if (_snapModelToRegistrationPoint && !_snappedToRegistrationPoint) {
-            snapToRegistrationPoint();
-        }
-        simulateInternal(deltaTime);
+    // check for scale to fit
+    if (_scaleToFit && !_scaledToFit) {
+        scaleToFit();
+    }
+    if (_snapModelToRegistrationPoint && !_snappedToRegistrationPoint) {
+        snapToRegistrationPoint();
     }
+    simulateAnimations(deltaTime);
+    return true;
 }
 
-void Model::simulateInternal(float deltaTime) {
-    // NOTE: this is a recursive call that walks all attachments, and their attachments
+void Model::updatePose() {
     // update the world space transforms for all joints
-    
-    // update animations
-    foreach (const AnimationHandlePointer& handle, _runningAnimations) {
-        handle->simulate(deltaTime);
-    }
-
     for (int i = 0; i < _jointStates.size(); i++) {
         updateJointState(i);
     }
@@ -938,7 +923,11 @@ void Model::simulateInternal(float deltaTime) {
     }
 
     _shapesAreDirty = !_shapes.isEmpty();
-    
+
+    updateClusterMatrices();
+}
+
+void Model::finishSimulation(float deltaTime) {
     // update the attachment transforms and simulate them
     const FBXGeometry& geometry = _geometry->getFBXGeometry();
     for (int i = 0; i < _attachments.size(); i++) {
@@ -964,28 +953,67 @@ void Model::simulateInternal(float deltaTime) {
         }
     }
     
+    // post the blender if we're not currently waiting for one to finish
+    if (geometry.hasBlendedMeshes() && _blendshapeCoefficients != _blendedBlendshapeCoefficients) {
+        _blendedBlendshapeCoefficients = _blendshapeCoefficients;
+        Application::getInstance()->getGeometryCache()->noteRequiresBlend(this);
+    }
+}
+
+void Model::simulateInternal(float deltaTime) {
+    // NOTE: this is a recursive call that walks all attachments, and their attachments
+    simulateAnimations(deltaTime);
+    updatePose();
+    finishSimulation(deltaTime);
+}
+
+void Model::simulateAnimations(float deltaTime) {
+    foreach (const AnimationHandlePointer& handle, _runningAnimations) {
+        handle->simulate(deltaTime);
+    }
+}
+
+/// Sets result to left * right, computed in the same order as the glm operator so that the results are identical.
+/// The result may not be one of the operands.
+static void multiplyMatrices(const glm::mat4& left, const glm::mat4& right, glm::mat4& result) {
+#ifdef HIFI_HAVE_SSE
+    __m128 left0 = _mm_loadu_ps(&left[0][0]);
+    __m128 left1 = _mm_loadu_ps(&left[1][0]);
+    __m128 left2 = _mm_loadu_ps(&left[2][0]);
+    __m128 left3 = _mm_loadu_ps(&left[3][0]);
+    for (int i = 0; i < 4; i++) {
+        __m128 column = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+            _mm_mul_ps(left0, _mm_set1_ps(right[i][0])),
+            _mm_mul_ps(left1, _mm_set1_ps(right[i][1]))),
+            _mm_mul_ps(left2, _mm_set1_ps(right[i][2]))),
+            _mm_mul_ps(left3, _mm_set1_ps(right[i][3])));
+        _mm_storeu_ps(&result[i][0], column);
+    }
+#else
+    result = left * right;
+#endif
+}
+
+void Model::updateClusterMatrices() {
+    // a joint is usually bound to clusters in several meshes, so rotate each joint's transform into the world frame once
     glm::mat4 modelToWorld = glm::mat4_cast(_rotation);
+    _jointWorldTransforms.resize(_jointStates.size());
+    for (int i = 0; i < _jointStates.size(); i++) {
+        const JointState& state = _jointStates.at(i);
+        multiplyMatrices(modelToWorld, _showTrueJointTransforms ? state.getTransform() : state.getVisibleTransform(),
+            _jointWorldTransforms[i]);
+    }
+
+    const FBXGeometry& geometry = _geometry->getFBXGeometry();
     for (int i = 0; i < _meshStates.size(); i++) {
         MeshState& state = _meshStates[i];
         const FBXMesh& mesh = geometry.meshes.at(i);
-        if (_showTrueJointTransforms) {
-            for (int j = 0; j < mesh.clusters.size(); j++) {
-                const FBXCluster& cluster = mesh.clusters.at(j);
-                state.clusterMatrices[j] = modelToWorld * _jointStates[cluster.jointIndex].getTransform() * cluster.inverseBindMatrix;
-            }
-        } else {
-            for (int j = 0; j < mesh.clusters.size(); j++) {
-                const FBXCluster& cluster = mesh.clusters.at(j);
-                state.clusterMatrices[j] = modelToWorld * _jointStates[cluster.jointIndex].getVisibleTransform() * cluster.inverseBindMatrix;
-            }
+        for (int j = 0; j < mesh.clusters.size(); j++) {
+            const FBXCluster& cluster = mesh.clusters.at(j);
+            multiplyMatrices(_jointWorldTransforms.at(cluster.jointIndex), cluster.inverseBindMatrix,
+                state.clusterMatrices[j]);
         }
     }
-    
-    // post the blender if we're not currently waiting for one to finish
-    if (geometry.hasBlendedMeshes() && _blendshapeCoefficients != _blendedBlendshapeCoefficients) {
-        _blendedBlendshapeCoefficients = _blendshapeCoefficients;
-        Application::getInstance()->getGeometryCache()->noteRequiresBlend(this);
-    }
 }
 
 void Model::updateJointState(int index) {
@@ -1250,7 +1278,10 @@ void Model::renderJointCollisionShapes(float alpha) {
 bool Model::maybeStartBlender() {
     const FBXGeometry& fbxGeometry = _geometry->getFBXGeometry();
     if (fbxGeometry.hasBlendedMeshes()) {
-        QThreadPool::globalInstance()->start(new Blender(this, ++_blendNumber, _geometry,
+        if (!_blendshapeBlender) {
+            _blendshapeBlender = QSharedPointer<BlendshapeBlender>(new BlendshapeBlender());
+        }
+        QThreadPool::globalInstance()->start(new Blender(this, ++_blendNumber, _geometry, _blendshapeBlender,
             fbxGeometry.meshes, _blendshapeCoefficients));
         return true;
     }
@@ -1300,6 +1331,7 @@ void Model::deleteGeometry() {
     }
     _attachments.clear();
     _blendedVertexBuffers.clear();
+    _blendshapeBlender.clear();
     _jointStates.clear();
     _meshStates.clear();
     clearShapes();
@@ -29,6 +29,7 @@
 class QScriptEngine;
 
 class AnimationHandle;
+class BlendshapeBlender;
 class Shape;
 class RenderArgs;
 class ViewFrustum;
@@ -87,6 +88,17 @@ public:
     void init();
     void reset();
     virtual void simulate(float deltaTime, bool fullUpdate = true);
+
+    /// Runs the part of a simulation that comes before posing the joints. Returns true if the model is to be posed, in
+    /// which case updatePose and then finishSimulation must follow.
+    virtual bool beginSimulation(float deltaTime, bool fullUpdate = true);
+
+    /// Updates the joint states and the cluster matrices. Doesn't touch anything but this model, so the poses of
+    /// different models may be updated at the same time (see PoseBatch).
+    void updatePose();
+
+    /// Simulates the attachments and posts the blender once the model is posed.
+    void finishSimulation(float deltaTime);
     
     enum RenderMode { DEFAULT_RENDER_MODE, SHADOW_RENDER_MODE, DIFFUSE_RENDER_MODE, NORMAL_RENDER_MODE };
     
@@ -211,6 +223,7 @@ protected:
     };
     
     QVector<MeshState> _meshStates;
+    QVector<glm::mat4> _jointWorldTransforms; // the joint transforms rotated by the model, shared by the clusters
     
     // returns 'true' if needs fullUpdate after geometry change
     bool updateGeometry();
@@ -222,6 +235,8 @@ protected:
     void snapToRegistrationPoint();
 
     void simulateInternal(float deltaTime);
+    void simulateAnimations(float deltaTime);
+    void updateClusterMatrices();
 
     /// Updates the state of the joint at the specified index.
     virtual void updateJointState(int index);
@@ -283,6 +298,7 @@ private:
     QList<AnimationHandlePointer> _runningAnimations;
 
     QVector<float> _blendedBlendshapeCoefficients;
+    QSharedPointer<BlendshapeBlender> _blendshapeBlender; // keeps the blended meshes of the current geometry
     int _blendNumber;
     int _appliedBlendNumber;
 
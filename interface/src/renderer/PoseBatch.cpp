@@ -0,0 +1,40 @@
+//
+//  PoseBatch.cpp
+//  interface/src/renderer
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <ParallelBatch.h>
+
+#include "Model.h"
+#include "PoseBatch.h"
+
+// posing a single model isn't worth waking up the pool
+const int MIN_MODELS_FOR_THREAD_POOL = 2;
+
+// the models of a run, each model is an item of the batch
+class PoseJob : public ParallelBatch {
+public:
+    QVector<Model*> models;
+
+protected:
+    virtual void runItem(int index) {
+        models.at(index)->updatePose();
+    }
+};
+
+void PoseBatch::run() {
+    if (_models.isEmpty()) {
+        return;
+    }
+    PoseJob* job = new PoseJob();
+    SharedParallelBatchPointer sharedJob(job);
+    job->models.swap(_models);
+
+    int modelCount = job->models.size();
+    ParallelBatch::runInThreadPool(sharedJob, modelCount, modelCount >= MIN_MODELS_FOR_THREAD_POOL);
+}
@@ -0,0 +1,37 @@
+//
+//  PoseBatch.h
+//  interface/src/renderer
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_PoseBatch_h
+#define hifi_PoseBatch_h
+
+#include <QVector>
+
+class Model;
+
+/// Poses a number of models together: the joint states and cluster matrices of the models are updated on the threads of
+/// the global pool as well as the calling one. Each model is posed by one thread, in the order of its joints, since the
+/// FBX joints come with every parent ahead of its children.
+class PoseBatch {
+public:
+
+    /// Adds a model for which beginSimulation returned true. Nothing else may touch the model until run returns, and
+    /// finishing its simulation is up to the caller after that.
+    void addModel(Model* model) { _models.append(model); }
+
+    int getModelCount() const { return _models.size(); }
+
+    /// Poses all the models added since the last run, returns once they're all done.
+    void run();
+
+private:
+    QVector<Model*> _models;
+};
+
+#endif // hifi_PoseBatch_h
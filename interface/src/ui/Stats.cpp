@@ -459,7 +459,7 @@ void Stats::display(
 
     VoxelSystem* voxels = Application::getInstance()->getVoxels();
 
-    lines = _expanded ? 14 : 3;
+    lines = _expanded ? 15 : 3;
     if (_expanded && Menu::getInstance()->isOptionChecked(MenuOption::AudioSpatialProcessing)) {
         lines += 10; // spatial audio processing adds 1 spacing line and 8 extra lines of info
     }
@@ -497,6 +497,14 @@ void Stats::display(
                     << " / Translucent:" << entities->getTranslucentMeshPartsRendered();
         verticalOffset += STATS_PELS_PER_LINE;
         drawText(horizontalOffset, verticalOffset, scale, rotation, font, (char*)voxelStats.str().c_str(), color);
+
+        voxelStats.str("");
+        voxelStats << "  Write Lock usecs: " << entities->getLastWriteLockUsecs()
+                    << " / Avg:" << (int)entities->getAverageWriteLockUsecs()
+                    << " / Max:" << entities->getMaxWriteLockUsecs()
+                    << " / Sections per commit:" << (int)entities->getAverageSectionsPerCommit();
+        verticalOffset += STATS_PELS_PER_LINE;
+        drawText(horizontalOffset, verticalOffset, scale, rotation, font, (char*)voxelStats.str().c_str(), color);
     }
 
     voxelStats.str("");
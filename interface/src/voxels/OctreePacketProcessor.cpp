@@ -61,7 +61,7 @@ void OctreePacketProcessor::processPacket(const SharedNodePointer& sendingNode,
     } // fall through to piggyback message
     
     voxelPacketType = packetTypeForPacket(mutablePacket);
-    PacketVersion packetVersion = mutablePacket[1];
+    PacketVersion packetVersion = versionFromPacketHeader(mutablePacket.constData());
     PacketVersion expectedVersion = versionForPacketType(voxelPacketType);
     
     // check version of piggyback packet against expected version
@@ -87,6 +87,9 @@ void OctreePacketProcessor::processPacket(const SharedNodePointer& sendingNode,
         switch(voxelPacketType) {
             case PacketTypeEntityErase: {
                 if (Menu::getInstance()->isOptionChecked(MenuOption::Models)) {
+                    // entity data staged before the erase has to reach the tree first, or it would bring erased
+                    // entities back
+                    app->_entities.commitStagedSections();
                     app->_entities.processEraseMessage(mutablePacket, sendingNode);
                 }
             } break;
@@ -112,3 +115,6 @@ void OctreePacketProcessor::processPacket(const SharedNodePointer& sendingNode,
     }
 }
 
+void OctreePacketProcessor::postProcess() {
+    Application::getInstance()->_entities.commitStagedSections();
+}
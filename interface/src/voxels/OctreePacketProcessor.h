@@ -20,5 +20,8 @@ class OctreePacketProcessor : public ReceivedPacketProcessor {
     Q_OBJECT
 protected:
     virtual void processPacket(const SharedNodePointer& sendingNode, const QByteArray& packet);
+
+    /// reads the entity data staged by the batch into the tree, so that the tree is locked once per batch
+    virtual void postProcess();
 };
 #endif // hifi_OctreePacketProcessor_h
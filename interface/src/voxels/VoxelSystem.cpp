@@ -15,6 +15,8 @@
 #include <iostream> // to load voxels from file
 #include <fstream> // to load voxels from file
 
+#include <QtCore/QVector>
+
 #include <OctalCode.h>
 #include <PacketHeaders.h>
 #include <PerfStat.h>
@@ -1748,6 +1750,18 @@ bool VoxelSystem::hasViewChanged() {
     return result;
 }
 
+// where the children of an element are in the current and the last culled view frustum, found for all of them at once
+class CulledChildren {
+public:
+    const unsigned char* parentOctalCode; // NULL until the children of an element at this level have been culled
+    ViewFrustum::location thisViewLocations[NUMBER_OF_CHILDREN];
+    unsigned char thisViewPlaneMasks[NUMBER_OF_CHILDREN];
+    ViewFrustum::location lastViewLocations[NUMBER_OF_CHILDREN];
+    unsigned char lastViewPlaneMasks[NUMBER_OF_CHILDREN];
+
+    CulledChildren() : parentOctalCode(NULL) { }
+};
+
 // combines the removeOutOfView args into a single class
 class hideOutOfViewArgs {
 public:
@@ -1769,6 +1783,10 @@ public:
     unsigned long nodesOutsideOutside;
     unsigned long nodesShown;
 
+    // indexed by the level of the parent element. The tree is recursed depth first, so the children visited right after
+    // an element are always the children of the last element visited at the level above them.
+    QVector<CulledChildren> culledChildren;
+
     hideOutOfViewArgs(VoxelSystem* voxelSystem, VoxelTree* tree,
                         bool culledOnce, bool widenViewFrustum, bool wantDeltaFrustums) :
         thisVoxelSystem(voxelSystem),
@@ -1945,17 +1963,44 @@ bool VoxelSystem::hideOutOfViewOperation(OctreeElement* element, void* extraData
     VoxelTreeElement* voxel = (VoxelTreeElement*)element;
     hideOutOfViewArgs* args = (hideOutOfViewArgs*)extraData;
     
+    bool wantLastCulledFrustum = args->culledOnce && args->wantDeltaFrustums;
+
+    int level = voxel->getLevel();
+    if (args->culledChildren.size() <= level) {
+        args->culledChildren.resize(level + 1);
+    }
+    // nothing below this element has been culled yet
+    args->culledChildren[level].parentOctalCode = NULL;
+
     // If we're still recursing the tree using this operator, then we don't know if we're inside or outside...
-    // so before we move forward we need to determine our frustum location
-    ViewFrustum::location inFrustum = voxel->inFrustum(args->thisViewFrustum);
+    // so before we move forward we need to determine our frustum location. If our parent intersected the view, it already
+    // found out for us and all of our siblings at once.
+    const CulledChildren& culledSiblings = args->culledChildren[level - 1];
+    int childIndex = culledSiblings.parentOctalCode
+        ? branchIndexWithDescendant(culledSiblings.parentOctalCode, voxel->getOctalCode()) : -1;
+
+    unsigned char thisViewPlaneMask = NO_FRUSTUM_PLANES_INSIDE;
+    ViewFrustum::location inFrustum;
+    if (childIndex >= 0) {
+        inFrustum = culledSiblings.thisViewLocations[childIndex];
+        thisViewPlaneMask = culledSiblings.thisViewPlaneMasks[childIndex];
+    } else {
+        inFrustum = voxel->inFrustum(args->thisViewFrustum, thisViewPlaneMask);
+    }
 
     // If we've culled at least once, then we will use the status of this voxel in the last culled frustum to determine
     // how to proceed. If we've never culled, then we just consider all these voxels to be UNKNOWN so that we will not
     // consider that case.
     ViewFrustum::location inLastCulledFrustum = ViewFrustum::OUTSIDE; // assume outside, but should get reset to actual value
+    unsigned char lastViewPlaneMask = NO_FRUSTUM_PLANES_INSIDE;
 
-    if (args->culledOnce && args->wantDeltaFrustums) {
-        inLastCulledFrustum = voxel->inFrustum(args->lastViewFrustum);
+    if (wantLastCulledFrustum) {
+        if (childIndex >= 0) {
+            inLastCulledFrustum = culledSiblings.lastViewLocations[childIndex];
+            lastViewPlaneMask = culledSiblings.lastViewPlaneMasks[childIndex];
+        } else {
+            inLastCulledFrustum = voxel->inFrustum(args->lastViewFrustum, lastViewPlaneMask);
+        }
     }
 
     // ok, now do some processing for this node...
@@ -2022,8 +2067,16 @@ bool VoxelSystem::hideOutOfViewOperation(OctreeElement* element, void* extraData
             }
 
             // If it INTERSECTS but shouldn't be displayed, then it's probably a parent and it is at least partially in view.
-            // So we DO want to recurse the children because some of them may not be in view... nothing specifically to do,
-            // just keep iterating the children
+            // So we DO want to recurse the children because some of them may not be in view... find out where they all are
+            // while we're here, only against the planes we aren't already completely inside of
+            CulledChildren& culledChildren = args->culledChildren[level];
+            voxel->childrenInFrustum(args->thisViewFrustum, thisViewPlaneMask,
+                                     culledChildren.thisViewLocations, culledChildren.thisViewPlaneMasks);
+            if (wantLastCulledFrustum) {
+                voxel->childrenInFrustum(args->lastViewFrustum, lastViewPlaneMask,
+                                         culledChildren.lastViewLocations, culledChildren.lastViewPlaneMasks);
+            }
+            culledChildren.parentOctalCode = voxel->getOctalCode();
             return true;
 
         } break;
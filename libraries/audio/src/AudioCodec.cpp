@@ -0,0 +1,191 @@
+//
+//  AudioCodec.cpp
+//  libraries/audio/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <string.h>
+
+#include <glm/glm.hpp>
+
+#include "AudioRingBuffer.h"
+#include "AudioCodec.h"
+
+AudioCodec* AudioCodec::create(Type type) {
+    switch (type) {
+        case ADPCM:
+            return new AudioCodecADPCM();
+        default:
+            return new AudioCodecPCM();
+    }
+}
+
+AudioCodec::Type AudioCodec::preferredTypeForMask(quint8 mask) {
+    mask &= SUPPORTED_AUDIO_CODECS_MASK;
+    if (mask & maskForType(ADPCM)) {
+        return ADPCM;
+    }
+    return PCM;
+}
+
+int AudioCodecPCM::encode(const int16_t* samples, int numSamples, int numChannels, char* destination) {
+    int numBytes = numSamples * sizeof(int16_t);
+    memcpy(destination, samples, numBytes);
+    return numBytes;
+}
+
+int AudioCodecPCM::decode(const char* source, int numBytes, int numChannels, int16_t* samples) {
+    int numSamples = numBytes / sizeof(int16_t);
+    memcpy(samples, source, numSamples * sizeof(int16_t));
+    return numSamples;
+}
+
+static const int ADPCM_INDEX_TABLE[16] = {
+    -1, -1, -1, -1, 2, 4, 6, 8,
+    -1, -1, -1, -1, 2, 4, 6, 8
+};
+
+static const int ADPCM_NUM_STEPS = 89;
+
+static const int ADPCM_STEP_TABLE[ADPCM_NUM_STEPS] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17,
+    19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+    130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+    337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+    876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+    2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358,
+    5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+AudioCodecADPCM::AudioCodecADPCM() {
+    reset();
+}
+
+void AudioCodecADPCM::reset() {
+    memset(_encoderState, 0, sizeof(_encoderState));
+}
+
+int AudioCodecADPCM::encodedBytesForSamples(int numSamples, int numChannels) const {
+    return (numChannels * BYTES_PER_CHANNEL_HEADER) + ((numSamples + 1) / 2);
+}
+
+int AudioCodecADPCM::samplesForEncodedBytes(int numBytes, int numChannels) const {
+    return glm::max(numBytes - (numChannels * BYTES_PER_CHANNEL_HEADER), 0) * 2;
+}
+
+quint8 AudioCodecADPCM::encodeSample(ChannelState& state, int16_t sample) {
+    int step = ADPCM_STEP_TABLE[state.stepIndex];
+    int difference = sample - state.predictor;
+
+    quint8 nibble = 0;
+    if (difference < 0) {
+        nibble = 8;
+        difference = -difference;
+    }
+
+    // quantize the difference to three bits of magnitude, accumulating the same delta the decoder will reconstruct
+    int delta = step >> 3;
+    if (difference >= step) {
+        nibble |= 4;
+        difference -= step;
+        delta += step;
+    }
+    step >>= 1;
+    if (difference >= step) {
+        nibble |= 2;
+        difference -= step;
+        delta += step;
+    }
+    step >>= 1;
+    if (difference >= step) {
+        nibble |= 1;
+        delta += step;
+    }
+
+    state.predictor = glm::clamp((nibble & 8) ? state.predictor - delta : state.predictor + delta,
+                                 MIN_SAMPLE_VALUE, MAX_SAMPLE_VALUE);
+    state.stepIndex = glm::clamp(state.stepIndex + ADPCM_INDEX_TABLE[nibble], 0, ADPCM_NUM_STEPS - 1);
+
+    return nibble;
+}
+
+int16_t AudioCodecADPCM::decodeSample(ChannelState& state, quint8 nibble) {
+    int step = ADPCM_STEP_TABLE[state.stepIndex];
+
+    int delta = step >> 3;
+    if (nibble & 4) {
+        delta += step;
+    }
+    if (nibble & 2) {
+        delta += step >> 1;
+    }
+    if (nibble & 1) {
+        delta += step >> 2;
+    }
+
+    state.predictor = glm::clamp((nibble & 8) ? state.predictor - delta : state.predictor + delta,
+                                 MIN_SAMPLE_VALUE, MAX_SAMPLE_VALUE);
+    state.stepIndex = glm::clamp(state.stepIndex + ADPCM_INDEX_TABLE[nibble], 0, ADPCM_NUM_STEPS - 1);
+
+    return (int16_t)state.predictor;
+}
+
+int AudioCodecADPCM::encode(const int16_t* samples, int numSamples, int numChannels, char* destination) {
+    numChannels = glm::clamp(numChannels, 1, (int)MAX_CHANNELS);
+    char* dataAt = destination;
+
+    // write the state each channel starts this frame with so the frame can be decoded on its own
+    for (int channel = 0; channel < numChannels; channel++) {
+        int16_t predictor = (int16_t)_encoderState[channel].predictor;
+        memcpy(dataAt, &predictor, sizeof(int16_t));
+        dataAt += sizeof(int16_t);
+        *dataAt++ = (char)_encoderState[channel].stepIndex;
+        *dataAt++ = 0;
+    }
+
+    // samples stay interleaved, two to a byte with the earlier sample in the low nibble
+    quint8* nibblesAt = reinterpret_cast<quint8*>(dataAt);
+    for (int i = 0; i < numSamples; i++) {
+        quint8 nibble = encodeSample(_encoderState[i % numChannels], samples[i]);
+        if (i % 2 == 0) {
+            nibblesAt[i / 2] = nibble;
+        } else {
+            nibblesAt[i / 2] |= (nibble << 4);
+        }
+    }
+
+    return encodedBytesForSamples(numSamples, numChannels);
+}
+
+int AudioCodecADPCM::decode(const char* source, int numBytes, int numChannels, int16_t* samples) {
+    numChannels = glm::clamp(numChannels, 1, (int)MAX_CHANNELS);
+    if (numBytes < numChannels * BYTES_PER_CHANNEL_HEADER) {
+        return 0;
+    }
+
+    const char* dataAt = source;
+    ChannelState decoderState[MAX_CHANNELS];
+    for (int channel = 0; channel < numChannels; channel++) {
+        int16_t predictor;
+        memcpy(&predictor, dataAt, sizeof(int16_t));
+        dataAt += sizeof(int16_t);
+        decoderState[channel].predictor = predictor;
+        decoderState[channel].stepIndex = glm::clamp((int)(quint8)*dataAt, 0, ADPCM_NUM_STEPS - 1);
+        dataAt += 2;
+    }
+
+    int numSamples = samplesForEncodedBytes(numBytes, numChannels);
+    const quint8* nibblesAt = reinterpret_cast<const quint8*>(dataAt);
+    for (int i = 0; i < numSamples; i++) {
+        quint8 nibble = (i % 2 == 0) ? (nibblesAt[i / 2] & 0x0F) : (nibblesAt[i / 2] >> 4);
+        samples[i] = decodeSample(decoderState[i % numChannels], nibble);
+    }
+
+    return numSamples;
+}
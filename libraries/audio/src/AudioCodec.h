@@ -0,0 +1,102 @@
+//
+//  AudioCodec.h
+//  libraries/audio/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_AudioCodec_h
+#define hifi_AudioCodec_h
+
+#include <stdint.h>
+
+#include <QtCore/QtGlobal>
+
+/// Encodes and decodes the 16-bit interleaved PCM frames carried by the audio packet types.
+/// Encoders may keep state between frames (one instance per outgoing stream), decoders must be able to decode any
+/// frame on its own so that a lost packet never corrupts the frames that follow it.
+class AudioCodec {
+public:
+    enum Type {
+        PCM = 0,
+        ADPCM,
+        NUM_TYPES
+    };
+
+    static AudioCodec* create(Type type);
+
+    static quint8 maskForType(Type type) { return (quint8)(1 << type); }
+    static bool isValidType(quint8 type) { return type < NUM_TYPES; }
+
+    /// returns the codec from the mask that gives the smallest frames, PCM if there is none in common
+    static Type preferredTypeForMask(quint8 mask);
+
+    virtual ~AudioCodec() { }
+
+    virtual Type getType() const = 0;
+
+    /// clears any state carried by the encoder between frames
+    virtual void reset() { }
+
+    virtual int encodedBytesForSamples(int numSamples, int numChannels) const = 0;
+    virtual int samplesForEncodedBytes(int numBytes, int numChannels) const = 0;
+
+    /// encodes numSamples interleaved samples into destination, returns the number of bytes written
+    virtual int encode(const int16_t* samples, int numSamples, int numChannels, char* destination) = 0;
+
+    /// decodes numBytes of encoded data into samples, returns the number of samples written
+    virtual int decode(const char* source, int numBytes, int numChannels, int16_t* samples) = 0;
+};
+
+/// the codecs this build can encode and decode, advertised to the audio-mixer in microphone audio packets
+const quint8 SUPPORTED_AUDIO_CODECS_MASK = (1 << AudioCodec::PCM) | (1 << AudioCodec::ADPCM);
+
+/// raw 16-bit samples, the format every audio packet used before codecs were negotiated
+class AudioCodecPCM : public AudioCodec {
+public:
+    Type getType() const { return PCM; }
+
+    int encodedBytesForSamples(int numSamples, int numChannels) const { return numSamples * sizeof(int16_t); }
+    int samplesForEncodedBytes(int numBytes, int numChannels) const { return numBytes / sizeof(int16_t); }
+
+    int encode(const int16_t* samples, int numSamples, int numChannels, char* destination);
+    int decode(const char* source, int numBytes, int numChannels, int16_t* samples);
+};
+
+/// IMA ADPCM, 4 bits per sample. Each frame starts with the predictor and step index for every channel so it can be
+/// decoded without any of the frames before it, the encoder carries its predictor across frames to avoid re-converging.
+class AudioCodecADPCM : public AudioCodec {
+public:
+    AudioCodecADPCM();
+
+    Type getType() const { return ADPCM; }
+
+    void reset();
+
+    int encodedBytesForSamples(int numSamples, int numChannels) const;
+    int samplesForEncodedBytes(int numBytes, int numChannels) const;
+
+    int encode(const int16_t* samples, int numSamples, int numChannels, char* destination);
+    int decode(const char* source, int numBytes, int numChannels, int16_t* samples);
+
+private:
+    static const int MAX_CHANNELS = 2;
+
+    // per channel header: 16-bit predictor, 8-bit step index, 8 bits reserved
+    static const int BYTES_PER_CHANNEL_HEADER = 4;
+
+    struct ChannelState {
+        int predictor;
+        int stepIndex;
+    };
+
+    static quint8 encodeSample(ChannelState& state, int16_t sample);
+    static int16_t decodeSample(ChannelState& state, quint8 nibble);
+
+    ChannelState _encoderState[MAX_CHANNELS];
+};
+
+#endif // hifi_AudioCodec_h
@@ -142,8 +142,35 @@ public:
         }
     }
 
+    // interleaved float samples, at whatever scale they come in since the filters are linear
+    void render(const float32_t* in, float32_t* out, const uint32_t frameCount) {
+        if (!_buffer || (frameCount > _frameCount))
+            return;
+
+        // de-interleave
+        for (uint32_t i = 0; i < frameCount; ++i) {
+            for (uint32_t j = 0; j < _channelCount; ++j) {
+                _buffer[j][i] = *in++;
+            }
+        }
+
+        // now step through each filter
+        for (uint32_t i = 0; i < _channelCount; ++i) {
+            for (uint32_t j = 0; j < _filterCount; ++j) {
+                _filters[j][i].render( &_buffer[i][0], &_buffer[i][0], frameCount );
+            }
+        }
+
+        // interleave
+        for (uint32_t i = 0; i < frameCount; ++i) {
+            for (uint32_t j = 0; j < _channelCount; ++j) {
+                *out++ = _buffer[j][i];
+            }
+        }
+    }
+
     void render(AudioBufferFloat32& frameBuffer) {
-        
+
         float32_t** samples = frameBuffer.getFrameData();
         for (uint32_t j = 0; j < frameBuffer.getChannelCount(); ++j) {
             for (uint32_t i = 0; i < _filterCount; ++i) {
@@ -17,7 +17,9 @@
 #include <UUID.h>
 
 #include "AbstractAudioInterface.h"
+#include "AudioCodec.h"
 #include "AudioRingBuffer.h"
+#include "VoiceActivityDetector.h"
 
 #include "AudioInjector.h"
 
@@ -100,6 +102,9 @@ void AudioInjector::injectAudio() {
         quint8 volume = MAX_INJECTOR_VOLUME * _options.getVolume();
         packetStream << volume;
         
+        // injected audio is sent as raw samples
+        packetStream << (quint8)AudioCodec::PCM;
+        
         QElapsedTimer timer;
         timer.start();
         int nextFrame = 0;
@@ -107,6 +112,14 @@ void AudioInjector::injectAudio() {
         int numPreAudioDataBytes = injectAudioPacket.size();
         bool shouldLoop = _options.getLoop();
         
+        // quiet frames go out as silent frames, which carry the same stream properties followed by the number of samples
+        // held back; only speech is tested against its own noise floor, anything else would lose steady sounds to it
+        VoiceActivityDetector voiceActivityDetector(SAMPLE_RATE);
+        int numInjectAudioHeaderBytes = numBytesForPacketHeader(injectAudioPacket);
+        QByteArray silentInjectAudioPacket = byteArrayWithPopulatedHeader(PacketTypeSilentInjectAudio);
+        int numSilentInjectAudioHeaderBytes = silentInjectAudioPacket.size();
+        _uplinkStats.reset();
+        
         // loop to send off our audio in NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL byte chunks
         quint16 outgoingInjectedAudioSequenceNumber = 0;
         while (_currentSendPosition < soundByteArray.size() && !_shouldStop) {
@@ -137,8 +150,25 @@ void AudioInjector::injectAudio() {
             NodeList* nodeList = NodeList::getInstance();
             SharedNodePointer audioMixer = nodeList->soloNodeOfType(NodeType::AudioMixer);
             
-            // send off this audio packet
-            nodeList->writeDatagram(injectAudioPacket, audioMixer);
+            const int16_t* nextSamples = reinterpret_cast<const int16_t*>(soundByteArray.data() + _currentSendPosition);
+            int numSamples = bytesToCopy / sizeof(int16_t);
+            bool shouldSendAudio = _options.getDetectVoiceActivity()
+                ? voiceActivityDetector.processFrame(nextSamples, numSamples, _options.isStereo() ? 2 : 1)
+                : !VoiceActivityDetector::isQuietFrame(nextSamples, numSamples);
+            if (shouldSendAudio) {
+                // send off this audio packet
+                nodeList->writeDatagram(injectAudioPacket, audioMixer);
+                _uplinkStats.audioFrameSent(injectAudioPacket.size());
+            } else {
+                silentInjectAudioPacket.resize(numSilentInjectAudioHeaderBytes);
+                silentInjectAudioPacket.append(injectAudioPacket.constData() + numInjectAudioHeaderBytes,
+                                               numPreAudioDataBytes - numInjectAudioHeaderBytes);
+                quint16 numSilentSamples = numSamples;
+                silentInjectAudioPacket.append(reinterpret_cast<const char*>(&numSilentSamples), sizeof(quint16));
+                
+                nodeList->writeDatagram(silentInjectAudioPacket, audioMixer);
+                _uplinkStats.silentFrameSent(silentInjectAudioPacket.size());
+            }
             outgoingInjectedAudioSequenceNumber++;
             
             _currentSendPosition += bytesToCopy;
@@ -19,6 +19,7 @@
 #include <glm/gtx/quaternion.hpp>
 
 #include "AudioInjectorOptions.h"
+#include "AudioUplinkStats.h"
 #include "Sound.h"
 
 class AudioInjector : public QObject {
@@ -28,6 +29,7 @@ public:
     AudioInjector(Sound* sound, const AudioInjectorOptions& injectorOptions);
     
     int getCurrentSendPosition() const { return _currentSendPosition; }
+    const AudioUplinkStats& getUplinkStats() const { return _uplinkStats; }
 public slots:
     void injectAudio();
     void stop() { _shouldStop = true; }
@@ -40,6 +42,7 @@ private:
     AudioInjectorOptions _options;
     bool _shouldStop;
     int _currentSendPosition;
+    AudioUplinkStats _uplinkStats;
 };
 
 Q_DECLARE_METATYPE(AudioInjector*)
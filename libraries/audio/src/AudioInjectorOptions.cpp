@@ -18,6 +18,7 @@ AudioInjectorOptions::AudioInjectorOptions(QObject* parent) :
     _loop(false),
     _orientation(glm::vec3(0.0f, 0.0f, 0.0f)),
     _isStereo(false),
+    _detectVoiceActivity(false),
     _loopbackAudioInterface(NULL)
 {
 }
@@ -28,6 +29,7 @@ AudioInjectorOptions::AudioInjectorOptions(const AudioInjectorOptions& other) {
     _loop = other._loop;
     _orientation = other._orientation;
     _isStereo = other._isStereo;
+    _detectVoiceActivity = other._detectVoiceActivity;
     _loopbackAudioInterface = other._loopbackAudioInterface;
 }
 
@@ -37,5 +39,6 @@ void AudioInjectorOptions::operator=(const AudioInjectorOptions& other) {
     _loop = other._loop;
     _orientation = other._orientation;
     _isStereo = other._isStereo;
+    _detectVoiceActivity = other._detectVoiceActivity;
     _loopbackAudioInterface = other._loopbackAudioInterface;
 }
\ No newline at end of file
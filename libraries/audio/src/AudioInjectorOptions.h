@@ -29,6 +29,7 @@ class AudioInjectorOptions : public QObject {
     Q_PROPERTY(float volume READ getVolume WRITE setVolume)
     Q_PROPERTY(bool loop READ getLoop WRITE setLoop)
     Q_PROPERTY(bool isStereo READ isStereo WRITE setIsStereo)
+    Q_PROPERTY(bool detectVoiceActivity READ getDetectVoiceActivity WRITE setDetectVoiceActivity)
 public:
     AudioInjectorOptions(QObject* parent = 0);
     AudioInjectorOptions(const AudioInjectorOptions& other);
@@ -49,6 +50,11 @@ public:
     const bool isStereo() const { return _isStereo; }
     void setIsStereo(const bool isStereo) { _isStereo = isStereo; }
     
+    /// whether the sound is speech, and frames that are only its background noise can go out as silent frames.
+    /// Otherwise only frames that are quiet in absolute terms do.
+    bool getDetectVoiceActivity() const { return _detectVoiceActivity; }
+    void setDetectVoiceActivity(bool detectVoiceActivity) { _detectVoiceActivity = detectVoiceActivity; }
+    
     AbstractAudioInterface* getLoopbackAudioInterface() const { return _loopbackAudioInterface; }
     void setLoopbackAudioInterface(AbstractAudioInterface* loopbackAudioInterface)
         { _loopbackAudioInterface = loopbackAudioInterface; }
@@ -58,6 +64,7 @@ private:
     bool _loop;
     glm::quat _orientation;
     bool _isStereo;
+    bool _detectVoiceActivity;
     AbstractAudioInterface* _loopbackAudioInterface;
 };
 
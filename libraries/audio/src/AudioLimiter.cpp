@@ -0,0 +1,77 @@
+//
+//  AudioLimiter.cpp
+//  libraries/audio/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <math.h>
+
+#include <SimdSupport.h>
+
+#include "AudioRingBuffer.h"
+#include "AudioLimiter.h"
+
+// the soft limiter leaves everything below this alone, and squeezes everything above it into the rest of the range
+const float SOFT_LIMIT_THRESHOLD = 0.75f * MAX_SAMPLE_VALUE;
+const float SOFT_LIMIT_RANGE = MAX_SAMPLE_VALUE - SOFT_LIMIT_THRESHOLD;
+
+float AudioLimiter::getSoftLimitThreshold() {
+    return SOFT_LIMIT_THRESHOLD;
+}
+
+// the knee has a slope of one at the threshold and approaches full scale without ever reaching it
+static inline float softLimitSample(float sample) {
+    float magnitude = fabsf(sample);
+    float over = fmaxf(magnitude - SOFT_LIMIT_THRESHOLD, 0.0f);
+    float limited = fminf(magnitude, SOFT_LIMIT_THRESHOLD) + (SOFT_LIMIT_RANGE * over) / (over + SOFT_LIMIT_RANGE);
+    return (sample < 0.0f) ? -limited : limited;
+}
+
+#ifdef HIFI_HAVE_SSE2
+// the same steps as softLimitSample, for four samples
+static inline __m128 softLimitSamples(__m128 samples) {
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    const __m128 threshold = _mm_set1_ps(SOFT_LIMIT_THRESHOLD);
+    const __m128 range = _mm_set1_ps(SOFT_LIMIT_RANGE);
+
+    __m128 sign = _mm_and_ps(samples, signMask);
+    __m128 magnitude = _mm_andnot_ps(signMask, samples);
+    __m128 over = _mm_max_ps(_mm_sub_ps(magnitude, threshold), _mm_setzero_ps());
+    __m128 limited = _mm_add_ps(_mm_min_ps(magnitude, threshold),
+                                _mm_div_ps(_mm_mul_ps(range, over), _mm_add_ps(over, range)));
+    return _mm_or_ps(limited, sign);
+}
+#endif
+
+void AudioLimiter::render(const float* in, int16_t* out, int sampleCount, bool softLimit) {
+    int i = 0;
+
+#ifdef HIFI_HAVE_SSE2
+    // clamp before converting, out of range floats don't convert to anything useful. The conversion rounds to nearest
+    // like lrintf below, and the pack would saturate to 16 bits by itself.
+    const __m128 minimum = _mm_set1_ps((float)MIN_SAMPLE_VALUE);
+    const __m128 maximum = _mm_set1_ps((float)MAX_SAMPLE_VALUE);
+    for (; i + 8 <= sampleCount; i += 8) {
+        __m128 low = _mm_loadu_ps(in + i);
+        __m128 high = _mm_loadu_ps(in + i + 4);
+        if (softLimit) {
+            low = softLimitSamples(low);
+            high = softLimitSamples(high);
+        }
+        low = _mm_min_ps(_mm_max_ps(low, minimum), maximum);
+        high = _mm_min_ps(_mm_max_ps(high, minimum), maximum);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                         _mm_packs_epi32(_mm_cvtps_epi32(low), _mm_cvtps_epi32(high)));
+    }
+#endif
+
+    for (; i < sampleCount; i++) {
+        float sample = softLimit ? softLimitSample(in[i]) : in[i];
+        sample = fminf(fmaxf(sample, (float)MIN_SAMPLE_VALUE), (float)MAX_SAMPLE_VALUE);
+        out[i] = (int16_t)lrintf(sample);
+    }
+}
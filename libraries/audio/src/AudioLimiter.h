@@ -0,0 +1,28 @@
+//
+//  AudioLimiter.h
+//  libraries/audio/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_AudioLimiter_h
+#define hifi_AudioLimiter_h
+
+#include <stdint.h>
+
+/// Packs a mix that was accumulated in floats into 16-bit samples, in one pass at the very end of mixing so that loud
+/// mixes clip the same way whatever order the sources were added in.
+class AudioLimiter {
+public:
+
+    /// Saturates each sample to the 16-bit range. With softLimit on, samples louder than getSoftLimitThreshold are
+    /// bent smoothly towards full scale instead of being clipped flat.
+    static void render(const float* in, int16_t* out, int sampleCount, bool softLimit);
+
+    static float getSoftLimitThreshold();
+};
+
+#endif // hifi_AudioLimiter_h
@@ -0,0 +1,56 @@
+//
+//  AudioUplinkStats.h
+//  libraries/audio/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_AudioUplinkStats_h
+#define hifi_AudioUplinkStats_h
+
+#include <QtCore/QString>
+
+/// Counts what an audio sender has put on the wire since it started, split between frames that carried audio and the
+/// silent frames sent in their place while discontinuous transmission held back the background noise.
+class AudioUplinkStats {
+public:
+    AudioUplinkStats() { reset(); }
+
+    void reset() {
+        _audioFrames = 0;
+        _audioBytes = 0;
+        _silentFrames = 0;
+        _silentBytes = 0;
+    }
+
+    void audioFrameSent(int packetBytes) { _audioFrames++; _audioBytes += packetBytes; }
+    void silentFrameSent(int packetBytes) { _silentFrames++; _silentBytes += packetBytes; }
+
+    quint64 getAudioFrames() const { return _audioFrames; }
+    quint64 getAudioBytes() const { return _audioBytes; }
+    quint64 getSilentFrames() const { return _silentFrames; }
+    quint64 getSilentBytes() const { return _silentBytes; }
+    quint64 getTotalBytes() const { return _audioBytes + _silentBytes; }
+
+    float getSilentFrameRatio() const {
+        quint64 totalFrames = _audioFrames + _silentFrames;
+        return totalFrames == 0 ? 0.0f : (float)_silentFrames / totalFrames;
+    }
+
+    QString toString() const {
+        return QString("%1 audio frames (%2 bytes), %3 silent frames (%4 bytes), %5% silent")
+            .arg(_audioFrames).arg(_audioBytes).arg(_silentFrames).arg(_silentBytes)
+            .arg(getSilentFrameRatio() * 100.0f, 0, 'f', 1);
+    }
+
+private:
+    quint64 _audioFrames;
+    quint64 _audioBytes;
+    quint64 _silentFrames;
+    quint64 _silentBytes;
+};
+
+#endif // hifi_AudioUplinkStats_h
@@ -20,6 +20,8 @@ InboundAudioStream::InboundAudioStream(int numFrameSamples, int numFramesCapacit
     _ringBuffer(numFrameSamples, false, numFramesCapacity),
     _lastPopSucceeded(false),
     _lastPopOutput(),
+    _lastPopOutputIsSilent(false),
+    _silentSamplesAtEnd(0),
     _dynamicJitterBuffers(settings._dynamicJitterBuffers),
     _staticDesiredJitterBufferFrames(settings._staticDesiredJitterBufferFrames),
     _useStDevForJitterCalc(settings._useStDevForJitterCalc),
@@ -45,14 +47,23 @@ InboundAudioStream::InboundAudioStream(int numFrameSamples, int numFramesCapacit
     _currentJitterBufferFrames(0),
     _timeGapStatsForStatsPacket(0, STATS_FOR_STATS_PACKET_WINDOW_SECONDS),
     _repetitionWithFade(settings._repetitionWithFade),
+    _codec(AudioCodec::create(AudioCodec::PCM)),
+    _codecChannels(1),
+    _decodedAudioData(),
     _hasReverb(false)
 {
 }
 
+InboundAudioStream::~InboundAudioStream() {
+    delete _codec;
+}
+
 void InboundAudioStream::reset() {
     _ringBuffer.reset();
     _lastPopSucceeded = false;
     _lastPopOutput = AudioRingBuffer::ConstIterator();
+    _lastPopOutputIsSilent = false;
+    _silentSamplesAtEnd = 0;
     _isStarved = true;
     _hasStarted = false;
     resetStats();
@@ -79,6 +90,7 @@ void InboundAudioStream::resetStats() {
 
 void InboundAudioStream::clearBuffer() {
     _ringBuffer.clear();
+    _silentSamplesAtEnd = 0;
     _framesAvailableStat.reset();
     _currentJitterBufferFrames = 0;
 }
@@ -121,15 +133,17 @@ int InboundAudioStream::parseData(const QByteArray& packet) {
             // as the packet we just received.
             int packetsDropped = arrivalInfo._seqDiffFromExpected;
             writeSamplesForDroppedPackets(packetsDropped * networkSamples);
+            _silentSamplesAtEnd = 0;
 
             // fall through to OnTime case
         }
         case SequenceNumberStats::OnTime: {
             // Packet is on time; parse its data to the ringbuffer
-            if (packetType == PacketTypeSilentAudioFrame) {
-                writeDroppableSilentSamples(networkSamples);
+            if (packetType == PacketTypeSilentAudioFrame || packetType == PacketTypeSilentInjectAudio) {
+                _silentSamplesAtEnd += writeDroppableSilentSamples(networkSamples);
             } else {
                 readBytes += parseAudioData(packetType, packet.mid(readBytes), networkSamples);
+                _silentSamplesAtEnd = 0;
             }
             break;
         }
@@ -174,15 +188,45 @@ int InboundAudioStream::parseStreamProperties(PacketType type, const QByteArray&
             memcpy(&_wetLevel, packetAfterSeqNum.data() + read, sizeof(float));
             read += sizeof(float);
         }
+
+        // the mixed audio is always stereo, the codec byte says how it was encoded for us
+        quint8 codecType = packetAfterSeqNum.at(read);
+        read += sizeof(quint8);
+        setCodec(AudioCodec::isValidType(codecType) ? (AudioCodec::Type)codecType : AudioCodec::PCM, 2);
     }
     
-    // mixed audio packets do not have any info between the seq num and the audio data.
-    numAudioSamples = (packetAfterSeqNum.size() - read) / sizeof(int16_t);
+    numAudioSamples = numSamplesForEncodedBytes(packetAfterSeqNum.size() - read);
     return read;
 }
 
 int InboundAudioStream::parseAudioData(PacketType type, const QByteArray& packetAfterStreamProperties, int numAudioSamples) {
-    return _ringBuffer.writeData(packetAfterStreamProperties.data(), numAudioSamples * sizeof(int16_t));
+    QByteArray decodedAudioData = decodeAudioData(packetAfterStreamProperties, numAudioSamples);
+    _ringBuffer.writeData(decodedAudioData.constData(), numAudioSamples * sizeof(int16_t));
+    return packetAfterStreamProperties.size();
+}
+
+void InboundAudioStream::setCodec(AudioCodec::Type type, int numChannels) {
+    if (type != _codec->getType()) {
+        delete _codec;
+        _codec = AudioCodec::create(type);
+    }
+    _codecChannels = numChannels;
+}
+
+QByteArray InboundAudioStream::decodeAudioData(const QByteArray& encodedAudioData, int networkSamples) {
+    if (_codec->getType() == AudioCodec::PCM) {
+        return encodedAudioData;
+    }
+
+    // reuse the decode buffer between packets, it only grows when a larger frame comes in
+    int numDecodedBytes = networkSamples * sizeof(int16_t);
+    if (_decodedAudioData.size() < numDecodedBytes) {
+        _decodedAudioData.resize(numDecodedBytes);
+    }
+    int numDecodedSamples = _codec->decode(encodedAudioData.constData(), encodedAudioData.size(), _codecChannels,
+                                           reinterpret_cast<int16_t*>(_decodedAudioData.data()));
+    // hand back a view of the decode buffer rather than a copy of it, it is overwritten by the next packet
+    return QByteArray::fromRawData(_decodedAudioData.constData(), numDecodedSamples * sizeof(int16_t));
 }
 
 int InboundAudioStream::writeDroppableSilentSamples(int silentSamples) {
@@ -271,8 +315,13 @@ int InboundAudioStream::popFrames(int maxFrames, bool allOrNothing, bool starveI
 }
 
 void InboundAudioStream::popSamplesNoCheck(int samples) {
+    // if everything left was written by silent frames, so is what we're popping
+    int samplesAvailable = _ringBuffer.samplesAvailable();
+    _lastPopOutputIsSilent = samplesAvailable <= _silentSamplesAtEnd;
+
     _lastPopOutput = _ringBuffer.nextOutput();
     _ringBuffer.shiftReadPosition(samples);
+    _silentSamplesAtEnd = std::min(_silentSamplesAtEnd, samplesAvailable - samples);
     framesAvailableChanged();
 
     _hasStarted = true;
@@ -13,6 +13,7 @@
 #define hifi_InboundAudioStream_h
 
 #include "NodeData.h"
+#include "AudioCodec.h"
 #include "AudioRingBuffer.h"
 #include "MovingMinMaxAvg.h"
 #include "SequenceNumberStats.h"
@@ -97,6 +98,7 @@ public:
 
 public:
     InboundAudioStream(int numFrameSamples, int numFramesCapacity, const Settings& settings);
+    virtual ~InboundAudioStream();
 
     void reset();
     virtual void resetStats();
@@ -110,6 +112,9 @@ public:
     bool lastPopSucceeded() const { return _lastPopSucceeded; };
     const AudioRingBuffer::ConstIterator& getLastPopOutput() const { return _lastPopOutput; }
 
+    /// true when the last frame popped came only from silent frames, so there's no need to look at its samples
+    bool lastPopOutputIsSilent() const { return _lastPopOutputIsSilent; }
+
 
     void setToStarved();
 
@@ -159,6 +164,8 @@ public:
     float getRevebTime() const { return _reverbTime; }
     float getWetLevel() const { return _wetLevel; }
 
+    AudioCodec::Type getCodecType() const { return _codec->getType(); }
+
 public slots:
     /// This function should be called every second for all the stats to function properly. If dynamic jitter buffers
     /// is enabled, those stats are used to calculate _desiredJitterBufferFrames.
@@ -188,6 +195,16 @@ protected:
     /// default implementation assumes packet contains raw audio samples after stream properties
     virtual int parseAudioData(PacketType type, const QByteArray& packetAfterStreamProperties, int networkSamples);
 
+    /// switches the decoder used for the audio data in incoming packets, called while parsing stream properties
+    void setCodec(AudioCodec::Type type, int numChannels);
+
+    /// returns the number of network samples that numBytes of audio data decodes to with the current codec
+    int numSamplesForEncodedBytes(int numBytes) const { return _codec->samplesForEncodedBytes(numBytes, _codecChannels); }
+
+    /// decodes the audio data of a packet to raw samples, without copying them: the result is the PCM data itself or a
+    /// view of the decode buffer, which is only valid until the next call
+    QByteArray decodeAudioData(const QByteArray& encodedAudioData, int networkSamples);
+
     /// writes silent samples to the buffer that may be dropped to reduce latency caused by the buffer
     virtual int writeDroppableSilentSamples(int silentSamples);
 
@@ -201,6 +218,8 @@ protected:
 
     bool _lastPopSucceeded;
     AudioRingBuffer::ConstIterator _lastPopOutput;
+    bool _lastPopOutputIsSilent;
+    int _silentSamplesAtEnd;            // how many of the newest samples in the ring buffer were written as silence
 
     bool _dynamicJitterBuffers;         // if false, _desiredJitterBufferFrames is locked at 1 (old behavior)
     int _staticDesiredJitterBufferFrames;
@@ -248,6 +267,10 @@ protected:
 
     bool _repetitionWithFade;
     
+    AudioCodec* _codec;
+    int _codecChannels;
+    QByteArray _decodedAudioData;
+
     // Reverb properties
     bool _hasReverb;
     float _reverbTime;
@@ -64,8 +64,19 @@ int InjectedAudioStream::parseStreamProperties(PacketType type,
     packetStream >> attenuationByte;
     _attenuationRatio = attenuationByte / (float)MAX_INJECTOR_VOLUME;
 
-    int numAudioBytes = packetAfterSeqNum.size() - packetStream.device()->pos();
-    numAudioSamples = numAudioBytes / sizeof(int16_t);
+    quint8 codecType = AudioCodec::PCM;
+    packetStream >> codecType;
+    setCodec(AudioCodec::isValidType(codecType) ? (AudioCodec::Type)codecType : AudioCodec::PCM, isStereo ? 2 : 1);
+
+    if (type == PacketTypeSilentInjectAudio) {
+        // the injector held back a frame of background noise, we're only told how long it was
+        quint16 numSilentSamples = 0;
+        packetStream >> numSilentSamples;
+        numAudioSamples = numSilentSamples;
+    } else {
+        int numAudioBytes = packetAfterSeqNum.size() - packetStream.device()->pos();
+        numAudioSamples = numSamplesForEncodedBytes(numAudioBytes);
+    }
 
     return packetStream.device()->pos();
 }
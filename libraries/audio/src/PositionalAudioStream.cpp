@@ -40,7 +40,8 @@ void PositionalAudioStream::resetStats() {
 }
 
 void PositionalAudioStream::updateLastPopOutputLoudnessAndTrailingLoudness() {
-    _lastPopOutputLoudness = _ringBuffer.getFrameLoudness(_lastPopOutput);
+    // a frame that came in as a silent frame is known to be silent, there's no need to scan it
+    _lastPopOutputLoudness = _lastPopOutputIsSilent ? 0.0f : _ringBuffer.getFrameLoudness(_lastPopOutput);
 
     const int TRAILING_AVERAGE_FRAMES = 100;
     const float CURRENT_FRAME_RATIO = 1.0f / TRAILING_AVERAGE_FRAMES;
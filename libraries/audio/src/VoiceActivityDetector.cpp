@@ -0,0 +1,168 @@
+//
+//  VoiceActivityDetector.cpp
+//  libraries/audio/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <float.h>
+#include <math.h>
+
+#include "VoiceActivityDetector.h"
+
+// the band speech is looked for in, below it is hum and rumble, above it is hiss
+const float SPEECH_BAND_LOW_HZ = 200.0f;
+const float SPEECH_BAND_HIGH_HZ = 3400.0f;
+
+// speech has to be this many times the energy of the noise in its band to start a talk spurt, and to keep one going
+const float ONSET_SNR = 4.0f;
+const float CONTINUATION_SNR = 2.0f;
+
+// and the speech band has to hold at least this much of the frame's energy, which keeps out broadband noise
+const float MIN_SPEECH_BAND_RATIO = 0.4f;
+
+// anything this much louder than the noise is sent whatever band it is in, like a fricative or a hand clap
+const float LOUD_SNR = 16.0f;
+
+// the floor never goes below the energy of a few LSBs of noise, so that a digitally silent input doesn't make the
+// first quiet sound a talk spurt
+const float MIN_FLOOR_ENERGY = 100.0f;
+
+// the noise floor is the quietest frame of the last NUM_FLOOR_BLOCKS blocks, so it follows a new noise in about four
+// seconds but isn't raised by speech that pauses now and then
+const int FLOOR_BLOCK_MSECS = 500;
+
+const int MSECS_PER_SECOND = 1000;
+
+static float onePoleCoefficient(float cutoffHz, int sampleRate) {
+    return 1.0f - expf(-2.0f * (float)M_PI * cutoffHz / sampleRate);
+}
+
+VoiceActivityDetector::VoiceActivityDetector(int sampleRate) :
+    _sampleRate(sampleRate),
+    _lowBandCoefficient(onePoleCoefficient(SPEECH_BAND_LOW_HZ, sampleRate)),
+    _highBandCoefficient(onePoleCoefficient(SPEECH_BAND_HIGH_HZ, sampleRate))
+{
+    setHangoverMsecs(DEFAULT_HANGOVER_MSECS);
+    reset();
+}
+
+void VoiceActivityDetector::setHangoverMsecs(int hangoverMsecs) {
+    _hangoverMsecs = hangoverMsecs;
+    _hangoverSamples = (int)((int64_t)hangoverMsecs * _sampleRate / MSECS_PER_SECOND);
+}
+
+void VoiceActivityDetector::reset() {
+    _lowBandState = 0.0f;
+    _highBandState = 0.0f;
+
+    _framesInBlock = 0;
+    _framesPerBlock = 1;
+    _blockIndex = 0;
+    _blocksFilled = 0;
+    _speechRunningMinimum = FLT_MAX;
+    _totalRunningMinimum = FLT_MAX;
+    for (int i = 0; i < NUM_FLOOR_BLOCKS; i++) {
+        _speechBlockMinima[i] = FLT_MAX;
+        _totalBlockMinima[i] = FLT_MAX;
+    }
+    _speechFloor = MIN_FLOOR_ENERGY;
+    _totalFloor = MIN_FLOOR_ENERGY;
+
+    _isSpeech = false;
+    _isTransmitting = false;
+    _hangoverSamplesLeft = 0;
+}
+
+float VoiceActivityDetector::getComfortNoiseLevel() const {
+    return sqrtf(_totalFloor);
+}
+
+void VoiceActivityDetector::updateFloor(float& runningMinimum, float* blockMinima, float energy, float& floor) {
+    if (energy < runningMinimum) {
+        runningMinimum = energy;
+    }
+    floor = runningMinimum;
+    for (int i = 0; i < _blocksFilled; i++) {
+        if (blockMinima[i] < floor) {
+            floor = blockMinima[i];
+        }
+    }
+    if (floor < MIN_FLOOR_ENERGY) {
+        floor = MIN_FLOOR_ENERGY;
+    }
+}
+
+bool VoiceActivityDetector::isQuietFrame(const int16_t* samples, int numSamples) {
+    for (int i = 0; i < numSamples; i++) {
+        if (samples[i] > MAX_QUIET_SAMPLE || samples[i] < -MAX_QUIET_SAMPLE) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool VoiceActivityDetector::processFrame(const int16_t* samples, int numSamples, int numChannels) {
+    int numFrames = numSamples / numChannels;
+    if (numFrames == 0) {
+        return _isTransmitting;
+    }
+
+    // split the frame into the speech band and everything else, and measure the energy of both
+    float speechEnergy = 0.0f;
+    float totalEnergy = 0.0f;
+    for (int i = 0; i < numFrames; i++) {
+        float sample = 0.0f;
+        for (int j = 0; j < numChannels; j++) {
+            sample += samples[i * numChannels + j];
+        }
+        sample /= numChannels;
+
+        _lowBandState += _lowBandCoefficient * (sample - _lowBandState);
+        _highBandState += _highBandCoefficient * (sample - _highBandState);
+        float speechSample = _highBandState - _lowBandState;
+
+        speechEnergy += speechSample * speechSample;
+        totalEnergy += sample * sample;
+    }
+    speechEnergy /= numFrames;
+    totalEnergy /= numFrames;
+
+    // the floors are measured before the decision, a frame that is louder than them can't lower them anyway
+    _framesPerBlock = (int)((int64_t)FLOOR_BLOCK_MSECS * _sampleRate / (MSECS_PER_SECOND * numFrames));
+    if (_framesPerBlock < 1) {
+        _framesPerBlock = 1;
+    }
+    updateFloor(_speechRunningMinimum, _speechBlockMinima, speechEnergy, _speechFloor);
+    updateFloor(_totalRunningMinimum, _totalBlockMinima, totalEnergy, _totalFloor);
+    if (++_framesInBlock >= _framesPerBlock) {
+        _speechBlockMinima[_blockIndex] = _speechRunningMinimum;
+        _totalBlockMinima[_blockIndex] = _totalRunningMinimum;
+        _blockIndex = (_blockIndex + 1) % NUM_FLOOR_BLOCKS;
+        if (_blocksFilled < NUM_FLOOR_BLOCKS) {
+            _blocksFilled++;
+        }
+        _speechRunningMinimum = FLT_MAX;
+        _totalRunningMinimum = FLT_MAX;
+        _framesInBlock = 0;
+    }
+
+    // it's easier to stay in a talk spurt than to start one
+    float snrThreshold = _isSpeech ? CONTINUATION_SNR : ONSET_SNR;
+    _isSpeech = (speechEnergy > snrThreshold * _speechFloor && speechEnergy > MIN_SPEECH_BAND_RATIO * totalEnergy)
+        || totalEnergy > LOUD_SNR * _totalFloor;
+
+    if (_isSpeech) {
+        _hangoverSamplesLeft = _hangoverSamples;
+        _isTransmitting = true;
+    } else if (_hangoverSamplesLeft > 0) {
+        _hangoverSamplesLeft -= numFrames;
+        _isTransmitting = true;
+    } else {
+        _isTransmitting = false;
+    }
+    return _isTransmitting;
+}
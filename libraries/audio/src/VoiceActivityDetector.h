@@ -0,0 +1,82 @@
+//
+//  VoiceActivityDetector.h
+//  libraries/audio/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_VoiceActivityDetector_h
+#define hifi_VoiceActivityDetector_h
+
+#include <stdint.h>
+
+/// Decides which frames of an outgoing audio stream are worth sending, the rest can go out as silent frames
+/// (discontinuous transmission). A frame is speech when the band that carries speech stands out from the noise floor
+/// measured in that band, or when the whole frame is much louder than the noise; hum and hiss don't count. Once speech
+/// stops the stream keeps being sent for a hangover time so that word endings and short pauses aren't cut.
+class VoiceActivityDetector {
+public:
+    static const int DEFAULT_HANGOVER_MSECS = 250;
+
+    /// the largest sample a frame can have and still count as quiet, a few LSBs of dither
+    static const int MAX_QUIET_SAMPLE = 4;
+
+    VoiceActivityDetector(int sampleRate);
+
+    void setHangoverMsecs(int hangoverMsecs);
+    int getHangoverMsecs() const { return _hangoverMsecs; }
+
+    /// forgets the measured noise floor and any speech in progress
+    void reset();
+
+    /// analyzes a frame of interleaved samples, returns true if it should be sent and false if a silent frame will do
+    bool processFrame(const int16_t* samples, int numSamples, int numChannels);
+
+    /// whether every sample of a frame is within MAX_QUIET_SAMPLE of zero. Unlike processFrame() this doesn't adapt to
+    /// the content, so it's what sounds that aren't speech (ambient loops, music, hum) are tested with.
+    static bool isQuietFrame(const int16_t* samples, int numSamples);
+
+    /// whether the last frame was speech by itself, not counting the hangover
+    bool isSpeech() const { return _isSpeech; }
+    bool isTransmitting() const { return _isTransmitting; }
+
+    /// the RMS amplitude of the background noise, the level comfort noise would be generated at by a receiver that
+    /// wants to fill the frames that weren't sent
+    float getComfortNoiseLevel() const;
+
+private:
+    static const int NUM_FLOOR_BLOCKS = 8;
+
+    void updateFloor(float& runningMinimum, float* blockMinima, float energy, float& floor);
+
+    int _sampleRate;
+    int _hangoverMsecs;
+    int _hangoverSamples;
+
+    // one-pole lowpass states, the speech band is what gets past the upper one but not the lower one
+    float _lowBandCoefficient;
+    float _highBandCoefficient;
+    float _lowBandState;
+    float _highBandState;
+
+    // minimum statistics: the floor is the smallest frame energy of the last few blocks of frames
+    int _framesInBlock;
+    int _framesPerBlock;
+    int _blockIndex;
+    int _blocksFilled;
+    float _speechRunningMinimum;
+    float _totalRunningMinimum;
+    float _speechBlockMinima[NUM_FLOOR_BLOCKS];
+    float _totalBlockMinima[NUM_FLOOR_BLOCKS];
+    float _speechFloor;
+    float _totalFloor;
+
+    bool _isSpeech;
+    bool _isTransmitting;
+    int _hangoverSamplesLeft;
+};
+
+#endif // hifi_VoiceActivityDetector_h
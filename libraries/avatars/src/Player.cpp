@@ -321,33 +321,7 @@ void Player::setCurrentTime(unsigned int currentTime) {
     }
     
     // Find correct frame
-    int lowestBound = 0;
-    int highestBound = _recording->getFrameNumber() - 1;
-    while (lowestBound + 1 != highestBound) {
-        assert(lowestBound < highestBound);
-        
-        int bestGuess = lowestBound +
-                    (highestBound - lowestBound) *
-                    (float)(currentTime - _recording->getFrameTimestamp(lowestBound)) /
-                    (float)(_recording->getFrameTimestamp(highestBound) - _recording->getFrameTimestamp(lowestBound));
-        
-        if (_recording->getFrameTimestamp(bestGuess) <= currentTime) {
-            if (currentTime < _recording->getFrameTimestamp(bestGuess + 1)) {
-                lowestBound = bestGuess;
-                highestBound = bestGuess + 1;
-            } else {
-                lowestBound = bestGuess + 1;
-            }
-        } else {
-            if (_recording->getFrameTimestamp(bestGuess - 1) <= currentTime) {
-                lowestBound = bestGuess - 1;
-                highestBound = bestGuess;
-            } else {
-                highestBound = bestGuess - 1;
-            }
-        }
-    }
-    
+    int lowestBound = _recording->findFrameAtTime(currentTime);
     _currentFrame = lowestBound;
     _timerOffset = _recording->getFrameTimestamp(lowestBound);
     
@@ -389,21 +363,11 @@ bool Player::computeCurrentFrame() {
         _currentFrame = INVALID_FRAME;
         return false;
     }
-    if (_currentFrame < 0) {
-        _currentFrame = 0;
-    }
     
     quint64 elapsed = glm::clamp(Player::elapsed() - _audioOffset, (qint64)0, (qint64)_recording->getLength());
-    while(_currentFrame >= 0 &&
-          _recording->getFrameTimestamp(_currentFrame) > elapsed) {
-        --_currentFrame;
-    }
     
-    while (_currentFrame < _recording->getFrameNumber() &&
-           _recording->getFrameTimestamp(_currentFrame) < elapsed) {
-        ++_currentFrame;
-    }
-    --_currentFrame;
+    // the last frame strictly before elapsed, timestamps are whole milliseconds
+    _currentFrame = _recording->findFrameAtTime((qint32)elapsed - 1);
     
     if (_currentFrame == _recording->getFrameNumber() - 1) {
         --_currentFrame;
@@ -16,12 +16,15 @@
 #include <Sound.h>
 #include <StreamUtils.h>
 
+#include <algorithm>
+
 #include <QBitArray>
 #include <QElapsedTimer>
 #include <QEventLoop>
 #include <QFile>
 #include <QFileInfo>
 #include <QPair>
+#include <QScopedPointer>
 
 #include "AvatarData.h"
 #include "Recording.h"
@@ -33,7 +36,18 @@
 static const int MAGIC_NUMBER_SIZE = 8;
 static const char MAGIC_NUMBER[MAGIC_NUMBER_SIZE] = {17, 72, 70, 82, 13, 10, 26, 10};
 // Version (Major, Minor)
-static const QPair<quint8, quint8> VERSION(0, 2);
+// 0.3 splits the frames in chunks that each start with a keyframe, with an index of the chunks ahead of them, so that
+// a recording can be played from a mapped file and decoded a chunk at a time.
+static const QPair<quint8, quint8> VERSION(0, 3);
+
+// about a second of frames, which keeps keyframes a small part of the file and decoding a chunk cheap
+static const int FRAMES_PER_CHUNK = 60;
+
+// translation, rotation, scale, head rotation, lean sideways, lean forward and look at position
+static const int NUM_SINGLE_VALUE_MASK_BITS = 7;
+
+bool readFrame(QDataStream& stream, RecordingFrame& frame, const RecordingFrame* previousFrame,
+               quint32 numBlendshapes, quint32 numJoints);
 
 int SCALE_RADIX = 10;
 int BLENDSHAPE_RADIX = 15;
@@ -43,11 +57,23 @@ void RecordingFrame::setBlendshapeCoefficients(QVector<float> blendshapeCoeffici
     _blendshapeCoefficients = blendshapeCoefficients;
 }
 
-Recording::Recording() : _audio(NULL) {
+Recording::Recording() :
+    _file(NULL),
+    _numBlendshapes(0),
+    _numJoints(0),
+    _lastUsedSlot(0),
+    _audio(NULL)
+{
+    for (int i = 0; i < NUM_DECODED_CHUNKS; ++i) {
+        _decodedChunks[i] = -1;
+    }
 }
 
 Recording::~Recording() {
+    // the frames of a chunked file are decoded out of the mapping of _file, the audio was copied out of it
+    _fileData.clear();
     delete _audio;
+    delete _file;
 }
 
 int Recording::getLength() const {
@@ -67,9 +93,77 @@ qint32 Recording::getFrameTimestamp(int i) const {
     return _timestamps[i];
 }
 
+int Recording::findFrameAtTime(qint32 time) const {
+    return (int)(std::upper_bound(_timestamps.constBegin(), _timestamps.constEnd(), time) - _timestamps.constBegin()) - 1;
+}
+
 const RecordingFrame& Recording::getFrame(int i) const {
     assert(i < _timestamps.size());
-    return _frames[i];
+    if (_chunks.isEmpty()) {
+        return _frames[i];
+    }
+    
+    int chunk = findChunk(i);
+    int slot = -1;
+    for (int j = 0; j < NUM_DECODED_CHUNKS; ++j) {
+        if (_decodedChunks[j] == chunk) {
+            slot = j;
+            break;
+        }
+    }
+    if (slot == -1) {
+        // replace the chunk that was used least recently
+        slot = (_lastUsedSlot + 1) % NUM_DECODED_CHUNKS;
+        decodeChunk(chunk, _decodedFrames[slot]);
+        _decodedChunks[slot] = chunk;
+    }
+    _lastUsedSlot = slot;
+    return _decodedFrames[slot][i - _chunks[chunk].firstFrame];
+}
+
+int Recording::findChunk(int frame) const {
+    int lowestBound = 0;
+    int highestBound = _chunks.size() - 1;
+    while (lowestBound < highestBound) {
+        int middle = (lowestBound + highestBound + 1) / 2;
+        if ((int)_chunks[middle].firstFrame <= frame) {
+            lowestBound = middle;
+        } else {
+            highestBound = middle - 1;
+        }
+    }
+    return lowestBound;
+}
+
+bool Recording::decodeChunk(int chunk, QVector<RecordingFrame>& frames) const {
+    const RecordingChunk& info = _chunks[chunk];
+    int nextFirstFrame = (chunk + 1 < _chunks.size()) ? _chunks[chunk + 1].firstFrame : _timestamps.size();
+    frames.resize(nextFirstFrame - info.firstFrame);
+    
+    // the index was checked against the size of the file when it was read
+    QByteArray chunkData = QByteArray::fromRawData(_fileData.constData() + info.offset, info.size);
+    bool success = (qChecksum(chunkData.constData(), chunkData.size()) == info.crc16);
+    QDataStream stream(chunkData);
+    for (int i = 0; success && i < frames.size(); ++i) {
+        success = readFrame(stream, frames[i], (i == 0) ? NULL : &frames[i - 1], _numBlendshapes, _numJoints);
+    }
+    
+    if (!success) {
+        // hold a neutral pose rather than play garbage
+        qDebug() << "Couldn't decode recording chunk" << chunk << "(frames" << info.firstFrame << "to" << nextFirstFrame << ")";
+        RecordingFrame neutralFrame;
+        neutralFrame._blendshapeCoefficients.fill(0.0f, _numBlendshapes);
+        neutralFrame._jointRotations.fill(glm::quat(), _numJoints);
+        neutralFrame._translation = glm::vec3();
+        neutralFrame._rotation = glm::quat();
+        neutralFrame._scale = 1.0f;
+        neutralFrame._headRotation = glm::quat();
+        neutralFrame._leanSideways = 0.0f;
+        neutralFrame._leanForward = 0.0f;
+        neutralFrame._lookAtPosition = glm::vec3();
+        frames.fill(neutralFrame);
+    }
+    return success;
 }
 
 void Recording::addFrame(int timestamp, RecordingFrame &frame) {
@@ -88,8 +182,16 @@ void Recording::addAudioPacket(const QByteArray& byteArray) {
 void Recording::clear() {
     _timestamps.clear();
     _frames.clear();
+    _chunks.clear();
+    for (int i = 0; i < NUM_DECODED_CHUNKS; ++i) {
+        _decodedChunks[i] = -1;
+        _decodedFrames[i].clear();
+    }
     delete _audio;
     _audio = NULL;
+    _fileData.clear();
+    delete _file;
+    _file = NULL;
 }
 
 void writeVec3(QDataStream& stream, const glm::vec3& value) {
@@ -133,6 +235,170 @@ bool readFloat(QDataStream& stream, float& value, int radix) {
     return true;
 }
 
+static void writeContext(QDataStream& stream, const RecordingContext& context) {
+    // Global Timestamp
+    stream << context.globalTimestamp;
+    // Domain
+    stream << context.domain;
+    // Position
+    writeVec3(stream, context.position);
+    // Orientation
+    writeQuat(stream, context.orientation);
+    // Scale
+    stream << context.scale;
+    // Head model
+    stream << context.headModel;
+    // Skeleton model
+    stream << context.skeletonModel;
+    // Display name
+    stream << context.displayName;
+    // Attachements
+    stream << (quint8)context.attachments.size();
+    foreach (AttachmentData data, context.attachments) {
+        // Model
+        stream << data.modelURL.toString();
+        // Joint name
+        stream << data.jointName;
+        // Position
+        writeVec3(stream, data.translation);
+        // Orientation
+        writeQuat(stream, data.rotation);
+        // Scale
+        stream << data.scale;
+    }
+}
+
+void writeFrame(QDataStream& stream, const RecordingFrame& frame, const RecordingFrame* previousFrame) {
+    // only what changed since the previous frame is written, a keyframe has no previous frame and writes everything
+    QBitArray mask(frame._blendshapeCoefficients.size() + frame._jointRotations.size() + NUM_SINGLE_VALUE_MASK_BITS);
+    int maskIndex = 0;
+    QByteArray buffer;
+    QDataStream bufferStream(&buffer, QIODevice::WriteOnly);
+    bufferStream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    
+    for (int i = 0; i < frame._blendshapeCoefficients.size(); ++i) {
+        if (!previousFrame || frame._blendshapeCoefficients[i] != previousFrame->_blendshapeCoefficients[i]) {
+            bufferStream << frame._blendshapeCoefficients[i];
+            mask.setBit(maskIndex);
+        }
+        ++maskIndex;
+    }
+    for (int i = 0; i < frame._jointRotations.size(); ++i) {
+        if (!previousFrame || frame._jointRotations[i] != previousFrame->_jointRotations[i]) {
+            writeQuat(bufferStream, frame._jointRotations[i]);
+            mask.setBit(maskIndex);
+        }
+        ++maskIndex;
+    }
+    if (!previousFrame || frame._translation != previousFrame->_translation) {
+        writeVec3(bufferStream, frame._translation);
+        mask.setBit(maskIndex);
+    }
+    ++maskIndex;
+    if (!previousFrame || frame._rotation != previousFrame->_rotation) {
+        writeQuat(bufferStream, frame._rotation);
+        mask.setBit(maskIndex);
+    }
+    ++maskIndex;
+    if (!previousFrame || frame._scale != previousFrame->_scale) {
+        bufferStream << frame._scale;
+        mask.setBit(maskIndex);
+    }
+    ++maskIndex;
+    if (!previousFrame || frame._headRotation != previousFrame->_headRotation) {
+        writeQuat(bufferStream, frame._headRotation);
+        mask.setBit(maskIndex);
+    }
+    ++maskIndex;
+    if (!previousFrame || frame._leanSideways != previousFrame->_leanSideways) {
+        bufferStream << frame._leanSideways;
+        mask.setBit(maskIndex);
+    }
+    ++maskIndex;
+    if (!previousFrame || frame._leanForward != previousFrame->_leanForward) {
+        bufferStream << frame._leanForward;
+        mask.setBit(maskIndex);
+    }
+    ++maskIndex;
+    if (!previousFrame || frame._lookAtPosition != previousFrame->_lookAtPosition) {
+        writeVec3(bufferStream, frame._lookAtPosition);
+        mask.setBit(maskIndex);
+    }
+    
+    stream << mask;
+    stream << buffer;
+}
+
+bool readFrame(QDataStream& stream, RecordingFrame& frame, const RecordingFrame* previousFrame,
+               quint32 numBlendshapes, quint32 numJoints) {
+    QBitArray mask;
+    QByteArray buffer;
+    stream >> mask;
+    stream >> buffer;
+    if (stream.status() != QDataStream::Ok ||
+        mask.size() != (int)(numBlendshapes + numJoints) + NUM_SINGLE_VALUE_MASK_BITS ||
+        (!previousFrame && mask.count(true) != mask.size())) {
+        return false;
+    }
+    QDataStream bufferStream(buffer);
+    bufferStream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    int maskIndex = 0;
+    bool success = true;
+    
+    frame._blendshapeCoefficients.resize(numBlendshapes);
+    for (quint32 i = 0; i < numBlendshapes; ++i) {
+        if (mask[maskIndex++]) {
+            bufferStream >> frame._blendshapeCoefficients[i];
+        } else {
+            frame._blendshapeCoefficients[i] = previousFrame->_blendshapeCoefficients[i];
+        }
+    }
+    frame._jointRotations.resize(numJoints);
+    for (quint32 i = 0; i < numJoints; ++i) {
+        if (mask[maskIndex++]) {
+            success &= readQuat(bufferStream, frame._jointRotations[i]);
+        } else {
+            frame._jointRotations[i] = previousFrame->_jointRotations[i];
+        }
+    }
+    if (mask[maskIndex++]) {
+        success &= readVec3(bufferStream, frame._translation);
+    } else {
+        frame._translation = previousFrame->_translation;
+    }
+    if (mask[maskIndex++]) {
+        success &= readQuat(bufferStream, frame._rotation);
+    } else {
+        frame._rotation = previousFrame->_rotation;
+    }
+    if (mask[maskIndex++]) {
+        bufferStream >> frame._scale;
+    } else {
+        frame._scale = previousFrame->_scale;
+    }
+    if (mask[maskIndex++]) {
+        success &= readQuat(bufferStream, frame._headRotation);
+    } else {
+        frame._headRotation = previousFrame->_headRotation;
+    }
+    if (mask[maskIndex++]) {
+        bufferStream >> frame._leanSideways;
+    } else {
+        frame._leanSideways = previousFrame->_leanSideways;
+    }
+    if (mask[maskIndex++]) {
+        bufferStream >> frame._leanForward;
+    } else {
+        frame._leanForward = previousFrame->_leanForward;
+    }
+    if (mask[maskIndex++]) {
+        success &= readVec3(bufferStream, frame._lookAtPosition);
+    } else {
+        frame._lookAtPosition = previousFrame->_lookAtPosition;
+    }
+    return success && bufferStream.status() == QDataStream::Ok;
+}
+
 void writeRecordingToFile(RecordingPointer recording, const QString& filename) {
     if (!recording || recording->getFrameNumber() < 1) {
         qDebug() << "Can't save empty recording";
@@ -172,171 +438,79 @@ void writeRecordingToFile(RecordingPointer recording, const QString& filename) {
     fileStream << dataOffset;
     file.seek(dataOffset);
     
-    // CONTEXT
-    RecordingContext& context = recording->getContext();
-    // Global Timestamp
-    fileStream << context.globalTimestamp;
-    // Domain
-    fileStream << context.domain;
-    // Position
-    writeVec3(fileStream, context.position);
-    // Orientation
-    writeQuat(fileStream, context.orientation);
-    // Scale
-    fileStream << context.scale;
-    // Head model
-    fileStream << context.headModel;
-    // Skeleton model
-    fileStream << context.skeletonModel;
-    // Display name
-    fileStream << context.displayName;
-    // Attachements
-    fileStream << (quint8)context.attachments.size();
-    foreach (AttachmentData data, context.attachments) {
-        // Model
-        fileStream << data.modelURL.toString();
-        // Joint name
-        fileStream << data.jointName;
-        // Position
-        writeVec3(fileStream, data.translation);
-        // Orientation
-        writeQuat(fileStream, data.rotation);
-        // Scale
-        fileStream << data.scale;
-    }
-    
-    // RECORDING
-    fileStream << recording->_timestamps;
-    
-    QBitArray mask;
-    quint32 numBlendshapes = 0;
-    quint32 numJoints = 0;
-    
-    for (int i = 0; i < recording->_timestamps.size(); ++i) {
-        mask.fill(false);
-        int maskIndex = 0;
+    // CHUNKS
+    // Each chunk starts with a keyframe, so that it can be decoded without the ones before it
+    int numFrames = recording->getFrameNumber();
+    RecordingFrame frame = recording->getFrame(0);
+    quint32 numBlendshapes = frame._blendshapeCoefficients.size();
+    quint32 numJoints = frame._jointRotations.size();
+    QVector<RecordingChunk> chunks;
+    QVector<QByteArray> chunkBuffers;
+    for (int i = 0; i < numFrames; i += FRAMES_PER_CHUNK) {
         QByteArray buffer;
         QDataStream stream(&buffer, QIODevice::WriteOnly);
-        RecordingFrame& previousFrame = recording->_frames[(i != 0) ? i - 1 : i];
-        RecordingFrame& frame = recording->_frames[i];
-        
-        // Blendshape Coefficients
-        if (i == 0) {
-            numBlendshapes = frame.getBlendshapeCoefficients().size();
-            stream << numBlendshapes;
-            mask.resize(mask.size() + numBlendshapes);
-        }
-        for (quint32 j = 0; j < numBlendshapes; ++j) {
-            if (i == 0 ||
-                frame._blendshapeCoefficients[j] != previousFrame._blendshapeCoefficients[j]) {
-                stream << frame.getBlendshapeCoefficients()[j];
-                mask.setBit(maskIndex);
-            }
-            ++maskIndex;
-        }
-        
-        // Joint Rotations
-        if (i == 0) {
-            numJoints = frame.getJointRotations().size();
-            stream << numJoints;
-            mask.resize(mask.size() + numJoints);
-        }
-        for (quint32 j = 0; j < numJoints; ++j) {
-            if (i == 0 ||
-                frame._jointRotations[j] != previousFrame._jointRotations[j]) {
-                writeQuat(stream, frame._jointRotations[j]);
-                mask.setBit(maskIndex);
-            }
-            maskIndex++;
-        }
-        
-        // Translation
-        if (i == 0) {
-            mask.resize(mask.size() + 1);
-        }
-        if (i == 0 || frame._translation != previousFrame._translation) {
-            writeVec3(stream, frame._translation);
-            mask.setBit(maskIndex);
-        }
-        maskIndex++;
-        
-        // Rotation
-        if (i == 0) {
-            mask.resize(mask.size() + 1);
-        }
-        if (i == 0 || frame._rotation != previousFrame._rotation) {
-            writeQuat(stream, frame._rotation);
-            mask.setBit(maskIndex);
-        }
-        maskIndex++;
-        
-        // Scale
-        if (i == 0) {
-            mask.resize(mask.size() + 1);
-        }
-        if (i == 0 || frame._scale != previousFrame._scale) {
-            stream << frame._scale;
-            mask.setBit(maskIndex);
-        }
-        maskIndex++;
-        
-        // Head Rotation
-        if (i == 0) {
-            mask.resize(mask.size() + 1);
-        }
-        if (i == 0 || frame._headRotation != previousFrame._headRotation) {
-            writeQuat(stream, frame._headRotation);
-            mask.setBit(maskIndex);
-        }
-        maskIndex++;
-        
-        // Lean Sideways
-        if (i == 0) {
-            mask.resize(mask.size() + 1);
+        RecordingFrame previousFrame;
+        for (int j = i; j < qMin(i + FRAMES_PER_CHUNK, numFrames); ++j) {
+            // copied, since a recording read from a chunked file only keeps a couple of chunks decoded
+            frame = recording->getFrame(j);
+            writeFrame(stream, frame, (j == i) ? NULL : &previousFrame);
+            previousFrame = frame;
         }
-        if (i == 0 || frame._leanSideways != previousFrame._leanSideways) {
-            stream << frame._leanSideways;
-            mask.setBit(maskIndex);
-        }
-        maskIndex++;
-        
-        // Lean Forward
-        if (i == 0) {
-            mask.resize(mask.size() + 1);
-        }
-        if (i == 0 || frame._leanForward != previousFrame._leanForward) {
-            stream << frame._leanForward;
-            mask.setBit(maskIndex);
+        RecordingChunk chunk;
+        chunk.firstFrame = i;
+        chunk.offset = 0;
+        chunk.size = buffer.size();
+        chunk.crc16 = qChecksum(buffer.constData(), buffer.size());
+        chunks << chunk;
+        chunkBuffers << buffer;
+    }
+    QByteArray audioArray = recording->getAudio() ? recording->getAudio()->getByteArray() : QByteArray();
+    
+    // CONTEXT and INDEX
+    // The index is the same size whatever offsets it holds, so it is written once to find where the chunks start and
+    // again with their offsets
+    RecordingContext& context = recording->getContext();
+    QByteArray data;
+    quint32 audioOffset = 0;
+    for (int pass = 0; pass < 2; ++pass) {
+        quint32 offset = dataOffset + data.size();
+        for (int i = 0; i < chunks.size(); ++i) {
+            chunks[i].offset = offset;
+            offset += chunks[i].size;
         }
-        maskIndex++;
+        audioOffset = offset;
         
-        // LookAt Position
-        if (i == 0) {
-            mask.resize(mask.size() + 1);
-        }
-        if (i == 0 || frame._lookAtPosition != previousFrame._lookAtPosition) {
-            writeVec3(stream, frame._lookAtPosition);
-            mask.setBit(maskIndex);
+        data.clear();
+        QDataStream dataStream(&data, QIODevice::WriteOnly);
+        writeContext(dataStream, context);
+        dataStream << numBlendshapes;
+        dataStream << numJoints;
+        dataStream << recording->_timestamps;
+        dataStream << (quint32)chunks.size();
+        foreach (const RecordingChunk& chunk, chunks) {
+            dataStream << chunk.firstFrame << chunk.offset << chunk.size << chunk.crc16;
         }
-        maskIndex++;
-        
-        fileStream << mask;
-        fileStream << buffer;
+        dataStream << audioOffset;
+        dataStream << (quint32)audioArray.size();
     }
     
-    fileStream << recording->_audio->getByteArray();
+    file.write(data);
+    foreach (const QByteArray& buffer, chunkBuffers) {
+        file.write(buffer);
+    }
+    // AUDIO
+    file.write(audioArray);
     
     qint64 writingTime = timer.restart();
-    // Write data length and CRC-16
-    quint32 dataLength = file.pos() - dataOffset;
-    file.seek(dataOffset); // Go to beginning of data for checksum
-    quint16 crc16 = qChecksum(file.readAll().constData(), dataLength);
+    // Write data length and CRC-16, they cover the context and the index, the chunks have their own
+    quint32 dataLength = data.size();
+    quint16 crc16 = qChecksum(data.constData(), dataLength);
     
     file.seek(dataLengthPos);
     fileStream << dataLength;
     file.seek(crc16Pos);
     fileStream << crc16;
-    file.seek(dataOffset + dataLength);
+    file.seek(file.size());
     
     bool wantDebug = true;
     if (wantDebug) {
@@ -367,7 +541,8 @@ void writeRecordingToFile(RecordingPointer recording, const QString& filename) {
         
         qDebug() << "Recording:";
         qDebug() << "Total frames:" << recording->getFrameNumber();
-        qDebug() << "Audio array:" << recording->getAudio()->getByteArray().size();
+        qDebug() << "Chunks:" << chunks.size();
+        qDebug() << "Audio array:" << audioArray.size();
     }
     
     qint64 checksumTime = timer.elapsed();
@@ -376,6 +551,7 @@ void writeRecordingToFile(RecordingPointer recording, const QString& filename) {
 
 RecordingPointer readRecordingFromFile(RecordingPointer recording, const QString& filename) {
     QByteArray byteArray;
+    QScopedPointer<QFile> file;
     QUrl url(filename);
     QElapsedTimer timer;
     timer.start(); // timer used for debug informations (download/parsing time)
@@ -400,15 +576,21 @@ RecordingPointer readRecordingFromFile(RecordingPointer recording, const QString
         // print debug + restart timer
         qDebug() << "Downloaded " << byteArray.size() << " bytes in " << timer.restart() << " ms.";
     } else {
-        // If local file, just read it.
+        // If local file, map it. Chunked recordings are decoded from the mapping as they play, older ones are decoded
+        // here and the mapping let go.
         qDebug() << "Reading recording from " << filename << ".";
-        QFile file(filename);
-        if (!file.open(QIODevice::ReadOnly)){
+        file.reset(new QFile(filename));
+        if (!file->open(QIODevice::ReadOnly)){
             qDebug() << "Could not open local file: " << url;
             return recording;
         }
-        byteArray = file.readAll();
-        file.close();
+        uchar* mapping = file->map(0, file->size());
+        if (mapping) {
+            byteArray = QByteArray::fromRawData(reinterpret_cast<const char*>(mapping), file->size());
+        } else {
+            byteArray = file->readAll();
+            file.reset();
+        }
     }
     
     if (filename.endsWith(".rec") || filename.endsWith(".REC")) {
@@ -436,7 +618,7 @@ RecordingPointer readRecordingFromFile(RecordingPointer recording, const QString
     
     QPair<quint8, quint8> version;
     fileStream >> version; // File format version
-    if (version != VERSION && version != QPair<quint8, quint8>(0,1)) {
+    if (version != VERSION && version != QPair<quint8, quint8>(0,2) && version != QPair<quint8, quint8>(0,1)) {
         qDebug() << "ERROR: This file format version is not supported.";
         return recording;
     }
@@ -448,8 +630,13 @@ RecordingPointer readRecordingFromFile(RecordingPointer recording, const QString
     quint16 crc16 = 0;
     fileStream >> crc16;
     
+    if ((qint64)dataOffset + dataLength > byteArray.size()) {
+        qDebug() << "File is shorter than its header says. Bailling!";
+        recording.clear();
+        return recording;
+    }
     
-    // Check checksum
+    // Check checksum, from version 0.3 it only covers the context and the index
     quint16 computedCRC16 = qChecksum(byteArray.constData() + dataOffset, dataLength);
     if (computedCRC16 != crc16) {
         qDebug() << "Checksum does not match. Bailling!";
@@ -527,92 +714,139 @@ RecordingPointer readRecordingFromFile(RecordingPointer recording, const QString
     
     quint32 numBlendshapes = 0;
     quint32 numJoints = 0;
-    // RECORDING
-    fileStream >> recording->_timestamps;
-    
-    for (int i = 0; i < recording->_timestamps.size(); ++i) {
-        QBitArray mask;
-        QByteArray buffer;
-        QDataStream stream(&buffer, QIODevice::ReadOnly);
-        RecordingFrame frame;
-        RecordingFrame& previousFrame = (i == 0) ? frame : recording->_frames.last();
+    if (version == VERSION) {
+        // INDEX
+        // The index is read on the side and only handed to the recording once all of it checks out. The chunks and the
+        // audio come after the header and the index, and have to be inside the file that was mapped.
+        quint64 contentStart = (quint64)dataOffset + dataLength;
+        quint64 contentEnd = (quint64)byteArray.size();
+        fileStream >> numBlendshapes;
+        fileStream >> numJoints;
+        QVector<qint32> timestamps;
+        fileStream >> timestamps;
+        quint32 numChunks = 0;
+        fileStream >> numChunks;
+        QVector<RecordingChunk> chunks;
+        bool isIndexValid = !timestamps.isEmpty() && numChunks > 0;
+        for (quint32 i = 0; isIndexValid && i < numChunks; ++i) {
+            RecordingChunk chunk;
+            fileStream >> chunk.firstFrame >> chunk.offset >> chunk.size >> chunk.crc16;
+            isIndexValid = chunk.offset >= contentStart && (quint64)chunk.offset + chunk.size <= contentEnd &&
+                (chunks.isEmpty() ? chunk.firstFrame == 0 : chunk.firstFrame > chunks.last().firstFrame) &&
+                chunk.firstFrame < (quint32)timestamps.size();
+            chunks << chunk;
+        }
+        quint32 audioOffset = 0;
+        quint32 audioSize = 0;
+        fileStream >> audioOffset;
+        fileStream >> audioSize;
+        if (!isIndexValid || fileStream.status() != QDataStream::Ok ||
+            audioOffset < contentStart || (quint64)audioOffset + audioSize > contentEnd) {
+            qDebug() << "Couldn't read file correctly. (Invalid chunk index)";
+            // the caller may still hold the recording, so drop what is left in it from before as well
+            recording->clear();
+            recording.clear();
+            return recording;
+        }
         
-        fileStream >> mask;
-        fileStream >> buffer;
-        int maskIndex = 0;
+        // RECORDING
+        // The frames are decoded when they are played, so the recording keeps the file. The audio is copied out of it,
+        // since the injector playing it can outlive the recording.
+        recording->_timestamps = timestamps;
+        recording->_chunks = chunks;
+        recording->_numBlendshapes = numBlendshapes;
+        recording->_numJoints = numJoints;
+        recording->_fileData = byteArray;
+        recording->_file = file.take();
+        recording->addAudioPacket(QByteArray(byteArray.constData() + audioOffset, audioSize));
+    } else {
+        // RECORDING
+        fileStream >> recording->_timestamps;
         
-        // Blendshape Coefficients
-        if (i == 0) {
-            stream >> numBlendshapes;
-        }
-        frame._blendshapeCoefficients.resize(numBlendshapes);
-        for (quint32 j = 0; j < numBlendshapes; ++j) {
-            if (!mask[maskIndex++]) {
-                frame._blendshapeCoefficients[j] = previousFrame._blendshapeCoefficients[j];
-            } else if (version == QPair<quint8, quint8>(0,1)) {
-                readFloat(stream, frame._blendshapeCoefficients[j], BLENDSHAPE_RADIX);
-            } else {
-                stream >> frame._blendshapeCoefficients[j];
+        for (int i = 0; i < recording->_timestamps.size(); ++i) {
+            QBitArray mask;
+            QByteArray buffer;
+            QDataStream stream(&buffer, QIODevice::ReadOnly);
+            RecordingFrame frame;
+            RecordingFrame& previousFrame = (i == 0) ? frame : recording->_frames.last();
+        
+            fileStream >> mask;
+            fileStream >> buffer;
+            int maskIndex = 0;
+        
+            // Blendshape Coefficients
+            if (i == 0) {
+                stream >> numBlendshapes;
             }
-        }
-        // Joint Rotations
-        if (i == 0) {
-            stream >> numJoints;
-        }
-        frame._jointRotations.resize(numJoints);
-        for (quint32 j = 0; j < numJoints; ++j) {
-            if (!mask[maskIndex++] || !readQuat(stream, frame._jointRotations[j])) {
-                frame._jointRotations[j] = previousFrame._jointRotations[j];
+            frame._blendshapeCoefficients.resize(numBlendshapes);
+            for (quint32 j = 0; j < numBlendshapes; ++j) {
+                if (!mask[maskIndex++]) {
+                    frame._blendshapeCoefficients[j] = previousFrame._blendshapeCoefficients[j];
+                } else if (version == QPair<quint8, quint8>(0,1)) {
+                    readFloat(stream, frame._blendshapeCoefficients[j], BLENDSHAPE_RADIX);
+                } else {
+                    stream >> frame._blendshapeCoefficients[j];
+                }
+            }
+            // Joint Rotations
+            if (i == 0) {
+                stream >> numJoints;
+            }
+            frame._jointRotations.resize(numJoints);
+            for (quint32 j = 0; j < numJoints; ++j) {
+                if (!mask[maskIndex++] || !readQuat(stream, frame._jointRotations[j])) {
+                    frame._jointRotations[j] = previousFrame._jointRotations[j];
+                }
             }
-        }
         
-        if (!mask[maskIndex++] || !readVec3(stream, frame._translation)) {
-            frame._translation = previousFrame._translation;
-        }
+            if (!mask[maskIndex++] || !readVec3(stream, frame._translation)) {
+                frame._translation = previousFrame._translation;
+            }
         
-        if (!mask[maskIndex++] || !readQuat(stream, frame._rotation)) {
-            frame._rotation = previousFrame._rotation;
-        }
+            if (!mask[maskIndex++] || !readQuat(stream, frame._rotation)) {
+                frame._rotation = previousFrame._rotation;
+            }
         
-        if (!mask[maskIndex++]) {
-            frame._scale = previousFrame._scale;
-        } else if (version == QPair<quint8, quint8>(0,1)) {
-            readFloat(stream, frame._scale, SCALE_RADIX);
-        } else {
-            stream >> frame._scale;
-        }
+            if (!mask[maskIndex++]) {
+                frame._scale = previousFrame._scale;
+            } else if (version == QPair<quint8, quint8>(0,1)) {
+                readFloat(stream, frame._scale, SCALE_RADIX);
+            } else {
+                stream >> frame._scale;
+            }
         
-        if (!mask[maskIndex++] || !readQuat(stream, frame._headRotation)) {
-            frame._headRotation = previousFrame._headRotation;
-        }
+            if (!mask[maskIndex++] || !readQuat(stream, frame._headRotation)) {
+                frame._headRotation = previousFrame._headRotation;
+            }
         
-        if (!mask[maskIndex++]) {
-            frame._leanSideways = previousFrame._leanSideways;
-        } else if (version == QPair<quint8, quint8>(0,1)) {
-            readFloat(stream, frame._leanSideways, LEAN_RADIX);
-        } else {
-            stream >> frame._leanSideways;
-        }
+            if (!mask[maskIndex++]) {
+                frame._leanSideways = previousFrame._leanSideways;
+            } else if (version == QPair<quint8, quint8>(0,1)) {
+                readFloat(stream, frame._leanSideways, LEAN_RADIX);
+            } else {
+                stream >> frame._leanSideways;
+            }
         
-        if (!mask[maskIndex++]) {
-            frame._leanForward = previousFrame._leanForward;
-        } else if (version == QPair<quint8, quint8>(0,1)) {
-            readFloat(stream, frame._leanForward, LEAN_RADIX);
-        } else {
-            stream >> frame._leanForward;
-        }
+            if (!mask[maskIndex++]) {
+                frame._leanForward = previousFrame._leanForward;
+            } else if (version == QPair<quint8, quint8>(0,1)) {
+                readFloat(stream, frame._leanForward, LEAN_RADIX);
+            } else {
+                stream >> frame._leanForward;
+            }
         
-        if (!mask[maskIndex++] || !readVec3(stream, frame._lookAtPosition)) {
-            frame._lookAtPosition = previousFrame._lookAtPosition;
+            if (!mask[maskIndex++] || !readVec3(stream, frame._lookAtPosition)) {
+                frame._lookAtPosition = previousFrame._lookAtPosition;
+            }
+        
+            recording->_frames << frame;
         }
         
-        recording->_frames << frame;
+        QByteArray audioArray;
+        fileStream >> audioArray;
+        recording->addAudioPacket(audioArray);
     }
     
-    QByteArray audioArray;
-    fileStream >> audioArray;
-    recording->addAudioPacket(audioArray);
-    
     bool wantDebug = true;
     if (wantDebug) {
         qDebug() << "[DEBUG] READ recording";
@@ -686,7 +920,9 @@ RecordingPointer readRecordingFromRecFile(RecordingPointer recording, const QStr
     // Fake context
     RecordingContext& context = recording->getContext();
     context.globalTimestamp = usecTimestampNow();
-    context.domain = NodeList::getInstance()->getDomainHandler().getHostname();
+    // there is no node list when a file is converted outside of a client
+    NodeList* nodeList = NodeList::getInstance();
+    context.domain = nodeList ? nodeList->getDomainHandler().getHostname() : QString();
     context.position = glm::vec3(144.5f, 3.3f, 181.3f);
     context.orientation = glm::angleAxis(glm::radians(-92.5f), glm::vec3(0, 1, 0));;
     context.scale = baseFrame._scale;
@@ -12,6 +12,7 @@
 #ifndef hifi_Recording_h
 #define hifi_Recording_h
 
+#include <QByteArray>
 #include <QString>
 #include <QVector>
 
@@ -22,6 +23,8 @@ template<class C>
 class QSharedPointer;
 
 class AttachmentData;
+class QDataStream;
+class QFile;
 class Recording;
 class RecordingFrame;
 class Sound;
@@ -45,6 +48,15 @@ public:
     glm::quat orientationInv;
 };
 
+/// Where a run of frames starting with a keyframe is in a chunked recording file
+class RecordingChunk {
+public:
+    quint32 firstFrame;
+    quint32 offset; // from the start of the file
+    quint32 size;
+    quint16 crc16;
+};
+
 /// Stores a recording
 class Recording {
 public:
@@ -55,8 +67,14 @@ public:
     int getLength() const; // in ms
     
     RecordingContext& getContext() { return _context; }
-    int getFrameNumber() const { return _frames.size(); }
+    int getFrameNumber() const { return _timestamps.size(); }
     qint32 getFrameTimestamp(int i) const;
+    
+    /// the last frame at or before time (in ms), or -1 if time is before the first frame
+    int findFrameAtTime(qint32 time) const;
+    
+    /// frames of a chunked file are decoded a chunk at a time the first time they are asked for. The reference stays valid
+    /// until frames from two other chunks have been asked for.
     const RecordingFrame& getFrame(int i) const;
     Sound* getAudio() const { return _audio; }
     
@@ -66,10 +84,29 @@ protected:
     void clear();
     
 private:
+    static const int NUM_DECODED_CHUNKS = 2;
+    
+    int findChunk(int frame) const;
+    bool decodeChunk(int chunk, QVector<RecordingFrame>& frames) const;
+    
     RecordingContext _context;
     QVector<qint32> _timestamps;
+    
+    // frames of recordings made here or read from the older formats, which are all decoded up front
     QVector<RecordingFrame> _frames;
     
+    // the content of a chunked file, mapped from disk when it can be, and where its chunks are
+    QFile* _file;
+    QByteArray _fileData;
+    QVector<RecordingChunk> _chunks;
+    quint32 _numBlendshapes;
+    quint32 _numJoints;
+    
+    // the chunks decoded last, the play head only ever needs the frame it is on and the next one
+    mutable int _decodedChunks[NUM_DECODED_CHUNKS];
+    mutable QVector<RecordingFrame> _decodedFrames[NUM_DECODED_CHUNKS];
+    mutable int _lastUsedSlot;
+    
     Sound* _audio;
     
     friend class Recorder;
@@ -116,10 +153,14 @@ private:
     glm::vec3 _lookAtPosition;
     
     friend class Recorder;
+    friend class Recording;
     friend void writeRecordingToFile(RecordingPointer recording, const QString& file);
     friend RecordingPointer readRecordingFromFile(RecordingPointer recording, const QString& file);
     friend RecordingPointer readRecordingFromRecFile(RecordingPointer recording, const QString& filename,
                                                      const QByteArray& byteArray);
+    friend void writeFrame(QDataStream& stream, const RecordingFrame& frame, const RecordingFrame* previousFrame);
+    friend bool readFrame(QDataStream& stream, RecordingFrame& frame, const RecordingFrame* previousFrame,
+                          quint32 numBlendshapes, quint32 numJoints);
 };
 
 void writeRecordingToFile(RecordingPointer recording, const QString& filename);
@@ -18,6 +18,7 @@
 DeleteEntityOperator::DeleteEntityOperator(EntityTree* tree, const EntityItemID& searchEntityID) :
     _tree(tree),
     _changeTime(usecTimestampNow()),
+    _trackDeletes(true),
     _foundCount(0),
     _lookingCount(0)
 {
@@ -27,9 +28,10 @@ DeleteEntityOperator::DeleteEntityOperator(EntityTree* tree, const EntityItemID&
 DeleteEntityOperator::~DeleteEntityOperator() {
 }
 
-DeleteEntityOperator::DeleteEntityOperator(EntityTree* tree) :
+DeleteEntityOperator::DeleteEntityOperator(EntityTree* tree, bool trackDeletes) :
     _tree(tree),
     _changeTime(usecTimestampNow()),
+    _trackDeletes(trackDeletes),
     _foundCount(0),
     _lookingCount(0)
 {
@@ -48,7 +50,9 @@ void DeleteEntityOperator::addEntityIDToDeleteList(const EntityItemID& searchEnt
             details.cube = details.containingElement->getAACube();
             _entitiesToDelete << details;
             _lookingCount++;
-            _tree->trackDeletedEntity(searchEntityID);
+            if (_trackDeletes) {
+                _tree->trackDeletedEntity(searchEntityID);
+            }
             // before deleting any entity make sure to remove it from our Mortal, Changing, and Moving lists
             _tree->removeEntityFromSimulationLists(searchEntityID);
         }
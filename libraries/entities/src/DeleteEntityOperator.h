@@ -29,7 +29,9 @@ inline bool operator==(const EntityToDeleteDetails& a, const EntityToDeleteDetai
 
 class DeleteEntityOperator : public RecurseOctreeOperator {
 public:
-    DeleteEntityOperator(EntityTree* tree);
+    /// trackDeletes: false when the entities are moving to another server rather than going away, so viewers are not
+    /// told to delete them
+    DeleteEntityOperator(EntityTree* tree, bool trackDeletes = true);
     DeleteEntityOperator(EntityTree* tree, const EntityItemID& searchEntityID);
     ~DeleteEntityOperator();
 
@@ -40,6 +42,7 @@ private:
     EntityTree* _tree;
     QSet<EntityToDeleteDetails> _entitiesToDelete;
     quint64 _changeTime;
+    bool _trackDeletes;
     int _foundCount;
     int _lookingCount;
     bool subTreeContainsSomeEntitiesToDelete(OctreeElement* element);
@@ -0,0 +1,130 @@
+//
+//  DeletedEntityLog.cpp
+//  libraries/entities/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <QtGlobal>
+
+#include "DeletedEntityLog.h"
+
+class DeletedEntityBlock {
+public:
+    DeletedEntityBlock(quint64 firstSequence) : firstSequence(firstSequence), count(0), next(NULL) { }
+
+    quint64 firstSequence;
+    QAtomicInt count; // the entries before count are written and never change again
+    QAtomicPointer<DeletedEntityBlock> next; // only set once the first entry of the next block is written
+    QUuid entityIDs[DeletedEntityLog::BLOCK_SIZE];
+};
+
+DeletedEntityLog::DeletedEntityLog() :
+    _head(new DeletedEntityBlock(0)),
+    _forgottenBefore(0) {
+
+    _tail = _head.load();
+}
+
+DeletedEntityLog::~DeletedEntityLog() {
+    DeletedEntityBlock* block = _head.load();
+    while (block) {
+        DeletedEntityBlock* next = block->next.load();
+        delete block;
+        block = next;
+    }
+}
+
+void DeletedEntityLog::append(const QUuid& entityID) {
+    QMutexLocker locker(&_mutex);
+    int count = _tail->count.load();
+    if (count < BLOCK_SIZE) {
+        _tail->entityIDs[count] = entityID;
+        _tail->count.storeRelease(count + 1);
+        return;
+    }
+    DeletedEntityBlock* block = new DeletedEntityBlock(_tail->firstSequence + BLOCK_SIZE);
+    block->entityIDs[0] = entityID;
+    block->count.store(1);
+    _tail->next.storeRelease(block);
+    _tail = block;
+}
+
+DeletedEntityBlock* DeletedEntityLog::findBlock(DeletedEntityCursor& cursor, int& index) const {
+    if (!cursor._block) {
+        // a cursor that has never been read from starts at the oldest deletion still kept. The head is only safe to
+        // take under the prune lock, a prune that already looked at the cursors may be about to free it.
+        QMutexLocker locker(&_pruneMutex);
+        cursor._block = _head.loadAcquire();
+        cursor._sequence = cursor._block->firstSequence;
+    }
+    index = (int)(cursor._sequence - cursor._block->firstSequence);
+    return cursor._block;
+}
+
+bool DeletedEntityLog::hasDeletionsAfter(const DeletedEntityCursor& cursor) const {
+    if (!cursor._block) {
+        // without starting the cursor, only the forgetting that could free the head has to be kept out
+        QMutexLocker locker(&_mutex);
+        DeletedEntityBlock* head = _head.load();
+        return head->count.load() > 0;
+    }
+    int index = (int)(cursor._sequence - cursor._block->firstSequence);
+    DeletedEntityBlock* block = cursor._block;
+    if (index < BLOCK_SIZE) {
+        return index < block->count.loadAcquire();
+    }
+    return block->next.loadAcquire() != NULL;
+}
+
+int DeletedEntityLog::read(DeletedEntityCursor& cursor, QUuid* entityIDs, int maxCount) const {
+    int index;
+    DeletedEntityBlock* block = findBlock(cursor, index);
+    int readCount = 0;
+    while (readCount < maxCount) {
+        if (index == BLOCK_SIZE) {
+            DeletedEntityBlock* next = block->next.loadAcquire();
+            if (!next) {
+                break;
+            }
+            block = next;
+            index = 0;
+        }
+        int count = block->count.loadAcquire();
+        if (index == count) {
+            break;
+        }
+        int toRead = qMin(count - index, maxCount - readCount);
+        for (int i = 0; i < toRead; i++) {
+            entityIDs[readCount++] = block->entityIDs[index++];
+        }
+    }
+    cursor._block = block;
+    cursor._sequence = block->firstSequence + index;
+    return readCount;
+}
+
+bool DeletedEntityLog::isEmpty() const {
+    // the last block is never freed, so whether anything is left to forget goes by the sequence numbers
+    QMutexLocker locker(&_mutex);
+    return _tail->firstSequence + _tail->count.load() <= _forgottenBefore;
+}
+
+void DeletedEntityLog::forgetBefore(quint64 sequence) {
+    QMutexLocker locker(&_mutex);
+    // with no cursors at all the sequence is as high as it goes, which doesn't forget deletions that are yet to come
+    quint64 endSequence = _tail->firstSequence + _tail->count.load();
+    _forgottenBefore = qMax(_forgottenBefore, qMin(sequence, endSequence));
+    DeletedEntityBlock* block = _head.load();
+
+    // a cursor at the very end of a block still points at it, so only blocks that end strictly before the sequence go
+    while (block != _tail && block->firstSequence + BLOCK_SIZE < sequence) {
+        DeletedEntityBlock* next = block->next.load();
+        _head.storeRelease(next);
+        delete block;
+        block = next;
+    }
+}
@@ -0,0 +1,80 @@
+//
+//  DeletedEntityLog.h
+//  libraries/entities/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_DeletedEntityLog_h
+#define hifi_DeletedEntityLog_h
+
+#include <QAtomicInt>
+#include <QAtomicPointer>
+#include <QMutex>
+#include <QUuid>
+
+class DeletedEntityBlock;
+
+/// Where one client has got to in a DeletedEntityLog. A new cursor starts at the oldest deletion the log still has.
+class DeletedEntityCursor {
+public:
+    DeletedEntityCursor() : _sequence(0), _block(NULL) { }
+
+    /// the sequence number of the next deletion to send, everything before it has been sent
+    quint64 getSequence() const { return _sequence; }
+
+private:
+    friend class DeletedEntityLog;
+
+    quint64 _sequence;
+    DeletedEntityBlock* _block; // the block the next deletion goes in, NULL until the cursor is first read from
+};
+
+/// The IDs of deleted entities in the order they were deleted, kept for the servers to send on to their clients. Each
+/// deletion gets the next sequence number, and each client keeps a cursor into the log. The deletions are stored in
+/// blocks that are never moved or changed once written, so the clients read through their cursors without taking any
+/// lock; only appending and forgetting lock, against each other. Blocks are forgotten once every cursor is past them.
+/// A new cursor finds its first block under the prune lock, so the server holds that lock while it works out what every
+/// cursor has read and forgets it: a cursor is either seen there, or starts after what is forgotten.
+class DeletedEntityLog {
+public:
+    static const int BLOCK_SIZE = 256;
+
+    DeletedEntityLog();
+    ~DeletedEntityLog();
+
+    /// adds a deletion to the end of the log
+    void append(const QUuid& entityID);
+
+    /// \return whether there are deletions in the log after the cursor
+    bool hasDeletionsAfter(const DeletedEntityCursor& cursor) const;
+
+    /// reads the deletions after the cursor, up to maxCount of them, and moves the cursor past them
+    /// \return the number of IDs written to entityIDs
+    int read(DeletedEntityCursor& cursor, QUuid* entityIDs, int maxCount) const;
+
+    /// \return whether every deletion in the log has been forgotten, the blocks it still keeps hold none that aren't
+    bool isEmpty() const;
+
+    /// held while the cursors are looked at to find the sequence number to forget before, until forgetBefore returns
+    void lockForPrune() { _pruneMutex.lock(); }
+    void unlockForPrune() { _pruneMutex.unlock(); }
+
+    /// frees the blocks whose deletions are all before the sequence number, which must be at or before the sequence
+    /// number of every cursor that may still be read from
+    void forgetBefore(quint64 sequence);
+
+private:
+    DeletedEntityBlock* findBlock(DeletedEntityCursor& cursor, int& index) const;
+
+    mutable QMutex _mutex;
+    mutable QMutex _pruneMutex;
+    QAtomicPointer<DeletedEntityBlock> _head;
+    DeletedEntityBlock* _tail;
+    quint64 _forgottenBefore; // the highest sequence number forgotten before, guarded by _mutex
+};
+
+#endif // hifi_DeletedEntityLog_h
@@ -0,0 +1,68 @@
+//
+//  EditedEntitiesOperator.cpp
+//  libraries/entities/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "EntityItem.h"
+#include "EntityTree.h"
+#include "EntityTreeElement.h"
+
+#include "EditedEntitiesOperator.h"
+
+EditedEntitiesOperator::EditedEntitiesOperator(EntityTree* tree) :
+    _tree(tree)
+{
+}
+
+void EditedEntitiesOperator::addEntityToMarkList(const EntityItemID& entityID) {
+    EntityTreeElement* containingElement = _tree->getContainingElement(entityID);
+    if (!containingElement) {
+        return; // deleted since it was edited, nothing left to mark
+    }
+    OctalCodeKey key = OctalCodeKey::fromOctalCode(containingElement->getOctalCode());
+    if (!key.isValid()) {
+        _deepElementCubes.append(containingElement->getAACube());
+        return;
+    }
+    // walk up until we reach a path we already have
+    while (!_pathKeys.contains(key)) {
+        _pathKeys.insert(key);
+        if (key == OctalCodeKey::root()) {
+            break;
+        }
+        key = key.getParent();
+    }
+}
+
+bool EditedEntitiesOperator::isOnEditedPath(OctreeElement* element) const {
+    OctalCodeKey key = OctalCodeKey::fromOctalCode(element->getOctalCode());
+    if (key.isValid() && _pathKeys.contains(key)) {
+        return true;
+    }
+    foreach (const AACube& cube, _deepElementCubes) {
+        if (element->getAACube().contains(cube)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool EditedEntitiesOperator::preRecursion(OctreeElement* element) {
+    // only go down the branches that lead to an edited element
+    return isOnEditedPath(element);
+}
+
+bool EditedEntitiesOperator::postRecursion(OctreeElement* element) {
+    // as we unwind, mark the paths as changed and prune any empty leaves along them, the same as UpdateEntityOperator
+    // does for an edit that doesn't move its entity
+    if (isOnEditedPath(element)) {
+        element->markWithChangedTime();
+        static_cast<EntityTreeElement*>(element)->pruneChildren();
+    }
+    return true; // the other paths may be in the next siblings
+}
@@ -0,0 +1,35 @@
+//
+//  EditedEntitiesOperator.h
+//  libraries/entities/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_EditedEntitiesOperator_h
+#define hifi_EditedEntitiesOperator_h
+
+#include <OctalCodeKey.h>
+
+/// Marks the paths from the root to the elements of a set of edited entities as changed, all in one recursion that only
+/// goes down the branches those elements are in. The entities must already be in their elements, this doesn't move them.
+class EditedEntitiesOperator : public RecurseOctreeOperator {
+public:
+    EditedEntitiesOperator(EntityTree* tree);
+
+    void addEntityToMarkList(const EntityItemID& entityID);
+    bool hasEditedEntities() const { return !_pathKeys.isEmpty() || !_deepElementCubes.isEmpty(); }
+
+    virtual bool preRecursion(OctreeElement* element);
+    virtual bool postRecursion(OctreeElement* element);
+private:
+    bool isOnEditedPath(OctreeElement* element) const;
+
+    EntityTree* _tree;
+    QSet<OctalCodeKey> _pathKeys; // the keys of the elements and all of their ancestors
+    QVector<AACube> _deepElementCubes; // elements too deep to have a key are found by their cubes
+};
+
+#endif // hifi_EditedEntitiesOperator_h
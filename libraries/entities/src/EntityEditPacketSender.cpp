@@ -31,6 +31,28 @@ void EntityEditPacketSender::queueEditEntityMessage(PacketType type, EntityItemI
         return; // bail early
     }
 
+    // adds have to go out right away so the server can hand back an ID, but an edit to an entity we know can be
+    // held for a moment and merged with the edits that follow it, a script moving an entity every frame then
+    // sends one edit per window with the latest value of everything it touched
+    if (type == PacketTypeEntityAddOrEdit && modelID.isKnownID && _editCoalescingWindowUsecs > 0) {
+        QMutexLocker locker(&_coalescedEditsLock);
+        QHash<EntityItemID, EntityItemProperties>::iterator heldEdit = _coalescedEntityEdits.find(modelID);
+        if (heldEdit != _coalescedEntityEdits.end()) {
+            heldEdit->merge(properties);
+            _coalescedEditCount.ref();
+        } else {
+            _coalescedEntityEdits.insert(modelID, properties);
+            _coalescedEntityEditOrder.append(modelID);
+            coalescedEditHeld();
+        }
+        return;
+    }
+
+    packEditEntityMessage(type, modelID, properties);
+}
+
+void EntityEditPacketSender::packEditEntityMessage(PacketType type, const EntityItemID& modelID,
+                                                   const EntityItemProperties& properties) {
     // use MAX_PACKET_SIZE since it's static and guaranteed to be larger than _maxPacketSize
     unsigned char bufferOut[MAX_PACKET_SIZE];
     int sizeOut = 0;
@@ -40,10 +62,27 @@ void EntityEditPacketSender::queueEditEntityMessage(PacketType type, EntityItemI
     }
 }
 
+void EntityEditPacketSender::packCoalescedEdits() {
+    foreach (const EntityItemID& entityID, _coalescedEntityEditOrder) {
+        packEditEntityMessage(PacketTypeEntityAddOrEdit, entityID, _coalescedEntityEdits.value(entityID));
+    }
+    _coalescedEntityEdits.clear();
+    _coalescedEntityEditOrder.clear();
+}
+
 void EntityEditPacketSender::queueEraseEntityMessage(const EntityItemID& entityItemID) {
     if (!_shouldSend) {
         return; // bail early
     }
+
+    // there's no point sending edits to an entity we're about to erase
+    _coalescedEditsLock.lock();
+    if (_coalescedEntityEdits.remove(entityItemID) > 0) {
+        _coalescedEntityEditOrder.removeOne(entityItemID);
+        _coalescedEditCount.ref();
+    }
+    _coalescedEditsLock.unlock();
+
     // use MAX_PACKET_SIZE since it's static and guaranteed to be larger than _maxPacketSize
     unsigned char bufferOut[MAX_PACKET_SIZE];
     size_t sizeOut = 0;
@@ -31,5 +31,15 @@ public:
     // My server type is the model server
     virtual char getMyNodeType() const { return NodeType::EntityServer; }
     virtual void adjustEditPacketForClockSkew(PacketType type, unsigned char* editBuffer, size_t length, int clockSkew);
+
+protected:
+    virtual void packCoalescedEdits();
+
+private:
+    void packEditEntityMessage(PacketType type, const EntityItemID& modelID, const EntityItemProperties& properties);
+
+    // edits to known entities held for the coalescing window, later edits to the same entity are merged into them
+    QHash<EntityItemID, EntityItemProperties> _coalescedEntityEdits;
+    QVector<EntityItemID> _coalescedEntityEditOrder; // the held entities in the order of their first edit, as packed
 };
 #endif // hifi_EntityEditPacketSender_h
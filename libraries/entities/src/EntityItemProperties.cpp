@@ -124,6 +124,44 @@ EntityPropertyFlags EntityItemProperties::getChangedProperties() const {
     return changedProperties;
 }
 
+void EntityItemProperties::merge(const EntityItemProperties& other) {
+    EntityPropertyFlags otherChangedProperties = other.getChangedProperties();
+
+    MERGE_CHANGED_PROPERTY(PROP_DIMENSIONS, dimensions);
+    MERGE_CHANGED_PROPERTY(PROP_POSITION, position);
+    MERGE_CHANGED_PROPERTY(PROP_ROTATION, rotation);
+    MERGE_CHANGED_PROPERTY(PROP_MASS, mass);
+    MERGE_CHANGED_PROPERTY(PROP_VELOCITY, velocity);
+    MERGE_CHANGED_PROPERTY(PROP_GRAVITY, gravity);
+    MERGE_CHANGED_PROPERTY(PROP_DAMPING, damping);
+    MERGE_CHANGED_PROPERTY(PROP_LIFETIME, lifetime);
+    MERGE_CHANGED_PROPERTY(PROP_SCRIPT, script);
+    MERGE_CHANGED_PROPERTY(PROP_COLOR, color);
+    MERGE_CHANGED_PROPERTY(PROP_MODEL_URL, modelURL);
+    MERGE_CHANGED_PROPERTY(PROP_ANIMATION_URL, animationURL);
+    MERGE_CHANGED_PROPERTY(PROP_ANIMATION_PLAYING, animationIsPlaying);
+    MERGE_CHANGED_PROPERTY(PROP_ANIMATION_FRAME_INDEX, animationFrameIndex);
+    MERGE_CHANGED_PROPERTY(PROP_ANIMATION_FPS, animationFPS);
+    MERGE_CHANGED_PROPERTY(PROP_VISIBLE, visible);
+    MERGE_CHANGED_PROPERTY(PROP_REGISTRATION_POINT, registrationPoint);
+    MERGE_CHANGED_PROPERTY(PROP_ANGULAR_VELOCITY, angularVelocity);
+    MERGE_CHANGED_PROPERTY(PROP_ANGULAR_DAMPING, angularDamping);
+    MERGE_CHANGED_PROPERTY(PROP_IGNORE_FOR_COLLISIONS, ignoreForCollisions);
+    MERGE_CHANGED_PROPERTY(PROP_COLLISIONS_WILL_MOVE, collisionsWillMove);
+
+    // glow and alpha are only rendered locally and never make it into an edit, but keep them consistent
+    if (other._glowLevelChanged) {
+        setGlowLevel(other._glowLevel);
+    }
+    if (other._localRenderAlphaChanged) {
+        setLocalRenderAlpha(other._localRenderAlpha);
+    }
+
+    if (other._lastEdited > _lastEdited) {
+        _lastEdited = other._lastEdited;
+    }
+}
+
 QScriptValue EntityItemProperties::copyToScriptValue(QScriptEngine* engine) const {
     QScriptValue properties = engine->newObject();
 
@@ -256,24 +294,25 @@ bool EntityItemProperties::encodeEntityEditPacket(PacketType command, EntityItem
     OctreeElement::AppendState appendState = OctreeElement::COMPLETED; // assume the best
     sizeOut = 0;
 
-    // TODO: We need to review how jurisdictions should be handled for entities. (The old Models and Particles code
-    // didn't do anything special for jurisdictions, so we're keeping that same behavior here.)
-    //
-    // Always include the root octcode. This is only because the OctreeEditPacketSender will check these octcodes
-    // to determine which server to send the changes to in the case of multiple jurisdictions. The root will be sent
-    // to all servers.
-    glm::vec3 rootPosition(0);
-    float rootScale = 0.5f;
-    unsigned char* octcode = pointToOctalCode(rootPosition.x, rootPosition.y, rootPosition.z, rootScale);
-
-    success = packetData->startSubTree(octcode);
-    delete[] octcode;
+    // The OctreeEditPacketSender uses this octcode to decide which servers get the edit when there are multiple
+    // jurisdictions. New entities are addressed to a small voxel at their position so only the server owning that part
+    // of the tree creates them. Edits to existing entities are addressed to the root, which goes to every server, since
+    // the entity may have been created before the jurisdictions last changed and only the server holding it applies it.
+    bool isNewEntityItem = (id.id == NEW_ENTITY);
+    if (isNewEntityItem) {
+        const float ADD_OCTCODE_SCALE = 1.0f / 65536.0f;
+        glm::vec3 position = glm::clamp(properties.getPosition() / (float)TREE_SCALE, 0.0f, 1.0f - ADD_OCTCODE_SCALE);
+        unsigned char* octcode = pointToOctalCode(position.x, position.y, position.z, ADD_OCTCODE_SCALE);
+        success = packetData->startSubTree(octcode);
+        delete[] octcode;
+    } else {
+        success = packetData->startSubTree(NULL);
+    }
     
     // assuming we have rome to fit our octalCode, proceed...
     if (success) {
 
         // Now add our edit content details...
-        bool isNewEntityItem = (id.id == NEW_ENTITY);
 
         // id
         // encode our ID as a byte count coded byte stream
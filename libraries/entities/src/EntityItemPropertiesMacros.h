@@ -134,6 +134,12 @@
         changedProperties += P;    \
     }
 
+#define MERGE_CHANGED_PROPERTY(P,M)                 \
+    if (otherChangedProperties.getHasProperty(P)) { \
+        _##M = other._##M;                          \
+        _##M##Changed = true;                       \
+    }
+
 
 #define COPY_PROPERTY_TO_QSCRIPTVALUE_VEC3(P) \
     QScriptValue P = vec3toScriptValue(engine, _##P); \
@@ -15,10 +15,16 @@
 
 #include "AddEntityOperator.h"
 #include "DeleteEntityOperator.h"
+#include "EditedEntitiesOperator.h"
 #include "MovingEntitiesOperator.h"
 #include "UpdateEntityOperator.h"
 
-EntityTree::EntityTree(bool shouldReaverage) : Octree(shouldReaverage) {
+EntityTree::EntityTree(bool shouldReaverage) :
+    Octree(shouldReaverage),
+    _isSharedWithOtherServers(false),
+    _inEditBurst(false),
+    _editBurstMoves(NULL)
+{
     _rootElement = createNewElement();
 }
 
@@ -38,6 +44,13 @@ void EntityTree::eraseAllOctreeElements(bool createNewRoot) {
         element->cleanupEntities();
     }
     _entityToElementMap.clear();
+
+    // anything held back from an edit burst was for elements that are going away
+    delete _editBurstMoves;
+    _editBurstMoves = NULL;
+    _editBurstMovingEntities.clear();
+    _editBurstEditedEntities.clear();
+
     Octree::eraseAllOctreeElements(createNewRoot);
     _movingEntities.clear();
     _changingEntities.clear();
@@ -84,6 +97,9 @@ void EntityTree::addEntityItem(EntityItem* entityItem) {
         return;
     }
 
+    // the add changes the tree, so finish the passes held back from the edits before it
+    applyEditBurst();
+
     // Recurse the tree and store the entity in the correct tree element
     AddEntityOperator theOperator(this, entityItem);
     recurseTreeWithOperator(&theOperator);
@@ -95,6 +111,11 @@ void EntityTree::addEntityItem(EntityItem* entityItem) {
 }
 
 bool EntityTree::updateEntity(const EntityItemID& entityID, const EntityItemProperties& properties) {
+    // a second edit to an entity that is waiting to move has to wait for the move, to keep its edits in order
+    if (_editBurstMovingEntities.contains(entityID)) {
+        applyEditBurst();
+    }
+
     // You should not call this on existing entities that are already part of the tree! Call updateEntity()
     EntityTreeElement* containingElement = getContainingElement(entityID);
     if (!containingElement) {
@@ -111,8 +132,12 @@ bool EntityTree::updateEntity(const EntityItemID& entityID, const EntityItemProp
     // check to see if we need to simulate this entity...
     EntityItem::SimulationState oldState = existingEntity->getSimulationState();
     
-    UpdateEntityOperator theOperator(this, containingElement, existingEntity, properties);
-    recurseTreeWithOperator(&theOperator);
+    if (_inEditBurst) {
+        updateEntityInEditBurst(existingEntity, containingElement, properties);
+    } else {
+        UpdateEntityOperator theOperator(this, containingElement, existingEntity, properties);
+        recurseTreeWithOperator(&theOperator);
+    }
     _isDirty = true;
 
     EntityItem::SimulationState newState = existingEntity->getSimulationState();
@@ -127,6 +152,68 @@ bool EntityTree::updateEntity(const EntityItemID& entityID, const EntityItemProp
     return true;
 }
 
+void EntityTree::updateEntityInEditBurst(EntityItem* existingEntity, EntityTreeElement* containingElement,
+                                         const EntityItemProperties& properties) {
+    // fill in the half of the bounds the edit leaves out, the same as UpdateEntityOperator does
+    EntityItemProperties boundedProperties = properties;
+    if (properties.containsPositionChange() && !properties.containsDimensionsChange()) {
+        boundedProperties.setDimensions(existingEntity->getDimensions() * (float)TREE_SCALE);
+    }
+    if (!properties.containsPositionChange() && properties.containsDimensionsChange()) {
+        boundedProperties.setPosition(existingEntity->getPosition() * (float)TREE_SCALE);
+    }
+
+    AACube oldCube = existingEntity->getMaximumAACube();
+    existingEntity->setProperties(boundedProperties);
+    AACube newCube = existingEntity->getMaximumAACube();
+
+    // the entity stays in its element until the end of the burst, when all the entities that left theirs move together
+    EntityItemID entityID = existingEntity->getEntityItemID();
+    if (!containingElement->bestFitBounds(newCube.clamp(0.0f, 1.0f))) {
+        if (!_editBurstMoves) {
+            _editBurstMoves = new MovingEntitiesOperator(this);
+        }
+        _editBurstMoves->addEntityToMoveList(existingEntity, oldCube, newCube);
+        _editBurstMovingEntities.insert(entityID);
+    }
+    _editBurstEditedEntities.insert(entityID);
+}
+
+void EntityTree::startEditBurst() {
+    _inEditBurst = true;
+}
+
+void EntityTree::finishEditBurst() {
+    applyEditBurst();
+    _inEditBurst = false;
+
+    // edits that were decoded but never applied, because their packets were dropped on the way
+    QMutexLocker locker(&_decodedEditsMutex);
+    _decodedEdits.clear();
+}
+
+void EntityTree::applyEditBurst() {
+    if (_editBurstMoves) {
+        if (_editBurstMoves->hasMovingEntities()) {
+            recurseTreeWithOperator(_editBurstMoves);
+        }
+        delete _editBurstMoves;
+        _editBurstMoves = NULL;
+        _editBurstMovingEntities.clear();
+    }
+
+    // with everything where it belongs, mark the paths down to all the edited entities in one pass
+    if (!_editBurstEditedEntities.isEmpty()) {
+        EditedEntitiesOperator theOperator(this);
+        foreach (const EntityItemID& entityID, _editBurstEditedEntities) {
+            theOperator.addEntityToMarkList(entityID);
+        }
+        _editBurstEditedEntities.clear();
+        if (theOperator.hasEditedEntities()) {
+            recurseTreeWithOperator(&theOperator);
+        }
+    }
+}
 
 EntityItem* EntityTree::addEntity(const EntityItemID& entityID, const EntityItemProperties& properties) {
     EntityItem* result = NULL;
@@ -161,24 +248,22 @@ EntityItem* EntityTree::addEntity(const EntityItemID& entityID, const EntityItem
 void EntityTree::trackDeletedEntity(const EntityItemID& entityID) {
     // this is only needed on the server to send delete messages for recently deleted entities to the viewers
     if (getIsServer()) {
-        // set up the deleted entities ID
-        quint64 deletedAt = usecTimestampNow();
-        _recentlyDeletedEntitiesLock.lockForWrite();
-        _recentlyDeletedEntityItemIDs.insert(deletedAt, entityID.id);
-        _recentlyDeletedEntitiesLock.unlock();
+        _deletedEntityLog.append(entityID.id);
     }
 }
 
 void EntityTree::deleteEntity(const EntityItemID& entityID) {
     // NOTE: callers must lock the tree before using this method
+    applyEditBurst();
     DeleteEntityOperator theOperator(this, entityID);
     recurseTreeWithOperator(&theOperator);
     _isDirty = true;
 }
 
-void EntityTree::deleteEntities(QSet<EntityItemID> entityIDs) {
+void EntityTree::deleteEntities(QSet<EntityItemID> entityIDs, bool trackDeletes) {
     // NOTE: callers must lock the tree before using this method
-    DeleteEntityOperator theOperator(this);
+    applyEditBurst();
+    DeleteEntityOperator theOperator(this, trackDeletes);
     foreach(const EntityItemID& entityID, entityIDs) {
         // tell our delete operator about this entityID
         theOperator.addEntityIDToDeleteList(entityID);
@@ -465,10 +550,25 @@ int EntityTree::processEditPacketData(PacketType packetType, const unsigned char
         }
         
         case PacketTypeEntityAddOrEdit: {
-            EntityItemID entityItemID;
-            EntityItemProperties properties;
-            bool validEditPacket = EntityItemProperties::decodeEntityEditPacket(editData, maxLength,
-                                                    processedBytes, entityItemID, properties);
+            // use the edit decoded ahead of the burst if there is one
+            DecodedEntityEdit edit;
+            bool decodedAhead = false;
+            _decodedEditsMutex.lock();
+            QHash<const unsigned char*, DecodedEntityEdit>::iterator decoded = _decodedEdits.find(editData);
+            if (decoded != _decodedEdits.end()) {
+                edit = decoded.value();
+                _decodedEdits.erase(decoded);
+                decodedAhead = true;
+            }
+            _decodedEditsMutex.unlock();
+            if (!decodedAhead) {
+                edit.valid = EntityItemProperties::decodeEntityEditPacket(editData, maxLength,
+                                                    edit.processedBytes, edit.entityItemID, edit.properties);
+            }
+            processedBytes = edit.processedBytes;
+            EntityItemID& entityItemID = edit.entityItemID;
+            const EntityItemProperties& properties = edit.properties;
+            bool validEditPacket = edit.valid;
 
             // If we got a valid edit packet, then it could be a new entity or it could be an update to
             // an existing entity... handle appropriately
@@ -482,7 +582,7 @@ int EntityTree::processEditPacketData(PacketType packetType, const unsigned char
                     // if the entityItem exists, then update it
                     if (existingEntity) {
                         updateEntity(entityItemID, properties);
-                    } else {
+                    } else if (!_isSharedWithOtherServers) {
                         qDebug() << "User attempted to edit an unknown entity. ID:" << entityItemID;
                     }
                 } else {
@@ -505,6 +605,32 @@ int EntityTree::processEditPacketData(PacketType packetType, const unsigned char
 }
 
 
+void EntityTree::decodeEditPacket(PacketType packetType, const QByteArray& packet, int editDataOffset) {
+    // erases are small and applied as they come, only the adds and edits are worth decoding ahead
+    if (packetType != PacketTypeEntityAddOrEdit) {
+        return;
+    }
+    const unsigned char* packetData = reinterpret_cast<const unsigned char*>(packet.constData());
+    QVector<QPair<const unsigned char*, DecodedEntityEdit> > decodedEdits;
+    int atByte = editDataOffset;
+    while (atByte < packet.size()) {
+        DecodedEntityEdit edit;
+        edit.processedBytes = 0;
+        edit.valid = EntityItemProperties::decodeEntityEditPacket(packetData + atByte, packet.size() - atByte,
+                                                                  edit.processedBytes, edit.entityItemID, edit.properties);
+        decodedEdits.append(qMakePair(packetData + atByte, edit));
+        if (edit.processedBytes <= 0) {
+            break;
+        }
+        atByte += edit.processedBytes;
+    }
+
+    QMutexLocker locker(&_decodedEditsMutex);
+    for (int i = 0; i < decodedEdits.size(); i++) {
+        _decodedEdits.insert(decodedEdits.at(i).first, decodedEdits.at(i).second);
+    }
+}
+
 void EntityTree::notifyNewlyCreatedEntity(const EntityItem& newEntity, const SharedNodePointer& senderNode) {
     _newlyCreatedHooksLock.lockForRead();
     for (int i = 0; i < _newlyCreatedHooks.size(); i++) {
@@ -749,27 +875,13 @@ void EntityTree::updateMortalEntities(quint64 now, QSet<EntityItemID>& entitiesT
 }
 
 
-bool EntityTree::hasEntitiesDeletedSince(quint64 sinceTime) {
-    // we can probably leverage the ordered nature of QMultiMap to do this quickly...
-    bool hasSomethingNewer = false;
-
-    _recentlyDeletedEntitiesLock.lockForRead();
-    QMultiMap<quint64, QUuid>::const_iterator iterator = _recentlyDeletedEntityItemIDs.constBegin();
-    while (iterator != _recentlyDeletedEntityItemIDs.constEnd()) {
-        if (iterator.key() > sinceTime) {
-            hasSomethingNewer = true;
-        }
-        ++iterator;
-    }
-    _recentlyDeletedEntitiesLock.unlock();
-    return hasSomethingNewer;
+bool EntityTree::hasEntitiesDeletedSince(const DeletedEntityCursor& cursor) const {
+    return _deletedEntityLog.hasDeletionsAfter(cursor);
 }
 
-// sinceTime is an in/out parameter - it will be side effected with the last time sent out
-bool EntityTree::encodeEntitiesDeletedSince(OCTREE_PACKET_SEQUENCE sequenceNumber, quint64& sinceTime, unsigned char* outputBuffer,
-                                            size_t maxLength, size_t& outputLength) {
-    bool hasMoreToSend = true;
-
+// cursor is an in/out parameter - it will be moved past the deletions sent out
+bool EntityTree::encodeEntitiesDeletedSince(OCTREE_PACKET_SEQUENCE sequenceNumber, DeletedEntityCursor& cursor,
+                                            unsigned char* outputBuffer, size_t maxLength, size_t& outputLength) {
     unsigned char* copyAt = outputBuffer;
     size_t numBytesPacketHeader = populatePacketHeader(reinterpret_cast<char*>(outputBuffer), PacketTypeEntityErase);
     copyAt += numBytesPacketHeader;
@@ -801,75 +913,27 @@ bool EntityTree::encodeEntitiesDeletedSince(OCTREE_PACKET_SEQUENCE sequenceNumbe
     copyAt += sizeof(numberOfIds);
     outputLength += sizeof(numberOfIds);
     
-    // we keep a multi map of entity IDs to timestamps, we only want to include the entity IDs that have been
-    // deleted since we last sent to this node
-    _recentlyDeletedEntitiesLock.lockForRead();
-
-    QMultiMap<quint64, QUuid>::const_iterator iterator = _recentlyDeletedEntityItemIDs.constBegin();
-    while (iterator != _recentlyDeletedEntityItemIDs.constEnd()) {
-        QList<QUuid> values = _recentlyDeletedEntityItemIDs.values(iterator.key());
-        for (int valueItem = 0; valueItem < values.size(); ++valueItem) {
-
-            // if the timestamp is more recent then out last sent time, include it
-            if (iterator.key() > sinceTime) {
-                QUuid entityID = values.at(valueItem);
-                QByteArray encodedEntityID = entityID.toRfc4122();
-                memcpy(copyAt, encodedEntityID.constData(), NUM_BYTES_RFC4122_UUID);
-                copyAt += NUM_BYTES_RFC4122_UUID;
-                outputLength += NUM_BYTES_RFC4122_UUID;
-                numberOfIds++;
-
-                // check to make sure we have room for one more id...
-                if (outputLength + NUM_BYTES_RFC4122_UUID > maxLength) {
-                    break;
-                }
-            }
-        }
-
-        // check to make sure we have room for one more id...
-        if (outputLength + NUM_BYTES_RFC4122_UUID > maxLength) {
-
-            // let our caller know how far we got
-            sinceTime = iterator.key();
-            break;
-        }
-        ++iterator;
+    // the log is read through the cursor without locking, so there's nothing to hold while the IDs are copied
+    int maxIDs = (int)((maxLength - outputLength) / NUM_BYTES_RFC4122_UUID);
+    QVector<QUuid> entityIDs(maxIDs);
+    numberOfIds = _deletedEntityLog.read(cursor, entityIDs.data(), maxIDs);
+    for (int i = 0; i < numberOfIds; i++) {
+        QByteArray encodedEntityID = entityIDs.at(i).toRfc4122();
+        memcpy(copyAt, encodedEntityID.constData(), NUM_BYTES_RFC4122_UUID);
+        copyAt += NUM_BYTES_RFC4122_UUID;
+        outputLength += NUM_BYTES_RFC4122_UUID;
     }
 
-    // if we got to the end, then we're done sending
-    if (iterator == _recentlyDeletedEntityItemIDs.constEnd()) {
-        hasMoreToSend = false;
-    }
-    _recentlyDeletedEntitiesLock.unlock();
-
     // replace the correct count for ids included
     memcpy(numberOfIDsAt, &numberOfIds, sizeof(numberOfIds));
-    
-    return hasMoreToSend;
-}
 
+    return _deletedEntityLog.hasDeletionsAfter(cursor);
+}
 
-// called by the server when it knows all nodes have been sent deleted packets
-void EntityTree::forgetEntitiesDeletedBefore(quint64 sinceTime) {
-    QSet<quint64> keysToRemove;
-
-    _recentlyDeletedEntitiesLock.lockForWrite();
-    QMultiMap<quint64, QUuid>::iterator iterator = _recentlyDeletedEntityItemIDs.begin();
 
-    // First find all the keys in the map that are older and need to be deleted
-    while (iterator != _recentlyDeletedEntityItemIDs.end()) {
-        if (iterator.key() <= sinceTime) {
-            keysToRemove << iterator.key();
-        }
-        ++iterator;
-    }
-
-    // Now run through the keysToRemove and remove them
-    foreach (quint64 value, keysToRemove) {
-        _recentlyDeletedEntityItemIDs.remove(value);
-    }
-    
-    _recentlyDeletedEntitiesLock.unlock();
+// called by the server when it knows all nodes have been sent the deletions before the sequence number
+void EntityTree::forgetEntitiesDeletedBefore(quint64 sequence) {
+    _deletedEntityLog.forgetBefore(sequence);
 }
 
 
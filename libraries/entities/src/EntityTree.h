@@ -12,11 +12,15 @@
 #ifndef hifi_EntityTree_h
 #define hifi_EntityTree_h
 
+#include <QMutex>
+
 #include <Octree.h>
+#include "DeletedEntityLog.h"
 #include "EntityTreeElement.h"
 
 
 class Model;
+class MovingEntitiesOperator;
 
 class NewlyCreatedEntityHook {
 public:
@@ -30,6 +34,16 @@ public:
 };
 
 
+/// an add or edit decoded from an edit packet ahead of being applied to the tree
+class DecodedEntityEdit {
+public:
+    bool valid;
+    int processedBytes;
+    EntityItemID entityItemID;
+    EntityItemProperties properties;
+};
+
+
 class SendEntitiesOperationArgs {
 public:
     glm::vec3 root;
@@ -61,6 +75,16 @@ public:
     virtual int processEditPacketData(PacketType packetType, const unsigned char* packetData, int packetLength,
                     const unsigned char* editData, int maxLength, const SharedNodePointer& senderNode);
 
+    virtual bool canDecodeEditPacketsAhead() const { return true; }
+    virtual void decodeEditPacket(PacketType packetType, const QByteArray& packet, int editDataOffset);
+
+    /// During a burst, edits to entities set their properties right away, but the tree passes for all of them are held
+    /// back and done together: the entities that left their elements are moved in one pass, and the paths to all the
+    /// edited elements are marked as changed in another. Adds and deletes do the held back passes first, and so does a
+    /// second edit to an entity that is waiting to move, so the edits to each entity still land in the order they came.
+    virtual void startEditBurst();
+    virtual void finishEditBurst();
+
     virtual bool rootElementHasData() const { return true; }
     
     // the root at least needs to store the number of entities in the packet/buffer
@@ -81,7 +105,7 @@ public:
     EntityItem* addEntity(const EntityItemID& entityID, const EntityItemProperties& properties);
     bool updateEntity(const EntityItemID& entityID, const EntityItemProperties& properties);
     void deleteEntity(const EntityItemID& entityID);
-    void deleteEntities(QSet<EntityItemID> entityIDs);
+    void deleteEntities(QSet<EntityItemID> entityIDs, bool trackDeletes = true);
     void removeEntityFromSimulationLists(const EntityItemID& entityID);
 
     const EntityItem* findClosestEntity(glm::vec3 position, float targetRadius);
@@ -107,11 +131,21 @@ public:
     void addNewlyCreatedHook(NewlyCreatedEntityHook* hook);
     void removeNewlyCreatedHook(NewlyCreatedEntityHook* hook);
 
-    bool hasAnyDeletedEntities() const { return _recentlyDeletedEntityItemIDs.size() > 0; }
-    bool hasEntitiesDeletedSince(quint64 sinceTime);
-    bool encodeEntitiesDeletedSince(OCTREE_PACKET_SEQUENCE sequenceNumber, quint64& sinceTime, 
+    /// when the world is split between servers, edits to existing entities reach every server and only the one holding
+    /// the entity applies them, so the rest ignore edits to entities they don't know about without logging them
+    void setIsSharedWithOtherServers(bool isShared) { _isSharedWithOtherServers = isShared; }
+
+    bool hasAnyDeletedEntities() const { return !_deletedEntityLog.isEmpty(); }
+    bool hasEntitiesDeletedSince(const DeletedEntityCursor& cursor) const;
+    bool encodeEntitiesDeletedSince(OCTREE_PACKET_SEQUENCE sequenceNumber, DeletedEntityCursor& cursor,
                                     unsigned char* packetData, size_t maxLength, size_t& outputLength);
-    void forgetEntitiesDeletedBefore(quint64 sinceTime);
+
+    /// the server holds this while it looks at the cursors of its clients and forgets what they have all been sent
+    void lockForPruningDeletedEntities() { _deletedEntityLog.lockForPrune(); }
+    void unlockForPruningDeletedEntities() { _deletedEntityLog.unlockForPrune(); }
+
+    /// forgets the deletions before the sequence number, which must be at or before the cursor of every client
+    void forgetEntitiesDeletedBefore(quint64 sequence);
 
     int processEraseMessage(const QByteArray& dataByteArray, const SharedNodePointer& sourceNode);
     int processEraseMessageDetails(const QByteArray& dataByteArray, const SharedNodePointer& sourceNode);
@@ -154,11 +188,14 @@ private:
 
     void notifyNewlyCreatedEntity(const EntityItem& newEntity, const SharedNodePointer& senderNode);
 
+    void updateEntityInEditBurst(EntityItem* existingEntity, EntityTreeElement* containingElement,
+                                 const EntityItemProperties& properties);
+    void applyEditBurst();
+
     QReadWriteLock _newlyCreatedHooksLock;
     QVector<NewlyCreatedEntityHook*> _newlyCreatedHooks;
 
-    QReadWriteLock _recentlyDeletedEntitiesLock;
-    QMultiMap<quint64, QUuid> _recentlyDeletedEntityItemIDs;
+    DeletedEntityLog _deletedEntityLog;
     EntityItemFBXService* _fbxService;
 
     QHash<EntityItemID, EntityTreeElement*> _entityToElementMap;
@@ -166,6 +203,16 @@ private:
     QList<EntityItem*> _movingEntities; // entities that are moving as part of update
     QList<EntityItem*> _changingEntities; // entities that are changing (like animating), but not moving
     QList<EntityItem*> _mortalEntities; // entities that are mortal (have lifetime), but not moving or changing
+
+    QMutex _decodedEditsMutex;
+    QHash<const unsigned char*, DecodedEntityEdit> _decodedEdits; // by where the edit starts in its packet
+
+    bool _isSharedWithOtherServers;
+
+    bool _inEditBurst;
+    MovingEntitiesOperator* _editBurstMoves;
+    QSet<EntityItemID> _editBurstMovingEntities;
+    QSet<EntityItemID> _editBurstEditedEntities;
 };
 
 #endif // hifi_EntityTree_h
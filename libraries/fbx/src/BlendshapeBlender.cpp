@@ -0,0 +1,138 @@
+//
+//  BlendshapeBlender.cpp
+//  libraries/fbx/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <QMutexLocker>
+
+#include <SharedUtil.h>
+#include <SimdSupport.h>
+
+#include "BlendshapeBlender.h"
+
+const float NORMAL_COEFFICIENT_SCALE = 0.01f;
+
+static void applyBlendshape(const FBXSparseBlendshapes& blendshapes, int blendshape, float vertexCoefficient,
+        glm::vec3* vertices, glm::vec3* normals) {
+    float normalCoefficient = vertexCoefficient * NORMAL_COEFFICIENT_SCALE;
+    const int* indices = blendshapes.indices.constData();
+    const float* vertexX = blendshapes.vertexX.constData();
+    const float* vertexY = blendshapes.vertexY.constData();
+    const float* vertexZ = blendshapes.vertexZ.constData();
+    const float* normalX = blendshapes.normalX.constData();
+    const float* normalY = blendshapes.normalY.constData();
+    const float* normalZ = blendshapes.normalZ.constData();
+    
+    int entry = blendshapes.offsets.at(blendshape);
+    int end = blendshapes.offsets.at(blendshape + 1);
+    
+#ifdef HIFI_HAVE_SSE
+    // scale four entries at a time, adding them to the vertices they belong to is a scatter that stays scalar
+    const int ENTRIES_PER_STEP = 4;
+    __m128 vertexScale = _mm_set1_ps(vertexCoefficient);
+    __m128 normalScale = _mm_set1_ps(normalCoefficient);
+    float scaled[6][ENTRIES_PER_STEP];
+    for (; entry + ENTRIES_PER_STEP <= end; entry += ENTRIES_PER_STEP) {
+        _mm_storeu_ps(scaled[0], _mm_mul_ps(_mm_loadu_ps(vertexX + entry), vertexScale));
+        _mm_storeu_ps(scaled[1], _mm_mul_ps(_mm_loadu_ps(vertexY + entry), vertexScale));
+        _mm_storeu_ps(scaled[2], _mm_mul_ps(_mm_loadu_ps(vertexZ + entry), vertexScale));
+        _mm_storeu_ps(scaled[3], _mm_mul_ps(_mm_loadu_ps(normalX + entry), normalScale));
+        _mm_storeu_ps(scaled[4], _mm_mul_ps(_mm_loadu_ps(normalY + entry), normalScale));
+        _mm_storeu_ps(scaled[5], _mm_mul_ps(_mm_loadu_ps(normalZ + entry), normalScale));
+        for (int i = 0; i < ENTRIES_PER_STEP; i++) {
+            int index = indices[entry + i];
+            vertices[index] += glm::vec3(scaled[0][i], scaled[1][i], scaled[2][i]);
+            normals[index] += glm::vec3(scaled[3][i], scaled[4][i], scaled[5][i]);
+        }
+    }
+#endif
+    for (; entry < end; entry++) {
+        int index = indices[entry];
+        vertices[index] += glm::vec3(vertexX[entry], vertexY[entry], vertexZ[entry]) * vertexCoefficient;
+        normals[index] += glm::vec3(normalX[entry], normalY[entry], normalZ[entry]) * normalCoefficient;
+    }
+}
+
+BlendshapeBlender::BlendshapeBlender() :
+    _blendsSinceFullBlend(0),
+    _blendshapesApplied(0) {
+}
+
+void BlendshapeBlender::blend(const QVector<FBXMesh>& meshes, const QVector<float>& coefficients,
+        QVector<glm::vec3>& vertices, QVector<glm::vec3>& normals) {
+    QMutexLocker locker(&_mutex);
+    if (_meshes.constData() != meshes.constData() || _meshOffsets.size() != meshes.size() ||
+            ++_blendsSinceFullBlend >= BLENDS_PER_FULL_BLEND) {
+        reset(meshes);
+    }
+    
+    // coefficients too small to matter are left out like the ones that are zero
+    bool anyChanges = false;
+    for (int i = 0; i < _appliedCoefficients.size(); i++) {
+        float coefficient = (i < coefficients.size() && coefficients.at(i) >= EPSILON) ? coefficients.at(i) : 0.0f;
+        _coefficientChanges[i] = coefficient - _appliedCoefficients.at(i);
+        _appliedCoefficients[i] = coefficient;
+        anyChanges = anyChanges || _coefficientChanges.at(i) != 0.0f;
+    }
+    
+    _blendshapesApplied = 0;
+    if (anyChanges) {
+        glm::vec3* allVertices = _vertices.data();
+        glm::vec3* allNormals = _normals.data();
+        for (int i = 0; i < meshes.size(); i++) {
+            if (_meshOffsets.at(i) == -1) {
+                continue;
+            }
+            const FBXSparseBlendshapes& blendshapes = meshes.at(i).sparseBlendshapes;
+            for (int j = 0, n = blendshapes.getBlendshapeCount(); j < n; j++) {
+                float coefficientChange = _coefficientChanges.at(j);
+                if (coefficientChange != 0.0f) {
+                    applyBlendshape(blendshapes, j, coefficientChange,
+                        allVertices + _meshOffsets.at(i), allNormals + _meshOffsets.at(i));
+                    _blendshapesApplied++;
+                }
+            }
+        }
+    }
+    vertices = _vertices;
+    normals = _normals;
+}
+
+void BlendshapeBlender::reset(const QVector<FBXMesh>& meshes) {
+    _meshes = meshes;
+    _blendsSinceFullBlend = 0;
+    
+    int vertexCount = 0;
+    int blendshapeCount = 0;
+    _meshOffsets.resize(meshes.size());
+    for (int i = 0; i < meshes.size(); i++) {
+        const FBXMesh& mesh = meshes.at(i);
+        if (mesh.blendshapes.isEmpty()) {
+            _meshOffsets[i] = -1;
+            continue;
+        }
+        _meshOffsets[i] = vertexCount;
+        vertexCount += mesh.vertices.size();
+        blendshapeCount = qMax(blendshapeCount, mesh.sparseBlendshapes.getBlendshapeCount());
+    }
+    
+    // start over from the unblended meshes, in the buffers we already have
+    _vertices.resize(vertexCount);
+    _normals.resize(vertexCount);
+    for (int i = 0; i < meshes.size(); i++) {
+        if (_meshOffsets.at(i) == -1) {
+            continue;
+        }
+        const FBXMesh& mesh = meshes.at(i);
+        qCopy(mesh.vertices.constBegin(), mesh.vertices.constEnd(), _vertices.begin() + _meshOffsets.at(i));
+        qCopy(mesh.normals.constBegin(), mesh.normals.constEnd(), _normals.begin() + _meshOffsets.at(i));
+    }
+    
+    _appliedCoefficients.fill(0.0f, blendshapeCount);
+    _coefficientChanges.resize(blendshapeCount);
+}
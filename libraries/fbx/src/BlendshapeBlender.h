@@ -0,0 +1,57 @@
+//
+//  BlendshapeBlender.h
+//  libraries/fbx/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_BlendshapeBlender_h
+#define hifi_BlendshapeBlender_h
+
+#include <QMutex>
+#include <QVector>
+
+#include <glm/glm.hpp>
+
+#include "FBXReader.h"
+
+/// Blends the meshes of a geometry with blendshape coefficients, keeping the blended vertices and normals from one blend
+/// to the next. A blend only applies the blendshapes whose coefficients changed, by the difference from the coefficient
+/// they were last applied with. Blends may be started from several threads, they take turns.
+class BlendshapeBlender {
+public:
+    
+    /// how many blends apply differences before the meshes are blended from scratch, to keep rounding errors from adding up
+    static const int BLENDS_PER_FULL_BLEND = 256;
+    
+    BlendshapeBlender();
+    
+    /// blends the meshes that have blendshapes, one after another in the order of the geometry, and hands out the vertices
+    /// and normals. They share their data with the blender, it's reused by the next blend once the caller lets go of them.
+    void blend(const QVector<FBXMesh>& meshes, const QVector<float>& coefficients,
+        QVector<glm::vec3>& vertices, QVector<glm::vec3>& normals);
+    
+    int getBlendshapesApplied() const { return _blendshapesApplied; }
+    
+private:
+    
+    void reset(const QVector<FBXMesh>& meshes);
+    
+    QMutex _mutex;
+    
+    QVector<glm::vec3> _vertices;
+    QVector<glm::vec3> _normals;
+    QVector<int> _meshOffsets; ///< where the vertices of each mesh start, -1 for meshes without blendshapes
+    QVector<float> _appliedCoefficients;
+    QVector<float> _coefficientChanges;
+    /// the meshes blended so far, to notice when they're replaced. Holding a reference keeps their data from being freed
+    /// and its address reused by other meshes, which would then be mistaken for them
+    QVector<FBXMesh> _meshes;
+    int _blendsSinceFullBlend;
+    int _blendshapesApplied;
+};
+
+#endif // hifi_BlendshapeBlender_h
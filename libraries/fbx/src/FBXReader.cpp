@@ -940,6 +940,41 @@ void addBlendshapes(const ExtractedBlendshape& extracted, const QList<WeightedIn
     }
 }
 
+FBXSparseBlendshapes getSparseBlendshapes(const QVector<FBXBlendshape>& blendshapes) {
+    FBXSparseBlendshapes sparseBlendshapes;
+    int entryCount = 0;
+    foreach (const FBXBlendshape& blendshape, blendshapes) {
+        entryCount += blendshape.indices.size();
+    }
+    sparseBlendshapes.offsets.reserve(blendshapes.size() + 1);
+    sparseBlendshapes.indices.reserve(entryCount);
+    sparseBlendshapes.vertexX.reserve(entryCount);
+    sparseBlendshapes.vertexY.reserve(entryCount);
+    sparseBlendshapes.vertexZ.reserve(entryCount);
+    sparseBlendshapes.normalX.reserve(entryCount);
+    sparseBlendshapes.normalY.reserve(entryCount);
+    sparseBlendshapes.normalZ.reserve(entryCount);
+    
+    foreach (const FBXBlendshape& blendshape, blendshapes) {
+        sparseBlendshapes.offsets.append(sparseBlendshapes.indices.size());
+        for (int i = 0; i < blendshape.indices.size(); i++) {
+            const glm::vec3& vertex = blendshape.vertices.at(i);
+            const glm::vec3& normal = blendshape.normals.at(i);
+            sparseBlendshapes.indices.append(blendshape.indices.at(i));
+            sparseBlendshapes.vertexX.append(vertex.x);
+            sparseBlendshapes.vertexY.append(vertex.y);
+            sparseBlendshapes.vertexZ.append(vertex.z);
+            sparseBlendshapes.normalX.append(normal.x);
+            sparseBlendshapes.normalY.append(normal.y);
+            sparseBlendshapes.normalZ.append(normal.z);
+        }
+    }
+    if (!blendshapes.isEmpty()) {
+        sparseBlendshapes.offsets.append(sparseBlendshapes.indices.size());
+    }
+    return sparseBlendshapes;
+}
+
 QString getTopModelID(const QMultiHash<QString, QString>& parentMap,
         const QHash<QString, FBXModel>& models, const QString& modelID) {
     QString topID = modelID;
@@ -1872,6 +1907,7 @@ FBXGeometry extractFBXGeometry(const FBXNode& node, const QVariantHash& mapping)
             }
         }
         extracted.mesh.isEye = (maxJointIndex == geometry.leftEyeJointIndex || maxJointIndex == geometry.rightEyeJointIndex);
+        extracted.mesh.sparseBlendshapes = getSparseBlendshapes(extracted.mesh.blendshapes);
         
         geometry.meshes.append(extracted.mesh);
     }
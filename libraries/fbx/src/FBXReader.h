@@ -55,6 +55,23 @@ public:
     QVector<glm::vec3> normals;
 };
 
+/// All the blendshapes of a mesh in one sparse structure of arrays: the entries of each blendshape follow those of the
+/// one before, and every coordinate has an array of its own so that they can be scaled four at a time.
+class FBXSparseBlendshapes {
+public:
+    
+    QVector<int> offsets; ///< the entries of blendshape i are the ones from offsets[i] up to offsets[i + 1]
+    QVector<int> indices;
+    QVector<float> vertexX;
+    QVector<float> vertexY;
+    QVector<float> vertexZ;
+    QVector<float> normalX;
+    QVector<float> normalY;
+    QVector<float> normalZ;
+    
+    int getBlendshapeCount() const { return offsets.isEmpty() ? 0 : offsets.size() - 1; }
+};
+
 /// A single joint (transformation node) extracted from an FBX document.
 class FBXJoint {
 public:
@@ -141,6 +158,7 @@ public:
     bool isEye;
     
     QVector<FBXBlendshape> blendshapes;
+    FBXSparseBlendshapes sparseBlendshapes;
     
     bool hasSpecularTexture() const;
 };
@@ -237,4 +255,7 @@ FBXGeometry readFBX(const QByteArray& model, const QVariantHash& mapping);
 /// Reads SVO geometry from the supplied model data.
 FBXGeometry readSVO(const QByteArray& model);
 
+/// Lays out the blendshapes of a mesh for blending, see FBXSparseBlendshapes.
+FBXSparseBlendshapes getSparseBlendshapes(const QVector<FBXBlendshape>& blendshapes);
+
 #endif // hifi_FBXReader_h
@@ -0,0 +1,223 @@
+//
+//  BatchedDatagramSocket.cpp
+//  libraries/networking/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <errno.h>
+#include <string.h>
+
+#ifdef Q_OS_LINUX
+#include <poll.h>
+#endif
+
+#include <QtCore/QDebug>
+
+#include "BatchedDatagramSocket.h"
+
+#ifdef HAVE_BATCHED_DATAGRAM_CALLS
+// how long a flush waits for a full send buffer to drain before leaving the rest queued for the next flush
+const int SEND_BUFFER_WAIT_MSECS = 5;
+#endif
+
+BatchedDatagramSocket::BatchedDatagramSocket(QUdpSocket& socket) :
+    _socket(socket),
+    _queuedDatagrams(MAX_DATAGRAMS_PER_BATCH),
+    _queuedCount(0),
+#ifdef HAVE_BATCHED_DATAGRAM_CALLS
+    _readCount(0),
+    _readIndex(0),
+    _receiveBuffer(MAX_DATAGRAMS_PER_BATCH * MAX_BATCHED_DATAGRAM_SIZE, 0),
+#endif
+    _datagramsRead(0),
+    _readCalls(0),
+    _datagramsWritten(0),
+    _writeCalls(0),
+    _droppedOversizedDatagrams(0)
+{
+#ifdef HAVE_BATCHED_DATAGRAM_CALLS
+    // the headers always point at the same buffers, only the lengths change from one batch to the next
+    memset(_receiveHeaders, 0, sizeof(_receiveHeaders));
+    memset(_sendHeaders, 0, sizeof(_sendHeaders));
+
+    for (int i = 0; i < MAX_DATAGRAMS_PER_BATCH; i++) {
+        _receiveVectors[i].iov_base = _receiveBuffer.data() + i * MAX_BATCHED_DATAGRAM_SIZE;
+        _receiveVectors[i].iov_len = MAX_BATCHED_DATAGRAM_SIZE;
+        _receiveHeaders[i].msg_hdr.msg_iov = &_receiveVectors[i];
+        _receiveHeaders[i].msg_hdr.msg_iovlen = 1;
+        _receiveHeaders[i].msg_hdr.msg_name = &_receiveSockAddrs[i];
+
+        _sendHeaders[i].msg_hdr.msg_iov = &_sendVectors[i];
+        _sendHeaders[i].msg_hdr.msg_iovlen = 1;
+        _sendHeaders[i].msg_hdr.msg_name = &_sendSockAddrs[i];
+        _sendHeaders[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+    }
+#endif
+}
+
+bool BatchedDatagramSocket::readDatagram(QByteArray& destination, HifiSockAddr& senderSockAddr) {
+#ifdef HAVE_BATCHED_DATAGRAM_CALLS
+    while (_readIndex < _readCount) {
+        const mmsghdr& header = _receiveHeaders[_readIndex];
+        const char* data = _receiveBuffer.constData() + _readIndex * MAX_BATCHED_DATAGRAM_SIZE;
+        const sockaddr* senderAddress = reinterpret_cast<const sockaddr*>(&_receiveSockAddrs[_readIndex]);
+        _readIndex++;
+
+        if (header.msg_hdr.msg_flags & MSG_TRUNC) {
+            // it didn't fit in a batch buffer and the rest of it is gone, don't hand out half a packet
+            _droppedOversizedDatagrams.ref();
+            continue;
+        }
+
+        destination.resize(header.msg_len);
+        memcpy(destination.data(), data, header.msg_len);
+        senderSockAddr = HifiSockAddr(senderAddress);
+        return true;
+    }
+#endif
+
+    if (!_socket.hasPendingDatagrams()) {
+        return false;
+    }
+
+    // the first datagram of a batch always comes through the QUdpSocket, reading through it is what re-enables its read
+    // notifier, so that we get readyRead again for anything that arrives after the batch
+    destination.resize(_socket.pendingDatagramSize());
+    _socket.readDatagram(destination.data(), destination.size(),
+                         senderSockAddr.getAddressPointer(), senderSockAddr.getPortPointer());
+    _datagramsRead.ref();
+    _readCalls.ref();
+
+#ifdef HAVE_BATCHED_DATAGRAM_CALLS
+    // then take whatever else is already waiting in one call
+    for (int i = 0; i < MAX_DATAGRAMS_PER_BATCH; i++) {
+        _receiveHeaders[i].msg_hdr.msg_namelen = sizeof(sockaddr_storage);
+        _receiveHeaders[i].msg_hdr.msg_flags = 0;
+    }
+
+    int numReceived = recvmmsg(_socket.socketDescriptor(), _receiveHeaders, MAX_DATAGRAMS_PER_BATCH, MSG_DONTWAIT, NULL);
+    _readCalls.ref();
+
+    _readIndex = 0;
+    _readCount = (numReceived > 0) ? numReceived : 0;
+    _datagramsRead.fetchAndAddRelaxed(_readCount);
+#endif
+
+    return true;
+}
+
+void BatchedDatagramSocket::queueDatagram(const QByteArray& datagram, const HifiSockAddr& destinationSockAddr) {
+#ifdef HAVE_BATCHED_DATAGRAM_CALLS
+    // the queue is only still full if the socket couldn't take any of it at the last flush
+    if (_queuedCount == MAX_DATAGRAMS_PER_BATCH) {
+        flushQueuedDatagrams();
+    }
+
+    if (destinationSockAddr.getAddress().protocol() == QAbstractSocket::IPv4Protocol
+        && _queuedCount < MAX_DATAGRAMS_PER_BATCH) {
+        int index = _queuedCount++;
+        _queuedDatagrams[index] = datagram;
+
+        sockaddr_in& destinationAddress = _sendSockAddrs[index];
+        memset(&destinationAddress, 0, sizeof(sockaddr_in));
+        destinationAddress.sin_family = AF_INET;
+        destinationAddress.sin_addr.s_addr = htonl(destinationSockAddr.getAddress().toIPv4Address());
+        destinationAddress.sin_port = htons(destinationSockAddr.getPort());
+
+        _sendVectors[index].iov_base = const_cast<char*>(_queuedDatagrams[index].constData());
+        _sendVectors[index].iov_len = _queuedDatagrams[index].size();
+
+        if (_queuedCount == MAX_DATAGRAMS_PER_BATCH) {
+            flushQueuedDatagrams();
+        }
+        return;
+    }
+#endif
+
+    // nothing to batch with here, send it right away
+    writeSingleDatagram(datagram, destinationSockAddr);
+}
+
+int BatchedDatagramSocket::flushQueuedDatagrams() {
+    int numSent = 0;
+
+#ifdef HAVE_BATCHED_DATAGRAM_CALLS
+    int numAttempted = 0;
+    while (numAttempted < _queuedCount) {
+        int result = sendmmsg(_socket.socketDescriptor(), _sendHeaders + numAttempted, _queuedCount - numAttempted, 0);
+        _writeCalls.ref();
+
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                // the socket is non-blocking and its send buffer is full, give it a moment to drain and try again
+                pollfd writablePoll = { (int)_socket.socketDescriptor(), POLLOUT, 0 };
+                if (poll(&writablePoll, 1, SEND_BUFFER_WAIT_MSECS) > 0) {
+                    continue;
+                }
+                break;
+            }
+
+            // only the first datagram failed, skip it and send the rest
+            qDebug() << "ERROR in sendmmsg:" << strerror(errno);
+            numAttempted++;
+        } else {
+            numAttempted += result;
+            numSent += result;
+        }
+    }
+
+    // what the socket had no room for stays queued, at the front and in order, for the next flush
+    int numLeft = _queuedCount - numAttempted;
+    for (int i = 0; i < numLeft; i++) {
+        _queuedDatagrams[i] = _queuedDatagrams[numAttempted + i];
+        _sendSockAddrs[i] = _sendSockAddrs[numAttempted + i];
+        _sendVectors[i] = _sendVectors[numAttempted + i];
+    }
+    for (int i = numLeft; i < _queuedCount; i++) {
+        _queuedDatagrams[i] = QByteArray();
+    }
+    _queuedCount = numLeft;
+    _datagramsWritten.fetchAndAddRelaxed(numSent);
+#endif
+
+    return numSent;
+}
+
+float BatchedDatagramSocket::getDatagramsPerReadCall() const {
+    int readCalls = _readCalls.load();
+    return (readCalls > 0) ? (float)_datagramsRead.load() / readCalls : 0.0f;
+}
+
+float BatchedDatagramSocket::getDatagramsPerWriteCall() const {
+    int writeCalls = _writeCalls.load();
+    return (writeCalls > 0) ? (float)_datagramsWritten.load() / writeCalls : 0.0f;
+}
+
+void BatchedDatagramSocket::resetStats() {
+    _datagramsRead.store(0);
+    _readCalls.store(0);
+    _datagramsWritten.store(0);
+    _writeCalls.store(0);
+    _droppedOversizedDatagrams.store(0);
+}
+
+qint64 BatchedDatagramSocket::writeSingleDatagram(const QByteArray& datagram, const HifiSockAddr& destinationSockAddr) {
+    qint64 bytesWritten = _socket.writeDatagram(datagram, destinationSockAddr.getAddress(), destinationSockAddr.getPort());
+    _writeCalls.ref();
+
+    if (bytesWritten < 0) {
+        qDebug() << "ERROR in writeDatagram:" << _socket.error() << "-" << _socket.errorString();
+    } else {
+        _datagramsWritten.ref();
+    }
+
+    return bytesWritten;
+}
@@ -0,0 +1,83 @@
+//
+//  BatchedDatagramSocket.h
+//  libraries/networking/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_BatchedDatagramSocket_h
+#define hifi_BatchedDatagramSocket_h
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QByteArray>
+#include <QtCore/QVector>
+#include <QtNetwork/QUdpSocket>
+
+#include "HifiSockAddr.h"
+
+#ifdef Q_OS_LINUX
+#define HAVE_BATCHED_DATAGRAM_CALLS
+#include <sys/socket.h>
+#include <sys/uio.h>
+#endif
+
+/// Moves datagrams through a bound QUdpSocket several at a time. On Linux a batch goes through a single recvmmsg or
+/// sendmmsg call using buffers that are allocated once, elsewhere every datagram is one QUdpSocket call like before.
+/// One thread may read and one thread may queue datagrams at a time, they don't have to be the same thread, and the stats
+/// may be read and reset from any thread.
+class BatchedDatagramSocket {
+public:
+    static const int MAX_DATAGRAMS_PER_BATCH = 32;
+    static const int MAX_BATCHED_DATAGRAM_SIZE = 8192;
+
+    BatchedDatagramSocket(QUdpSocket& socket);
+
+    /// reads the next datagram, from the batch already read or from a new one. Returns false once nothing is pending.
+    bool readDatagram(QByteArray& destination, HifiSockAddr& senderSockAddr);
+
+    /// queues a datagram that goes out with the next flush, the queue is flushed right away once it's full
+    void queueDatagram(const QByteArray& datagram, const HifiSockAddr& destinationSockAddr);
+
+    /// sends everything that is queued, returns the number of datagrams that went out
+    int flushQueuedDatagrams();
+
+    int getQueuedDatagramCount() const { return _queuedCount; }
+
+    float getDatagramsPerReadCall() const;
+    float getDatagramsPerWriteCall() const;
+    int getDroppedOversizedDatagrams() const { return _droppedOversizedDatagrams.load(); }
+    void resetStats();
+
+private:
+    qint64 writeSingleDatagram(const QByteArray& datagram, const HifiSockAddr& destinationSockAddr);
+
+    QUdpSocket& _socket;
+
+    QVector<QByteArray> _queuedDatagrams; // keeps the queued datagrams alive until they are flushed
+    int _queuedCount;
+
+#ifdef HAVE_BATCHED_DATAGRAM_CALLS
+    int _readCount;
+    int _readIndex;
+
+    QByteArray _receiveBuffer;
+    mmsghdr _receiveHeaders[MAX_DATAGRAMS_PER_BATCH];
+    iovec _receiveVectors[MAX_DATAGRAMS_PER_BATCH];
+    sockaddr_storage _receiveSockAddrs[MAX_DATAGRAMS_PER_BATCH];
+
+    mmsghdr _sendHeaders[MAX_DATAGRAMS_PER_BATCH];
+    iovec _sendVectors[MAX_DATAGRAMS_PER_BATCH];
+    sockaddr_in _sendSockAddrs[MAX_DATAGRAMS_PER_BATCH];
+#endif
+
+    QAtomicInt _datagramsRead;
+    QAtomicInt _readCalls;
+    QAtomicInt _datagramsWritten;
+    QAtomicInt _writeCalls;
+    QAtomicInt _droppedOversizedDatagrams;
+};
+
+#endif // hifi_BatchedDatagramSocket_h
@@ -66,9 +66,15 @@ LimitedNodeList* LimitedNodeList::getInstance() {
 
 LimitedNodeList::LimitedNodeList(unsigned short socketListenPort, unsigned short dtlsListenPort) :
     _sessionUUID(),
+    _sessionLocalID(NULL_LOCAL_ID),
     _nodeHash(),
+    _localIDNodes(),
     _nodeHashMutex(QMutex::Recursive),
+    _publishedNodeTable(new NodeTable()),
+    _nodeTableEpoch(0),
     _nodeSocket(this),
+    _batchedNodeSocket(_nodeSocket),
+    _datagramBatchThread(NULL),
     _dtlsSocket(NULL),
     _localSockAddr(),
     _publicSockAddr(),
@@ -76,6 +82,9 @@ LimitedNodeList::LimitedNodeList(unsigned short socketListenPort, unsigned short
     _numCollectedBytes(0),
     _packetStatTimer()
 {
+    // the empty table readers get until the first node is added, referenced by the published pointer
+    _publishedNodeTable.load()->ref.ref();
+    
     _nodeSocket.bind(QHostAddress::AnyIPv4, socketListenPort);
     qDebug() << "NodeList socket is listening on" << _nodeSocket.localPort();
     
@@ -102,6 +111,13 @@ LimitedNodeList::LimitedNodeList(unsigned short socketListenPort, unsigned short
     _packetStatTimer.start();
 }
 
+LimitedNodeList::~LimitedNodeList() {
+    const NodeTable* nodeTable = _publishedNodeTable.load();
+    if (!nodeTable->ref.deref()) {
+        delete nodeTable;
+    }
+}
+
 void LimitedNodeList::setSessionUUID(const QUuid& sessionUUID) {
     QUuid oldUUID = _sessionUUID;
     _sessionUUID = sessionUUID;
@@ -181,7 +197,7 @@ bool LimitedNodeList::packetVersionAndHashMatch(const QByteArray& packet) {
     PacketType checkType = packetTypeForPacket(packet);
     int numPacketTypeBytes = numBytesArithmeticCodingFromBuffer(packet.data());
     
-    if (packet[numPacketTypeBytes] != versionForPacketType(checkType)
+    if (versionFromPacketHeader(packet.constData()) != versionForPacketType(checkType)
         && checkType != PacketTypeStunResponse) {
         PacketType mismatchType = packetTypeForPacket(packet);
         
@@ -231,8 +247,13 @@ qint64 LimitedNodeList::writeDatagram(const QByteArray& datagram, const HifiSock
     }
     
     // stat collection for packets
-    ++_numCollectedPackets;
-    _numCollectedBytes += datagram.size();
+    _numCollectedPackets.ref();
+    _numCollectedBytes.fetchAndAddRelaxed(datagram.size());
+    
+    if (_datagramBatchThread.loadAcquire() == QThread::currentThread()) {
+        _batchedNodeSocket.queueDatagram(datagramCopy, destinationSockAddr);
+        return datagramCopy.size();
+    }
     
     qint64 bytesWritten = _nodeSocket.writeDatagram(datagramCopy,
                                                     destinationSockAddr.getAddress(), destinationSockAddr.getPort());
@@ -298,6 +319,15 @@ qint64 LimitedNodeList::writeDatagram(const char* data, qint64 size, const Share
     return writeDatagram(QByteArray(data, size), destinationNode, overridenSockAddr);
 }
 
+void LimitedNodeList::beginDatagramBatch() {
+    _datagramBatchThread.storeRelease(QThread::currentThread());
+}
+
+void LimitedNodeList::flushDatagramBatch() {
+    _datagramBatchThread.storeRelease(NULL);
+    _batchedNodeSocket.flushQueuedDatagrams();
+}
+
 qint64 LimitedNodeList::writeUnverifiedDatagram(const char* data, qint64 size, const SharedNodePointer& destinationNode,
                                const HifiSockAddr& overridenSockAddr) {
     return writeUnverifiedDatagram(QByteArray(data, size), destinationNode, overridenSockAddr);
@@ -338,31 +368,61 @@ int LimitedNodeList::findNodeAndUpdateWithDataFromPacket(const QByteArray& packe
     return 0;
 }
 
-SharedNodePointer LimitedNodeList::nodeWithUUID(const QUuid& nodeUUID, bool blockingLock) {
-    const int WAIT_TIME = 10; // wait up to 10ms in the try lock case
-    SharedNodePointer node;
-    // if caller wants us to block and guarantee the correct answer, then honor that request
-    if (blockingLock) {
-        // this will block till we can get access
-        QMutexLocker locker(&_nodeHashMutex);
-        node = _nodeHash.value(nodeUUID);
-    } else if (_nodeHashMutex.tryLock(WAIT_TIME)) { // some callers are willing to get wrong answers but not block
-        node = _nodeHash.value(nodeUUID);
-        _nodeHashMutex.unlock();
+NodeTablePointer LimitedNodeList::getNodeTable() {
+    // a reader counts itself in for the current epoch before it looks at the published table. A writer that replaces
+    // the table ends the epoch and waits for its readers to leave before it drops its reference to the old table, so
+    // the pointer we load here stays valid until our own reference to it is taken.
+    forever {
+        int epoch = _nodeTableEpoch.loadAcquire();
+        QAtomicInt& epochReaders = _nodeTableReaders[epoch & 1];
+        epochReaders.ref();
+        
+        if (_nodeTableEpoch.loadAcquire() == epoch) {
+            NodeTablePointer nodeTable(_publishedNodeTable.loadAcquire());
+            epochReaders.deref();
+            return nodeTable;
+        }
+        
+        // a writer ended the epoch in between, count ourselves in for the new one
+        epochReaders.deref();
     }
-    return node;
- }
+}
 
 SharedNodePointer LimitedNodeList::sendingNodeForPacket(const QByteArray& packet) {
+    // a compact header names the sender by its local ID, which indexes straight into the local ID table
+    if (hasCompactPacketHeader(packet.constData())) {
+        return nodeWithLocalID(localIDFromPacketHeader(packet));
+    }
+    
     QUuid nodeUUID = uuidFromPacketHeader(packet);
     
     // return the matching node, or NULL if there is no match
     return nodeWithUUID(nodeUUID);
 }
 
-NodeHash LimitedNodeList::getNodeHash() {
-    QMutexLocker locker(&_nodeHashMutex);
-    return NodeHash(_nodeHash);
+void LimitedNodeList::publishNodeTable() {
+    NodeTable* nodeTable = new NodeTable();
+    nodeTable->nodeHash = _nodeHash;
+    nodeTable->nodes.reserve(_nodeHash.size());
+    foreach (const SharedNodePointer& node, _nodeHash) {
+        nodeTable->nodes.append(node);
+    }
+    nodeTable->localIDNodes = _localIDNodes;
+    
+    // this reference belongs to the published pointer
+    nodeTable->ref.ref();
+    const NodeTable* oldNodeTable = _publishedNodeTable.fetchAndStoreOrdered(nodeTable);
+    
+    // end the epoch and wait out the readers that may have loaded the old pointer without referencing it yet, after
+    // that the old table only lives on in the snapshots readers still hold
+    int endedEpoch = _nodeTableEpoch.fetchAndAddOrdered(1);
+    while (_nodeTableReaders[endedEpoch & 1].loadAcquire() != 0) {
+        QThread::yieldCurrentThread();
+    }
+    
+    if (!oldNodeTable->ref.deref()) {
+        delete oldNodeTable;
+    }
 }
 
 void LimitedNodeList::eraseAllNodes() {
@@ -376,6 +436,8 @@ void LimitedNodeList::eraseAllNodes() {
     while (nodeItem != _nodeHash.end()) {
         nodeItem = killNodeAtHashIterator(nodeItem);
     }
+    
+    publishNodeTable();
 }
 
 void LimitedNodeList::reset() {
@@ -388,10 +450,16 @@ void LimitedNodeList::killNodeWithUUID(const QUuid& nodeUUID) {
     NodeHash::iterator nodeItemToKill = _nodeHash.find(nodeUUID);
     if (nodeItemToKill != _nodeHash.end()) {
         killNodeAtHashIterator(nodeItemToKill);
+        publishNodeTable();
     }
 }
 
 NodeHash::iterator LimitedNodeList::killNodeAtHashIterator(NodeHash::iterator& nodeItemToKill) {
+    LocalID localID = nodeItemToKill.value()->getLocalID();
+    if (localID != NULL_LOCAL_ID && _localIDNodes.value(localID) == nodeItemToKill.value()) {
+        _localIDNodes[localID].clear();
+    }
+    
     qDebug() << "Killed" << *nodeItemToKill.value();
     emit nodeKilled(nodeItemToKill.value());
     return _nodeHash.erase(nodeItemToKill);
@@ -406,7 +474,8 @@ void LimitedNodeList::processKillNode(const QByteArray& dataByteArray) {
 }
 
 SharedNodePointer LimitedNodeList::addOrUpdateNode(const QUuid& uuid, NodeType_t nodeType,
-                                            const HifiSockAddr& publicSocket, const HifiSockAddr& localSocket) {
+                                            const HifiSockAddr& publicSocket, const HifiSockAddr& localSocket,
+                                            LocalID localID) {
     _nodeHashMutex.lock();
     
     if (!_nodeHash.contains(uuid)) {
@@ -416,6 +485,8 @@ SharedNodePointer LimitedNodeList::addOrUpdateNode(const QUuid& uuid, NodeType_t
         SharedNodePointer newNodeSharedPointer(newNode, &QObject::deleteLater);
         
         _nodeHash.insert(newNode->getUUID(), newNodeSharedPointer);
+        setLocalIDForNode(newNodeSharedPointer, localID);
+        publishNodeTable();
         
         _nodeHashMutex.unlock();
         
@@ -425,12 +496,36 @@ SharedNodePointer LimitedNodeList::addOrUpdateNode(const QUuid& uuid, NodeType_t
 
         return newNodeSharedPointer;
     } else {
+        const SharedNodePointer& matchingNode = _nodeHash.value(uuid);
+        if (localID != NULL_LOCAL_ID && localID != matchingNode->getLocalID()) {
+            setLocalIDForNode(matchingNode, localID);
+            publishNodeTable();
+        }
+        
         _nodeHashMutex.unlock();
         
         return updateSocketsForNode(uuid, publicSocket, localSocket);
     }
 }
 
+void LimitedNodeList::setLocalIDForNode(const SharedNodePointer& node, LocalID localID) {
+    QMutexLocker locker(&_nodeHashMutex);
+    
+    LocalID oldLocalID = node->getLocalID();
+    if (oldLocalID != NULL_LOCAL_ID && _localIDNodes.value(oldLocalID) == node) {
+        _localIDNodes[oldLocalID].clear();
+    }
+    
+    node->setLocalID(localID);
+    
+    if (localID != NULL_LOCAL_ID) {
+        if (localID >= _localIDNodes.size()) {
+            _localIDNodes.resize(localID + 1);
+        }
+        _localIDNodes[localID] = node;
+    }
+}
+
 SharedNodePointer LimitedNodeList::updateSocketsForNode(const QUuid& uuid,
                                                  const HifiSockAddr& publicSocket, const HifiSockAddr& localSocket) {
 
@@ -515,13 +610,13 @@ SharedNodePointer LimitedNodeList::soloNodeOfType(char nodeType) {
 }
 
 void LimitedNodeList::getPacketStats(float& packetsPerSecond, float& bytesPerSecond) {
-    packetsPerSecond = (float) _numCollectedPackets / ((float) _packetStatTimer.elapsed() / 1000.0f);
-    bytesPerSecond = (float) _numCollectedBytes / ((float) _packetStatTimer.elapsed() / 1000.0f);
+    packetsPerSecond = (float) _numCollectedPackets.load() / ((float) _packetStatTimer.elapsed() / 1000.0f);
+    bytesPerSecond = (float) _numCollectedBytes.load() / ((float) _packetStatTimer.elapsed() / 1000.0f);
 }
 
 void LimitedNodeList::resetPacketStats() {
-    _numCollectedPackets = 0;
-    _numCollectedBytes = 0;
+    _numCollectedPackets.store(0);
+    _numCollectedBytes.store(0);
     _packetStatTimer.restart();
 }
 
@@ -529,6 +624,7 @@ void LimitedNodeList::removeSilentNodes() {
 
     _nodeHashMutex.lock();
     
+    bool killedNodes = false;
     NodeHash::iterator nodeItem = _nodeHash.begin();
 
     while (nodeItem != _nodeHash.end()) {
@@ -539,6 +635,7 @@ void LimitedNodeList::removeSilentNodes() {
         if ((usecTimestampNow() - node->getLastHeardMicrostamp()) > (NODE_SILENCE_THRESHOLD_MSECS * 1000)) {
             // call our private method to kill this node (removes it and emits the right signal)
             nodeItem = killNodeAtHashIterator(nodeItem);
+            killedNodes = true;
         } else {
             // we didn't kill this node, push the iterator forwards
             ++nodeItem;
@@ -547,6 +644,10 @@ void LimitedNodeList::removeSilentNodes() {
         node->getMutex().unlock();
     }
     
+    if (killedNodes) {
+        publishNodeTable();
+    }
+    
     _nodeHashMutex.unlock();
 }
 
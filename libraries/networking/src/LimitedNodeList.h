@@ -24,10 +24,16 @@
 #include <QtCore/QMutex>
 #include <QtCore/QSet>
 #include <QtCore/QSettings>
+#include <QtCore/QAtomicInt>
+#include <QtCore/QAtomicPointer>
+#include <QtCore/QSharedData>
 #include <QtCore/QSharedPointer>
+#include <QtCore/QThread>
+#include <QtCore/QVector>
 #include <QtNetwork/QHostAddress>
 #include <QtNetwork/QUdpSocket>
 
+#include "BatchedDatagramSocket.h"
 #include "DomainHandler.h"
 #include "Node.h"
 
@@ -52,6 +58,17 @@ typedef QSharedPointer<Node> SharedNodePointer;
 typedef QHash<QUuid, SharedNodePointer> NodeHash;
 Q_DECLARE_METATYPE(SharedNodePointer)
 
+/// An immutable snapshot of the node list. Readers hold on to one for as long as they like without any locking, every
+/// change to the node list publishes a new one.
+class NodeTable : public QSharedData {
+public:
+    NodeHash nodeHash;
+    QVector<SharedNodePointer> nodes; ///< the same nodes packed in an array, for iterating over all of them
+    QVector<SharedNodePointer> localIDNodes; ///< indexed by local ID
+};
+
+typedef QExplicitlySharedDataPointer<const NodeTable> NodeTablePointer;
+
 typedef quint8 PingType_t;
 namespace PingType {
     const PingType_t Agnostic = 0;
@@ -66,12 +83,18 @@ public:
     static LimitedNodeList* createInstance(unsigned short socketListenPort = 0, unsigned short dtlsPort = 0);
     static LimitedNodeList* getInstance();
 
+    ~LimitedNodeList();
+
     const QUuid& getSessionUUID() const { return _sessionUUID; }
     void setSessionUUID(const QUuid& sessionUUID);
     
+    LocalID getSessionLocalID() const { return _sessionLocalID; }
+    void setSessionLocalID(LocalID sessionLocalID) { _sessionLocalID = sessionLocalID; }
+    
     
     void rebindNodeSocket();
     QUdpSocket& getNodeSocket() { return _nodeSocket; }
+    BatchedDatagramSocket& getBatchedNodeSocket() { return _batchedNodeSocket; }
     QUdpSocket& getDTLSSocket();
     
     bool packetVersionAndHashMatch(const QByteArray& packet);
@@ -89,16 +112,25 @@ public:
     qint64 writeUnverifiedDatagram(const char* data, qint64 size, const SharedNodePointer& destinationNode,
                          const HifiSockAddr& overridenSockAddr = HifiSockAddr());
 
+    /// datagrams written from the calling thread are queued until flushDatagramBatch() and then sent together,
+    /// datagrams written from other threads in the meantime still go out right away
+    void beginDatagramBatch();
+    void flushDatagramBatch();
+
     void(*linkedDataCreateCallback)(Node *);
 
-    NodeHash getNodeHash();
-    int size() const { return _nodeHash.size(); }
+    /// the current snapshot of the node list, never blocks
+    NodeTablePointer getNodeTable();
+    NodeHash getNodeHash() { return getNodeTable()->nodeHash; }
+    int size() { return getNodeTable()->nodes.size(); }
 
-    SharedNodePointer nodeWithUUID(const QUuid& nodeUUID, bool blockingLock = true);
+    SharedNodePointer nodeWithUUID(const QUuid& nodeUUID) { return getNodeTable()->nodeHash.value(nodeUUID); }
+    SharedNodePointer nodeWithLocalID(LocalID localID) { return getNodeTable()->localIDNodes.value(localID); }
     SharedNodePointer sendingNodeForPacket(const QByteArray& packet);
     
     SharedNodePointer addOrUpdateNode(const QUuid& uuid, NodeType_t nodeType,
-                                      const HifiSockAddr& publicSocket, const HifiSockAddr& localSocket);
+                                      const HifiSockAddr& publicSocket, const HifiSockAddr& localSocket,
+                                      LocalID localID = NULL_LOCAL_ID);
     SharedNodePointer updateSocketsForNode(const QUuid& uuid,
                                            const HifiSockAddr& publicSocket, const HifiSockAddr& localSocket);
     
@@ -152,19 +184,31 @@ protected:
                          const QUuid& connectionSecret);
 
     NodeHash::iterator killNodeAtHashIterator(NodeHash::iterator& nodeItemToKill);
+    void setLocalIDForNode(const SharedNodePointer& node, LocalID localID);
+    
+    /// replaces the snapshot readers get with the current state of the node hash, called with the node hash mutex held
+    /// after every change to it
+    void publishNodeTable();
 
     
     void changeSocketBufferSizes(int numBytes);
 
     QUuid _sessionUUID;
+    LocalID _sessionLocalID;
     NodeHash _nodeHash;
+    QVector<SharedNodePointer> _localIDNodes; // indexed by local ID, guarded by the node hash mutex
     QMutex _nodeHashMutex;
+    QAtomicPointer<const NodeTable> _publishedNodeTable;
+    QAtomicInt _nodeTableEpoch;
+    QAtomicInt _nodeTableReaders[2]; // readers that may be looking at the published table, by parity of their epoch
     QUdpSocket _nodeSocket;
+    BatchedDatagramSocket _batchedNodeSocket;
+    QAtomicPointer<QThread> _datagramBatchThread; // read by every thread that writes a datagram
     QUdpSocket* _dtlsSocket;
     HifiSockAddr _localSockAddr;
     HifiSockAddr _publicSockAddr;
-    int _numCollectedPackets;
-    int _numCollectedBytes;
+    QAtomicInt _numCollectedPackets;
+    QAtomicInt _numCollectedBytes;
     QElapsedTimer _packetStatTimer;
 };
 
@@ -46,6 +46,7 @@ const QString& NodeType::getNodeTypeName(NodeType_t nodeType) {
 Node::Node(const QUuid& uuid, NodeType_t type, const HifiSockAddr& publicSocket, const HifiSockAddr& localSocket) :
 	NetworkPeer(uuid, publicSocket, localSocket),
     _type(type),
+    _localID(NULL_LOCAL_ID),
     _activeSocket(NULL),
     _symmetricSocket(),
     _connectionSecret(),
@@ -140,6 +141,7 @@ QDataStream& operator<<(QDataStream& out, const Node& node) {
     out << node._uuid;
     out << node._publicSocket;
     out << node._localSocket;
+    out << node._localID;
     
     return out;
 }
@@ -149,6 +151,7 @@ QDataStream& operator>>(QDataStream& in, Node& node) {
     in >> node._uuid;
     in >> node._publicSocket;
     in >> node._localSocket;
+    in >> node._localID;
     
     return in;
 }
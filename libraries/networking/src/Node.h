@@ -28,6 +28,10 @@
 
 typedef quint8 NodeType_t;
 
+/// the short index the domain-server hands each node for the compact packet header, zero until it has one
+typedef quint16 LocalID;
+const LocalID NULL_LOCAL_ID = 0;
+
 namespace NodeType {
     const NodeType_t DomainServer = 'D';
     const NodeType_t VoxelServer = 'V';
@@ -56,6 +60,9 @@ public:
     char getType() const { return _type; }
     void setType(char type) { _type = type; }
     
+    LocalID getLocalID() const { return _localID; }
+    void setLocalID(LocalID localID) { _localID = localID; }
+    
     const QUuid& getConnectionSecret() const { return _connectionSecret; }
     void setConnectionSecret(const QUuid& connectionSecret) { _connectionSecret = connectionSecret; }
 
@@ -96,6 +103,7 @@ private:
     Node& operator=(Node otherNode);
 
     NodeType_t _type;
+    LocalID _localID;
     
     HifiSockAddr* _activeSocket;
     HifiSockAddr _symmetricSocket;
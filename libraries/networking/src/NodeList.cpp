@@ -204,6 +204,7 @@ void NodeList::reset() {
 
     // refresh the owner UUID to the NULL UUID
     setSessionUUID(QUuid());
+    setSessionLocalID(NULL_LOCAL_ID);
     
     if (sender() != &_domainHandler) {
         // clear the domain connection information, unless they're the ones that asked us to reset
@@ -392,12 +393,15 @@ int NodeList::processDomainServerList(const QByteArray& packet) {
     
     // pull our owner UUID from the packet, it's always the first thing
     QUuid newUUID;
-    packetStream >> newUUID;
+    LocalID newLocalID;
+    packetStream >> newUUID >> newLocalID;
     setSessionUUID(newUUID);
+    setSessionLocalID(newLocalID);
     
     // pull each node in the packet
+    LocalID nodeLocalID;
     while(packetStream.device()->pos() < packet.size()) {
-        packetStream >> nodeType >> nodeUUID >> nodePublicSocket >> nodeLocalSocket;
+        packetStream >> nodeType >> nodeUUID >> nodePublicSocket >> nodeLocalSocket >> nodeLocalID;
 
         // if the public socket address is 0 then it's reachable at the same IP
         // as the domain server
@@ -405,7 +409,7 @@ int NodeList::processDomainServerList(const QByteArray& packet) {
             nodePublicSocket.setAddress(_domainHandler.getIP());
         }
 
-        SharedNodePointer node = addOrUpdateNode(nodeUUID, nodeType, nodePublicSocket, nodeLocalSocket);
+        SharedNodePointer node = addOrUpdateNode(nodeUUID, nodeType, nodePublicSocket, nodeLocalSocket, nodeLocalID);
         
         packetStream >> connectionUUID;
         node->setConnectionSecret(connectionUUID);
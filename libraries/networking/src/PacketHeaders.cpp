@@ -49,11 +49,13 @@ PacketVersion versionForPacketType(PacketType type) {
     switch (type) {
         case PacketTypeMicrophoneAudioNoEcho:
         case PacketTypeMicrophoneAudioWithEcho:
-            return 2;
+            return 3;
+        case PacketTypeInjectAudio:
+            return 1;
         case PacketTypeSilentAudioFrame:
             return 4;
         case PacketTypeMixedAudio:
-            return 2;
+            return 3;
         case PacketTypeAvatarData:
             return 3;
         case PacketTypeAvatarIdentity:
@@ -61,6 +63,7 @@ PacketVersion versionForPacketType(PacketType type) {
         case PacketTypeEnvironmentData:
             return 2;
         case PacketTypeDomainList:
+            return 4;
         case PacketTypeDomainListRequest:
             return 3;
         case PacketTypeCreateAssignment:
@@ -74,7 +77,7 @@ PacketVersion versionForPacketType(PacketType type) {
 
         case PacketTypeEntityAddOrEdit:
         case PacketTypeEntityData:
-            return VERSION_ENTITIES_SUPPORT_DIMENSIONS;
+            return VERSION_ENTITIES_HAVE_PRIMED_COMPRESSION;
 
         case PacketTypeEntityErase:
             return 2;
@@ -83,7 +86,11 @@ PacketVersion versionForPacketType(PacketType type) {
         case PacketTypeMetavoxelData:
             return 8;
         case PacketTypeVoxelData:
-            return VERSION_VOXELS_HAS_FILE_BREAKS;
+            return VERSION_VOXELS_HAVE_PRIMED_COMPRESSION;
+        case PacketTypeOctreeSubtreeTransfer:
+            return 2;
+        case PacketTypeOctreeSubtreeTransferAck:
+            return 1;
         default:
             return 0;
     }
@@ -137,6 +144,11 @@ QString nameForPacketType(PacketType type) {
         PACKET_TYPE_NAME_LOOKUP(PacketTypeVoxelEditNack);
         PACKET_TYPE_NAME_LOOKUP(PacketTypeEntityEditNack);
         PACKET_TYPE_NAME_LOOKUP(PacketTypeSignedTransactionPayment);
+        PACKET_TYPE_NAME_LOOKUP(PacketTypeJurisdictionLoad);
+        PACKET_TYPE_NAME_LOOKUP(PacketTypeJurisdictionHandoff);
+        PACKET_TYPE_NAME_LOOKUP(PacketTypeOctreeSubtreeTransfer);
+        PACKET_TYPE_NAME_LOOKUP(PacketTypeOctreeSubtreeTransferAck);
+        PACKET_TYPE_NAME_LOOKUP(PacketTypeSilentInjectAudio);
         default:
             return QString("Type: ") + QString::number((int)type);
     }
@@ -165,11 +177,21 @@ int populatePacketHeader(char* packet, PacketType type, const QUuid& connectionU
     
     char* position = packet + numTypeBytes + sizeof(PacketVersion);
     
-    QUuid packUUID = connectionUUID.isNull() ? LimitedNodeList::getInstance()->getSessionUUID() : connectionUUID;
+    LimitedNodeList* nodeList = LimitedNodeList::getInstance();
+    quint16 sessionLocalID = nodeList->getSessionLocalID();
     
-    QByteArray rfcUUID = packUUID.toRfc4122();
-    memcpy(position, rfcUUID.constData(), NUM_BYTES_RFC4122_UUID);
-    position += NUM_BYTES_RFC4122_UUID;
+    if (connectionUUID.isNull() && sessionLocalID != NULL_LOCAL_ID && !FULL_HEADER_PACKETS.contains(type)) {
+        // everyone in our domain knows us by the local ID the domain-server handed us
+        packet[numTypeBytes] |= COMPACT_HEADER_VERSION_FLAG;
+        memcpy(position, &sessionLocalID, NUM_BYTES_LOCAL_ID);
+        position += NUM_BYTES_LOCAL_ID;
+    } else {
+        QUuid packUUID = connectionUUID.isNull() ? nodeList->getSessionUUID() : connectionUUID;
+        
+        QByteArray rfcUUID = packUUID.toRfc4122();
+        memcpy(position, rfcUUID.constData(), NUM_BYTES_RFC4122_UUID);
+        position += NUM_BYTES_RFC4122_UUID;
+    }
     
     if (!NON_VERIFIED_PACKETS.contains(type)) {
         // pack 16 bytes of zeros where the md5 hash will be placed once data is packed
@@ -182,17 +204,14 @@ int populatePacketHeader(char* packet, PacketType type, const QUuid& connectionU
 }
 
 int numBytesForPacketHeader(const QByteArray& packet) {
-    // returns the number of bytes used for the type, version, and UUID
-    return numBytesArithmeticCodingFromBuffer(packet.data())
-    + numHashBytesInPacketHeaderGivenPacketType(packetTypeForPacket(packet))
-    + NUM_STATIC_HEADER_BYTES;
+    return numBytesForPacketHeader(packet.constData());
 }
 
 int numBytesForPacketHeader(const char* packet) {
-    // returns the number of bytes used for the type, version, and UUID
+    // returns the number of bytes used for the type, version, and UUID or local ID
     return numBytesArithmeticCodingFromBuffer(packet)
     + numHashBytesInPacketHeaderGivenPacketType(packetTypeForPacket(packet))
-    + NUM_STATIC_HEADER_BYTES;
+    + (hasCompactPacketHeader(packet) ? NUM_STATIC_COMPACT_HEADER_BYTES : NUM_STATIC_HEADER_BYTES);
 }
 
 int numBytesForPacketHeaderGivenPacketType(PacketType type) {
@@ -205,11 +224,35 @@ int numHashBytesInPacketHeaderGivenPacketType(PacketType type) {
     return (NON_VERIFIED_PACKETS.contains(type) ? 0 : NUM_BYTES_MD5_HASH);
 }
 
+bool hasCompactPacketHeader(const char* packet) {
+    return (packet[numBytesArithmeticCodingFromBuffer(packet)] & COMPACT_HEADER_VERSION_FLAG) != 0;
+}
+
+PacketVersion versionFromPacketHeader(const char* packet) {
+    return packet[numBytesArithmeticCodingFromBuffer(packet)] & ~COMPACT_HEADER_VERSION_FLAG;
+}
+
 QUuid uuidFromPacketHeader(const QByteArray& packet) {
+    if (hasCompactPacketHeader(packet.constData())) {
+        SharedNodePointer sendingNode = LimitedNodeList::getInstance()->nodeWithLocalID(localIDFromPacketHeader(packet));
+        return sendingNode ? sendingNode->getUUID() : QUuid();
+    }
+    
     return QUuid::fromRfc4122(packet.mid(numBytesArithmeticCodingFromBuffer(packet.data()) + sizeof(PacketVersion),
                                          NUM_BYTES_RFC4122_UUID));
 }
 
+quint16 localIDFromPacketHeader(const QByteArray& packet) {
+    if (!hasCompactPacketHeader(packet.constData())) {
+        return NULL_LOCAL_ID;
+    }
+    
+    quint16 localID;
+    memcpy(&localID, packet.constData() + numBytesArithmeticCodingFromBuffer(packet.data()) + sizeof(PacketVersion),
+           NUM_BYTES_LOCAL_ID);
+    return localID;
+}
+
 QByteArray hashFromPacketHeader(const QByteArray& packet) {
     return packet.mid(numBytesForPacketHeader(packet) - NUM_BYTES_MD5_HASH, NUM_BYTES_MD5_HASH);
 }
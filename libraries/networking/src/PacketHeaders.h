@@ -74,7 +74,12 @@ enum PacketType {
     PacketTypeIceServerHeartbeat,
     PacketTypeIceServerHeartbeatResponse,
     PacketTypeUnverifiedPing,
-    PacketTypeUnverifiedPingReply
+    PacketTypeUnverifiedPingReply,
+    PacketTypeJurisdictionLoad,
+    PacketTypeJurisdictionHandoff,
+    PacketTypeOctreeSubtreeTransfer,
+    PacketTypeOctreeSubtreeTransferAck,
+    PacketTypeSilentInjectAudio
 };
 
 typedef char PacketVersion;
@@ -86,12 +91,28 @@ const QSet<PacketType> NON_VERIFIED_PACKETS = QSet<PacketType>()
     << PacketTypeNodeJsonStats << PacketTypeVoxelQuery << PacketTypeEntityQuery
     << PacketTypeOctreeDataNack << PacketTypeVoxelEditNack << PacketTypeEntityEditNack
     << PacketTypeIceServerHeartbeat << PacketTypeIceServerHeartbeatResponse
-    << PacketTypeUnverifiedPing << PacketTypeUnverifiedPingReply;
+    << PacketTypeUnverifiedPing << PacketTypeUnverifiedPingReply
+    << PacketTypeJurisdictionLoad << PacketTypeJurisdictionHandoff;
+
+// packets to and from the domain-server, the ice-server and STUN always carry the sender's full UUID, everything else
+// is sent with the compact header once the domain-server has handed us a local ID
+const QSet<PacketType> FULL_HEADER_PACKETS = QSet<PacketType>()
+    << PacketTypeDomainServerRequireDTLS << PacketTypeDomainConnectRequest
+    << PacketTypeDomainList << PacketTypeDomainListRequest << PacketTypeDomainConnectionDenied
+    << PacketTypeCreateAssignment << PacketTypeRequestAssignment << PacketTypeStunResponse
+    << PacketTypeNodeJsonStats << PacketTypeIceServerHeartbeat << PacketTypeIceServerHeartbeatResponse
+    << PacketTypeUnverifiedPing << PacketTypeUnverifiedPingReply
+    << PacketTypeJurisdictionLoad << PacketTypeJurisdictionHandoff;
 
 const int NUM_BYTES_MD5_HASH = 16;
+const int NUM_BYTES_LOCAL_ID = sizeof(quint16);
 const int NUM_STATIC_HEADER_BYTES = sizeof(PacketVersion) + NUM_BYTES_RFC4122_UUID;
+const int NUM_STATIC_COMPACT_HEADER_BYTES = sizeof(PacketVersion) + NUM_BYTES_LOCAL_ID;
 const int MAX_PACKET_HEADER_BYTES = sizeof(PacketType) + NUM_BYTES_MD5_HASH + NUM_STATIC_HEADER_BYTES;
 
+// set in the version byte when the header carries the sender's local ID instead of its UUID
+const PacketVersion COMPACT_HEADER_VERSION_FLAG = (PacketVersion)0x80;
+
 PacketVersion versionForPacketType(PacketType type);
 QString nameForPacketType(PacketType type);
 
@@ -105,9 +126,16 @@ int numHashBytesInPacketHeaderGivenPacketType(PacketType type);
 
 int numBytesForPacketHeader(const QByteArray& packet);
 int numBytesForPacketHeader(const char* packet);
+
+/// the size of a full header of this type, the most any header of this type takes
 int numBytesForPacketHeaderGivenPacketType(PacketType type);
 
+bool hasCompactPacketHeader(const char* packet);
+PacketVersion versionFromPacketHeader(const char* packet);
+
+/// the sender's UUID, looked up from its local ID for a compact header. Null if we don't know the sender.
 QUuid uuidFromPacketHeader(const QByteArray& packet);
+quint16 localIDFromPacketHeader(const QByteArray& packet);
 
 QByteArray hashFromPacketHeader(const QByteArray& packet);
 QByteArray hashForPacketAndConnectionUUID(const QByteArray& packet, const QUuid& connectionUUID);
@@ -124,6 +152,8 @@ const PacketVersion VERSION_ROOT_ELEMENT_HAS_DATA = 2;
 const PacketVersion VERSION_ENTITIES_SUPPORT_SPLIT_MTU = 3;
 const PacketVersion VERSION_ENTITIES_HAS_FILE_BREAKS = VERSION_ENTITIES_SUPPORT_SPLIT_MTU;
 const PacketVersion VERSION_ENTITIES_SUPPORT_DIMENSIONS = 4;
+const PacketVersion VERSION_ENTITIES_HAVE_PRIMED_COMPRESSION = 5;
 const PacketVersion VERSION_VOXELS_HAS_FILE_BREAKS = 1;
+const PacketVersion VERSION_VOXELS_HAVE_PRIMED_COMPRESSION = 2;
 
 #endif // hifi_PacketHeaders_h
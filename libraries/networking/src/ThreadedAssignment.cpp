@@ -88,6 +88,11 @@ void ThreadedAssignment::addPacketStatsAndSendStatsPacket(QJsonObject &statsObje
     statsObject["packets_per_second"] = packetsPerSecond;
     statsObject["bytes_per_second"] = bytesPerSecond;
     
+    BatchedDatagramSocket& batchedNodeSocket = nodeList->getBatchedNodeSocket();
+    statsObject["datagrams_per_read_call"] = batchedNodeSocket.getDatagramsPerReadCall();
+    statsObject["datagrams_per_write_call"] = batchedNodeSocket.getDatagramsPerWriteCall();
+    batchedNodeSocket.resetStats();
+    
     nodeList->sendStatsToDomainServer(statsObject);
 }
 
@@ -105,14 +110,5 @@ void ThreadedAssignment::checkInWithDomainServerOrExit() {
 }
 
 bool ThreadedAssignment::readAvailableDatagram(QByteArray& destinationByteArray, HifiSockAddr& senderSockAddr) {
-    NodeList* nodeList = NodeList::getInstance();
-    
-    if (nodeList->getNodeSocket().hasPendingDatagrams()) {
-        destinationByteArray.resize(nodeList->getNodeSocket().pendingDatagramSize());
-        nodeList->getNodeSocket().readDatagram(destinationByteArray.data(), destinationByteArray.size(),
-                                               senderSockAddr.getAddressPointer(), senderSockAddr.getPortPointer());
-        return true;
-    } else {
-        return false;
-    }
+    return NodeList::getInstance()->getBatchedNodeSocket().readDatagram(destinationByteArray, senderSockAddr);
 }
@@ -14,6 +14,7 @@
 #include <QtCore/QStringList>
 #include <QDebug>
 
+#include <AACube.h>
 #include <PacketHeaders.h>
 #include <OctalCode.h>
 
@@ -207,6 +208,37 @@ JurisdictionMap::Area JurisdictionMap::isMyJurisdiction(const unsigned char* nod
     return isInJurisdiction ? WITHIN : BELOW;
 }
 
+static AACube cubeForOctalCode(const unsigned char* octalCode) {
+    VoxelPositionSize details;
+    voxelDetailsForCode(octalCode, details);
+    return AACube(glm::vec3(details.x, details.y, details.z), details.s);
+}
+
+bool JurisdictionMap::containsPoint(const glm::vec3& point) const {
+    if (!_rootOctalCode || !cubeForOctalCode(_rootOctalCode).contains(point)) {
+        return false;
+    }
+    for (size_t i = 0; i < _endNodes.size(); i++) {
+        if (cubeForOctalCode(_endNodes[i]).contains(point)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool JurisdictionMap::isEmpty() const {
+    return _rootOctalCode && findEndNode(_rootOctalCode) >= 0;
+}
+
+int JurisdictionMap::findEndNode(const unsigned char* octalCode) const {
+    for (size_t i = 0; i < _endNodes.size(); i++) {
+        if (compareOctalCodes(_endNodes[i], octalCode) == EXACT_MATCH) {
+            return i;
+        }
+    }
+    return -1;
+}
+
 
 bool JurisdictionMap::readFromFile(const char* filename) {
     QString     settingsFile(filename);
@@ -255,6 +287,8 @@ bool JurisdictionMap::writeToFile(const char* filename) {
 
     settings.setValue("root", rootNodeValue);
     
+    // drop end nodes from an earlier write, we may have fewer of them now
+    settings.remove("endNodes");
     settings.beginGroup("endNodes");
     for (size_t i = 0; i < _endNodes.size(); i++) {
         QString key = QString("endnode%1").arg(i);
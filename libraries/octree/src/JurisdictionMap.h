@@ -20,6 +20,8 @@
 #include <QtCore/QUuid>
 #include <QReadWriteLock>
 
+#include <glm/glm.hpp>
+
 #include <Node.h>
 
 class JurisdictionMap {
@@ -51,6 +53,15 @@ public:
 
     Area isMyJurisdiction(const unsigned char* nodeOctalCode, int childIndex) const;
 
+    /// true if the point (in domain units) falls under our root and outside all of our end nodes
+    bool containsPoint(const glm::vec3& point) const;
+
+    /// true if one of our end nodes is our root, which is how a server that owns no part of the octree reports itself
+    bool isEmpty() const;
+
+    /// returns the index of the end node matching octalCode, -1 if it isn't one of ours
+    int findEndNode(const unsigned char* octalCode) const;
+
     bool writeToFile(const char* filename);
     bool readFromFile(const char* filename);
 
@@ -49,11 +49,13 @@ bool JurisdictionSender::process() {
         unsigned char* bufferOut = &buffer[0];
         int sizeOut = 0;
 
+        lockJurisdiction();
         if (_jurisdictionMap) {
             sizeOut = _jurisdictionMap->packIntoMessage(bufferOut, MAX_PACKET_SIZE);
         } else {
             sizeOut = JurisdictionMap::packEmptyJurisdictionIntoMessage(getNodeType(), bufferOut, MAX_PACKET_SIZE);
         }
+        unlockJurisdiction();
         int nodeCount = 0;
 
         lockRequestingNodes();
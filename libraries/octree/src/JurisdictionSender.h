@@ -30,7 +30,11 @@ public:
     JurisdictionSender(JurisdictionMap* map, NodeType_t type = NodeType::VoxelServer);
     ~JurisdictionSender();
 
-    void setJurisdiction(JurisdictionMap* map) { _jurisdictionMap = map; }
+    void setJurisdiction(JurisdictionMap* map) { lockJurisdiction(); _jurisdictionMap = map; unlockJurisdiction(); }
+
+    /// Hold while changing the contents of the JurisdictionMap we were given so we never send a half updated map.
+    void lockJurisdiction() { _jurisdictionMutex.lock(); }
+    void unlockJurisdiction() { _jurisdictionMutex.unlock(); }
 
     virtual bool process();
 
@@ -49,6 +53,7 @@ protected:
 
 private:
     QMutex _requestingNodeMutex;
+    QMutex _jurisdictionMutex;
     JurisdictionMap* _jurisdictionMap;
     std::queue<QUuid> _nodesRequestingJurisdictions;
     NodeType_t _nodeType;
@@ -24,6 +24,7 @@
 #include <GeometryUtil.h>
 #include <OctalCode.h>
 #include <PacketHeaders.h>
+#include <ParallelBatch.h>
 #include <SharedUtil.h>
 #include <Shape.h>
 #include <ShapeCollider.h>
@@ -33,6 +34,7 @@
 #include "CoverageMap.h"
 #include "OctreeConstants.h"
 #include "OctreeElementBag.h"
+#include "OctreeElementIndex.h"
 #include "Octree.h"
 #include "ViewFrustum.h"
 
@@ -42,6 +44,7 @@ float boundaryDistanceForRenderLevel(unsigned int renderLevel, float voxelSizeSc
 
 Octree::Octree(bool shouldReaverage) :
     _rootElement(NULL),
+    _elementIndex(NULL),
     _isDirty(true),
     _shouldReaverage(shouldReaverage),
     _stopImport(false),
@@ -54,6 +57,16 @@ Octree::Octree(bool shouldReaverage) :
 Octree::~Octree() {
     // This will delete all children, don't create a new root in this case.
     eraseAllOctreeElements(false);
+    delete _elementIndex;
+}
+
+void Octree::setUseElementIndex(bool useElementIndex) {
+    if (useElementIndex && !_elementIndex) {
+        _elementIndex = new OctreeElementIndex();
+    } else if (!useElementIndex && _elementIndex) {
+        delete _elementIndex;
+        _elementIndex = NULL;
+    }
 }
 
 // Recurses voxel tree calling the RecurseOctreeOperation function for each element.
@@ -185,6 +198,28 @@ OctreeElement* Octree::nodeForOctalCode(OctreeElement* ancestorElement,
         return _rootElement;
     }
 
+    // searches from the root can start from the index, either at the element itself or at its parent
+    if (_elementIndex && ancestorElement == _rootElement && !parentOfFoundElement && *needleCode > 0) {
+        OctalCodeKey needleKey = OctalCodeKey::fromOctalCode(needleCode);
+        OctreeElement* indexedElement = _elementIndex->find(needleKey);
+        if (indexedElement) {
+            return indexedElement;
+        }
+        // when the parent isn't indexed either, go down from the root without looking in the index again
+        OctreeElement* startElement = _elementIndex->find(needleKey.getParent());
+        OctreeElement* foundElement = nodeForOctalCodeInBranch(startElement ? startElement : _rootElement,
+                                                               needleCode, NULL);
+        if (*foundElement->getOctalCode() == *needleCode) {
+            _elementIndex->insert(foundElement);
+        }
+        return foundElement;
+    }
+
+    return nodeForOctalCodeInBranch(ancestorElement, needleCode, parentOfFoundElement);
+}
+
+OctreeElement* Octree::nodeForOctalCodeInBranch(OctreeElement* ancestorElement,
+                                               const unsigned char* needleCode, OctreeElement** parentOfFoundElement) const {
     // find the appropriate branch index based on this ancestorElement
     if (*needleCode > 0) {
         int branchForNeedle = branchIndexWithDescendant(ancestorElement->getOctalCode(), needleCode);
@@ -203,7 +238,7 @@ OctreeElement* Octree::nodeForOctalCode(OctreeElement* ancestorElement,
                 return childElement;
             } else {
                 // we need to go deeper
-                return nodeForOctalCode(childElement, needleCode, parentOfFoundElement);
+                return nodeForOctalCodeInBranch(childElement, needleCode, parentOfFoundElement);
             }
         }
     }
@@ -425,11 +460,10 @@ void Octree::readBitstreamToTree(const unsigned char * bitstream, unsigned long
 }
 
 void Octree::deleteOctreeElementAt(float x, float y, float z, float s) {
-    unsigned char* octalCode = pointToOctalCode(x,y,z,s);
+    PointOctalCode pointCode(x, y, z, s);
     lockForWrite();
-    deleteOctalCodeFromTree(octalCode);
+    deleteOctalCodeFromTree(pointCode.getOctalCode());
     unlock();
-    delete[] octalCode; // cleanup memory
 }
 
 class DeleteOctalCodeFromTreeArgs {
@@ -546,6 +580,9 @@ void Octree::deleteOctalCodeFromTreeRecursion(OctreeElement* element, void* extr
 }
 
 void Octree::eraseAllOctreeElements(bool createNewRoot) {
+    if (_elementIndex) {
+        _elementIndex->clear();
+    }
     delete _rootElement; // this will recurse and delete all children
     if (createNewRoot) {
         _rootElement = createNewElement();
@@ -624,13 +661,34 @@ void Octree::reaverageOctreeElements(OctreeElement* startElement) {
     }
 }
 
+// The octal code of a point. It's written into a buffer on the stack when it fits in a key, so lookups by position
+// don't allocate, only codes too deep for a key go on the heap.
+class PointOctalCode {
+public:
+    PointOctalCode(float x, float y, float z, float s) : _key(OctalCodeKey::fromPoint(x, y, z, s)), _allocatedCode(NULL) {
+        if (_key.isValid()) {
+            _key.writeOctalCode(_codeBuffer);
+        } else {
+            _allocatedCode = pointToOctalCode(x, y, z, s);
+        }
+    }
+    ~PointOctalCode() { delete[] _allocatedCode; }
+
+    const unsigned char* getOctalCode() const { return _allocatedCode ? _allocatedCode : _codeBuffer; }
+
+private:
+    OctalCodeKey _key;
+    unsigned char _codeBuffer[MAX_OCTAL_CODE_KEY_BYTES];
+    unsigned char* _allocatedCode;
+};
+
 OctreeElement* Octree::getOctreeElementAt(float x, float y, float z, float s) const {
-    unsigned char* octalCode = pointToOctalCode(x,y,z,s);
+    PointOctalCode pointCode(x, y, z, s);
+    const unsigned char* octalCode = pointCode.getOctalCode();
     OctreeElement* element = nodeForOctalCode(_rootElement, octalCode, NULL);
     if (*element->getOctalCode() != *octalCode) {
         element = NULL;
     }
-    delete[] octalCode; // cleanup memory
 #ifdef HAS_AUDIT_CHILDREN
     if (element) {
         element->auditChildren("Octree::getOctreeElementAt()");
@@ -640,10 +698,9 @@ OctreeElement* Octree::getOctreeElementAt(float x, float y, float z, float s) co
 }
 
 OctreeElement* Octree::getOctreeEnclosingElementAt(float x, float y, float z, float s) const {
-    unsigned char* octalCode = pointToOctalCode(x,y,z,s);
-    OctreeElement* element = nodeForOctalCode(_rootElement, octalCode, NULL);
-    
-    delete[] octalCode; // cleanup memory
+    PointOctalCode pointCode(x, y, z, s);
+    OctreeElement* element = nodeForOctalCode(_rootElement, pointCode.getOctalCode(), NULL);
+
 #ifdef HAS_AUDIT_CHILDREN
     if (element) {
         element->auditChildren("Octree::getOctreeElementAt()");
@@ -654,6 +711,15 @@ OctreeElement* Octree::getOctreeEnclosingElementAt(float x, float y, float z, fl
 
 
 OctreeElement* Octree::getOrCreateChildElementAt(float x, float y, float z, float s) {
+    if (_elementIndex) {
+        OctalCodeKey key = OctreeElementIndex::keyForPoint(x, y, z, s);
+        OctreeElement* element = _elementIndex->find(key);
+        if (!element) {
+            element = getRoot()->getOrCreateChildElementAt(x, y, z, s);
+            _elementIndex->insert(element);
+        }
+        return element;
+    }
     return getRoot()->getOrCreateChildElementAt(x, y, z, s);
 }
 
@@ -715,6 +781,132 @@ bool Octree::findRayIntersection(const glm::vec3& origin, const glm::vec3& direc
     return args.found;
 }
 
+// the rays of a packet go through the tree together, a bit for each of them says if it is still searching
+typedef quint32 RayPacketMask;
+const int RAYS_PER_PACKET = 32;
+
+// batches smaller than this are done on the calling thread, handing them off would cost more than it saves
+const int MIN_RAY_PACKETS_FOR_THREAD_POOL = 4;
+
+// the rays are sorted by the octant they head into and then by the cell of a coarse grid they start in
+const int RAY_ORDER_CELLS_PER_AXIS = 16;
+
+static void findRayPacketIntersections(OctreeElement* element, OctreeRayQuery** rays, const glm::vec3* scaledOrigins,
+                                       RayPacketMask searchingRays, int recursionCount) {
+    if (recursionCount > DANGEROUSLY_DEEP_RECURSION) {
+        qDebug() << "findRayPacketIntersections() reached DANGEROUSLY_DEEP_RECURSION, bailing!";
+        return;
+    }
+
+    // every ray does exactly what findRayIntersectionOp() would have done for it here, and the rays that would have
+    // stopped recursing at this element are left out below it
+    RayPacketMask childRays = 0;
+    for (int i = 0; i < RAYS_PER_PACKET && (searchingRays >> i); i++) {
+        if (!(searchingRays & (1u << i))) {
+            continue;
+        }
+        OctreeRayQuery& ray = *rays[i];
+        bool keepSearching = true;
+        if (element->findRayIntersection(scaledOrigins[i], ray.direction, keepSearching,
+                                         ray.element, ray.distance, ray.face, &ray.intersectedObject)) {
+            ray.intersects = true;
+        }
+        if (keepSearching) {
+            childRays |= (1u << i);
+        }
+    }
+
+    if (childRays) {
+        for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+            OctreeElement* child = element->getChildAtIndex(i);
+            if (child) {
+                findRayPacketIntersections(child, rays, scaledOrigins, childRays, recursionCount + 1);
+            }
+        }
+    }
+}
+
+// a batch of rays sorted into packets, each packet is an item of the batch
+class RayBatch : public ParallelBatch {
+public:
+    OctreeElement* root;
+    QVector<OctreeRayQuery*> rays;
+    QVector<glm::vec3> scaledOrigins;
+
+protected:
+    virtual void runItem(int packet) {
+        int firstRay = packet * RAYS_PER_PACKET;
+        int rayCount = qMin(RAYS_PER_PACKET, rays.size() - firstRay);
+        RayPacketMask packetRays = (rayCount == RAYS_PER_PACKET) ? ~(RayPacketMask)0 : ((1u << rayCount) - 1);
+
+        findRayPacketIntersections(root, rays.data() + firstRay, scaledOrigins.data() + firstRay, packetRays, 0);
+    }
+};
+
+static int rayOrderKey(const OctreeRayQuery& ray, const glm::vec3& scaledOrigin) {
+    int octant = (ray.direction.x < 0.0f ? 4 : 0) | (ray.direction.y < 0.0f ? 2 : 0) | (ray.direction.z < 0.0f ? 1 : 0);
+    glm::vec3 cell = glm::clamp(scaledOrigin * (float)RAY_ORDER_CELLS_PER_AXIS,
+                                0.0f, (float)(RAY_ORDER_CELLS_PER_AXIS - 1));
+    return ((octant * RAY_ORDER_CELLS_PER_AXIS + (int)cell.x) * RAY_ORDER_CELLS_PER_AXIS + (int)cell.y)
+        * RAY_ORDER_CELLS_PER_AXIS + (int)cell.z;
+}
+
+bool Octree::findRayIntersections(QVector<OctreeRayQuery>& rays, Octree::lockType lockType, bool* accurateResult) {
+    for (int i = 0; i < rays.size(); i++) {
+        rays[i].intersects = false;
+        rays[i].distance = FLT_MAX;
+    }
+
+    bool gotLock = false;
+    if (lockType == Octree::Lock) {
+        lockForRead();
+        gotLock = true;
+    } else if (lockType == Octree::TryLock) {
+        gotLock = tryLockForRead();
+        if (!gotLock) {
+            if (accurateResult) {
+                *accurateResult = false; // if user asked to accuracy or result, let them know this is inaccurate
+            }
+            return false; // if we wanted to tryLock, and we couldn't then just bail...
+        }
+    }
+
+    // rays that start close together heading the same way visit mostly the same elements, so sorting them into packets
+    // like that lets each packet share most of its trip through the tree
+    QVector<QPair<int, int> > order(rays.size());
+    for (int i = 0; i < rays.size(); i++) {
+        order[i] = qMakePair(rayOrderKey(rays[i], rays[i].origin / (float)TREE_SCALE), i);
+    }
+    qSort(order);
+
+    RayBatch* batch = new RayBatch();
+    SharedParallelBatchPointer sharedBatch(batch);
+    batch->root = _rootElement;
+    batch->rays.resize(rays.size());
+    batch->scaledOrigins.resize(rays.size());
+    for (int i = 0; i < order.size(); i++) {
+        OctreeRayQuery& ray = rays[order[i].second];
+        batch->rays[i] = &ray;
+        batch->scaledOrigins[i] = ray.origin / (float)TREE_SCALE;
+    }
+    int packetCount = (rays.size() + RAYS_PER_PACKET - 1) / RAYS_PER_PACKET;
+    ParallelBatch::runInThreadPool(sharedBatch, packetCount, packetCount >= MIN_RAY_PACKETS_FOR_THREAD_POOL);
+
+    if (gotLock) {
+        unlock();
+    }
+
+    if (accurateResult) {
+        *accurateResult = true; // if user asked to accuracy or result, let them know this is accurate
+    }
+
+    bool found = false;
+    for (int i = 0; i < rays.size() && !found; i++) {
+        found = rays[i].intersects;
+    }
+    return found;
+}
+
 class SphereArgs {
 public:
     glm::vec3 center;
@@ -1042,14 +1234,17 @@ int Octree::encodeTreeBitstream(OctreeElement* element,
     bool roomForOctalCode = false; // assume the worst
     int codeLength = 1; // assume root
     if (params.chopLevels) {
-        unsigned char* newCode = chopOctalCode(element->getOctalCode(), params.chopLevels);
-        roomForOctalCode = packetData->startSubTree(newCode);
-
-        if (newCode) {
-            delete newCode;
-            codeLength = numberOfThreeBitSectionsInCode(newCode);
+        // chopping the key doesn't allocate, only codes too deep for a key are chopped in their byte form
+        OctalCodeKey choppedKey = element->getOctalCodeKey().getChopped(params.chopLevels);
+        if (choppedKey.isValid()) {
+            unsigned char choppedCode[MAX_OCTAL_CODE_KEY_BYTES];
+            codeLength = choppedKey.writeOctalCode(choppedCode);
+            roomForOctalCode = packetData->startSubTree(choppedCode);
         } else {
-            codeLength = 1;
+            unsigned char* newCode = chopOctalCode(element->getOctalCode(), params.chopLevels);
+            roomForOctalCode = packetData->startSubTree(newCode);
+            codeLength = newCode ? bytesRequiredForCodeLength(numberOfThreeBitSectionsInCode(newCode)) : 1;
+            delete[] newCode;
         }
     } else {
         roomForOctalCode = packetData->startSubTree(element->getOctalCode());
@@ -1073,10 +1268,15 @@ int Octree::encodeTreeBitstream(OctreeElement* element,
         params.stats->traversed(element);
     }
 
-    ViewFrustum::location parentLocationThisView = ViewFrustum::INTERSECT; // assume parent is in view, but not fully
+    // the recursion works out where the children are from where the element is, all at once
+    unsigned char planeMaskThisView = NO_FRUSTUM_PLANES_INSIDE;
+    ViewFrustum::location locationThisView = ViewFrustum::INSIDE; // no view frustum means everything is in view
+    if (params.viewFrustum) {
+        locationThisView = element->inFrustum(*params.viewFrustum, planeMaskThisView);
+    }
 
     int childBytesWritten = encodeTreeBitstreamRecursion(element, packetData, bag, params,
-                                                            currentEncodeLevel, parentLocationThisView);
+                                                            currentEncodeLevel, locationThisView, planeMaskThisView);
 
 
     // if childBytesWritten == 1 then something went wrong... that's not possible
@@ -1110,7 +1310,8 @@ int Octree::encodeTreeBitstream(OctreeElement* element,
 int Octree::encodeTreeBitstreamRecursion(OctreeElement* element,
                                             OctreePacketData* packetData, OctreeElementBag& bag,
                                             EncodeBitstreamParams& params, int& currentEncodeLevel,
-                                            const ViewFrustum::location& parentLocationThisView) const {
+                                            ViewFrustum::location locationThisView,
+                                            unsigned char planeMaskThisView) const {
 
 
     const bool wantDebug = false;
@@ -1166,12 +1367,8 @@ int Octree::encodeTreeBitstreamRecursion(OctreeElement* element,
             return bytesAtThisLevel;
         }
 
-        // if the parent isn't known to be INSIDE, then it must be INTERSECT, and we should double check to see
-        // if we are INSIDE, INTERSECT, or OUTSIDE
-        if (parentLocationThisView != ViewFrustum::INSIDE) {
-            assert(parentLocationThisView != ViewFrustum::OUTSIDE); // we shouldn't be here if our parent was OUTSIDE!
-            nodeLocationThisView = element->inFrustum(*params.viewFrustum);
-        }
+        // our caller already knows if we are INSIDE, INTERSECT, or OUTSIDE, it found out for all our siblings at once
+        nodeLocationThisView = locationThisView;
 
         // If we're at a element that is out of view, then we can return, because no nodes below us will be in view!
         // although technically, we really shouldn't ever be here, because our callers shouldn't be calling us if
@@ -1344,18 +1541,27 @@ int Octree::encodeTreeBitstreamRecursion(OctreeElement* element,
         }
     }
 
+    // if we intersect the view, find out where all of our children are in one go, only testing them against the planes
+    // we aren't already completely inside of. If we're fully in view, or no view frustum was given, then we can assume
+    // ALL children are in view.
+    ViewFrustum::location childLocationsThisView[NUMBER_OF_CHILDREN];
+    unsigned char childPlaneMasksThisView[NUMBER_OF_CHILDREN];
+    if (params.viewFrustum && nodeLocationThisView == ViewFrustum::INTERSECT) {
+        element->childrenInFrustum(*params.viewFrustum, planeMaskThisView, childLocationsThisView, childPlaneMasksThisView);
+    } else {
+        for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+            childLocationsThisView[i] = ViewFrustum::INSIDE;
+            childPlaneMasksThisView[i] = ALL_FRUSTUM_PLANES_INSIDE;
+        }
+    }
+
     // for each child element in Distance sorted order..., check to see if they exist, are colored, and in view, and if so
     // add them to our distance ordered array of children
     for (int i = 0; i < currentCount; i++) {
         OctreeElement* childElement = sortedChildren[i];
         int originalIndex = indexOfChildren[i];
 
-        bool childIsInView  = (childElement && 
-                ( !params.viewFrustum || // no view frustum was given, everything is assumed in view
-                  (nodeLocationThisView == ViewFrustum::INSIDE) || // parent was fully in view, we can assume ALL children are
-                  (nodeLocationThisView == ViewFrustum::INTERSECT && 
-                        childElement->isInView(*params.viewFrustum)) // the parent intersects and the child is in view
-                ));
+        bool childIsInView = (childElement && childLocationsThisView[originalIndex] != ViewFrustum::OUTSIDE);
 
         if (!childIsInView) {
             // must check childElement here, because it could be we got here because there was no childElement
@@ -1673,7 +1879,8 @@ int Octree::encodeTreeBitstreamRecursion(OctreeElement* element,
                     // will be true. But if the tree has already been encoded, we will skip this.
                     if (element->shouldRecurseChildTree(originalIndex, params)) {
                         childTreeBytesOut = encodeTreeBitstreamRecursion(childElement, packetData, bag, params,
-                                                                                thisLevel, nodeLocationThisView);
+                                                                         thisLevel, childLocationsThisView[originalIndex],
+                                                                         childPlaneMasksThisView[originalIndex]);
                     } else {
                         childTreeBytesOut = 0;
                     }
@@ -12,6 +12,7 @@
 #ifndef hifi_Octree_h
 #define hifi_Octree_h
 
+#include <cfloat>
 #include <set>
 #include <SimpleMovingAverage.h>
 
@@ -20,6 +21,7 @@ class ReadBitstreamToTreeParams;
 class Octree;
 class OctreeElement;
 class OctreeElementBag;
+class OctreeElementIndex;
 class OctreePacketData;
 class Shape;
 
@@ -36,6 +38,7 @@ class Shape;
 #include <QHash>
 #include <QObject>
 #include <QReadWriteLock>
+#include <QVector>
 
 /// derive from this class to use the Octree::recurseTreeWithOperator() method
 class RecurseOctreeOperator {
@@ -50,6 +53,9 @@ typedef bool (*RecurseOctreeOperation)(OctreeElement* element, void* extraData);
 typedef enum {GRADIENT, RANDOM, NATURAL} creationMode;
 typedef QHash<uint, AACube> CubeList;
 
+/// the key of a cube in a CubeList, made from its center
+uint qHash(const glm::vec3& point);
+
 const bool NO_EXISTS_BITS         = false;
 const bool WANT_EXISTS_BITS       = true;
 const bool NO_COLOR               = false;
@@ -213,6 +219,29 @@ public:
     {}
 };
 
+/// one ray of a batch for Octree::findRayIntersections(), along with what it hit once the batch is done
+class OctreeRayQuery {
+public:
+    glm::vec3 origin;
+    glm::vec3 direction;
+
+    bool intersects;
+    OctreeElement* element;
+    float distance;
+    BoxFace face;
+    void* intersectedObject; /// the type is defined by the type of Octree, the caller is assumed to know the type
+
+    OctreeRayQuery(const glm::vec3& origin = glm::vec3(), const glm::vec3& direction = glm::vec3()) :
+        origin(origin),
+        direction(direction),
+        intersects(false),
+        element(NULL),
+        distance(FLT_MAX),
+        face(UNKNOWN_FACE),
+        intersectedObject(NULL)
+    {}
+};
+
 class Octree : public QObject {
     Q_OBJECT
 public:
@@ -232,7 +261,18 @@ public:
     virtual bool handlesEditPacketType(PacketType packetType) const { return false; }
     virtual int processEditPacketData(PacketType packetType, const unsigned char* packetData, int packetLength,
                     const unsigned char* editData, int maxLength, const SharedNodePointer& sourceNode) { return 0; }
-                    
+
+    /// Trees that can decode the edits in a packet before processEditPacketData() is called for them return true here,
+    /// and the server then calls decodeEditPacket() for each packet of a burst without the tree lock, on several threads.
+    /// editDataOffset is where the first edit starts, processEditPacketData() gets pointers into the same packet data.
+    virtual bool canDecodeEditPacketsAhead() const { return false; }
+    virtual void decodeEditPacket(PacketType packetType, const QByteArray& packet, int editDataOffset) { }
+
+    /// Called around a burst of edit packets applied under one write lock. A tree can hold back work it only needs to do
+    /// once for the whole burst, as long as it is done by the time finishEditBurst() returns.
+    virtual void startEditBurst() { }
+    virtual void finishEditBurst() { }
+
     virtual bool recurseChildrenWithData() const { return true; }
     virtual bool rootElementHasData() const { return false; }
     virtual int minimumRequiredRootDataBytes() const { return 0; }
@@ -269,6 +309,11 @@ public:
     OctreeElement* getOrCreateChildElementAt(float x, float y, float z, float s);
     OctreeElement* getOrCreateChildElementContaining(const AACube& box);
 
+    /// When enabled, elements found by octal code or by point are remembered in a hash index, so that finding them
+    /// again doesn't go down from the root. The index is off by default.
+    void setUseElementIndex(bool useElementIndex);
+    bool getUseElementIndex() const { return _elementIndex != NULL; }
+
     void recurseTreeWithOperation(RecurseOctreeOperation operation, void* extraData = NULL);
     void recurseTreeWithPostOperation(RecurseOctreeOperation operation, void* extraData = NULL);
 
@@ -302,16 +347,23 @@ public:
                              void** intersectedObject = NULL,
                              Octree::lockType lockType = Octree::TryLock, bool* accurateResult = NULL);
 
-    bool findSpherePenetration(const glm::vec3& center, float radius, glm::vec3& penetration, void** penetratedObject = NULL, 
+    /// finds what each ray of a batch hits, with the same results as calling findRayIntersection() for each of them. The
+    /// rays are grouped into packets of rays heading the same way from nearby, and each packet goes through the tree only
+    /// once. Large batches are spread over the global thread pool. Returns true if any of the rays intersected.
+    bool findRayIntersections(QVector<OctreeRayQuery>& rays,
+                              Octree::lockType lockType = Octree::TryLock, bool* accurateResult = NULL);
+
+    virtual bool findSpherePenetration(const glm::vec3& center, float radius, glm::vec3& penetration,
+                                    void** penetratedObject = NULL,
                                     Octree::lockType lockType = Octree::TryLock, bool* accurateResult = NULL);
 
-    bool findCapsulePenetration(const glm::vec3& start, const glm::vec3& end, float radius, glm::vec3& penetration, 
+    virtual bool findCapsulePenetration(const glm::vec3& start, const glm::vec3& end, float radius, glm::vec3& penetration, 
                                     Octree::lockType lockType = Octree::TryLock, bool* accurateResult = NULL);
 
-    bool findShapeCollisions(const Shape* shape, CollisionList& collisions, 
+    virtual bool findShapeCollisions(const Shape* shape, CollisionList& collisions, 
                                     Octree::lockType = Octree::TryLock, bool* accurateResult = NULL);
 
-    bool findContentInCube(const AACube& cube, CubeList& cubes);
+    virtual bool findContentInCube(const AACube& cube, CubeList& cubes);
 
     OctreeElement* getElementEnclosingPoint(const glm::vec3& point, 
                                     Octree::lockType lockType = Octree::TryLock, bool* accurateResult = NULL);
@@ -369,16 +421,19 @@ protected:
     int encodeTreeBitstreamRecursion(OctreeElement* element,
                                      OctreePacketData* packetData, OctreeElementBag& bag,
                                      EncodeBitstreamParams& params, int& currentEncodeLevel,
-                                     const ViewFrustum::location& parentLocationThisView) const;
+                                     ViewFrustum::location locationThisView, unsigned char planeMaskThisView) const;
 
     static bool countOctreeElementsOperation(OctreeElement* element, void* extraData);
 
     OctreeElement* nodeForOctalCode(OctreeElement* ancestorElement, const unsigned char* needleCode, OctreeElement** parentOfFoundElement) const;
+    OctreeElement* nodeForOctalCodeInBranch(OctreeElement* ancestorElement, const unsigned char* needleCode,
+                                            OctreeElement** parentOfFoundElement) const;
     OctreeElement* createMissingElement(OctreeElement* lastParentElement, const unsigned char* codeToReach);
     int readElementData(OctreeElement *destinationElement, const unsigned char* nodeData,
                 int bufferSizeBytes, ReadBitstreamToTreeParams& args);
 
     OctreeElement* _rootElement;
+    OctreeElementIndex* _elementIndex;
 
     bool _isDirty;
     bool _shouldReaverage;
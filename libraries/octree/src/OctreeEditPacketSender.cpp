@@ -18,16 +18,20 @@
 #include "OctreeEditPacketSender.h"
 
 const int OctreeEditPacketSender::DEFAULT_MAX_PENDING_MESSAGES = PacketSender::DEFAULT_PACKETS_PER_SECOND;
+const quint64 OctreeEditPacketSender::DEFAULT_EDIT_COALESCING_WINDOW_USECS = 33 * USECS_PER_MSEC;
 
 
 OctreeEditPacketSender::OctreeEditPacketSender() :
     PacketSender(),
     _shouldSend(true),
     _maxPendingMessages(DEFAULT_MAX_PENDING_MESSAGES),
-    _releaseQueuedMessagesPending(false),
+    _releaseQueuedMessagesPending(0),
     _serverJurisdictions(NULL),
     _maxPacketSize(MAX_PACKET_SIZE),
-    _destinationWalletUUID()
+    _destinationWalletUUID(),
+    _editCoalescingWindowUsecs(DEFAULT_EDIT_COALESCING_WINDOW_USECS),
+    _firstCoalescedEditAt(0),
+    _coalescedEditCount(0)
 {
     
 }
@@ -155,9 +159,8 @@ void OctreeEditPacketSender::processPreServerExistsPackets() {
 
     // if while waiting for the jurisdictions the caller called releaseQueuedMessages()
     // then we want to honor that request now.
-    if (_releaseQueuedMessagesPending) {
+    if (_releaseQueuedMessagesPending.testAndSetOrdered(1, 0)) {
         releaseQueuedMessages();
-        _releaseQueuedMessagesPending = false;
     }
 }
 
@@ -257,6 +260,10 @@ void OctreeEditPacketSender::queueOctreeEditMessage(PacketType type, unsigned ch
             
             if (type == PacketTypeEntityErase) {
                 isMyJurisdiction = true; // send erase messages to all servers
+            } else if (numberOfThreeBitSectionsInCode(editPacketBuffer) == 0) {
+                // edits addressed to the root don't say where they land (entities use this for edits to existing
+                // items, which only the server holding the item will apply) so they also go to all servers
+                isMyJurisdiction = true;
             } else if (_serverJurisdictions) {
                 // we need to get the jurisdiction for this
                 // here we need to get the "pending packet" for this server
@@ -285,15 +292,18 @@ void OctreeEditPacketSender::queueOctreeEditMessage(PacketType type, unsigned ch
                     initializePacket(packetBuffer, type);
                 }
 
+                unsigned char* editMessageAt = &packetBuffer._currentBuffer[packetBuffer._currentSize];
+                memcpy(editMessageAt, editPacketBuffer, length);
+
                 // This is really the first time we know which server/node this particular edit message
                 // is going to, so we couldn't adjust for clock skew till now. But here's our chance.
                 // We call this virtual function that allows our specific type of EditPacketSender to
-                // fixup the buffer for any clock skew
+                // fixup the buffer for any clock skew. We fix up our copy, since the same message may be
+                // going to several servers that each have their own skew.
                 if (node->getClockSkewUsec() != 0) {
-                    adjustEditPacketForClockSkew(type, editPacketBuffer, length, node->getClockSkewUsec());
+                    adjustEditPacketForClockSkew(type, editMessageAt, length, node->getClockSkewUsec());
                 }
 
-                memcpy(&packetBuffer._currentBuffer[packetBuffer._currentSize], editPacketBuffer, length);
                 packetBuffer._currentSize += length;
                 packetBuffer._satoshiCost += satoshiCost;
             }
@@ -305,11 +315,14 @@ void OctreeEditPacketSender::queueOctreeEditMessage(PacketType type, unsigned ch
 }
 
 void OctreeEditPacketSender::releaseQueuedMessages() {
+    // held edits whose window has passed go out with this release, the rest wait for a later edit to merge with
+    packExpiredCoalescedEdits();
+
     // if we don't yet have jurisdictions then we can't actually release messages yet because we don't
     // know where to send them to. Instead, just remember this request and when we eventually get jurisdictions
     // call release again at that time.
     if (!serversExist()) {
-        _releaseQueuedMessagesPending = true;
+        _releaseQueuedMessagesPending.storeRelease(1);
     } else {
         _packetsQueueLock.lock();
         for (QHash<QUuid, EditPacketBuffer>::iterator i = _pendingEditPackets.begin(); i != _pendingEditPackets.end(); i++) {
@@ -355,10 +368,37 @@ bool OctreeEditPacketSender::process() {
         processPreServerExistsPackets();
     }
 
+    // held edits shouldn't wait on the caller to release them, some callers never do
+    if (packExpiredCoalescedEdits()) {
+        releaseQueuedMessages();
+    }
+
     // base class does most of the work.
     return PacketSender::process();
 }
 
+void OctreeEditPacketSender::coalescedEditHeld() {
+    if (_firstCoalescedEditAt == 0) {
+        _firstCoalescedEditAt = usecTimestampNow();
+    }
+}
+
+void OctreeEditPacketSender::flushCoalescedEdits() {
+    if (_firstCoalescedEditAt != 0) {
+        packCoalescedEdits();
+        _firstCoalescedEditAt = 0;
+    }
+}
+
+bool OctreeEditPacketSender::packExpiredCoalescedEdits() {
+    QMutexLocker locker(&_coalescedEditsLock);
+    if (_firstCoalescedEditAt == 0 || usecTimestampNow() - _firstCoalescedEditAt < _editCoalescingWindowUsecs) {
+        return false;
+    }
+    flushCoalescedEdits();
+    return true;
+}
+
 void OctreeEditPacketSender::processNackPacket(const QByteArray& packet) {
     // parse sending node from packet, retrieve packet history for that node
     QUuid sendingNodeUUID = uuidFromPacketHeader(packet);
@@ -13,6 +13,7 @@
 #define hifi_OctreeEditPacketSender_h
 
 #include <qqueue.h>
+#include <QAtomicInt>
 #include <PacketSender.h>
 #include <PacketHeaders.h>
 
@@ -79,6 +80,17 @@ public:
     /// returns the current desired max packet size in bytes that the OctreeEditPacketSender will create
     int getMaxPacketSize() const { return _maxPacketSize; }
 
+    /// Set how long, in usecs, edits that can be merged with later edits to the same item are held before they are packed.
+    /// Zero turns coalescing off and every edit is packed as soon as it is queued.
+    void setEditCoalescingWindow(quint64 editCoalescingWindowUsecs) { _editCoalescingWindowUsecs = editCoalescingWindowUsecs; }
+    quint64 getEditCoalescingWindow() const { return _editCoalescingWindowUsecs; }
+
+    // the default time edits are held for coalescing, about two frames
+    static const quint64 DEFAULT_EDIT_COALESCING_WINDOW_USECS;
+
+    /// the number of edits that were merged into a later edit to the same item instead of being sent
+    int getCoalescedEditCount() const { return _coalescedEditCount.load(); }
+
     // you must override these...
     virtual char getMyNodeType() const = 0;
     virtual void adjustEditPacketForClockSkew(PacketType type, 
@@ -106,12 +118,25 @@ protected:
     
     void processPreServerExistsPackets();
 
+    /// Packs the edits a subclass is holding for coalescing with queueOctreeEditMessage() and forgets them. Called
+    /// with _coalescedEditsLock held, subclasses that hold edits must override this.
+    virtual void packCoalescedEdits() { }
+
+    /// call with _coalescedEditsLock held after starting to hold an edit for coalescing, starts the window if needed
+    void coalescedEditHeld();
+
+    /// call with _coalescedEditsLock held to pack everything held now, regardless of the window
+    void flushCoalescedEdits();
+
+    /// packs the held edits if the coalescing window has passed, returns true if it did
+    bool packExpiredCoalescedEdits();
+
     // These are packets which are destined from know servers but haven't been released because they're still too small
     QHash<QUuid, EditPacketBuffer> _pendingEditPackets;
     
     // These are packets that are waiting to be processed because we don't yet know if there are servers
     int _maxPendingMessages;
-    bool _releaseQueuedMessagesPending;
+    QAtomicInt _releaseQueuedMessagesPending; // set by the caller's thread, cleared by the one that finds the servers
     QMutex _pendingPacketsLock;
     QMutex _packetsQueueLock; // don't let different threads release the queue while another thread is writing to it
     QVector<EditPacketBuffer*> _preServerPackets; // these will get packed into other larger packets
@@ -128,5 +153,10 @@ protected:
     QHash<QUuid, quint16> _outgoingSequenceNumbers;
     
     QUuid _destinationWalletUUID;
+
+    QMutex _coalescedEditsLock; // taken before _packetsQueueLock, never after
+    quint64 _editCoalescingWindowUsecs;
+    quint64 _firstCoalescedEditAt; // when the oldest held edit was held, 0 if nothing is held
+    QAtomicInt _coalescedEditCount; // counted under _coalescedEditsLock, read from any thread
 };
 #endif // hifi_OctreeEditPacketSender_h
@@ -1211,6 +1211,20 @@ ViewFrustum::location OctreeElement::inFrustum(const ViewFrustum& viewFrustum) c
     return viewFrustum.cubeInFrustum(cube);
 }
 
+ViewFrustum::location OctreeElement::inFrustum(const ViewFrustum& viewFrustum, unsigned char& planeMask) const {
+    AACube cube = _cube; // use temporary cube so we can scale it
+    cube.scale(TREE_SCALE);
+    return viewFrustum.cubeInFrustum(cube, planeMask);
+}
+
+void OctreeElement::childrenInFrustum(const ViewFrustum& viewFrustum, unsigned char planeMask,
+                                      ViewFrustum::location childLocations[NUMBER_OF_CHILDREN],
+                                      unsigned char childPlaneMasks[NUMBER_OF_CHILDREN]) const {
+    AACube cube = _cube; // use temporary cube so we can scale it
+    cube.scale(TREE_SCALE);
+    viewFrustum.childrenInFrustum(cube, planeMask, childLocations, childPlaneMasks);
+}
+
 // There are two types of nodes for which we want to "render"
 // 1) Leaves that are in the LOD
 // 2) Non-leaves are more complicated though... usually you don't want to render them, but if their children
@@ -19,6 +19,7 @@
 #include <QReadWriteLock>
 
 #include <OctalCode.h>
+#include <OctalCodeKey.h>
 #include <SharedUtil.h>
 
 #include "AACube.h"
@@ -134,6 +135,7 @@ public:
 
     // Base class methods you don't need to implement
     const unsigned char* getOctalCode() const { return (_octcodePointer) ? _octalCode.pointer : &_octalCode.buffer[0]; }
+    OctalCodeKey getOctalCodeKey() const { return OctalCodeKey::fromOctalCode(getOctalCode()); }
     OctreeElement* getChildAtIndex(int childIndex) const;
     void deleteChildAtIndex(int childIndex);
     OctreeElement* removeChildAtIndex(int childIndex);
@@ -151,6 +153,12 @@ public:
     float getEnclosingRadius() const;
     bool isInView(const ViewFrustum& viewFrustum) const { return inFrustum(viewFrustum) != ViewFrustum::OUTSIDE; }
     ViewFrustum::location inFrustum(const ViewFrustum& viewFrustum) const;
+    ViewFrustum::location inFrustum(const ViewFrustum& viewFrustum, unsigned char& planeMask) const;
+
+    /// finds where all the children of this element are at once, see ViewFrustum::childrenInFrustum()
+    void childrenInFrustum(const ViewFrustum& viewFrustum, unsigned char planeMask,
+                           ViewFrustum::location childLocations[NUMBER_OF_CHILDREN],
+                           unsigned char childPlaneMasks[NUMBER_OF_CHILDREN]) const;
     float distanceToCamera(const ViewFrustum& viewFrustum) const; 
     float furthestDistanceToCamera(const ViewFrustum& viewFrustum) const;
 
@@ -0,0 +1,86 @@
+//
+//  OctreeElementIndex.cpp
+//  libraries/octree/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "OctreeElementIndex.h"
+
+OctreeElementIndex::OctreeElementIndex() {
+    OctreeElement::addDeleteHook(this);
+}
+
+OctreeElementIndex::~OctreeElementIndex() {
+    OctreeElement::removeDeleteHook(this);
+}
+
+OctreeElement* OctreeElementIndex::find(const OctalCodeKey& key) const {
+    if (!key.isValid()) {
+        return NULL;
+    }
+    QMutexLocker locker(&_mutex);
+    return _elements.value(key, NULL);
+}
+
+void OctreeElementIndex::insert(OctreeElement* element) {
+    OctalCodeKey key = element->getOctalCodeKey();
+    if (key.isValid()) {
+        QMutexLocker locker(&_mutex);
+        _elements.insert(key, element);
+    }
+}
+
+void OctreeElementIndex::clear() {
+    QMutexLocker locker(&_mutex);
+    _elements.clear();
+}
+
+int OctreeElementIndex::size() const {
+    QMutexLocker locker(&_mutex);
+    return _elements.size();
+}
+
+void OctreeElementIndex::elementDeleted(OctreeElement* element) {
+    OctalCodeKey key = element->getOctalCodeKey();
+    if (!key.isValid()) {
+        return;
+    }
+    QMutexLocker locker(&_mutex);
+    QHash<OctalCodeKey, OctreeElement*>::iterator found = _elements.find(key);
+    if (found != _elements.end() && found.value() == element) {
+        _elements.erase(found);
+    }
+}
+
+OctalCodeKey OctreeElementIndex::keyForPoint(float x, float y, float z, float s) {
+    // this makes the same choices as OctreeElement::getOrCreateChildElementAt(), an element is the one asked for when
+    // the scale is more than half of the element's, otherwise the point picks the child to go into
+    OctalCodeKey key = OctalCodeKey::root();
+    float scale = 1.0f;
+    float cornerX = 0.0f;
+    float cornerY = 0.0f;
+    float cornerZ = 0.0f;
+    while (s <= scale / 2.0f && key.isValid()) {
+        float halfScale = scale / 2.0f;
+        int childIndex = 0;
+        if (x > cornerX + halfScale) {
+            childIndex |= 4;
+            cornerX += halfScale;
+        }
+        if (y > cornerY + halfScale) {
+            childIndex |= 2;
+            cornerY += halfScale;
+        }
+        if (z > cornerZ + halfScale) {
+            childIndex |= 1;
+            cornerZ += halfScale;
+        }
+        key = key.getChild(childIndex);
+        scale = halfScale;
+    }
+    return key;
+}
@@ -0,0 +1,52 @@
+//
+//  OctreeElementIndex.h
+//  libraries/octree/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_OctreeElementIndex_h
+#define hifi_OctreeElementIndex_h
+
+#include <QHash>
+#include <QMutex>
+
+#include <OctalCodeKey.h>
+
+#include "OctreeElement.h"
+
+/// Maps octal code keys to the elements of one tree, so that an element that was found once can be found again
+/// without going down from the root. Elements are added as lookups find them, and removed through the element delete
+/// hook. The delete hooks are shared by all trees, so an element is only removed if it's the one the index holds.
+class OctreeElementIndex : public OctreeElementDeleteHook {
+public:
+    OctreeElementIndex();
+    ~OctreeElementIndex();
+
+    /// the element with this key, or NULL if it isn't indexed
+    OctreeElement* find(const OctalCodeKey& key) const;
+
+    /// the element with this octal code, or NULL if it isn't indexed
+    OctreeElement* find(const unsigned char* octalCode) const { return find(OctalCodeKey::fromOctalCode(octalCode)); }
+
+    /// adds the element, unless its code is too long to have a key
+    void insert(OctreeElement* element);
+
+    void clear();
+    int size() const;
+
+    virtual void elementDeleted(OctreeElement* element);
+
+    /// the key of the element that OctreeElement::getOrCreateChildElementAt() finds for this point and scale, or
+    /// an invalid key if that element is too deep to have one
+    static OctalCodeKey keyForPoint(float x, float y, float z, float s);
+
+private:
+    mutable QMutex _mutex;
+    QHash<OctalCodeKey, OctreeElement*> _elements;
+};
+
+#endif // hifi_OctreeElementIndex_h
@@ -0,0 +1,183 @@
+//
+//  OctreePacketCompressor.cpp
+//  libraries/octree/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <string.h>
+
+#include <zlib.h>
+
+#include "OctreePacketCompressor.h"
+
+// A section is at most a packet, so a small window is enough to hold the dictionary and the whole section, and keeps
+// the stream of every client's send task small. Decoding uses the largest window so qCompress data still reads.
+const int COMPRESS_WINDOW_BITS = 12;
+const int COMPRESS_MEMORY_LEVEL = 6;
+const int UNCOMPRESS_WINDOW_BITS = MAX_WBITS;
+
+// The dictionary is made of what voxel and entity sections are made of: child masks, runs of colors, common float
+// values and the strings that show up in entity properties. zlib looks for matches from the end of the dictionary first,
+// so the most common sequences are last.
+static const char COMPRESSION_DICTIONARY[] =
+    // entity floats: 0.5, -1, 0.1, 0.01, 2, 10, in vectors
+    "\x00\x00\x00\x3f" "\x00\x00\x80\xbf" "\xcd\xcc\xcc\x3d" "\x0a\xd7\x23\x3c" "\x00\x00\x00\x40" "\x00\x00\x20\x41"
+    "\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x80\x3f" "\x00\x00\x80\x3f\x00\x00\x80\x3f\x00\x00\x80\x3f"
+    // entity strings
+    "animations" "attachments" "Sphere" "Model" "Box" ".svo" ".fst" ".fbx"
+    "https://" "http://public.highfidelity.io/models/" "http://"
+    // voxel colors, greys and the primaries
+    "\x80\x80\x80\x80\x80\x80" "\xff\x00\x00\xff\x00\x00" "\x00\xff\x00\x00\xff\x00" "\x00\x00\xff\x00\x00\xff"
+    "\xff\xff\xff\xff\xff\xff"
+    // voxel child masks, halves and quarters of an element, then full ones
+    "\x0f\xf0\x33\xcc\x55\xaa\x0f\xf0\x33\xcc\x55\xaa" "\x01\x02\x04\x08\x10\x20\x40\x80"
+    "\xff\xff\xff\xff\xff\xff\xff\xff"
+    "\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00";
+
+// sizeof counts the terminator, which isn't part of the dictionary
+const int COMPRESSION_DICTIONARY_SIZE = sizeof(COMPRESSION_DICTIONARY) - 1;
+
+OctreePacketCompressor::OctreePacketCompressor() :
+    _stream(new z_stream),
+    _hasStream(false),
+    _streamCompressionLevel(DEFAULT_COMPRESSION_LEVEL),
+    _compressionLevel(DEFAULT_COMPRESSION_LEVEL),
+    _isActive(false),
+    _overflowed(false),
+    _output(NULL),
+    _maxOutputBytes(0),
+    _bytesIn(0)
+{
+    memset(_stream, 0, sizeof(z_stream));
+}
+
+OctreePacketCompressor::~OctreePacketCompressor() {
+    if (_hasStream) {
+        deflateEnd(_stream);
+    }
+    delete _stream;
+}
+
+bool OctreePacketCompressor::initStream() {
+    if (_hasStream && _streamCompressionLevel == _compressionLevel) {
+        // reusing the stream keeps its buffers, only the dictionary has to be set again
+        return deflateReset(_stream) == Z_OK;
+    }
+    if (_hasStream) {
+        deflateEnd(_stream);
+        _hasStream = false;
+    }
+    memset(_stream, 0, sizeof(z_stream));
+    if (deflateInit2(_stream, _compressionLevel, Z_DEFLATED, COMPRESS_WINDOW_BITS, COMPRESS_MEMORY_LEVEL,
+                     Z_DEFAULT_STRATEGY) != Z_OK) {
+        return false;
+    }
+    _hasStream = true;
+    _streamCompressionLevel = _compressionLevel;
+    return true;
+}
+
+void OctreePacketCompressor::begin(unsigned char* output, int maxOutputBytes) {
+    _output = output;
+    _maxOutputBytes = maxOutputBytes;
+    _bytesIn = 0;
+    _isActive = true;
+    _overflowed = maxOutputBytes <= SIZE_PREFIX_BYTES || !initStream()
+        || deflateSetDictionary(_stream, reinterpret_cast<const Bytef*>(COMPRESSION_DICTIONARY),
+                                COMPRESSION_DICTIONARY_SIZE) != Z_OK;
+    if (!_overflowed) {
+        _stream->next_out = _output + SIZE_PREFIX_BYTES;
+        _stream->avail_out = _maxOutputBytes - SIZE_PREFIX_BYTES;
+    }
+}
+
+bool OctreePacketCompressor::append(const unsigned char* data, int length) {
+    _bytesIn += length;
+    if (_overflowed || length == 0) {
+        return !_overflowed;
+    }
+    _stream->next_in = const_cast<Bytef*>(data);
+    _stream->avail_in = length;
+    while (_stream->avail_in > 0) {
+        if (_stream->avail_out == 0 || deflate(_stream, Z_NO_FLUSH) != Z_OK) {
+            _overflowed = true;
+            break;
+        }
+    }
+    return !_overflowed;
+}
+
+int OctreePacketCompressor::finish() {
+    _isActive = false;
+    if (_overflowed) {
+        return -1;
+    }
+    _stream->next_in = NULL;
+    _stream->avail_in = 0;
+    int status;
+    do {
+        status = deflate(_stream, Z_FINISH);
+    } while (status == Z_OK && _stream->avail_out > 0);
+
+    if (status != Z_STREAM_END) {
+        return -1;
+    }
+
+    // the size prefix is big-endian, like qCompress writes it
+    _output[0] = (_bytesIn >> 24) & 0xFF;
+    _output[1] = (_bytesIn >> 16) & 0xFF;
+    _output[2] = (_bytesIn >> 8) & 0xFF;
+    _output[3] = _bytesIn & 0xFF;
+
+    return SIZE_PREFIX_BYTES + (int)_stream->total_out;
+}
+
+void OctreePacketCompressor::abandon() {
+    if (_isActive && _hasStream) {
+        // forget what the section compressed so far, begin() sets the dictionary again
+        deflateReset(_stream);
+    }
+    _isActive = false;
+    _overflowed = false;
+    _output = NULL;
+    _maxOutputBytes = 0;
+    _bytesIn = 0;
+}
+
+int OctreePacketCompressor::uncompress(const unsigned char* data, int length, unsigned char* output,
+                                       int maxOutputBytes) {
+    if (length <= SIZE_PREFIX_BYTES) {
+        return -1;
+    }
+    int expectedBytes = (data[0] << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
+    if (expectedBytes < 0 || expectedBytes > maxOutputBytes) {
+        return -1;
+    }
+
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    if (inflateInit2(&stream, UNCOMPRESS_WINDOW_BITS) != Z_OK) {
+        return -1;
+    }
+    stream.next_in = const_cast<Bytef*>(data + SIZE_PREFIX_BYTES);
+    stream.avail_in = length - SIZE_PREFIX_BYTES;
+    stream.next_out = output;
+    stream.avail_out = maxOutputBytes;
+
+    int status = inflate(&stream, Z_FINISH);
+    if (status == Z_NEED_DICT) {
+        // sections from OctreePacketCompressor name the dictionary, the ones from qCompress don't
+        if (inflateSetDictionary(&stream, reinterpret_cast<const Bytef*>(COMPRESSION_DICTIONARY),
+                                 COMPRESSION_DICTIONARY_SIZE) == Z_OK) {
+            status = inflate(&stream, Z_FINISH);
+        }
+    }
+    int outputBytes = (int)stream.total_out;
+    inflateEnd(&stream);
+
+    return (status == Z_STREAM_END && outputBytes == expectedBytes) ? outputBytes : -1;
+}
@@ -0,0 +1,76 @@
+//
+//  OctreePacketCompressor.h
+//  libraries/octree/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_OctreePacketCompressor_h
+#define hifi_OctreePacketCompressor_h
+
+// the stream is kept out of the header, so that users of OctreePacketData don't need the zlib headers
+struct z_stream_s;
+
+/// A zlib stream that compresses the content of one octree packet section as it is written, so that finalizing the
+/// section only has to flush what is left instead of compressing the whole section again. The stream is primed with a
+/// dictionary of byte sequences that are common in voxel and entity bitstreams, which helps most on small sections where
+/// zlib hasn't seen enough data to find matches of its own. The output has the same layout as qCompress (a big-endian
+/// uncompressed size followed by the zlib stream), and uncompress reads both.
+class OctreePacketCompressor {
+public:
+    static const int DEFAULT_COMPRESSION_LEVEL = 6;
+
+    OctreePacketCompressor();
+    ~OctreePacketCompressor();
+
+    /// 1 is fastest, 9 compresses best. Takes effect at the next begin()
+    void setCompressionLevel(int level) { _compressionLevel = level; }
+    int getCompressionLevel() const { return _compressionLevel; }
+
+    /// starts a new section, output is written to the buffer given, which must have room for the size prefix
+    void begin(unsigned char* output, int maxOutputBytes);
+
+    /// compresses more of the section, returns false if the output buffer ran out
+    bool append(const unsigned char* data, int length);
+
+    /// flushes the rest of the section, returns the size of the output or -1 if it didn't fit
+    int finish();
+
+    /// drops the section begun last without writing anything, the stream is primed again at the next begin()
+    void abandon();
+
+    /// whether begin() was called and neither finish() nor abandon() were yet
+    bool isActive() const { return _isActive; }
+
+    /// the number of uncompressed bytes appended since begin()
+    int getBytesIn() const { return _bytesIn; }
+
+    /// uncompresses a section written by finish() or by qCompress, returns its size or -1 if it's invalid or bigger
+    /// than maxOutputBytes
+    static int uncompress(const unsigned char* data, int length, unsigned char* output, int maxOutputBytes);
+
+private:
+    static const int SIZE_PREFIX_BYTES = 4;
+
+    // the stream owns zlib's state, there is no sharing it between compressors
+    OctreePacketCompressor(const OctreePacketCompressor&);
+    OctreePacketCompressor& operator=(const OctreePacketCompressor&);
+
+    bool initStream();
+
+    z_stream_s* _stream;
+    bool _hasStream;
+    int _streamCompressionLevel;
+    int _compressionLevel;
+    bool _isActive;
+    bool _overflowed;
+
+    unsigned char* _output;
+    int _maxOutputBytes;
+    int _bytesIn;
+};
+
+#endif // hifi_OctreePacketCompressor_h
@@ -15,6 +15,7 @@
 #include "OctreePacketData.h"
 
 bool OctreePacketData::_debug = false;
+int OctreePacketData::_compressionLevel = OctreePacketCompressor::DEFAULT_COMPRESSION_LEVEL;
 quint64 OctreePacketData::_totalBytesOfOctalCodes = 0;
 quint64 OctreePacketData::_totalBytesOfBitMasks = 0;
 quint64 OctreePacketData::_totalBytesOfColor = 0;
@@ -42,6 +43,10 @@ void OctreePacketData::reset() {
     _compressedBytes = 0;
     _bytesInUseLastCheck = 0;
     _dirty = false;
+    _bytesCompressed = 0;
+    _compressorInSync = true;
+    // a packet that is reset before it was finalized leaves the compressor in the middle of its section
+    _compressor.abandon();
 
     _bytesOfOctalCodes = 0;
     _bytesOfBitMasks = 0;
@@ -123,6 +128,7 @@ bool OctreePacketData::releaseReservedBytes(int numberOfBytes) {
 bool OctreePacketData::updatePriorBitMask(int offset, unsigned char bitmask) {
     bool success = false;
     if (offset >= 0 && offset < _bytesInUse) {
+        uncompressedChangedAt(offset);
         _uncompressed[offset] = bitmask;
         success = true;
         _dirty = true;
@@ -133,6 +139,7 @@ bool OctreePacketData::updatePriorBitMask(int offset, unsigned char bitmask) {
 bool OctreePacketData::updatePriorBytes(int offset, const unsigned char* replacementBytes, int length) {
     bool success = false;
     if (length >= 0 && offset >= 0 && ((offset + length) <= _bytesInUse)) {
+        uncompressedChangedAt(offset);
         if (replacementBytes >= &_uncompressed[offset] && replacementBytes <= &_uncompressed[offset + length]) {
             memmove(&_uncompressed[offset], replacementBytes, length); // copy new content with overlap safety
         } else {
@@ -201,6 +208,18 @@ int OctreePacketData::getFinalizedSize() {
 
 void OctreePacketData::endSubTree() {
     _subTreeAt = _bytesInUse;
+
+    // the subtree won't be discarded anymore, so it can go to the compressor now rather than when the packet is finalized
+    if (_enableCompression && _compressorInSync && _bytesInUse > _bytesCompressed) {
+        quint64 start = usecTimestampNow();
+        if (!_compressor.isActive()) {
+            _compressor.setCompressionLevel(_compressionLevel);
+            _compressor.begin(_compressed, MAX_OCTREE_PACKET_DATA_SIZE - 1);
+        }
+        _compressor.append(&_uncompressed[_bytesCompressed], _bytesInUse - _bytesCompressed);
+        _bytesCompressed = _bytesInUse;
+        _compressContentTime += usecTimestampNow() - start;
+    }
 }
 
 void OctreePacketData::discardSubTree() {
@@ -208,6 +227,7 @@ void OctreePacketData::discardSubTree() {
     _bytesInUse -= bytesInSubTree;
     _bytesAvailable += bytesInSubTree; 
     _subTreeAt = _bytesInUse; // should be the same actually...
+    uncompressedChangedAt(_bytesInUse);
     _dirty = true;
 
     // rewind to start of this subtree, other items rewound by endLevel()
@@ -247,6 +267,7 @@ void OctreePacketData::discardLevel(LevelDetails key) {
             
     _bytesInUse -= bytesInLevel;
     _bytesAvailable += bytesInLevel; 
+    uncompressedChangedAt(_bytesInUse);
     _dirty = true;
     
     // reserved bytes are reset to the value when the level started
@@ -450,19 +471,23 @@ bool OctreePacketData::compressContent() {
     _bytesInUseLastCheck = _bytesInUse;
 
     bool success = false;
-    const int MAX_COMPRESSION = 9;
 
-    // we only want to compress the data payload, not the message header
-    const uchar* uncompressedData = &_uncompressed[0];
-    int uncompressedSize = _bytesInUse;
+    // if everything the compressor has seen is still in the packet only the rest has to be compressed, otherwise the
+    // packet is compressed again from the start
+    if (!(_compressorInSync && _compressor.isActive())) {
+        _compressor.setCompressionLevel(_compressionLevel);
+        _compressor.begin(_compressed, MAX_OCTREE_PACKET_DATA_SIZE - 1);
+        _bytesCompressed = 0;
+    }
+    _compressor.append(&_uncompressed[_bytesCompressed], _bytesInUse - _bytesCompressed);
+    int compressedSize = _compressor.finish();
 
-    QByteArray compressedData = qCompress(uncompressedData, uncompressedSize, MAX_COMPRESSION);
+    // the stream is finished, anything written after this is compressed with the whole packet at the next finalize
+    _bytesCompressed = _bytesInUse;
+    _compressorInSync = false;
 
-    if (compressedData.size() < (int)MAX_OCTREE_PACKET_DATA_SIZE) {
-        _compressedBytes = compressedData.size();
-        for (int i = 0; i < _compressedBytes; i++) {
-            _compressed[i] = compressedData[i];
-        }
+    if (compressedSize > 0) {
+        _compressedBytes = compressedSize;
         _dirty = false;
         success = true;
     }
@@ -476,20 +501,14 @@ void OctreePacketData::loadFinalizedContent(const unsigned char* data, int lengt
     if (data && length > 0) {
 
         if (_enableCompression) {
-            QByteArray compressedData;
-            for (int i = 0; i < length; i++) {
-                compressedData[i] = data[i];
-                _compressed[i] = compressedData[i];
+            if (length <= (int)MAX_OCTREE_PACKET_DATA_SIZE) {
+                memcpy(_compressed, data, length);
+                _compressedBytes = length;
             }
-            _compressedBytes = length;
-            QByteArray uncompressedData = qUncompress(compressedData);
-            if (uncompressedData.size() <= _bytesAvailable) {
-                _bytesInUse = uncompressedData.size();
-                _bytesAvailable -= uncompressedData.size();
-
-                for (int i = 0; i < _bytesInUse; i++) {
-                    _uncompressed[i] = uncompressedData[i];
-                }
+            int uncompressedSize = OctreePacketCompressor::uncompress(data, length, _uncompressed, _bytesAvailable);
+            if (uncompressedSize >= 0) {
+                _bytesInUse = uncompressedSize;
+                _bytesAvailable -= uncompressedSize;
             }
         } else {
             for (int i = 0; i < length; i++) {
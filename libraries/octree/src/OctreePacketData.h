@@ -28,6 +28,7 @@
 
 #include "OctreeConstants.h"
 #include "OctreeElement.h"
+#include "OctreePacketCompressor.h"
 
 typedef unsigned char OCTREE_PACKET_FLAGS;
 typedef uint16_t OCTREE_PACKET_SEQUENCE;
@@ -191,7 +192,7 @@ public:
     int getUncompressedSize() { return _bytesInUse; }
 
     /// update the size of the packet in uncompressed form
-    void setUncompressedSize(int newSize) { _bytesInUse = newSize; }
+    void setUncompressedSize(int newSize) { uncompressedChangedAt(newSize); _bytesInUse = newSize; }
 
     /// has some content been written to the packet
     bool hasContent() const { return (_bytesInUse > 0); }
@@ -211,6 +212,11 @@ public:
     /// displays contents for debugging
     void debugContent();
     
+    /// the zlib level packets are compressed with, 1 is fastest and 9 compresses best. Applies to packets started after
+    /// the call
+    static void setCompressionLevel(int level) { _compressionLevel = level; }
+    static int getCompressionLevel() { return _compressionLevel; }
+
     static quint64 getCompressContentTime() { return _compressContentTime; } /// total time spent compressing content
     static quint64 getCompressContentCalls() { return _compressContentCalls; } /// total calls to compress content
     static quint64 getTotalBytesOfOctalCodes() { return _totalBytesOfOctalCodes; }  /// total bytes for octal codes
@@ -235,12 +241,21 @@ private:
     int _subTreeBytesReserved; // the number of reserved bytes at start of a subtree
 
     bool compressContent();
+
+    /// the compressor has already seen the bytes before _bytesCompressed, changing any of them means the packet has to
+    /// be compressed again from the start when it's finalized
+    void uncompressedChangedAt(int offset) { if (offset < _bytesCompressed) { _compressorInSync = false; } }
     
     unsigned char _compressed[MAX_OCTREE_UNCOMRESSED_PACKET_SIZE];
     int _compressedBytes;
     int _bytesInUseLastCheck;
     bool _dirty;
 
+    // committed subtrees are compressed as they end, so finalizing only has to flush the last of them
+    OctreePacketCompressor _compressor;
+    int _bytesCompressed;
+    bool _compressorInSync;
+
     // statistics...
     int _bytesOfOctalCodes;
     int _bytesOfBitMasks;
@@ -253,6 +268,8 @@ private:
 
     static bool _debug;
 
+    static int _compressionLevel;
+
     static quint64 _compressContentTime;
     static quint64 _compressContentCalls;
 
@@ -19,7 +19,12 @@
 OctreeRenderer::OctreeRenderer() :
     _tree(NULL),
     _managedTree(false),
-    _viewFrustum(NULL)
+    _viewFrustum(NULL),
+    _deferCommits(false),
+    _lastWriteLockUsecs(0),
+    _maxWriteLockUsecs(0),
+    _previousMaxWriteLockUsecs(0),
+    _maxWriteLockStart(0)
 {
 }
 
@@ -114,10 +119,7 @@ void OctreeRenderer::processDatagram(const QByteArray& dataByteArray, const Shar
             }
             
             if (sectionLength) {
-                // ask the VoxelTree to read the bitstream into the tree
-                ReadBitstreamToTreeParams args(packetIsColored ? WANT_COLOR : NO_COLOR, WANT_EXISTS_BITS, NULL, 
-                                                sourceUUID, sourceNode, false, expectedVersion);
-                _tree->lockForWrite();
+                // uncompressing doesn't touch the tree, so it happens before taking the tree's lock
                 OctreePacketData packetData(packetIsCompressed);
                 packetData.loadFinalizedContent(dataAt, sectionLength);
                 if (extraDebugging) {
@@ -128,14 +130,14 @@ void OctreeRenderer::processDatagram(const QByteArray& dataByteArray, const Shar
                            sequence, flightTime, packetLength, dataBytes, subsection, sectionLength,
                            packetData.getUncompressedSize());
                 }
-                if (extraDebugging) {
-                    qDebug() << "OctreeRenderer::processDatagram() ******* START _tree->readBitstreamToTree()...";
-                }
-                _tree->readBitstreamToTree(packetData.getUncompressedData(), packetData.getUncompressedSize(), args);
-                if (extraDebugging) {
-                    qDebug() << "OctreeRenderer::processDatagram() ******* END _tree->readBitstreamToTree()...";
-                }
-                _tree->unlock();
+                StagedOctreeSection section;
+                section.data = QByteArray(reinterpret_cast<const char*>(packetData.getUncompressedData()),
+                                          packetData.getUncompressedSize());
+                section.isColored = packetIsColored;
+                section.sourceUUID = sourceUUID;
+                section.sourceNode = sourceNode;
+                section.version = expectedVersion;
+                stageSection(section);
             
                 dataBytes -= sectionLength;
                 dataAt += sectionLength;
@@ -143,6 +145,80 @@ void OctreeRenderer::processDatagram(const QByteArray& dataByteArray, const Shar
         }
         subsection++;
     }
+    if (!_deferCommits) {
+        commitStagedSections();
+    }
+}
+
+void OctreeRenderer::stageSection(const StagedOctreeSection& section) {
+    _stagedSectionsMutex.lock();
+    _stagedSections.append(section);
+    bool isFull = _stagedSections.size() >= MAX_STAGED_SECTIONS;
+    _stagedSectionsMutex.unlock();
+
+    // a long burst is committed in pieces, so that no one commit holds the lock for long
+    if (isFull) {
+        commitStagedSections();
+    }
+}
+
+void OctreeRenderer::commitStagedSections() {
+    // swap the staged sections out, so that more can be staged while these are read into the tree
+    QVector<StagedOctreeSection> sections;
+    _stagedSectionsMutex.lock();
+    sections.swap(_stagedSections);
+    _stagedSectionsMutex.unlock();
+
+    if (sections.isEmpty() || !_tree) {
+        return;
+    }
+
+    _tree->lockForWrite();
+    quint64 lockedAt = usecTimestampNow();
+    foreach (const StagedOctreeSection& section, sections) {
+        ReadBitstreamToTreeParams args(section.isColored ? WANT_COLOR : NO_COLOR, WANT_EXISTS_BITS, NULL,
+                                       section.sourceUUID, section.sourceNode, false, section.version);
+        _tree->readBitstreamToTree(reinterpret_cast<const unsigned char*>(section.data.constData()),
+                                   section.data.size(), args);
+    }
+    quint64 unlockedAt = usecTimestampNow();
+    _tree->unlock();
+
+    recordWriteLock(unlockedAt - lockedAt, sections.size());
+}
+
+void OctreeRenderer::recordWriteLock(quint64 usecs, int sections) {
+    QMutexLocker locker(&_writeLockStatsMutex);
+    quint64 now = usecTimestampNow();
+    if (now - _maxWriteLockStart > USECS_PER_SECOND) {
+        _previousMaxWriteLockUsecs = _maxWriteLockUsecs;
+        _maxWriteLockUsecs = 0;
+        _maxWriteLockStart = now;
+    }
+    _lastWriteLockUsecs = usecs;
+    _maxWriteLockUsecs = qMax(_maxWriteLockUsecs, usecs);
+    _writeLockUsecs.updateAverage(usecs);
+    _sectionsPerCommit.updateAverage(sections);
+}
+
+quint64 OctreeRenderer::getLastWriteLockUsecs() const {
+    QMutexLocker locker(&_writeLockStatsMutex);
+    return _lastWriteLockUsecs;
+}
+
+quint64 OctreeRenderer::getMaxWriteLockUsecs() const {
+    QMutexLocker locker(&_writeLockStatsMutex);
+    return qMax(_maxWriteLockUsecs, _previousMaxWriteLockUsecs);
+}
+
+float OctreeRenderer::getAverageWriteLockUsecs() const {
+    QMutexLocker locker(&_writeLockStatsMutex);
+    return _writeLockUsecs.getAverage();
+}
+
+float OctreeRenderer::getAverageSectionsPerCommit() const {
+    QMutexLocker locker(&_writeLockStatsMutex);
+    return _sectionsPerCommit.getAverage();
 }
 
 bool OctreeRenderer::renderOperation(OctreeElement* element, void* extraData) {
@@ -189,6 +265,11 @@ void OctreeRenderer::render(RenderMode renderMode) {
 }
 
 void OctreeRenderer::clear() { 
+    // whatever was staged came before the clear
+    _stagedSectionsMutex.lock();
+    _stagedSections.clear();
+    _stagedSectionsMutex.unlock();
+
     if (_tree) {
         _tree->lockForWrite();
         _tree->eraseAllOctreeElements(); 
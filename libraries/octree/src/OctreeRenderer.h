@@ -15,10 +15,13 @@
 #include <glm/glm.hpp>
 #include <stdint.h>
 
+#include <QMutex>
 #include <QObject>
+#include <QVector>
 
 #include <PacketHeaders.h>
 #include <SharedUtil.h>
+#include <SimpleMovingAverage.h>
 
 #include "Octree.h"
 #include "OctreePacketData.h"
@@ -27,6 +30,15 @@
 class OctreeRenderer;
 class RenderArgs;
 
+/// A packet section that has been uncompressed but not yet read into the tree
+class StagedOctreeSection {
+public:
+    QByteArray data;
+    bool isColored;
+    QUuid sourceUUID;
+    SharedNodePointer sourceNode;
+    PacketVersion version;
+};
 
 // Generic client side Octree renderer class.
 class OctreeRenderer : public QObject {
@@ -45,9 +57,20 @@ public:
 
     virtual void setTree(Octree* newTree);
     
-    /// process incoming data
+    /// process incoming data. Sections are uncompressed without holding the tree's lock and staged, then read into the
+    /// tree by commitStagedSections(), which happens at the end of the datagram unless commits are deferred
     virtual void processDatagram(const QByteArray& dataByteArray, const SharedNodePointer& sourceNode);
 
+    /// reads every staged section into the tree under a single write lock
+    void commitStagedSections();
+
+    /// when deferred, the owner calls commitStagedSections() once per batch of datagrams, so that the tree is locked
+    /// once per batch instead of once per section. A commit still happens whenever MAX_STAGED_SECTIONS are staged.
+    void setDeferCommits(bool deferCommits) { _deferCommits = deferCommits; }
+    bool getDeferCommits() const { return _deferCommits; }
+
+    static const int MAX_STAGED_SECTIONS = 64;
+
     /// initialize and GPU/rendering related resources
     virtual void init();
 
@@ -81,6 +104,12 @@ public:
     int getTranslucentMeshPartsRendered() const { return _translucentMeshPartsRendered; }
     int getOpaqueMeshPartsRendered() const { return _opaqueMeshPartsRendered; }
 
+    /// how long commits held the tree's write lock, the max is over the last second or so
+    quint64 getLastWriteLockUsecs() const;
+    quint64 getMaxWriteLockUsecs() const;
+    float getAverageWriteLockUsecs() const;
+    float getAverageSectionsPerCommit() const;
+
 protected:
     Octree* _tree;
     bool _managedTree;
@@ -102,6 +131,24 @@ protected:
 
     int _translucentMeshPartsRendered;
     int _opaqueMeshPartsRendered;
+
+private:
+    void stageSection(const StagedOctreeSection& section);
+    void recordWriteLock(quint64 usecs, int sections);
+
+    // staging is guarded by its own lock, so that clear() can drop staged sections from another thread
+    QMutex _stagedSectionsMutex;
+    QVector<StagedOctreeSection> _stagedSections;
+    bool _deferCommits;
+
+    // commits are made from the thread staging the sections and from the one rendering, which also reads the stats
+    mutable QMutex _writeLockStatsMutex;
+    quint64 _lastWriteLockUsecs;
+    quint64 _maxWriteLockUsecs;
+    quint64 _previousMaxWriteLockUsecs;
+    quint64 _maxWriteLockStart;
+    SimpleMovingAverage _writeLockUsecs;
+    SimpleMovingAverage _sectionsPerCommit;
 };
 
 class RenderArgs {
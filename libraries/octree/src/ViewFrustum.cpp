@@ -19,6 +19,7 @@
 
 #include "GeometryUtil.h"
 #include "SharedUtil.h"
+#include "SimdSupport.h"
 #include "ViewFrustum.h"
 #include "OctreeConstants.h"
 
@@ -358,6 +359,15 @@ ViewFrustum::location ViewFrustum::sphereInFrustum(const glm::vec3& center, floa
 
 
 ViewFrustum::location ViewFrustum::cubeInFrustum(const AACube& cube) const {
+    unsigned char planeMask = NO_FRUSTUM_PLANES_INSIDE;
+    return cubeInFrustum(cube, planeMask);
+}
+
+ViewFrustum::location ViewFrustum::cubeInFrustum(const AACube& cube, unsigned char& planeMask) const {
+    // a cube that is inside all of the planes, or inside the keyhole, was found to be INSIDE at its parent already
+    if (planeMask == ALL_FRUSTUM_PLANES_INSIDE) {
+        return INSIDE;
+    }
 
     ViewFrustum::location regularResult = INSIDE;
     ViewFrustum::location keyholeResult = OUTSIDE;
@@ -367,6 +377,7 @@ ViewFrustum::location ViewFrustum::cubeInFrustum(const AACube& cube) const {
         keyholeResult = cubeInKeyhole(cube);
     }
     if (keyholeResult == INSIDE) {
+        planeMask = ALL_FRUSTUM_PLANES_INSIDE;
         return keyholeResult;
     }
 
@@ -375,6 +386,9 @@ ViewFrustum::location ViewFrustum::cubeInFrustum(const AACube& cube) const {
     // One suggested optimization is to first check against the approximated cone. We might
     // also be able to test against the cone to the bounding sphere of the box.
     for(int i=0; i < 6; i++) {
+        if (planeMask & (1 << i)) {
+            continue; // a parent was already completely inside this plane
+        }
         const glm::vec3& normal = _planes[i].getNormal();
         const glm::vec3& boxVertexP = cube.getVertexP(normal);
         float planeToBoxVertexPDistance = _planes[i].distance(boxVertexP);
@@ -387,11 +401,123 @@ ViewFrustum::location ViewFrustum::cubeInFrustum(const AACube& cube) const {
             return keyholeResult;
         } else if (planeToBoxVertexNDistance < 0) {
             regularResult =  INTERSECT;
+        } else {
+            planeMask |= (1 << i);
         }
     }
     return regularResult;
 }
 
+// returns a bit for each child of the cube whose vertex at vertexOffset from the child's corner is behind the plane,
+// the distances come out exactly like Plane::distance() would compute them for each child on its own
+static unsigned char childrenBehindPlane(const ::Plane& plane, const glm::vec3& parentCorner, float halfScale,
+                                         const glm::vec3& vertexOffset) {
+    const glm::vec3& normal = plane.getNormal();
+
+    // the coordinates of the vertex for the children in the low and the high half of the parent along each axis
+    float lowX = parentCorner.x + vertexOffset.x;
+    float highX = (parentCorner.x + halfScale) + vertexOffset.x;
+    float lowY = parentCorner.y + vertexOffset.y;
+    float highY = (parentCorner.y + halfScale) + vertexOffset.y;
+    float lowZ = parentCorner.z + vertexOffset.z;
+    float highZ = (parentCorner.z + halfScale) + vertexOffset.z;
+
+#ifdef HIFI_HAVE_SSE
+    // children 0-3 are in the low half along x and children 4-7 in the high half, within each group of four the halves
+    // along y and z follow the bits of the child index
+    __m128 yTerms = _mm_mul_ps(_mm_set1_ps(normal.y), _mm_setr_ps(lowY, lowY, highY, highY));
+    __m128 zTerms = _mm_mul_ps(_mm_set1_ps(normal.z), _mm_setr_ps(lowZ, highZ, lowZ, highZ));
+    __m128 dCoefficient = _mm_set1_ps(plane.getDCoefficient());
+
+    __m128 lowDistances = _mm_add_ps(dCoefficient,
+        _mm_add_ps(_mm_add_ps(_mm_set1_ps(normal.x * lowX), yTerms), zTerms));
+    __m128 highDistances = _mm_add_ps(dCoefficient,
+        _mm_add_ps(_mm_add_ps(_mm_set1_ps(normal.x * highX), yTerms), zTerms));
+
+    __m128 zero = _mm_setzero_ps();
+    return (unsigned char)(_mm_movemask_ps(_mm_cmplt_ps(lowDistances, zero))
+        | (_mm_movemask_ps(_mm_cmplt_ps(highDistances, zero)) << 4));
+#else
+    unsigned char childrenBehind = 0;
+    for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+        glm::vec3 vertex((i & 4) ? highX : lowX, (i & 2) ? highY : lowY, (i & 1) ? highZ : lowZ);
+        if (plane.distance(vertex) < 0) {
+            childrenBehind |= (1 << i);
+        }
+    }
+    return childrenBehind;
+#endif
+}
+
+void ViewFrustum::childrenInFrustum(const AACube& parentCube, unsigned char parentPlaneMask,
+                                    ViewFrustum::location childLocations[NUMBER_OF_CHILDREN],
+                                    unsigned char childPlaneMasks[NUMBER_OF_CHILDREN]) const {
+    for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+        childPlaneMasks[i] = parentPlaneMask;
+    }
+    if (parentPlaneMask == ALL_FRUSTUM_PLANES_INSIDE) {
+        for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+            childLocations[i] = INSIDE;
+        }
+        return;
+    }
+
+    const glm::vec3& parentCorner = parentCube.getCorner();
+    float halfScale = parentCube.getScale() / 2.0f;
+
+    unsigned char outsideChildren = 0;
+    unsigned char intersectingChildren = 0;
+    for (int plane = 0; plane < 6 && outsideChildren != 0xff; plane++) {
+        if (parentPlaneMask & (1 << plane)) {
+            continue;
+        }
+
+        // the P and N vertices are at the same corner of every child, only the child's own corner moves
+        const glm::vec3& normal = _planes[plane].getNormal();
+        glm::vec3 vertexPOffset(normal.x > 0 ? halfScale : 0.0f, normal.y > 0 ? halfScale : 0.0f,
+                                normal.z > 0 ? halfScale : 0.0f);
+        glm::vec3 vertexNOffset(normal.x < 0 ? halfScale : 0.0f, normal.y < 0 ? halfScale : 0.0f,
+                                normal.z < 0 ? halfScale : 0.0f);
+
+        unsigned char vertexPBehind = childrenBehindPlane(_planes[plane], parentCorner, halfScale, vertexPOffset);
+        unsigned char vertexNBehind = childrenBehindPlane(_planes[plane], parentCorner, halfScale, vertexNOffset);
+
+        outsideChildren |= vertexPBehind;
+        intersectingChildren |= vertexNBehind;
+
+        for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+            if (!(vertexNBehind & (1 << i))) {
+                childPlaneMasks[i] |= (1 << plane);
+            }
+        }
+    }
+
+    for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+        if (!((outsideChildren | intersectingChildren) & (1 << i))) {
+            childLocations[i] = INSIDE;
+            continue;
+        }
+
+        // the keyhole only matters for children that aren't completely inside the regular frustum
+        ViewFrustum::location keyholeResult = OUTSIDE;
+        if (_keyholeRadius >= 0.0f) {
+            glm::vec3 childCorner((i & 4) ? parentCorner.x + halfScale : parentCorner.x,
+                                  (i & 2) ? parentCorner.y + halfScale : parentCorner.y,
+                                  (i & 1) ? parentCorner.z + halfScale : parentCorner.z);
+            keyholeResult = cubeInKeyhole(AACube(childCorner, halfScale));
+        }
+
+        if (keyholeResult == INSIDE) {
+            childLocations[i] = INSIDE;
+            childPlaneMasks[i] = ALL_FRUSTUM_PLANES_INSIDE;
+        } else if (outsideChildren & (1 << i)) {
+            childLocations[i] = keyholeResult;
+        } else {
+            childLocations[i] = INTERSECT;
+        }
+    }
+}
+
 ViewFrustum::location ViewFrustum::boxInFrustum(const AABox& box) const {
 
     ViewFrustum::location regularResult = INSIDE;
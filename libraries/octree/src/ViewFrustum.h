@@ -30,6 +30,11 @@ const float DEFAULT_ASPECT_RATIO = 16.f/9.f;
 const float DEFAULT_NEAR_CLIP = 0.08f;
 const float DEFAULT_FAR_CLIP = TREE_SCALE;
 
+/// a plane mask has a bit for each of the six planes of the frustum that a cube is known to be completely inside of, a cube's
+/// children are inside of those planes as well so they never need to be tested against them again
+const unsigned char NO_FRUSTUM_PLANES_INSIDE = 0x00;
+const unsigned char ALL_FRUSTUM_PLANES_INSIDE = 0x3f;
+
 class ViewFrustum {
 public:
     // setters for camera attributes
@@ -98,6 +103,15 @@ public:
     ViewFrustum::location cubeInFrustum(const AACube& cube) const;
     ViewFrustum::location boxInFrustum(const AABox& box) const;
 
+    /// like cubeInFrustum(), but skips the planes set in planeMask and adds the planes the cube turns out to be inside of
+    ViewFrustum::location cubeInFrustum(const AACube& cube, unsigned char& planeMask) const;
+
+    /// finds the locations of all eight children of a cube at once, indexed like the children of an octree element. Only
+    /// the planes not set in the parent's plane mask are tested, and each child gets its own plane mask to pass down.
+    void childrenInFrustum(const AACube& parentCube, unsigned char parentPlaneMask,
+                           ViewFrustum::location childLocations[NUMBER_OF_CHILDREN],
+                           unsigned char childPlaneMasks[NUMBER_OF_CHILDREN]) const;
+
     // some frustum comparisons
     bool matches(const ViewFrustum& compareTo, bool debug = false) const;
     bool matches(const ViewFrustum* compareTo, bool debug = false) const { return matches(*compareTo, debug); }
@@ -17,6 +17,7 @@
 #include <QtNetwork/QNetworkReply>
 #include <QScriptEngine>
 
+#include <AudioCodec.h>
 #include <AudioEffectOptions.h>
 #include <AudioInjector.h>
 #include <AudioRingBuffer.h>
@@ -29,6 +30,7 @@
 #include <PacketHeaders.h>
 #include <Sound.h>
 #include <UUID.h>
+#include <VoiceActivityDetector.h>
 #include <VoxelConstants.h>
 #include <VoxelDetail.h>
 
@@ -102,6 +104,7 @@ ScriptEngine::ScriptEngine(const QString& scriptContents, const QString& fileNam
     _isListeningToAudioStream(false),
     _avatarSound(NULL),
     _numAvatarSoundSentBytes(0),
+    _avatarAudioUplinkStats(),
     _controllerScriptingInterface(controllerScriptingInterface),
     _avatarData(NULL),
     _scriptName(),
@@ -128,6 +131,7 @@ ScriptEngine::ScriptEngine(const QUrl& scriptURL,
     _isListeningToAudioStream(false),
     _avatarSound(NULL),
     _numAvatarSoundSentBytes(0),
+    _avatarAudioUplinkStats(),
     _controllerScriptingInterface(controllerScriptingInterface),
     _avatarData(NULL),
     _scriptName(),
@@ -462,13 +466,9 @@ void ScriptEngine::run() {
                     numAvailableSamples = numAvailableBytes / sizeof(int16_t);
 
 
-                    // check if the all of the _numAvatarAudioBufferSamples to be sent are silence
-                    for (int i = 0; i < numAvailableSamples; ++i) {
-                        if (nextSoundOutput[i] != 0) {
-                            silentFrame = false;
-                            break;
-                        }
-                    }
+                    // quiet frames of the sound go out as silent frames, the sound may not be speech so there's no
+                    // noise floor to compare against
+                    silentFrame = VoiceActivityDetector::isQuietFrame(nextSoundOutput, numAvailableSamples);
 
                     _numAvatarSoundSentBytes += numAvailableBytes;
                     if (_numAvatarSoundSentBytes == soundByteArray.size()) {
@@ -490,11 +490,6 @@ void ScriptEngine::run() {
                 packetStream << (quint16) 0;
 
                 if (silentFrame) {
-                    if (!_isListeningToAudioStream) {
-                        // if we have a silent frame and we're not listening then just send nothing and break out of here
-                        break;
-                    }
-
                     // write the number of silent samples so the audio-mixer can uphold timing
                     packetStream.writeRawData(reinterpret_cast<const char*>(&SCRIPT_AUDIO_BUFFER_SAMPLES), sizeof(int16_t));
 
@@ -507,6 +502,10 @@ void ScriptEngine::run() {
                     // assume scripted avatar audio is mono and set channel flag to zero
                     packetStream << (quint8)0;
 
+                    // scripted audio is sent as raw samples, but we can decode any mix the audio-mixer sends
+                    packetStream << (quint8)AudioCodec::PCM;
+                    packetStream << SUPPORTED_AUDIO_CODECS_MASK;
+
                     // use the orientation and position of this avatar for the source of this audio
                     packetStream.writeRawData(reinterpret_cast<const char*>(&_avatarData->getPosition()), sizeof(glm::vec3));
                     glm::quat headOrientation = _avatarData->getHeadOrientation();
@@ -527,6 +526,12 @@ void ScriptEngine::run() {
 
                         // send audio packet
                         nodeList->writeDatagram(audioPacket, node);
+
+                        if (silentFrame) {
+                            _avatarAudioUplinkStats.silentFrameSent(audioPacket.size());
+                        } else {
+                            _avatarAudioUplinkStats.audioFrameSent(audioPacket.size());
+                        }
                     }
                 }
             }
@@ -547,6 +552,10 @@ void ScriptEngine::run() {
     }
     emit scriptEnding();
 
+    if (_avatarAudioUplinkStats.getTotalBytes() > 0) {
+        qDebug() << "Avatar audio sent by" << _fileNameString << ":" << _avatarAudioUplinkStats.toString();
+    }
+
     // kill the avatar identity timer
     delete _avatarIdentityTimer;
 
@@ -20,6 +20,7 @@
 
 #include <AnimationCache.h>
 #include <AudioScriptingInterface.h>
+#include <AudioUplinkStats.h>
 #include <AvatarData.h>
 #include <AvatarHashMap.h>
 #include <VoxelsScriptingInterface.h>
@@ -129,6 +130,7 @@ protected:
     bool _isListeningToAudioStream;
     Sound* _avatarSound;
     int _numAvatarSoundSentBytes;
+    AudioUplinkStats _avatarAudioUplinkStats;
 
 private:
     QUrl resolveInclude(const QString& include) const;
@@ -363,6 +363,26 @@ unsigned char* hexStringToOctalCode(const QString& input) {
     return bytes;
 }
 
+quint64 octalCodeToKey(const unsigned char* octalCode) {
+    if (!octalCode) {
+        return ROOT_OCTAL_CODE_KEY;
+    }
+    int sections = numberOfThreeBitSectionsInCode(octalCode);
+    if (sections > MAX_OCTAL_CODE_KEY_SECTIONS) {
+        return INVALID_OCTAL_CODE_KEY;
+    }
+    // the sections are packed from the high bit of the first byte, so reading them as one big-endian number and
+    // shifting away the unused low bits leaves them in order
+    int bits = sections * BITS_IN_OCTAL;
+    int bytes = (bits + 7) / 8;
+    quint64 sectionBits = 0;
+    for (int i = 0; i < bytes; i++) {
+        sectionBits = (sectionBits << 8) | octalCode[1 + i];
+    }
+    sectionBits >>= bytes * 8 - bits;
+    return (ROOT_OCTAL_CODE_KEY << bits) | sectionBits;
+}
+
 QString octalCodeToHexString(const unsigned char* octalCode) {
     const int HEX_NUMBER_BASE = 16;
     const int HEX_BYTE_SIZE = 2;
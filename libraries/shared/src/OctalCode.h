@@ -62,6 +62,13 @@ typedef enum {
 
 OctalCodeComparison compareOctalCodes(const unsigned char* code1, const unsigned char* code2);
 
+/// An octal code packed into 64 bits: a 1 followed by the three bit sections, so that codes of different lengths
+/// never collide. The root's key is 1, codes longer than MAX_OCTAL_CODE_KEY_SECTIONS don't fit and have no key.
+const int MAX_OCTAL_CODE_KEY_SECTIONS = 21;
+const quint64 ROOT_OCTAL_CODE_KEY = 1;
+const quint64 INVALID_OCTAL_CODE_KEY = 0;
+quint64 octalCodeToKey(const unsigned char* octalCode);
+
 QString octalCodeToHexString(const unsigned char* octalCode);
 unsigned char* hexStringToOctalCode(const QString& input);
 
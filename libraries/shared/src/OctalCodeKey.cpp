@@ -0,0 +1,63 @@
+//
+//  OctalCodeKey.cpp
+//  libraries/shared/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "OctalCodeKey.h"
+
+OctalCodeKey OctalCodeKey::fromPoint(float x, float y, float z, float s) {
+    // the same choices as pointToVoxel(): the element is the biggest one no bigger than s, and a point on the line
+    // between two children goes to the higher one
+    if (s >= 1.0f) {
+        return root();
+    }
+    int depth = 1;
+    for (float scale = 0.5f; scale > s; scale /= 2.0f) {
+        if (++depth > MAX_OCTAL_CODE_KEY_SECTIONS) {
+            return OctalCodeKey();
+        }
+    }
+    quint64 value = ROOT_OCTAL_CODE_KEY;
+    float halfScale = 0.5f;
+    float cornerX = 0.0f;
+    float cornerY = 0.0f;
+    float cornerZ = 0.0f;
+    for (int i = 0; i < depth; i++) {
+        int childIndex = 0;
+        if (x >= cornerX + halfScale) {
+            childIndex |= 4;
+            cornerX += halfScale;
+        }
+        if (y >= cornerY + halfScale) {
+            childIndex |= 2;
+            cornerY += halfScale;
+        }
+        if (z >= cornerZ + halfScale) {
+            childIndex |= 1;
+            cornerZ += halfScale;
+        }
+        value = (value << BITS_IN_OCTAL) | childIndex;
+        halfScale /= 2.0f;
+    }
+    return OctalCodeKey(value);
+}
+
+int OctalCodeKey::writeOctalCode(unsigned char* buffer) const {
+    int depth = getDepth();
+    int bits = depth * BITS_IN_OCTAL;
+    int bytes = (bits + 7) / 8;
+    buffer[0] = depth;
+
+    // the sections go from the high bit of the first byte, with the last byte padded with zeros
+    quint64 sectionBits = (_value & ((ROOT_OCTAL_CODE_KEY << bits) - 1)) << (bytes * 8 - bits);
+    for (int i = bytes; i > 0; i--) {
+        buffer[i] = sectionBits & 0xFF;
+        sectionBits >>= 8;
+    }
+    return 1 + bytes;
+}
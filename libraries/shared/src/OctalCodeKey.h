@@ -0,0 +1,107 @@
+//
+//  OctalCodeKey.h
+//  libraries/shared/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_OctalCodeKey_h
+#define hifi_OctalCodeKey_h
+
+#include <QHash>
+
+#include "OctalCode.h"
+
+/// the most bytes an octal code with a key can take in its byte form
+const int MAX_OCTAL_CODE_KEY_BYTES = 1 + (MAX_OCTAL_CODE_KEY_SECTIONS * BITS_IN_OCTAL + 7) / 8;
+
+/// An octal code held in a single 64 bit value instead of a heap allocated buffer: a 1 bit followed by the three bit
+/// sections in Morton order, so the depth is where the leading bit is. Children, parents and ancestors are shifts and
+/// masks, and two keys compare as integers. Codes deeper than MAX_OCTAL_CODE_KEY_SECTIONS don't fit, those keys are
+/// invalid and callers fall back to the byte form, which is still what goes over the wire and into files.
+class OctalCodeKey {
+public:
+    OctalCodeKey() : _value(INVALID_OCTAL_CODE_KEY) { }
+    explicit OctalCodeKey(quint64 value) : _value(value) { }
+
+    static OctalCodeKey root() { return OctalCodeKey(ROOT_OCTAL_CODE_KEY); }
+    static OctalCodeKey fromOctalCode(const unsigned char* octalCode) { return OctalCodeKey(octalCodeToKey(octalCode)); }
+
+    /// the key of the code pointToOctalCode() would return, without allocating it
+    static OctalCodeKey fromPoint(float x, float y, float z, float s);
+
+    bool isValid() const { return _value != INVALID_OCTAL_CODE_KEY; }
+    quint64 getValue() const { return _value; }
+
+    int getDepth() const { return isValid() ? highestBit(_value) / BITS_IN_OCTAL : 0; }
+
+    /// the key of a child, invalid if the child would be too deep
+    OctalCodeKey getChild(int childIndex) const {
+        return (isValid() && getDepth() < MAX_OCTAL_CODE_KEY_SECTIONS)
+            ? OctalCodeKey((_value << BITS_IN_OCTAL) | childIndex) : OctalCodeKey();
+    }
+
+    /// the key of the parent, the root is its own parent
+    OctalCodeKey getParent() const {
+        return _value > ROOT_OCTAL_CODE_KEY ? OctalCodeKey(_value >> BITS_IN_OCTAL) : *this;
+    }
+
+    /// the key of the ancestor at the given depth, or this key if it isn't that deep
+    OctalCodeKey getAncestor(int depth) const {
+        int levelsUp = getDepth() - depth;
+        return levelsUp > 0 ? OctalCodeKey(_value >> (levelsUp * BITS_IN_OCTAL)) : *this;
+    }
+
+    /// whether this key is the other's, or one of its ancestors
+    bool isAncestorOf(const OctalCodeKey& other) const {
+        return isValid() && other.isValid() && other.getDepth() >= getDepth()
+            && other.getAncestor(getDepth())._value == _value;
+    }
+
+    /// which of this key's children leads to the descendant
+    int getBranchTowards(const OctalCodeKey& descendant) const {
+        return (int)(descendant.getAncestor(getDepth() + 1)._value & 7);
+    }
+
+    /// the key with the first levels taken off, what encoding does for jurisdictions that start below the root
+    OctalCodeKey getChopped(int levels) const {
+        if (!isValid()) {
+            return *this;
+        }
+        int depth = getDepth() - levels;
+        if (depth <= 0) {
+            return root();
+        }
+        int bits = depth * BITS_IN_OCTAL;
+        return OctalCodeKey((ROOT_OCTAL_CODE_KEY << bits) | (_value & ((ROOT_OCTAL_CODE_KEY << bits) - 1)));
+    }
+
+    /// writes the byte form of the code, the buffer needs MAX_OCTAL_CODE_KEY_BYTES. Returns the bytes written.
+    int writeOctalCode(unsigned char* buffer) const;
+
+    bool operator==(const OctalCodeKey& other) const { return _value == other._value; }
+    bool operator!=(const OctalCodeKey& other) const { return _value != other._value; }
+    bool operator<(const OctalCodeKey& other) const { return _value < other._value; }
+
+private:
+    static int highestBit(quint64 value) {
+#ifdef __GNUC__
+        return 63 - __builtin_clzll(value);
+#else
+        int bit = 0;
+        while (value >>= 1) {
+            bit++;
+        }
+        return bit;
+#endif
+    }
+
+    quint64 _value;
+};
+
+inline uint qHash(const OctalCodeKey& key) { return qHash(key.getValue()); }
+
+#endif // hifi_OctalCodeKey_h
@@ -0,0 +1,64 @@
+//
+//  ParallelBatch.cpp
+//  libraries/shared/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+
+#include "ParallelBatch.h"
+
+class ParallelBatchHelper : public QRunnable {
+public:
+    ParallelBatchHelper(const SharedParallelBatchPointer& batch) : _batch(batch) { }
+
+    virtual void run() {
+        while (_batch->runNextItem()) {
+        }
+    }
+
+private:
+    SharedParallelBatchPointer _batch; // a helper that starts late may outlive the call that ran the batch
+};
+
+ParallelBatch::ParallelBatch() :
+    _itemCount(0),
+    _nextItem(0)
+{
+}
+
+ParallelBatch::~ParallelBatch() {
+}
+
+void ParallelBatch::runInThreadPool(const SharedParallelBatchPointer& batch, int itemCount, bool useThreadPool) {
+    batch->_itemCount = itemCount;
+
+    if (useThreadPool) {
+        int helperCount = qMin(QThread::idealThreadCount() - 1, itemCount - 1);
+        for (int i = 0; i < helperCount; i++) {
+            QThreadPool::globalInstance()->start(new ParallelBatchHelper(batch));
+        }
+    }
+
+    // work on the batch here too, then wait for the items the helpers took. Helpers that haven't started by the time
+    // everything is taken don't need to be waited for.
+    while (batch->runNextItem()) {
+    }
+    batch->_finishedItems.acquire(itemCount);
+}
+
+bool ParallelBatch::runNextItem() {
+    int index = _nextItem.fetchAndAddOrdered(1);
+    if (index >= _itemCount) {
+        return false; // nothing left, and what the items work on may not even exist anymore
+    }
+    runItem(index);
+    _finishedItems.release();
+    return true;
+}
@@ -0,0 +1,48 @@
+//
+//  ParallelBatch.h
+//  libraries/shared/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_ParallelBatch_h
+#define hifi_ParallelBatch_h
+
+#include <QAtomicInt>
+#include <QSemaphore>
+#include <QSharedPointer>
+
+class ParallelBatch;
+
+typedef QSharedPointer<ParallelBatch> SharedParallelBatchPointer;
+
+/// Work split into items that can be done in any order on any thread. Subclasses hold what the items work on and do one
+/// item in runItem(), runInThreadPool() has the calling thread and threads of the global pool take the items one at a
+/// time until they're all done. A batch is run once.
+class ParallelBatch {
+public:
+    ParallelBatch();
+    virtual ~ParallelBatch();
+
+    /// runs every item of the batch and returns once they're done. Threads of the pool only help out if useThreadPool is
+    /// set, callers leave it off for batches too small to be worth waking the pool for.
+    static void runInThreadPool(const SharedParallelBatchPointer& batch, int itemCount, bool useThreadPool = true);
+
+protected:
+    virtual void runItem(int index) = 0;
+
+private:
+    friend class ParallelBatchHelper;
+
+    /// runs the next item nobody has taken, returns false once they're all taken
+    bool runNextItem();
+
+    int _itemCount;
+    QAtomicInt _nextItem;
+    QSemaphore _finishedItems;
+};
+
+#endif // hifi_ParallelBatch_h
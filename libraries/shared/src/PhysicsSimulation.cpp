@@ -9,24 +9,32 @@
 //  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
 //
 
+#include <cfloat>
+
 #include <glm/glm.hpp>
 
+#include <QtAlgorithms>
+
 #include "PhysicsSimulation.h"
 
+#include "ParallelBatch.h"
 #include "PerfStat.h"
 #include "PhysicsEntity.h"
 #include "Ragdoll.h"
 #include "Shape.h"
 #include "ShapeCollider.h"
 #include "SharedUtil.h"
+#include "VerletPoint.h"
 
 int MAX_DOLLS_PER_SIMULATION = 16;
 int MAX_ENTITIES_PER_SIMULATION = 64;
 int MAX_COLLISIONS_PER_SIMULATION = 256;
 
+// below this many points in the islands to enforce, handing them to other threads costs more than it saves
+const int MIN_RAGDOLL_POINTS_FOR_THREAD_POOL = 256;
 
 PhysicsSimulation::PhysicsSimulation() : _translation(0.0f), _frameCount(0), _entity(NULL), _ragdoll(NULL), 
-        _collisions(MAX_COLLISIONS_PER_SIMULATION) {
+        _collisions(MAX_COLLISIONS_PER_SIMULATION), _useBroadphase(true) {
 }
 
 PhysicsSimulation::~PhysicsSimulation() {
@@ -50,6 +58,7 @@ void PhysicsSimulation::clear() {
 
     // contacts have backpointers to shapes so we clear them
     _contacts.clear();
+    _shapeDolls.clear();
 }
 
 void PhysicsSimulation::setRagdoll(Ragdoll* ragdoll) { 
@@ -214,14 +223,10 @@ void PhysicsSimulation::stepForward(float deltaTime, float minError, int maxIter
     integrate(deltaTime);
     enforceContacts();
     int numDolls = _otherRagdolls.size();
+    resetRagdollIslands();
     {
         PerformanceTimer perfTimer("enforce");
-        if (_ragdoll) {
-            _ragdoll->enforceConstraints();
-        }
-        for (int i = 0; i < numDolls; ++i) {
-            _otherRagdolls[i]->enforceConstraints();
-        }
+        enforceRagdollConstraints(minError);
     }
 
     bool collidedWithOtherRagdoll = false;
@@ -231,15 +236,11 @@ void PhysicsSimulation::stepForward(float deltaTime, float minError, int maxIter
         collidedWithOtherRagdoll = computeCollisions() || collidedWithOtherRagdoll;
         updateContacts();
         resolveCollisions();
+        findRagdollIslands();
 
         { // enforce constraints
             PerformanceTimer perfTimer("enforce");
-            if (_ragdoll) {
-                error = _ragdoll->enforceConstraints();
-            }
-            for (int i = 0; i < numDolls; ++i) {
-                error = glm::max(error, _otherRagdolls[i]->enforceConstraints());
-            }
+            error = enforceRagdollConstraints(minError);
         }
         applyContactFriction();
         ++iterations;
@@ -305,6 +306,9 @@ void PhysicsSimulation::integrate(float deltaTime) {
 bool PhysicsSimulation::computeCollisions() {
     PerformanceTimer perfTimer("collide");
     _collisions.clear();
+    if (_useBroadphase) {
+        return computeCollisionsWithBroadphase();
+    }
 
     const QVector<Shape*> shapes = _entity->getShapes();
     int numShapes = shapes.size();
@@ -332,6 +336,230 @@ bool PhysicsSimulation::computeCollisions() {
     return otherCollisions;
 }
 
+// a pair of shapes, packed so that sorting the pairs puts them in the order the full loops in computeCollisions() try
+// them: the main entity with itself, then with each other entity in turn
+const int SHAPE_PAIR_INDEX_BITS = 20;
+const quint64 SHAPE_PAIR_INDEX_MASK = (1 << SHAPE_PAIR_INDEX_BITS) - 1;
+
+static quint64 packShapePair(int entity, int shapeIndex, int otherShapeIndex) {
+    return ((quint64)entity << (2 * SHAPE_PAIR_INDEX_BITS)) | ((quint64)shapeIndex << SHAPE_PAIR_INDEX_BITS) |
+        (quint64)otherShapeIndex;
+}
+
+bool PhysicsSimulation::computeCollisionsWithBroadphase() {
+    const QVector<Shape*> shapes = _entity->getShapes();
+    int numShapes = shapes.size();
+
+    _broadphase.clear();
+    for (int i = 0; i < numShapes; ++i) {
+        _broadphase.addShape(shapes.at(i), 0);
+    }
+    int numEntities = _otherEntities.size();
+    _firstEntityShapes.resize(numEntities + 1);
+    for (int i = 0; i < numEntities; ++i) {
+        _firstEntityShapes[i] = _broadphase.getShapeCount();
+        const QVector<Shape*> otherShapes = _otherEntities.at(i)->getShapes();
+        for (int j = 0; j < otherShapes.size(); ++j) {
+            _broadphase.addShape(otherShapes.at(j), i + 1);
+        }
+    }
+    _firstEntityShapes[numEntities] = _broadphase.getShapeCount();
+
+    // the main entity's shapes were added first, so the first shape of each pair is one of them
+    _overlaps.clear();
+    _broadphase.findOverlaps(0, _overlaps);
+    _shapePairs.resize(_overlaps.size());
+    int entity = 0;
+    for (int i = 0; i < _overlaps.size(); ++i) {
+        int second = _overlaps.at(i).second;
+        if (second < numShapes) {
+            _shapePairs[i] = packShapePair(0, _overlaps.at(i).first, second);
+            continue;
+        }
+        // the overlaps tend to come in runs from the same entity
+        while (second < _firstEntityShapes[entity]) {
+            --entity;
+        }
+        while (second >= _firstEntityShapes[entity + 1]) {
+            ++entity;
+        }
+        _shapePairs[i] = packShapePair(entity + 1, _overlaps.at(i).first, second - _firstEntityShapes[entity]);
+    }
+    qSort(_shapePairs);
+
+    bool otherCollisions = false;
+    for (int i = 0; i < _shapePairs.size(); ++i) {
+        quint64 pair = _shapePairs.at(i);
+        int pairEntity = (int)(pair >> (2 * SHAPE_PAIR_INDEX_BITS));
+        int shapeIndex = (int)((pair >> SHAPE_PAIR_INDEX_BITS) & SHAPE_PAIR_INDEX_MASK);
+        int otherShapeIndex = (int)(pair & SHAPE_PAIR_INDEX_MASK);
+        if (pairEntity == 0) {
+            // collide main ragdoll with self
+            if (_entity->collisionsAreEnabled(shapeIndex, otherShapeIndex)) {
+                ShapeCollider::collideShapes(shapes.at(shapeIndex), shapes.at(otherShapeIndex), _collisions);
+            }
+        } else {
+            // collide main ragdoll with others
+            if (_collisions.isFull()) {
+                break;
+            }
+            const QVector<Shape*> otherShapes = _otherEntities.at(pairEntity - 1)->getShapes();
+            otherCollisions = ShapeCollider::collideShapes(shapes.at(shapeIndex), otherShapes.at(otherShapeIndex),
+                                                           _collisions) || otherCollisions;
+        }
+    }
+    return otherCollisions;
+}
+
+void PhysicsSimulation::resetRagdollIslands() {
+    _dolls.clear();
+    if (_ragdoll) {
+        _dolls.push_back(_ragdoll);
+    }
+    for (int i = 0; i < _otherRagdolls.size(); ++i) {
+        _dolls.push_back(_otherRagdolls[i]);
+    }
+    int numDolls = _dolls.size();
+    _dollErrors.fill(FLT_MAX, numDolls);
+    _dollsTouched.fill(true, numDolls);
+    _dollIslands.resize(numDolls);
+    for (int i = 0; i < numDolls; ++i) {
+        _dollIslands[i] = i;
+    }
+    // the points may have been rebuilt since the last step
+    _shapeDolls.clear();
+}
+
+int PhysicsSimulation::findRagdollIndex(Shape* shape) {
+    if (!shape) {
+        return -1;
+    }
+    QHash<Shape*, int>::const_iterator found = _shapeDolls.constFind(shape);
+    if (found != _shapeDolls.constEnd()) {
+        return found.value();
+    }
+    // a shape belongs to the ragdoll that holds its verlet points, shapes without any don't belong to one
+    int dollIndex = -1;
+    QVector<VerletPoint*> points;
+    shape->getVerletPoints(points);
+    for (int i = 0; i < points.size() && dollIndex == -1; ++i) {
+        for (int j = 0; j < _dolls.size(); ++j) {
+            const QVector<VerletPoint>& dollPoints = _dolls[j]->getPoints();
+            if (points[i] >= dollPoints.constData() && points[i] < dollPoints.constData() + dollPoints.size()) {
+                dollIndex = j;
+                break;
+            }
+        }
+    }
+    _shapeDolls.insert(shape, dollIndex);
+    return dollIndex;
+}
+
+int PhysicsSimulation::findIsland(int dollIndex) {
+    while (_dollIslands[dollIndex] != dollIndex) {
+        _dollIslands[dollIndex] = _dollIslands[_dollIslands[dollIndex]];
+        dollIndex = _dollIslands[dollIndex];
+    }
+    return dollIndex;
+}
+
+void PhysicsSimulation::linkRagdolls(int dollIndexA, int dollIndexB) {
+    if (dollIndexA != -1) {
+        _dollsTouched[dollIndexA] = true;
+    }
+    if (dollIndexB != -1) {
+        _dollsTouched[dollIndexB] = true;
+    }
+    if (dollIndexA != -1 && dollIndexB != -1) {
+        _dollIslands[findIsland(dollIndexA)] = findIsland(dollIndexB);
+    }
+}
+
+void PhysicsSimulation::findRagdollIslands() {
+    int numDolls = _dolls.size();
+    _dollsTouched.fill(false, numDolls);
+    for (int i = 0; i < numDolls; ++i) {
+        _dollIslands[i] = i;
+    }
+    int numCollisions = _collisions.size();
+    for (int i = 0; i < numCollisions; ++i) {
+        CollisionInfo* collision = _collisions.getCollision(i);
+        linkRagdolls(findRagdollIndex(collision->getShapeA()), findRagdollIndex(collision->getShapeB()));
+    }
+    // contacts move their shapes too, see applyContactFriction()
+    QMap<quint64, ContactPoint>::const_iterator itr = _contacts.constBegin();
+    while (itr != _contacts.constEnd()) {
+        linkRagdolls(findRagdollIndex(itr.value().getShapeA()), findRagdollIndex(itr.value().getShapeB()));
+        ++itr;
+    }
+}
+
+/// The ragdolls of the islands to enforce, grouped by island. Each island is an item of the batch, and ragdolls don't
+/// share points, so the islands don't need any locking.
+class RagdollIslandBatch : public ParallelBatch {
+public:
+    QVector<Ragdoll*> dolls;
+    QVector<int> firstDolls; // where each island starts in dolls, with an extra entry for the end
+    QVector<float> errors;
+
+    int getIslandCount() const { return firstDolls.size() - 1; }
+
+protected:
+    virtual void runItem(int island) {
+        for (int i = firstDolls.at(island); i < firstDolls.at(island + 1); ++i) {
+            errors[i] = dolls.at(i)->enforceConstraints();
+        }
+    }
+};
+
+float PhysicsSimulation::enforceRagdollConstraints(float minError) {
+    int numDolls = _dolls.size();
+    if (numDolls == 0) {
+        return 0.0f;
+    }
+
+    // gather the dolls of each island that isn't settled
+    QVector<int> islandDolls(numDolls, -1);
+    QVector<bool> islandsToEnforce(numDolls, false);
+    for (int i = 0; i < numDolls; ++i) {
+        int island = findIsland(i);
+        if (_dollsTouched.at(i) || _dollErrors.at(i) > minError) {
+            islandsToEnforce[island] = true;
+        }
+    }
+    RagdollIslandBatch* batch = new RagdollIslandBatch();
+    SharedParallelBatchPointer sharedBatch(batch);
+    int numPoints = 0;
+    for (int island = 0; island < numDolls; ++island) {
+        if (!islandsToEnforce.at(island)) {
+            continue;
+        }
+        batch->firstDolls.push_back(batch->dolls.size());
+        for (int i = 0; i < numDolls; ++i) {
+            if (findIsland(i) == island) {
+                islandDolls[i] = batch->dolls.size();
+                batch->dolls.push_back(_dolls.at(i));
+                numPoints += _dolls.at(i)->getPoints().size();
+            }
+        }
+    }
+    batch->firstDolls.push_back(batch->dolls.size());
+    batch->errors.resize(batch->dolls.size());
+
+    int numIslands = batch->getIslandCount();
+    ParallelBatch::runInThreadPool(sharedBatch, numIslands,
+                                   numIslands > 1 && numPoints >= MIN_RAGDOLL_POINTS_FOR_THREAD_POOL);
+
+    float error = 0.0f;
+    for (int i = 0; i < numDolls; ++i) {
+        if (islandDolls.at(i) != -1) {
+            _dollErrors[i] = batch->errors.at(islandDolls.at(i));
+        }
+        error = glm::max(error, _dollErrors.at(i));
+    }
+    return error;
+}
+
 void PhysicsSimulation::resolveCollisions() {
     PerformanceTimer perfTimer("resolve");
     // walk all collisions, accumulate movement on shapes, and build a list of affected shapes
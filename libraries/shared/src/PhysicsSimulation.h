@@ -13,12 +13,14 @@
 #define hifi_PhysicsSimulation_h
 
 #include <QtGlobal>
+#include <QHash>
 #include <QMap>
 #include <QVector>
 
 #include "CollisionInfo.h"
 #include "ContactPoint.h"
 #include "RayIntersectionInfo.h"
+#include "ShapeBroadphase.h"
 
 class PhysicsEntity;
 class Ragdoll;
@@ -61,11 +63,26 @@ public:
 
     bool getShapeCollisions(const Shape* shape, CollisionList& collisions) const;
 
+    /// Without the broadphase every pair of shapes goes to the ShapeCollider. The collisions are the same either way,
+    /// this is for checking that and for measuring the difference.
+    void setUseBroadphase(bool useBroadphase) { _useBroadphase = useBroadphase; }
+    bool getUseBroadphase() const { return _useBroadphase; }
+
 protected:
     void integrate(float deltaTime);
 
     /// \return true if main ragdoll collides with other avatar
     bool computeCollisions();
+    bool computeCollisionsWithBroadphase();
+
+    /// Ragdolls that touch through collisions or contacts form an island. Islands that nothing touched since their
+    /// constraints were last enforced to within minError are settled, and are skipped until something touches them.
+    void resetRagdollIslands();
+    void findRagdollIslands();
+    float enforceRagdollConstraints(float minError);
+    int findRagdollIndex(Shape* shape);
+    int findIsland(int dollIndex);
+    void linkRagdolls(int dollIndexA, int dollIndexB);
 
     void resolveCollisions();
     void enforceContacts();
@@ -85,6 +102,18 @@ private:
     QVector<PhysicsEntity*> _otherEntities;
     CollisionList _collisions;
     QMap<quint64, ContactPoint> _contacts;
+
+    bool _useBroadphase;
+    ShapeBroadphase _broadphase;
+    QVector<ShapeOverlap> _overlaps;
+    QVector<quint64> _shapePairs;
+    QVector<int> _firstEntityShapes;
+
+    QVector<Ragdoll*> _dolls; // the main ragdoll first, if there is one, then the others
+    QVector<float> _dollErrors;
+    QVector<int> _dollIslands;
+    QVector<bool> _dollsTouched;
+    QHash<Shape*, int> _shapeDolls;
 };
 
 #endif // hifi_PhysicsSimulation_h
@@ -0,0 +1,297 @@
+//
+//  ShapeBatch.cpp
+//  libraries/shared/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <cfloat>
+#include <cmath>
+
+#include "AACubeShape.h"
+#include "CapsuleShape.h"
+#include "Shape.h"
+#include "SharedUtil.h"
+#include "SimdSupport.h"
+
+#include "ShapeBatch.h"
+
+// the candidate test pads the reach of each pair by a fraction of the radii and a fraction of the distance from the origin,
+// which is far more than the rounding in the test or in the narrowphase that follows it
+const float CANDIDATE_RADIUS_MARGIN = 1.001f;
+const float CANDIDATE_POSITION_MARGIN = 1.0e-6f;
+
+static float computePositionMargin(const glm::vec3& center) {
+    return CANDIDATE_POSITION_MARGIN * (fabsf(center.x) + fabsf(center.y) + fabsf(center.z)) + EPSILON;
+}
+
+void ShapeBatch::clear() {
+    _shapes.clear();
+    _bounds.clear();
+}
+
+void ShapeBatch::addShape(const Shape* shape) {
+    int index = _shapes.size();
+    _shapes.append(shape);
+    if (index % SHAPE_BATCH_BLOCK_SIZE == 0) {
+        // start a new block, the unused places in it are never candidates
+        int blockStart = _bounds.size();
+        _bounds.resize(blockStart + FLOATS_PER_BLOCK);
+        float* block = _bounds.data() + blockStart;
+        for (int i = 0; i < FLOATS_PER_BLOCK; ++i) {
+            block[i] = 0.0f;
+        }
+        for (int i = 0; i < SHAPE_BATCH_BLOCK_SIZE; ++i) {
+            block[RADIUS * SHAPE_BATCH_BLOCK_SIZE + i] = -FLT_MAX;
+        }
+    }
+    if (!shape) {
+        return;
+    }
+    glm::vec3 start;
+    glm::vec3 axis(0.0f);
+    float radius;
+    if (shape->getType() == CAPSULE_SHAPE) {
+        // the bounding radius of a verlet capsule isn't kept up to date as its points move, so use the end points
+        const CapsuleShape* capsule = static_cast<const CapsuleShape*>(shape);
+        glm::vec3 end;
+        capsule->getStartPoint(start);
+        capsule->getEndPoint(end);
+        axis = end - start;
+        radius = capsule->getRadius();
+
+    } else if (!computeBoundingSphere(shape, start, radius)) {
+        start = shape->getTranslation();
+        radius = FLT_MAX;
+    }
+    float axisLength2 = glm::dot(axis, axis);
+    bound(index, X) = start.x;
+    bound(index, Y) = start.y;
+    bound(index, Z) = start.z;
+    bound(index, AXIS_X) = axis.x;
+    bound(index, AXIS_Y) = axis.y;
+    bound(index, AXIS_Z) = axis.z;
+    bound(index, INVERSE_AXIS_LENGTH2) = (axisLength2 > 0.0f) ? 1.0f / axisLength2 : 0.0f;
+    bound(index, RADIUS) = radius;
+}
+
+void ShapeBatch::addShapes(const QVector<Shape*>& shapes, int startIndex) {
+    for (int i = startIndex; i < shapes.size(); ++i) {
+        addShape(shapes.at(i));
+    }
+}
+
+int ShapeBatch::findCandidates(int block, const glm::vec3& center, float radius) const {
+#ifdef HIFI_HAVE_SSE
+    const float* bounds = _bounds.constData() + block * FLOATS_PER_BLOCK;
+    __m128 axisX = _mm_loadu_ps(bounds + AXIS_X * SHAPE_BATCH_BLOCK_SIZE);
+    __m128 axisY = _mm_loadu_ps(bounds + AXIS_Y * SHAPE_BATCH_BLOCK_SIZE);
+    __m128 axisZ = _mm_loadu_ps(bounds + AXIS_Z * SHAPE_BATCH_BLOCK_SIZE);
+    __m128 toCenterX = _mm_sub_ps(_mm_set1_ps(center.x), _mm_loadu_ps(bounds + X * SHAPE_BATCH_BLOCK_SIZE));
+    __m128 toCenterY = _mm_sub_ps(_mm_set1_ps(center.y), _mm_loadu_ps(bounds + Y * SHAPE_BATCH_BLOCK_SIZE));
+    __m128 toCenterZ = _mm_sub_ps(_mm_set1_ps(center.z), _mm_loadu_ps(bounds + Z * SHAPE_BATCH_BLOCK_SIZE));
+
+    // the closest point to the center on each segment
+    __m128 zero = _mm_setzero_ps();
+    __m128 along = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(toCenterX, axisX), _mm_mul_ps(toCenterY, axisY)),
+        _mm_mul_ps(toCenterZ, axisZ)), _mm_loadu_ps(bounds + INVERSE_AXIS_LENGTH2 * SHAPE_BATCH_BLOCK_SIZE));
+    along = _mm_min_ps(_mm_max_ps(along, zero), _mm_set1_ps(1.0f));
+    __m128 offsetX = _mm_sub_ps(toCenterX, _mm_mul_ps(along, axisX));
+    __m128 offsetY = _mm_sub_ps(toCenterY, _mm_mul_ps(along, axisY));
+    __m128 offsetZ = _mm_sub_ps(toCenterZ, _mm_mul_ps(along, axisZ));
+    __m128 distance2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(offsetX, offsetX), _mm_mul_ps(offsetY, offsetY)),
+        _mm_mul_ps(offsetZ, offsetZ));
+
+    __m128 reach = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_set1_ps(radius),
+        _mm_loadu_ps(bounds + RADIUS * SHAPE_BATCH_BLOCK_SIZE)), _mm_set1_ps(CANDIDATE_RADIUS_MARGIN)),
+        _mm_set1_ps(computePositionMargin(center)));
+    return _mm_movemask_ps(_mm_and_ps(_mm_cmple_ps(distance2, _mm_mul_ps(reach, reach)), _mm_cmpgt_ps(reach, zero)));
+#else
+    int candidates = 0;
+    for (int i = 0; i < SHAPE_BATCH_BLOCK_SIZE; ++i) {
+        if (isCandidate(block * SHAPE_BATCH_BLOCK_SIZE + i, center, radius)) {
+            candidates |= (1 << i);
+        }
+    }
+    return candidates;
+#endif
+}
+
+bool ShapeBatch::isCandidate(int index, const glm::vec3& center, float radius) const {
+    glm::vec3 axis(bound(index, AXIS_X), bound(index, AXIS_Y), bound(index, AXIS_Z));
+    glm::vec3 toCenter = center - glm::vec3(bound(index, X), bound(index, Y), bound(index, Z));
+    float along = glm::clamp(glm::dot(toCenter, axis) * bound(index, INVERSE_AXIS_LENGTH2), 0.0f, 1.0f);
+    glm::vec3 offset = toCenter - along * axis;
+    float reach = (radius + bound(index, RADIUS)) * CANDIDATE_RADIUS_MARGIN + computePositionMargin(center);
+    return reach > 0.0f && glm::dot(offset, offset) <= reach * reach;
+}
+
+bool ShapeBatch::computeBoundingSphere(const Shape* shape, glm::vec3& center, float& radius) {
+    switch (shape->getType()) {
+        case CAPSULE_SHAPE: {
+            const CapsuleShape* capsule = static_cast<const CapsuleShape*>(shape);
+            glm::vec3 start, end;
+            capsule->getStartPoint(start);
+            capsule->getEndPoint(end);
+            center = 0.5f * (start + end);
+            radius = 0.5f * glm::distance(start, end) + capsule->getRadius();
+            return true;
+        }
+        case AACUBE_SHAPE: {
+            const float HALF_CUBE_DIAGONAL = 0.5f * sqrtf(3.0f);
+            center = shape->getTranslation();
+            radius = HALF_CUBE_DIAGONAL * static_cast<const AACubeShape*>(shape)->getScale();
+            return true;
+        }
+        case SPHERE_SHAPE:
+        case LIST_SHAPE:
+            center = shape->getTranslation();
+            radius = shape->getBoundingRadius();
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+void AACubeBatch::clear() {
+    _count = 0;
+    _bounds.clear();
+}
+
+void AACubeBatch::addCube(const AACube& cube) {
+    int index = _count++;
+    int place = index % SHAPE_BATCH_BLOCK_SIZE;
+    if (place == 0) {
+        // start a new block, the unused places in it are cubes at the far corner that nothing is ever in
+        int blockStart = _bounds.size();
+        _bounds.resize(blockStart + FLOATS_PER_BLOCK);
+        float* block = _bounds.data() + blockStart;
+        for (int i = 0; i < FLOATS_PER_BLOCK; ++i) {
+            block[i] = FLT_MAX;
+        }
+    }
+    float* block = _bounds.data() + (index / SHAPE_BATCH_BLOCK_SIZE) * FLOATS_PER_BLOCK;
+    block[CORNER_X * SHAPE_BATCH_BLOCK_SIZE + place] = cube.getCorner().x;
+    block[CORNER_Y * SHAPE_BATCH_BLOCK_SIZE + place] = cube.getCorner().y;
+    block[CORNER_Z * SHAPE_BATCH_BLOCK_SIZE + place] = cube.getCorner().z;
+    block[SCALE * SHAPE_BATCH_BLOCK_SIZE + place] = cube.getScale();
+}
+
+AACube AACubeBatch::getCube(int index) const {
+    return AACube(glm::vec3(bound(index, CORNER_X), bound(index, CORNER_Y), bound(index, CORNER_Z)), bound(index, SCALE));
+}
+
+// the same test as AACube::expandedContains()
+#ifdef HIFI_HAVE_SSE
+static inline __m128 isWithinExpanded(__m128 value, __m128 corner, __m128 size, __m128 expansion) {
+    return _mm_and_ps(_mm_cmpge_ps(value, _mm_sub_ps(corner, expansion)),
+        _mm_cmple_ps(value, _mm_add_ps(_mm_add_ps(corner, size), expansion)));
+}
+#else
+static bool isWithinExpanded(float value, float corner, float size, float expansion) {
+    return value >= corner - expansion && value <= corner + size + expansion;
+}
+#endif
+
+int AACubeBatch::findContaining(int block, const glm::vec3& point, float expansion) const {
+#ifdef HIFI_HAVE_SSE
+    const float* bounds = _bounds.constData() + block * FLOATS_PER_BLOCK;
+    __m128 scale = _mm_loadu_ps(bounds + SCALE * SHAPE_BATCH_BLOCK_SIZE);
+    __m128 expansions = _mm_set1_ps(expansion);
+    __m128 inside = _mm_and_ps(_mm_and_ps(
+        isWithinExpanded(_mm_set1_ps(point.x), _mm_loadu_ps(bounds + CORNER_X * SHAPE_BATCH_BLOCK_SIZE), scale, expansions),
+        isWithinExpanded(_mm_set1_ps(point.y), _mm_loadu_ps(bounds + CORNER_Y * SHAPE_BATCH_BLOCK_SIZE), scale, expansions)),
+        isWithinExpanded(_mm_set1_ps(point.z), _mm_loadu_ps(bounds + CORNER_Z * SHAPE_BATCH_BLOCK_SIZE), scale, expansions));
+    return _mm_movemask_ps(inside);
+#else
+    int containing = 0;
+    for (int i = 0; i < SHAPE_BATCH_BLOCK_SIZE; ++i) {
+        int index = block * SHAPE_BATCH_BLOCK_SIZE + i;
+        float scale = bound(index, SCALE);
+        if (isWithinExpanded(point.x, bound(index, CORNER_X), scale, expansion) &&
+                isWithinExpanded(point.y, bound(index, CORNER_Y), scale, expansion) &&
+                isWithinExpanded(point.z, bound(index, CORNER_Z), scale, expansion)) {
+            containing |= (1 << i);
+        }
+    }
+    return containing;
+#endif
+}
+
+// the segment is tested against each cube on the three axes of the cube and the three at right angles to both the
+// segment and one of those, with the segment and the cube both measured from their centers
+#ifdef HIFI_HAVE_SSE
+static inline __m128 absolute(__m128 value) {
+    return _mm_andnot_ps(_mm_set1_ps(-0.0f), value);
+}
+
+static inline __m128 isWithinReach(__m128 distance, __m128 reach) {
+    return _mm_cmple_ps(absolute(distance), reach);
+}
+#endif
+
+int AACubeBatch::findIntersectingSegment(int block, const glm::vec3& start, const glm::vec3& end, float expansion) const {
+    glm::vec3 middle = 0.5f * (start + end);
+    glm::vec3 halfSpan = 0.5f * (end - start);
+    glm::vec3 halfExtent = glm::abs(halfSpan);
+    float margin = computePositionMargin(middle);
+
+    // the places past the last cube are never hits, their bounds aren't usable here
+    int unused = (block + 1) * SHAPE_BATCH_BLOCK_SIZE - _count;
+    int used = (unused > 0) ? (1 << (SHAPE_BATCH_BLOCK_SIZE - unused)) - 1 : (1 << SHAPE_BATCH_BLOCK_SIZE) - 1;
+
+#ifdef HIFI_HAVE_SSE
+    const float* bounds = _bounds.constData() + block * FLOATS_PER_BLOCK;
+    __m128 halfScale = _mm_mul_ps(_mm_loadu_ps(bounds + SCALE * SHAPE_BATCH_BLOCK_SIZE), _mm_set1_ps(0.5f));
+    __m128 margins = _mm_set1_ps(margin);
+    __m128 reach = _mm_add_ps(_mm_mul_ps(_mm_add_ps(halfScale, _mm_set1_ps(expansion)),
+        _mm_set1_ps(CANDIDATE_RADIUS_MARGIN)), margins);
+    __m128 offsetX = _mm_sub_ps(_mm_sub_ps(_mm_set1_ps(middle.x),
+        _mm_loadu_ps(bounds + CORNER_X * SHAPE_BATCH_BLOCK_SIZE)), halfScale);
+    __m128 offsetY = _mm_sub_ps(_mm_sub_ps(_mm_set1_ps(middle.y),
+        _mm_loadu_ps(bounds + CORNER_Y * SHAPE_BATCH_BLOCK_SIZE)), halfScale);
+    __m128 offsetZ = _mm_sub_ps(_mm_sub_ps(_mm_set1_ps(middle.z),
+        _mm_loadu_ps(bounds + CORNER_Z * SHAPE_BATCH_BLOCK_SIZE)), halfScale);
+    __m128 spanX = _mm_set1_ps(halfSpan.x);
+    __m128 spanY = _mm_set1_ps(halfSpan.y);
+    __m128 spanZ = _mm_set1_ps(halfSpan.z);
+
+    __m128 hits = _mm_and_ps(_mm_and_ps(
+        isWithinReach(offsetX, _mm_add_ps(reach, _mm_set1_ps(halfExtent.x))),
+        isWithinReach(offsetY, _mm_add_ps(reach, _mm_set1_ps(halfExtent.y)))),
+        isWithinReach(offsetZ, _mm_add_ps(reach, _mm_set1_ps(halfExtent.z))));
+    hits = _mm_and_ps(hits, _mm_and_ps(_mm_and_ps(
+        isWithinReach(_mm_sub_ps(_mm_mul_ps(offsetY, spanZ), _mm_mul_ps(offsetZ, spanY)),
+            _mm_mul_ps(reach, _mm_set1_ps(halfExtent.y + halfExtent.z))),
+        isWithinReach(_mm_sub_ps(_mm_mul_ps(offsetZ, spanX), _mm_mul_ps(offsetX, spanZ)),
+            _mm_mul_ps(reach, _mm_set1_ps(halfExtent.z + halfExtent.x)))),
+        isWithinReach(_mm_sub_ps(_mm_mul_ps(offsetX, spanY), _mm_mul_ps(offsetY, spanX)),
+            _mm_mul_ps(reach, _mm_set1_ps(halfExtent.x + halfExtent.y)))));
+    return _mm_movemask_ps(hits) & used;
+#else
+    int hits = 0;
+    for (int i = 0; i < SHAPE_BATCH_BLOCK_SIZE; ++i) {
+        if (!(used & (1 << i))) {
+            continue;
+        }
+        int index = block * SHAPE_BATCH_BLOCK_SIZE + i;
+        float halfScale = 0.5f * bound(index, SCALE);
+        float reach = (halfScale + expansion) * CANDIDATE_RADIUS_MARGIN + margin;
+        glm::vec3 offset = middle - glm::vec3(bound(index, CORNER_X), bound(index, CORNER_Y), bound(index, CORNER_Z)) -
+            glm::vec3(halfScale, halfScale, halfScale);
+        if (fabsf(offset.x) <= reach + halfExtent.x &&
+                fabsf(offset.y) <= reach + halfExtent.y &&
+                fabsf(offset.z) <= reach + halfExtent.z &&
+                fabsf(offset.y * halfSpan.z - offset.z * halfSpan.y) <= reach * (halfExtent.y + halfExtent.z) &&
+                fabsf(offset.z * halfSpan.x - offset.x * halfSpan.z) <= reach * (halfExtent.z + halfExtent.x) &&
+                fabsf(offset.x * halfSpan.y - offset.y * halfSpan.x) <= reach * (halfExtent.x + halfExtent.y)) {
+            hits |= (1 << i);
+        }
+    }
+    return hits;
+#endif
+}
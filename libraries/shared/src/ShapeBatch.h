@@ -0,0 +1,107 @@
+//
+//  ShapeBatch.h
+//  libraries/shared/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_ShapeBatch_h
+#define hifi_ShapeBatch_h
+
+#include <QVector>
+
+#include <glm/glm.hpp>
+
+#include "AACube.h"
+
+class Shape;
+
+/// The number of shapes or cubes a batch tests at once.
+const int SHAPE_BATCH_BLOCK_SIZE = 4;
+
+/// The shapes one or more shapes get collided with, with the bounds of each kept as a segment and a radius (zero length
+/// for everything but capsules). The bounds are stored four shapes to a block, one array per coordinate, so a block can be
+/// tested against a bounding sphere in one go and only the shapes that might touch it go on to the narrowphase.
+class ShapeBatch {
+public:
+    /// removes the shapes, but keeps the memory for the next set
+    void clear();
+
+    /// adds a shape, NULL shapes take an index but are never candidates
+    void addShape(const Shape* shape);
+
+    /// adds the shapes of a list from startIndex on
+    void addShapes(const QVector<Shape*>& shapes, int startIndex = 0);
+
+    int size() const { return _shapes.size(); }
+    const Shape* getShape(int index) const { return _shapes.at(index); }
+
+    int getBlockCount() const { return _bounds.size() / FLOATS_PER_BLOCK; }
+
+    /// \return a bit for each shape of the block whose bounds might come within radius of the center: bit k is the shape at
+    /// block * SHAPE_BATCH_BLOCK_SIZE + k. The test leaves a margin for rounding, it never misses a shape that touches.
+    int findCandidates(int block, const glm::vec3& center, float radius) const;
+
+    /// the same test one shape at a time, for reference
+    bool isCandidate(int index, const glm::vec3& center, float radius) const;
+
+    /// \return a sphere that holds all of the shape, or false for shapes like planes that have no bounds
+    static bool computeBoundingSphere(const Shape* shape, glm::vec3& center, float& radius);
+
+private:
+    enum { X, Y, Z, AXIS_X, AXIS_Y, AXIS_Z, INVERSE_AXIS_LENGTH2, RADIUS, FLOATS_PER_SHAPE };
+    static const int FLOATS_PER_BLOCK = FLOATS_PER_SHAPE * SHAPE_BATCH_BLOCK_SIZE;
+
+    float& bound(int index, int coordinate) {
+        return _bounds[(index / SHAPE_BATCH_BLOCK_SIZE) * FLOATS_PER_BLOCK + coordinate * SHAPE_BATCH_BLOCK_SIZE +
+            index % SHAPE_BATCH_BLOCK_SIZE];
+    }
+    float bound(int index, int coordinate) const {
+        return _bounds.at((index / SHAPE_BATCH_BLOCK_SIZE) * FLOATS_PER_BLOCK + coordinate * SHAPE_BATCH_BLOCK_SIZE +
+            index % SHAPE_BATCH_BLOCK_SIZE);
+    }
+
+    QVector<const Shape*> _shapes;
+    QVector<float> _bounds;
+};
+
+/// Axis aligned cubes kept four to a block, one array per coordinate, so a point can be tested against a block of them
+/// in one go. The test is the same as AACube::expandedContains(), with the same results.
+class AACubeBatch {
+public:
+    AACubeBatch() : _count(0) { }
+
+    void clear();
+    void addCube(const AACube& cube);
+
+    int size() const { return _count; }
+    AACube getCube(int index) const;
+
+    int getBlockCount() const { return _bounds.size() / FLOATS_PER_BLOCK; }
+
+    /// \return a bit for each cube of the block that contains the point once expanded, bit k is the cube at
+    /// block * SHAPE_BATCH_BLOCK_SIZE + k
+    int findContaining(int block, const glm::vec3& point, float expansion) const;
+
+    /// \return a bit for each cube of the block that the segment might pass through once the cube is expanded, laid out
+    /// as for findContaining(). This is a separating axis test with a margin for rounding, so it never misses a cube that
+    /// AACube::expandedIntersectsSegment() hits, but may keep one that only grazes it.
+    int findIntersectingSegment(int block, const glm::vec3& start, const glm::vec3& end, float expansion) const;
+
+private:
+    enum { CORNER_X, CORNER_Y, CORNER_Z, SCALE, FLOATS_PER_CUBE };
+    static const int FLOATS_PER_BLOCK = FLOATS_PER_CUBE * SHAPE_BATCH_BLOCK_SIZE;
+
+    float bound(int index, int coordinate) const {
+        return _bounds.at((index / SHAPE_BATCH_BLOCK_SIZE) * FLOATS_PER_BLOCK + coordinate * SHAPE_BATCH_BLOCK_SIZE +
+            index % SHAPE_BATCH_BLOCK_SIZE);
+    }
+
+    int _count;
+    QVector<float> _bounds;
+};
+
+#endif // hifi_ShapeBatch_h
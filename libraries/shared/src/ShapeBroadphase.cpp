@@ -0,0 +1,115 @@
+//
+//  ShapeBroadphase.cpp
+//  libraries/shared/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <cfloat>
+
+#include "AACubeShape.h"
+#include "CapsuleShape.h"
+#include "Shape.h"
+
+#include "ShapeBroadphase.h"
+
+void ShapeBroadphase::addShape(const Shape* shape, int group) {
+    Entry entry;
+    entry.shape = shape;
+    entry.group = group;
+    if (shape) {
+        computeBounds(shape, entry.minimum, entry.maximum);
+    } else {
+        entry.minimum = entry.maximum = glm::vec3(FLT_MAX);
+    }
+    _entries.append(entry);
+}
+
+void ShapeBroadphase::computeBounds(const Shape* shape, glm::vec3& minimum, glm::vec3& maximum) {
+    switch (shape->getType()) {
+        case CAPSULE_SHAPE: {
+            // the bounding radius of a verlet capsule isn't kept up to date as its points move, so use the end points
+            const CapsuleShape* capsule = static_cast<const CapsuleShape*>(shape);
+            glm::vec3 start, end;
+            capsule->getStartPoint(start);
+            capsule->getEndPoint(end);
+            glm::vec3 radius(capsule->getRadius());
+            minimum = glm::min(start, end) - radius;
+            maximum = glm::max(start, end) + radius;
+            break;
+        }
+        case AACUBE_SHAPE: {
+            glm::vec3 halfScale(0.5f * static_cast<const AACubeShape*>(shape)->getScale());
+            minimum = shape->getTranslation() - halfScale;
+            maximum = shape->getTranslation() + halfScale;
+            break;
+        }
+        case SPHERE_SHAPE:
+        case LIST_SHAPE: {
+            glm::vec3 radius(shape->getBoundingRadius());
+            minimum = shape->getTranslation() - radius;
+            maximum = shape->getTranslation() + radius;
+            break;
+        }
+        default:
+            // planes and anything we don't know the extent of overlap everything
+            minimum = glm::vec3(-FLT_MAX);
+            maximum = glm::vec3(FLT_MAX);
+            break;
+    }
+}
+
+void ShapeBroadphase::findOverlaps(int group, QVector<ShapeOverlap>& overlaps) {
+    int numEntries = _entries.size();
+    if (_order.size() != numEntries) {
+        _order.resize(numEntries);
+        for (int i = 0; i < numEntries; ++i) {
+            _order[i] = i;
+        }
+    }
+
+    // insertion sort on the low x edges, the order from last time is usually nearly right
+    for (int i = 1; i < numEntries; ++i) {
+        int index = _order[i];
+        float minimumX = _entries.at(index).minimum.x;
+        int j = i - 1;
+        while (j >= 0 && _entries.at(_order[j]).minimum.x > minimumX) {
+            _order[j + 1] = _order[j];
+            --j;
+        }
+        _order[j + 1] = index;
+    }
+
+    _active.clear();
+    for (int i = 0; i < numEntries; ++i) {
+        int index = _order[i];
+        const Entry& entry = _entries.at(index);
+        if (!entry.shape) {
+            continue;
+        }
+
+        // drop the shapes that end before this one starts, they can't overlap it or anything after it
+        int numKept = 0;
+        for (int j = 0; j < _active.size(); ++j) {
+            if (_entries.at(_active[j]).maximum.x >= entry.minimum.x) {
+                _active[numKept++] = _active[j];
+            }
+        }
+        _active.resize(numKept);
+
+        for (int j = 0; j < numKept; ++j) {
+            int otherIndex = _active[j];
+            const Entry& other = _entries.at(otherIndex);
+            if ((entry.group == group || other.group == group) &&
+                    entry.minimum.y <= other.maximum.y && entry.maximum.y >= other.minimum.y &&
+                    entry.minimum.z <= other.maximum.z && entry.maximum.z >= other.minimum.z) {
+                ShapeOverlap overlap = { qMin(index, otherIndex), qMax(index, otherIndex) };
+                overlaps.append(overlap);
+            }
+        }
+        _active.append(index);
+    }
+}
@@ -0,0 +1,60 @@
+//
+//  ShapeBroadphase.h
+//  libraries/shared/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_ShapeBroadphase_h
+#define hifi_ShapeBroadphase_h
+
+#include <QVector>
+
+#include <glm/glm.hpp>
+
+class Shape;
+
+/// two shapes with overlapping bounds, by the order they were added in, first < second
+class ShapeOverlap {
+public:
+    int first;
+    int second;
+};
+
+/// Sweep and prune over the bounding boxes of shapes: the boxes are sorted by their low edge along x and swept in that
+/// order, so a shape is only compared with the shapes whose boxes it overlaps along x. The sorted order is kept from one
+/// call to the next and fixed up with an insertion sort, which is close to linear when the shapes move a little at a time.
+class ShapeBroadphase {
+public:
+    /// removes the shapes, but keeps the sorted order for the next set of shapes
+    void clear() { _entries.clear(); }
+
+    /// adds a shape, NULL shapes take a place in the order but never overlap anything
+    void addShape(const Shape* shape, int group);
+
+    int getShapeCount() const { return _entries.size(); }
+
+    /// finds the pairs with overlapping bounds that have at least one shape in the group, in no particular order
+    void findOverlaps(int group, QVector<ShapeOverlap>& overlaps);
+
+    /// a box that holds all of the shape, or an unbounded one for shapes like planes
+    static void computeBounds(const Shape* shape, glm::vec3& minimum, glm::vec3& maximum);
+
+private:
+    class Entry {
+    public:
+        const Shape* shape;
+        int group;
+        glm::vec3 minimum;
+        glm::vec3 maximum;
+    };
+
+    QVector<Entry> _entries;
+    QVector<int> _order;
+    QVector<int> _active;
+};
+
+#endif // hifi_ShapeBroadphase_h
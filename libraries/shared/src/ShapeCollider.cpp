@@ -18,6 +18,7 @@
 #include "GeometryUtil.h"
 #include "ListShape.h"
 #include "PlaneShape.h"
+#include "ShapeBatch.h"
 #include "SphereShape.h"
 
 #include "StreamUtils.h"
@@ -110,6 +111,44 @@ bool collideShapeWithShapes(const Shape* shapeA, const QVector<Shape*>& shapes,
 }
 
 bool collideShapesWithShapes(const QVector<Shape*>& shapesA, const QVector<Shape*>& shapesB, CollisionList& collisions) {
+    // gather the bounds of shapesB once, so that each shape of A can skip most of them a block at a time
+    ShapeBatch batch;
+    batch.addShapes(shapesB);
+    return collideShapesWithBatch(shapesA, batch, collisions);
+}
+
+// every shape of a block, for shapes that have no bounds
+const int ALL_BLOCK_CANDIDATES = (1 << SHAPE_BATCH_BLOCK_SIZE) - 1;
+
+bool collideShapeWithBatch(const Shape* shapeA, const ShapeBatch& batch, CollisionList& collisions) {
+    if (!shapeA) {
+        return false;
+    }
+    glm::vec3 center;
+    float radius;
+    bool bounded = ShapeBatch::computeBoundingSphere(shapeA, center, radius);
+    bool collided = false;
+    int numShapes = batch.size();
+    int numBlocks = batch.getBlockCount();
+    for (int block = 0; block < numBlocks; ++block) {
+        int candidates = bounded ? batch.findCandidates(block, center, radius) : ALL_BLOCK_CANDIDATES;
+        for (int i = block * SHAPE_BATCH_BLOCK_SIZE; candidates != 0 && i < numShapes; ++i, candidates >>= 1) {
+            const Shape* shapeB = batch.getShape(i);
+            if (!(candidates & 1) || !shapeB) {
+                continue;
+            }
+            if (collideShapes(shapeA, shapeB, collisions)) {
+                collided = true;
+                if (collisions.isFull()) {
+                    return true;
+                }
+            }
+        }
+    }
+    return collided;
+}
+
+bool collideShapesWithBatch(const QVector<Shape*>& shapesA, const ShapeBatch& batch, CollisionList& collisions) {
     bool collided = false;
     int numShapesA = shapesA.size();
     for (int i = 0; i < numShapesA; ++i) {
@@ -117,7 +156,7 @@ bool collideShapesWithShapes(const QVector<Shape*>& shapesA, const QVector<Shape
         if (!shapeA) {
             continue;
         }
-        if (collideShapeWithShapes(shapeA, shapesB, 0, collisions)) {
+        if (collideShapeWithBatch(shapeA, batch, collisions)) {
             collided = true;
             if (collisions.isFull()) {
                 break;
@@ -127,6 +166,27 @@ bool collideShapesWithShapes(const QVector<Shape*>& shapesA, const QVector<Shape
     return collided;
 }
 
+bool collideShapeWithAACubesLegacy(const Shape* shapeA, const AACubeBatch& cubes, CollisionList& collisions) {
+    const glm::vec3& center = shapeA->getTranslation();
+    float radius = shapeA->getBoundingRadius();
+    bool collided = false;
+    int numCubes = cubes.size();
+    int numBlocks = cubes.getBlockCount();
+    for (int block = 0; block < numBlocks; ++block) {
+        int containing = cubes.findContaining(block, center, radius);
+        for (int i = block * SHAPE_BATCH_BLOCK_SIZE; containing != 0 && i < numCubes; ++i, containing >>= 1) {
+            if (!(containing & 1)) {
+                continue;
+            }
+            AACube cube = cubes.getCube(i);
+            if (collideShapeWithAACubeLegacy(shapeA, cube.calcCenter(), cube.getScale(), collisions)) {
+                collided = true;
+            }
+        }
+    }
+    return collided;
+}
+
 bool collideShapeWithAACubeLegacy(const Shape* shapeA, const glm::vec3& cubeCenter, float cubeSide, CollisionList& collisions) {
     Shape::Type typeA = shapeA->getType();
     if (typeA == SPHERE_SHAPE) {
@@ -18,7 +18,9 @@
 #include "RayIntersectionInfo.h"
 #include "SharedUtil.h" 
 
+class AACubeBatch;
 class Shape;
+class ShapeBatch;
 class SphereShape;
 class CapsuleShape;
 
@@ -36,6 +38,23 @@ namespace ShapeCollider {
     bool collideShapeWithShapes(const Shape* shapeA, const QVector<Shape*>& shapes, int startIndex, CollisionList& collisions);
     bool collideShapesWithShapes(const QVector<Shape*>& shapesA, const QVector<Shape*>& shapesB, CollisionList& collisions);
 
+    /// Gives the same collisions, in the same order, as collideShapeWithShapes() on the shapes the batch was built from:
+    /// the shapes whose bounds can't reach shapeA are dropped a block at a time and the rest go through the dispatch table.
+    /// \param shapeA pointer to a shape (may be NULL)
+    /// \param batch the shapes to collide with
+    /// \param[out] collisions where to append collision details
+    /// \return true if shapeA collides with any shape of the batch
+    bool collideShapeWithBatch(const Shape* shapeA, const ShapeBatch& batch, CollisionList& collisions);
+    bool collideShapesWithBatch(const QVector<Shape*>& shapesA, const ShapeBatch& batch, CollisionList& collisions);
+
+    /// The same as calling collideShapeWithAACubeLegacy() for each cube, in order, whose bounds expanded by the bounding
+    /// radius of shapeA contain its translation.
+    /// \param shapeA a pointer to a shape (cannot be NULL)
+    /// \param cubes the cubes to collide with
+    /// \param[out] collisions where to append collision details
+    /// \return true if shapeA collides with any of the cubes
+    bool collideShapeWithAACubesLegacy(const Shape* shapeA, const AACubeBatch& cubes, CollisionList& collisions);
+
     /// \param shapeA a pointer to a shape (cannot be NULL)
     /// \param cubeCenter center of cube
     /// \param cubeSide lenght of side of cube
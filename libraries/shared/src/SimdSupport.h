@@ -0,0 +1,27 @@
+//
+//  SimdSupport.h
+//  libraries/shared/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_SimdSupport_h
+#define hifi_SimdSupport_h
+
+// which SSE intrinsics the compiler lets us use, code that uses them keeps a plain C++ path for the rest. MSVC doesn't
+// define __SSE__, but every x64 target has SSE2 and on x86 /arch:SSE and up set _M_IX86_FP.
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define HIFI_HAVE_SSE
+#include <xmmintrin.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HIFI_HAVE_SSE2
+#include <emmintrin.h>
+#endif
+
+#endif // hifi_SimdSupport_h
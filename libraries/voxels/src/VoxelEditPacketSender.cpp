@@ -18,6 +18,10 @@
 #define GUESS_OF_VOXELCODE_SIZE 10
 #define MAXIMUM_EDIT_VOXEL_MESSAGE_SIZE 1500
 #define SIZE_OF_COLOR_DATA sizeof(rgbColor)
+
+// past this many held edits we pack them rather than keep scanning them for overlaps
+const int MAX_COALESCED_VOXEL_EDITS = 256;
+
 /// creates an "insert" or "remove" voxel message for a voxel code corresponding to the closest voxel which encloses a cube 
 /// with lower corners at x,y,z, having side of length S. The input values x,y,z range 0.0 <= v < 1.0 message should be either
 /// PacketTypeVoxelSet, PacketTypeVoxelSetDestructive, or PacketTypeVoxelErase. The buffer is returned to caller becomes
@@ -138,11 +142,66 @@ void VoxelEditPacketSender::queueVoxelEditMessages(PacketType type, int numberOf
         int sizeOut = 0;
 
         if (encodeVoxelEditMessageDetails(type, 1, &details[i], &bufferOut[0], _maxPacketSize, sizeOut)) {
-            queueOctreeEditMessage(type, bufferOut, sizeOut, satoshiCostForMessage(details[i]));
+            queueCoalescedVoxelEditMessage(type, bufferOut, sizeOut, satoshiCostForMessage(details[i]));
         }
     }    
 }
 
+void VoxelEditPacketSender::queueCoalescedVoxelEditMessage(PacketType type, unsigned char* codeColorBuffer,
+                                                           size_t length, qint64 satoshiCost) {
+    if (_editCoalescingWindowUsecs == 0) {
+        queueOctreeEditMessage(type, codeColorBuffer, length, satoshiCost);
+        return;
+    }
+
+    QByteArray octalCode(reinterpret_cast<const char*>(codeColorBuffer),
+                         bytesRequiredForCodeLength(numberOfThreeBitSectionsInCode(codeColorBuffer)));
+    QByteArray codeColor(reinterpret_cast<const char*>(codeColorBuffer), length);
+
+    QMutexLocker locker(&_coalescedEditsLock);
+
+    QHash<QByteArray, int>::const_iterator heldIndex = _coalescedVoxelEditIndices.constFind(octalCode);
+    if (heldIndex != _coalescedVoxelEditIndices.constEnd() && _coalescedVoxelEdits[heldIndex.value()].type == type) {
+        // only the last color painted on a voxel matters
+        CoalescedVoxelEdit& heldEdit = _coalescedVoxelEdits[heldIndex.value()];
+        heldEdit.codeColor = codeColor;
+        heldEdit.satoshiCost = satoshiCost;
+        _coalescedEditCount.ref();
+        return;
+    }
+
+    // an erase of a voxel we're setting, or a set inside or around a voxel we're erasing, only means the same thing
+    // on the server if it lands after what we're holding, so everything held goes out first
+    bool overlapsHeldEdit = (heldIndex != _coalescedVoxelEditIndices.constEnd());
+    const unsigned char* code = reinterpret_cast<const unsigned char*>(octalCode.constData());
+    for (int i = 0; i < _coalescedVoxelEdits.size() && !overlapsHeldEdit; i++) {
+        const unsigned char* heldCode = reinterpret_cast<const unsigned char*>(_coalescedVoxelEdits[i].codeColor.constData());
+        overlapsHeldEdit = isAncestorOf(heldCode, code) || isAncestorOf(code, heldCode);
+    }
+    if (overlapsHeldEdit) {
+        flushCoalescedEdits();
+    }
+
+    CoalescedVoxelEdit heldEdit = { type, codeColor, satoshiCost };
+    _coalescedVoxelEditIndices.insert(octalCode, _coalescedVoxelEdits.size());
+    _coalescedVoxelEdits.append(heldEdit);
+    coalescedEditHeld();
+
+    if (_coalescedVoxelEdits.size() >= MAX_COALESCED_VOXEL_EDITS) {
+        flushCoalescedEdits();
+    }
+}
+
+void VoxelEditPacketSender::packCoalescedEdits() {
+    foreach (const CoalescedVoxelEdit& heldEdit, _coalescedVoxelEdits) {
+        queueOctreeEditMessage(heldEdit.type,
+                               reinterpret_cast<unsigned char*>(const_cast<char*>(heldEdit.codeColor.constData())),
+                               heldEdit.codeColor.size(), heldEdit.satoshiCost);
+    }
+    _coalescedVoxelEdits.clear();
+    _coalescedVoxelEditIndices.clear();
+}
+
 qint64 VoxelEditPacketSender::satoshiCostForMessage(const VoxelDetail& details) {    
     if (_satoshisPerVoxel == 0 && _satoshisPerMeterCubed == 0) {
         return 0;
@@ -29,7 +29,7 @@ public:
     /// node or nodes the packet should be sent to. Can be called even before voxel servers are known, in which case up to 
     /// MaxPendingMessages will be buffered and processed when voxel servers are known.
     void queueVoxelEditMessage(PacketType type, unsigned char* codeColorBuffer, size_t length) {
-        queueOctreeEditMessage(type, codeColorBuffer, length);
+        queueCoalescedVoxelEditMessage(type, codeColorBuffer, length, 0);
     }
 
     /// Queues an array of several voxel edit messages. Will potentially send a pending multi-command packet. Determines 
@@ -56,8 +56,23 @@ public:
     
     qint64 satoshiCostForMessage(const VoxelDetail& details);
     
+protected:
+    virtual void packCoalescedEdits();
+
 private:
+    /// holds a single octcode/color edit for the coalescing window, a later edit of the same type to the same voxel
+    /// replaces it in place
+    void queueCoalescedVoxelEditMessage(PacketType type, unsigned char* codeColorBuffer, size_t length, qint64 satoshiCost);
+
     qint64 _satoshisPerVoxel;
     qint64 _satoshisPerMeterCubed;
+
+    struct CoalescedVoxelEdit {
+        PacketType type;
+        QByteArray codeColor;
+        qint64 satoshiCost;
+    };
+    QVector<CoalescedVoxelEdit> _coalescedVoxelEdits; // in the order they will be packed
+    QHash<QByteArray, int> _coalescedVoxelEditIndices; // octal code to index in _coalescedVoxelEdits
 };
 #endif // hifi_VoxelEditPacketSender_h
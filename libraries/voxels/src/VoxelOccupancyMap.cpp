@@ -0,0 +1,548 @@
+//
+//  VoxelOccupancyMap.cpp
+//  libraries/voxels/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <algorithm>
+
+#include <GeometryUtil.h>
+#include <Shape.h>
+#include <ShapeBatch.h>
+#include <ShapeCollider.h>
+#include <SharedUtil.h>
+
+#include "VoxelDetail.h"
+#include "VoxelTree.h"
+#include "VoxelTreeElement.h"
+
+#include "VoxelOccupancyMap.h"
+
+const int CELLS_PER_SIDE = VoxelOccupancyMap::BRICKS_PER_SIDE * VoxelOccupancyMap::CELLS_PER_BRICK_SIDE;
+const float BRICK_SCALE = 1.0f / VoxelOccupancyMap::BRICKS_PER_SIDE;
+
+// how many bits of each axis orderOf() keeps, as many as an octal code key has sections
+const int ORDER_BITS_PER_AXIS = MAX_OCTAL_CODE_KEY_SECTIONS;
+
+// queries are grown by this much (in tree units) before they're turned into cells, so that elements that only touch
+// the query on a cell boundary are still looked at by the exact tests
+const float QUERY_PADDING = EPSILON;
+
+static quint64 packCoordinates(int x, int y, int z) {
+    return ((quint64)x << 32) | ((quint64)y << 16) | (quint64)z;
+}
+
+static void unpackCoordinates(quint64 key, int& x, int& y, int& z) {
+    x = (int)(key >> 32);
+    y = (int)((key >> 16) & 0xFFFF);
+    z = (int)(key & 0xFFFF);
+}
+
+static int toGrid(float value, int resolution) {
+    return qBound(0, (int)floorf(value * resolution), resolution - 1);
+}
+
+static quint64 brickKeyAt(const glm::vec3& corner) {
+    return packCoordinates(toGrid(corner.x, VoxelOccupancyMap::BRICKS_PER_SIDE),
+                           toGrid(corner.y, VoxelOccupancyMap::BRICKS_PER_SIDE),
+                           toGrid(corner.z, VoxelOccupancyMap::BRICKS_PER_SIDE));
+}
+
+// the bit for a child of a brick or summary node, children are 4 to a side
+static quint64 childBit(int x, int y, int z) {
+    return Q_UINT64_C(1) << ((x << 4) | (y << 2) | z);
+}
+
+// the bits of the cells from minimum to maximum, inclusive, both given within the brick
+static quint64 cellMask(const int* minimum, const int* maximum) {
+    quint64 mask = 0;
+    for (int x = minimum[0]; x <= maximum[0]; x++) {
+        for (int y = minimum[1]; y <= maximum[1]; y++) {
+            for (int z = minimum[2]; z <= maximum[2]; z++) {
+                mask |= childBit(x, y, z);
+            }
+        }
+    }
+    return mask;
+}
+
+static bool overlaps(const VoxelOccupancyBox& box, const glm::vec3& minimum, const glm::vec3& maximum) {
+    return box.corner.x <= maximum.x && box.corner.x + box.scale >= minimum.x &&
+        box.corner.y <= maximum.y && box.corner.y + box.scale >= minimum.y &&
+        box.corner.z <= maximum.z && box.corner.z + box.scale >= minimum.z;
+}
+
+static bool comesBefore(const VoxelOccupancyBox* first, const VoxelOccupancyBox* second) {
+    return first->order < second->order || (first->order == second->order && first->scale > second->scale);
+}
+
+static quint64 spreadBits(quint64 value) {
+    value &= 0x1FFFFF;
+    value = (value | value << 32) & Q_UINT64_C(0x001F00000000FFFF);
+    value = (value | value << 16) & Q_UINT64_C(0x001F0000FF0000FF);
+    value = (value | value << 8) & Q_UINT64_C(0x100F00F00F00F00F);
+    value = (value | value << 4) & Q_UINT64_C(0x10C30C30C30C30C3);
+    value = (value | value << 2) & Q_UINT64_C(0x1249249249249249);
+    return value;
+}
+
+quint64 VoxelOccupancyMap::orderOf(const glm::vec3& corner) {
+    // x is the high bit of a child index, then y, then z, see OctreeElement::getMyChildContainingPoint()
+    const float RESOLUTION = (float)(1 << ORDER_BITS_PER_AXIS);
+    return (spreadBits((quint64)(corner.x * RESOLUTION)) << 2) | (spreadBits((quint64)(corner.y * RESOLUTION)) << 1) |
+        spreadBits((quint64)(corner.z * RESOLUTION));
+}
+
+static VoxelOccupancyBox boxFor(const VoxelTreeElement* element) {
+    const AACube& cube = element->getAACube();
+    VoxelOccupancyBox box;
+    box.corner = cube.getCorner();
+    box.scale = cube.getScale();
+    box.order = VoxelOccupancyMap::orderOf(box.corner);
+    box.color[0] = element->getColor()[RED_INDEX];
+    box.color[1] = element->getColor()[GREEN_INDEX];
+    box.color[2] = element->getColor()[BLUE_INDEX];
+    box.isLeaf = element->isLeaf();
+    return box;
+}
+
+// adds the colored elements of a subtree in the order the tree recursion would visit them
+static void gatherBoxes(VoxelTreeElement* element, QVector<VoxelOccupancyBox>& boxes) {
+    if (element->isColored()) {
+        boxes.append(boxFor(element));
+    }
+    for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+        VoxelTreeElement* child = element->getChildAtIndex(i);
+        if (child) {
+            gatherBoxes(child, boxes);
+        }
+    }
+}
+
+VoxelOccupancyMap::VoxelOccupancyMap(VoxelTree* tree) :
+    _tree(tree),
+    _needsRebuild(true),
+    _coarseListChanged(false)
+{
+    OctreeElement::addDeleteHook(this);
+    OctreeElement::addUpdateHook(this);
+}
+
+VoxelOccupancyMap::~VoxelOccupancyMap() {
+    OctreeElement::removeUpdateHook(this);
+    OctreeElement::removeDeleteHook(this);
+}
+
+void VoxelOccupancyMap::elementDeleted(OctreeElement* element) {
+    markDirty(element);
+}
+
+void VoxelOccupancyMap::elementUpdated(OctreeElement* element) {
+    markDirty(element);
+}
+
+void VoxelOccupancyMap::markDirty(OctreeElement* element) {
+    // the hooks are called for the elements of every tree, and from the element constructors and destructors, so this
+    // only notes where the element is and leaves looking at the tree to update()
+    const AACube& cube = element->getAACube();
+    if (cube.getScale() > BRICK_SCALE) {
+        OctalCodeKey key = element->getOctalCodeKey();
+        QMutexLocker locker(&_dirtyMutex);
+        if (!_needsRebuild) {
+            _dirtyCoarseKeys.insert(key);
+        }
+    } else {
+        quint64 brickKey = brickKeyAt(cube.getCorner());
+        QMutexLocker locker(&_dirtyMutex);
+        if (!_needsRebuild) {
+            _dirtyBricks.insert(brickKey);
+        }
+    }
+}
+
+void VoxelOccupancyMap::update() {
+    QSet<quint64> dirtyBricks;
+    QSet<OctalCodeKey> dirtyCoarseKeys;
+    bool needsRebuild;
+    {
+        QMutexLocker locker(&_dirtyMutex);
+        needsRebuild = _needsRebuild;
+        _needsRebuild = false;
+        dirtyBricks.swap(_dirtyBricks);
+        dirtyCoarseKeys.swap(_dirtyCoarseKeys);
+    }
+    if (needsRebuild) {
+        rebuild();
+    } else {
+        foreach (quint64 brickKey, dirtyBricks) {
+            updateBrick(brickKey);
+        }
+        foreach (const OctalCodeKey& key, dirtyCoarseKeys) {
+            updateCoarseElement(key);
+        }
+    }
+    if (_coarseListChanged) {
+        _coarseList = _coarseBoxes.values().toVector();
+        _coarseListChanged = false;
+    }
+}
+
+void VoxelOccupancyMap::rebuild() {
+    _bricks.clear();
+    for (int level = 0; level < SUMMARY_LEVELS; level++) {
+        _summaries[level].clear();
+    }
+    _coarseBoxes.clear();
+    _coarseListChanged = true;
+    if (_tree->getRoot()) {
+        rebuildFrom(_tree->getRoot());
+    }
+}
+
+void VoxelOccupancyMap::rebuildFrom(VoxelTreeElement* element) {
+    if (element->getAACube().getScale() > BRICK_SCALE) {
+        if (element->isColored()) {
+            _coarseBoxes.insert(element->getOctalCodeKey(), boxFor(element));
+        }
+        for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+            VoxelTreeElement* child = element->getChildAtIndex(i);
+            if (child) {
+                rebuildFrom(child);
+            }
+        }
+    } else {
+        setBrick(brickKeyAt(element->getAACube().getCorner()), element);
+    }
+}
+
+OctreeElement* VoxelOccupancyMap::findElement(const OctalCodeKey& key) const {
+    OctreeElement* element = _tree->getRoot();
+    for (int depth = 0; element && depth < key.getDepth(); depth++) {
+        element = element->getChildAtIndex(key.getAncestor(depth).getBranchTowards(key));
+    }
+    return element;
+}
+
+void VoxelOccupancyMap::updateBrick(quint64 brickKey) {
+    int x, y, z;
+    unpackCoordinates(brickKey, x, y, z);
+    OctalCodeKey key = OctalCodeKey::fromPoint((x + 0.5f) * BRICK_SCALE, (y + 0.5f) * BRICK_SCALE,
+                                               (z + 0.5f) * BRICK_SCALE, BRICK_SCALE);
+    setBrick(brickKey, static_cast<VoxelTreeElement*>(findElement(key)));
+}
+
+void VoxelOccupancyMap::setBrick(quint64 brickKey, VoxelTreeElement* brickElement) {
+    VoxelOccupancyBrick brick;
+    brick.cells = 0;
+    if (brickElement) {
+        gatherBoxes(brickElement, brick.boxes);
+    }
+
+    QHash<quint64, VoxelOccupancyBrick>::iterator found = _bricks.find(brickKey);
+    if (brick.boxes.isEmpty()) {
+        if (found != _bricks.end()) {
+            _bricks.erase(found);
+            removeFromSummaries(brickKey);
+        }
+        return;
+    }
+
+    int x, y, z;
+    unpackCoordinates(brickKey, x, y, z);
+    int brickCell[] = { x * CELLS_PER_BRICK_SIDE, y * CELLS_PER_BRICK_SIDE, z * CELLS_PER_BRICK_SIDE };
+    foreach (const VoxelOccupancyBox& box, brick.boxes) {
+        int minimum[3];
+        int maximum[3];
+        for (int i = 0; i < 3; i++) {
+            minimum[i] = qBound(0, (int)floorf(box.corner[i] * CELLS_PER_SIDE) - brickCell[i], CELLS_PER_BRICK_SIDE - 1);
+            maximum[i] = qBound(0, (int)ceilf((box.corner[i] + box.scale) * CELLS_PER_SIDE) - 1 - brickCell[i],
+                                CELLS_PER_BRICK_SIDE - 1);
+        }
+        brick.cells |= cellMask(minimum, maximum);
+    }
+
+    if (found == _bricks.end()) {
+        _bricks.insert(brickKey, brick);
+        addToSummaries(brickKey);
+    } else {
+        found.value() = brick;
+    }
+}
+
+void VoxelOccupancyMap::updateCoarseElement(const OctalCodeKey& key) {
+    const VoxelTreeElement* element = static_cast<const VoxelTreeElement*>(findElement(key));
+    if (element && element->isColored()) {
+        _coarseBoxes.insert(key, boxFor(element));
+    } else {
+        _coarseBoxes.remove(key);
+    }
+    _coarseListChanged = true;
+}
+
+void VoxelOccupancyMap::addToSummaries(quint64 brickKey) {
+    int x, y, z;
+    unpackCoordinates(brickKey, x, y, z);
+    for (int level = 0; level < SUMMARY_LEVELS; level++) {
+        quint64& mask = _summaries[level][packCoordinates(x >> 2, y >> 2, z >> 2)];
+        bool wasEmpty = (mask == 0);
+        mask |= childBit(x & 3, y & 3, z & 3);
+        if (!wasEmpty) {
+            return; // the levels above already have it
+        }
+        x >>= 2;
+        y >>= 2;
+        z >>= 2;
+    }
+}
+
+void VoxelOccupancyMap::removeFromSummaries(quint64 brickKey) {
+    int x, y, z;
+    unpackCoordinates(brickKey, x, y, z);
+    for (int level = 0; level < SUMMARY_LEVELS; level++) {
+        QHash<quint64, quint64>::iterator found = _summaries[level].find(packCoordinates(x >> 2, y >> 2, z >> 2));
+        if (found == _summaries[level].end()) {
+            return;
+        }
+        found.value() &= ~childBit(x & 3, y & 3, z & 3);
+        if (found.value() != 0) {
+            return; // the node still has other children
+        }
+        _summaries[level].erase(found);
+        x >>= 2;
+        y >>= 2;
+        z >>= 2;
+    }
+}
+
+void VoxelOccupancyMap::findCandidates(const glm::vec3& minimum, const glm::vec3& maximum,
+                                       QVector<const VoxelOccupancyBox*>& candidates) const {
+    glm::vec3 paddedMinimum = minimum - glm::vec3(QUERY_PADDING, QUERY_PADDING, QUERY_PADDING);
+    glm::vec3 paddedMaximum = maximum + glm::vec3(QUERY_PADDING, QUERY_PADDING, QUERY_PADDING);
+
+    for (int i = 0; i < _coarseList.size(); i++) {
+        if (overlaps(_coarseList.at(i), paddedMinimum, paddedMaximum)) {
+            candidates.append(&_coarseList.at(i));
+        }
+    }
+
+    if (paddedMaximum.x < 0.0f || paddedMaximum.y < 0.0f || paddedMaximum.z < 0.0f ||
+            paddedMinimum.x > 1.0f || paddedMinimum.y > 1.0f || paddedMinimum.z > 1.0f) {
+        return; // nothing below BRICK_LEVEL is outside the tree
+    }
+    int minimumCell[] = { toGrid(paddedMinimum.x, CELLS_PER_SIDE), toGrid(paddedMinimum.y, CELLS_PER_SIDE),
+                          toGrid(paddedMinimum.z, CELLS_PER_SIDE) };
+    int maximumCell[] = { toGrid(paddedMaximum.x, CELLS_PER_SIDE), toGrid(paddedMaximum.y, CELLS_PER_SIDE),
+                          toGrid(paddedMaximum.z, CELLS_PER_SIDE) };
+
+    // the top summary nodes are 4 to a side above the level below them, which are 4 to a side above the bricks...
+    const int topShift = 2 + 2 * SUMMARY_LEVELS;
+    for (int x = minimumCell[0] >> topShift; x <= maximumCell[0] >> topShift; x++) {
+        for (int y = minimumCell[1] >> topShift; y <= maximumCell[1] >> topShift; y++) {
+            for (int z = minimumCell[2] >> topShift; z <= maximumCell[2] >> topShift; z++) {
+                findCandidatesInNode(SUMMARY_LEVELS - 1, x, y, z, minimumCell, maximumCell,
+                                     paddedMinimum, paddedMaximum, candidates);
+            }
+        }
+    }
+}
+
+void VoxelOccupancyMap::findCandidatesInNode(int level, int x, int y, int z, const int* minimumCell,
+                                             const int* maximumCell, const glm::vec3& minimum, const glm::vec3& maximum,
+                                             QVector<const VoxelOccupancyBox*>& candidates) const {
+    quint64 mask = _summaries[level].value(packCoordinates(x, y, z), 0);
+    if (mask == 0) {
+        return;
+    }
+    int childShift = 2 + 2 * level;
+    int nodeCoordinates[] = { x, y, z };
+    int first[3];
+    int last[3];
+    for (int i = 0; i < 3; i++) {
+        first[i] = qMax(0, (minimumCell[i] >> childShift) - nodeCoordinates[i] * 4);
+        last[i] = qMin(3, (maximumCell[i] >> childShift) - nodeCoordinates[i] * 4);
+    }
+    for (int childX = first[0]; childX <= last[0]; childX++) {
+        for (int childY = first[1]; childY <= last[1]; childY++) {
+            for (int childZ = first[2]; childZ <= last[2]; childZ++) {
+                if (!(mask & childBit(childX, childY, childZ))) {
+                    continue;
+                }
+                if (level == 0) {
+                    findCandidatesInBrick(x * 4 + childX, y * 4 + childY, z * 4 + childZ, minimumCell, maximumCell,
+                                          minimum, maximum, candidates);
+                } else {
+                    findCandidatesInNode(level - 1, x * 4 + childX, y * 4 + childY, z * 4 + childZ, minimumCell,
+                                         maximumCell, minimum, maximum, candidates);
+                }
+            }
+        }
+    }
+}
+
+void VoxelOccupancyMap::findCandidatesInBrick(int x, int y, int z, const int* minimumCell, const int* maximumCell,
+                                              const glm::vec3& minimum, const glm::vec3& maximum,
+                                              QVector<const VoxelOccupancyBox*>& candidates) const {
+    QHash<quint64, VoxelOccupancyBrick>::const_iterator found = _bricks.constFind(packCoordinates(x, y, z));
+    if (found == _bricks.constEnd()) {
+        return;
+    }
+    int brickCoordinates[] = { x, y, z };
+    int first[3];
+    int last[3];
+    for (int i = 0; i < 3; i++) {
+        first[i] = qMax(0, minimumCell[i] - brickCoordinates[i] * CELLS_PER_BRICK_SIDE);
+        last[i] = qMin(CELLS_PER_BRICK_SIDE - 1, maximumCell[i] - brickCoordinates[i] * CELLS_PER_BRICK_SIDE);
+    }
+    const VoxelOccupancyBrick& brick = found.value();
+    if (!(brick.cells & cellMask(first, last))) {
+        return;
+    }
+    for (int i = 0; i < brick.boxes.size(); i++) {
+        if (overlaps(brick.boxes.at(i), minimum, maximum)) {
+            candidates.append(&brick.boxes.at(i));
+        }
+    }
+}
+
+void VoxelOccupancyMap::fillCubes(const QVector<const VoxelOccupancyBox*>& candidates, float scale) {
+    _cubes.clear();
+    foreach (const VoxelOccupancyBox* box, candidates) {
+        _cubes.addCube(AACube(box->corner * scale, box->scale * scale));
+    }
+}
+
+bool VoxelOccupancyMap::findSpherePenetration(const glm::vec3& center, float radius, glm::vec3& penetration,
+                                              void** penetratedObject) {
+    glm::vec3 treeCenter = center / (float)(TREE_SCALE);
+    float treeRadius = radius / (float)(TREE_SCALE);
+    glm::vec3 extent(treeRadius, treeRadius, treeRadius);
+    penetration = glm::vec3(0.0f, 0.0f, 0.0f);
+
+    QMutexLocker locker(&_mutex);
+    update();
+    QVector<const VoxelOccupancyBox*> candidates;
+    findCandidates(treeCenter - extent, treeCenter + extent, candidates);
+    std::stable_sort(candidates.begin(), candidates.end(), comesBefore);
+
+    // the expanded box test goes four candidates at a time, only the boxes it keeps get the exact test
+    fillCubes(candidates);
+    const VoxelOccupancyBox* penetrated = NULL;
+    int numBlocks = _cubes.getBlockCount();
+    for (int block = 0; block < numBlocks; ++block) {
+        int containing = _cubes.findContaining(block, treeCenter, treeRadius);
+        for (int i = block * SHAPE_BATCH_BLOCK_SIZE; containing != 0; ++i, containing >>= 1) {
+            glm::vec3 boxPenetration;
+            if ((containing & 1) && _cubes.getCube(i).findSpherePenetration(treeCenter, treeRadius, boxPenetration)) {
+                penetration = addPenetrations(penetration, boxPenetration * (float)(TREE_SCALE));
+                penetrated = candidates.at(i);
+            }
+        }
+    }
+
+    // like the tree, the details are of the last voxel that was penetrated
+    if (penetratedObject) {
+        VoxelDetail* voxelDetails = NULL;
+        if (penetrated) {
+            voxelDetails = new VoxelDetail;
+            voxelDetails->x = penetrated->corner.x;
+            voxelDetails->y = penetrated->corner.y;
+            voxelDetails->z = penetrated->corner.z;
+            voxelDetails->s = penetrated->scale;
+            voxelDetails->red = penetrated->color[0];
+            voxelDetails->green = penetrated->color[1];
+            voxelDetails->blue = penetrated->color[2];
+        }
+        *penetratedObject = (void*)voxelDetails;
+    }
+    return penetrated != NULL;
+}
+
+bool VoxelOccupancyMap::findCapsulePenetration(const glm::vec3& start, const glm::vec3& end, float radius,
+                                               glm::vec3& penetration) {
+    glm::vec3 treeStart = start / (float)(TREE_SCALE);
+    glm::vec3 treeEnd = end / (float)(TREE_SCALE);
+    float treeRadius = radius / (float)(TREE_SCALE);
+    glm::vec3 extent(treeRadius, treeRadius, treeRadius);
+    penetration = glm::vec3(0.0f, 0.0f, 0.0f);
+
+    QMutexLocker locker(&_mutex);
+    update();
+    QVector<const VoxelOccupancyBox*> candidates;
+    findCandidates(glm::min(treeStart, treeEnd) - extent, glm::max(treeStart, treeEnd) + extent, candidates);
+    std::stable_sort(candidates.begin(), candidates.end(), comesBefore);
+
+    fillCubes(candidates);
+    bool found = false;
+    int numBlocks = _cubes.getBlockCount();
+    for (int block = 0; block < numBlocks; ++block) {
+        int intersecting = _cubes.findIntersectingSegment(block, treeStart, treeEnd, treeRadius);
+        for (int i = block * SHAPE_BATCH_BLOCK_SIZE; intersecting != 0; ++i, intersecting >>= 1) {
+            if (!(intersecting & 1)) {
+                continue;
+            }
+            AACube cube = _cubes.getCube(i);
+            glm::vec3 boxPenetration;
+            if (cube.expandedIntersectsSegment(treeStart, treeEnd, treeRadius) &&
+                    cube.findCapsulePenetration(treeStart, treeEnd, treeRadius, boxPenetration)) {
+                penetration = addPenetrations(penetration, boxPenetration * (float)(TREE_SCALE));
+                found = true;
+            }
+        }
+    }
+    return found;
+}
+
+bool VoxelOccupancyMap::findShapeCollisions(const Shape* shape, CollisionList& collisions) {
+    glm::vec3 treeCenter = shape->getTranslation() / (float)(TREE_SCALE);
+    float treeRadius = shape->getBoundingRadius() / (float)(TREE_SCALE);
+    glm::vec3 extent(treeRadius, treeRadius, treeRadius);
+
+    QMutexLocker locker(&_mutex);
+    update();
+    QVector<const VoxelOccupancyBox*> candidates;
+    findCandidates(treeCenter - extent, treeCenter + extent, candidates);
+    std::stable_sort(candidates.begin(), candidates.end(), comesBefore);
+
+    fillCubes(candidates, TREE_SCALE);
+    return ShapeCollider::collideShapeWithAACubesLegacy(shape, _cubes, collisions);
+}
+
+void VoxelOccupancyMap::findContentInCube(const AACube& cube, CubeList& cubes) {
+    QMutexLocker locker(&_mutex);
+    update();
+    QVector<const VoxelOccupancyBox*> candidates;
+    findCandidates(cube.getCorner() / (float)(TREE_SCALE),
+                   (cube.getCorner() + glm::vec3(cube.getScale(), cube.getScale(), cube.getScale())) / (float)(TREE_SCALE),
+                   candidates);
+
+    foreach (const VoxelOccupancyBox* box, candidates) {
+        if (!box->isLeaf) {
+            continue;
+        }
+        AACube boxCube(box->corner, box->scale);
+        boxCube.scale(TREE_SCALE);
+        if (boxCube.touches(cube)) {
+            cubes.insert(qHash(boxCube.calcCenter()), boxCube);
+        }
+    }
+}
+
+int VoxelOccupancyMap::getBrickCount() {
+    QMutexLocker locker(&_mutex);
+    update();
+    return _bricks.size();
+}
+
+int VoxelOccupancyMap::getBoxCount() {
+    QMutexLocker locker(&_mutex);
+    update();
+    int count = _coarseList.size();
+    foreach (const VoxelOccupancyBrick& brick, _bricks) {
+        count += brick.boxes.size();
+    }
+    return count;
+}
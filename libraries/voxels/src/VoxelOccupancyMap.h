@@ -0,0 +1,122 @@
+//
+//  VoxelOccupancyMap.h
+//  libraries/voxels/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_VoxelOccupancyMap_h
+#define hifi_VoxelOccupancyMap_h
+
+#include <QHash>
+#include <QMutex>
+#include <QSet>
+#include <QVector>
+
+#include <glm/glm.hpp>
+
+#include <CollisionInfo.h>
+#include <OctalCodeKey.h>
+#include <Octree.h>
+#include <OctreeElement.h>
+#include <ShapeBatch.h>
+
+class Shape;
+class VoxelTree;
+class VoxelTreeElement;
+
+/// One colored element of the tree, in tree units
+class VoxelOccupancyBox {
+public:
+    glm::vec3 corner;
+    float scale;
+    quint64 order; /// where the element comes when the tree is walked from the root, see VoxelOccupancyMap::orderOf()
+    unsigned char color[3];
+    bool isLeaf;
+};
+
+/// The colored elements below one element at BRICK_LEVEL, and which of its 4x4x4 cells they touch
+class VoxelOccupancyBrick {
+public:
+    quint64 cells;
+    QVector<VoxelOccupancyBox> boxes;
+};
+
+/// A flat copy of the colored elements of a VoxelTree for the collision queries the avatar and entity code makes every
+/// frame. Elements at or below BRICK_LEVEL are kept in bricks, each with a bit per cell that something in it touches,
+/// and each level of summaries above the bricks has a bit per child that has anything in it, so a query only looks at
+/// the boxes in the cells it overlaps. The few colored elements above BRICK_LEVEL are kept in a plain list.
+///
+/// The map follows the tree through the element update and delete hooks, which only record which bricks changed; those
+/// are rebuilt from the tree by the next query. The queries give the same results as the Octree ones, in the same order,
+/// and must be called with the tree locked for reading.
+class VoxelOccupancyMap : public OctreeElementDeleteHook, public OctreeElementUpdateHook {
+public:
+    static const int BRICK_LEVEL = 12;
+    static const int BRICKS_PER_SIDE = 1 << BRICK_LEVEL;
+    static const int CELLS_PER_BRICK_SIDE = 4;
+    static const int SUMMARY_LEVELS = 2;
+
+    VoxelOccupancyMap(VoxelTree* tree);
+    ~VoxelOccupancyMap();
+
+    bool findSpherePenetration(const glm::vec3& center, float radius, glm::vec3& penetration, void** penetratedObject);
+    bool findCapsulePenetration(const glm::vec3& start, const glm::vec3& end, float radius, glm::vec3& penetration);
+    bool findShapeCollisions(const Shape* shape, CollisionList& collisions);
+    void findContentInCube(const AACube& cube, CubeList& cubes);
+
+    int getBrickCount();
+    int getBoxCount();
+
+    virtual void elementDeleted(OctreeElement* element);
+    virtual void elementUpdated(OctreeElement* element);
+
+    /// a key that sorts elements in the order a recursion from the root visits them: the corner in Morton order, then
+    /// larger elements before the smaller ones that share their corner
+    static quint64 orderOf(const glm::vec3& corner);
+
+private:
+    void markDirty(OctreeElement* element);
+    void update();
+    void rebuild();
+    void rebuildFrom(VoxelTreeElement* element);
+    void updateBrick(quint64 brickKey);
+    void setBrick(quint64 brickKey, VoxelTreeElement* brickElement);
+    void updateCoarseElement(const OctalCodeKey& key);
+    void addToSummaries(quint64 brickKey);
+    void removeFromSummaries(quint64 brickKey);
+    OctreeElement* findElement(const OctalCodeKey& key) const;
+
+    void findCandidates(const glm::vec3& minimum, const glm::vec3& maximum,
+                        QVector<const VoxelOccupancyBox*>& candidates) const;
+    void findCandidatesInNode(int level, int x, int y, int z, const int* minimumCell, const int* maximumCell,
+                              const glm::vec3& minimum, const glm::vec3& maximum,
+                              QVector<const VoxelOccupancyBox*>& candidates) const;
+    void findCandidatesInBrick(int x, int y, int z, const int* minimumCell, const int* maximumCell,
+                               const glm::vec3& minimum, const glm::vec3& maximum,
+                               QVector<const VoxelOccupancyBox*>& candidates) const;
+
+    /// puts the candidates in _cubes in the same order, scaled by scale
+    void fillCubes(const QVector<const VoxelOccupancyBox*>& candidates, float scale = 1.0f);
+
+    VoxelTree* _tree;
+
+    QMutex _dirtyMutex;
+    bool _needsRebuild;
+    QSet<quint64> _dirtyBricks;
+    QSet<OctalCodeKey> _dirtyCoarseKeys;
+
+    QMutex _mutex;
+    QHash<quint64, VoxelOccupancyBrick> _bricks;
+    QHash<quint64, quint64> _summaries[SUMMARY_LEVELS];
+    QHash<OctalCodeKey, VoxelOccupancyBox> _coarseBoxes;
+    QVector<VoxelOccupancyBox> _coarseList;
+    bool _coarseListChanged;
+
+    AACubeBatch _cubes; // the candidates of a query, kept to reuse the memory
+};
+
+#endif // hifi_VoxelOccupancyMap_h
@@ -15,14 +15,24 @@
 #include <QImage>
 #include <QRgb>
 
+#include "VoxelOccupancyMap.h"
 #include "VoxelTree.h"
 #include "Tags.h"
 
 // Voxel Specific operations....
 
-VoxelTree::VoxelTree(bool shouldReaverage) : Octree(shouldReaverage) 
+VoxelTree::VoxelTree(bool shouldReaverage) :
+    Octree(shouldReaverage),
+    _occupancyMap(NULL)
 {
     _rootElement = createNewElement();
+    // voxel scripts and edits look up the same elements by position over and over
+    setUseElementIndex(true);
+}
+
+VoxelTree::~VoxelTree() {
+    // the map has to stop listening before Octree's destructor deletes the elements
+    delete _occupancyMap;
 }
 
 VoxelTreeElement* VoxelTree::createNewElement(unsigned char * octalCode) {
@@ -36,6 +46,102 @@ VoxelTreeElement* VoxelTree::createNewElement(unsigned char * octalCode) {
 }
 
 
+void VoxelTree::setUseOccupancyMap(bool useOccupancyMap) {
+    if (useOccupancyMap == getUseOccupancyMap()) {
+        return;
+    }
+    lockForWrite();
+    if (useOccupancyMap) {
+        _occupancyMap = new VoxelOccupancyMap(this);
+    } else {
+        delete _occupancyMap;
+        _occupancyMap = NULL;
+    }
+    unlock();
+}
+
+bool VoxelTree::lockForQuery(Octree::lockType lockType, bool& gotLock, bool* accurateResult) {
+    gotLock = false;
+    if (lockType == Octree::Lock) {
+        lockForRead();
+        gotLock = true;
+    } else if (lockType == Octree::TryLock) {
+        gotLock = tryLockForRead();
+        if (!gotLock) {
+            if (accurateResult) {
+                *accurateResult = false; // if user asked to accuracy or result, let them know this is inaccurate
+            }
+            return false;
+        }
+    }
+    return true;
+}
+
+void VoxelTree::unlockAfterQuery(bool gotLock, bool* accurateResult) {
+    if (gotLock) {
+        unlock();
+    }
+    if (accurateResult) {
+        *accurateResult = true; // if user asked to accuracy or result, let them know this is accurate
+    }
+}
+
+bool VoxelTree::findSpherePenetration(const glm::vec3& center, float radius, glm::vec3& penetration,
+                                      void** penetratedObject, Octree::lockType lockType, bool* accurateResult) {
+    if (!_occupancyMap) {
+        return Octree::findSpherePenetration(center, radius, penetration, penetratedObject, lockType, accurateResult);
+    }
+    penetration = glm::vec3(0.0f, 0.0f, 0.0f);
+    bool gotLock;
+    if (!lockForQuery(lockType, gotLock, accurateResult)) {
+        return false;
+    }
+    bool found = _occupancyMap->findSpherePenetration(center, radius, penetration, penetratedObject);
+    unlockAfterQuery(gotLock, accurateResult);
+    return found;
+}
+
+bool VoxelTree::findCapsulePenetration(const glm::vec3& start, const glm::vec3& end, float radius,
+                                       glm::vec3& penetration, Octree::lockType lockType, bool* accurateResult) {
+    if (!_occupancyMap) {
+        return Octree::findCapsulePenetration(start, end, radius, penetration, lockType, accurateResult);
+    }
+    penetration = glm::vec3(0.0f, 0.0f, 0.0f);
+    bool gotLock;
+    if (!lockForQuery(lockType, gotLock, accurateResult)) {
+        return false;
+    }
+    bool found = _occupancyMap->findCapsulePenetration(start, end, radius, penetration);
+    unlockAfterQuery(gotLock, accurateResult);
+    return found;
+}
+
+bool VoxelTree::findShapeCollisions(const Shape* shape, CollisionList& collisions,
+                                    Octree::lockType lockType, bool* accurateResult) {
+    if (!_occupancyMap) {
+        return Octree::findShapeCollisions(shape, collisions, lockType, accurateResult);
+    }
+    bool gotLock;
+    if (!lockForQuery(lockType, gotLock, accurateResult)) {
+        return false;
+    }
+    bool found = _occupancyMap->findShapeCollisions(shape, collisions);
+    unlockAfterQuery(gotLock, accurateResult);
+    return found;
+}
+
+bool VoxelTree::findContentInCube(const AACube& cube, CubeList& cubes) {
+    if (!_occupancyMap) {
+        return Octree::findContentInCube(cube, cubes);
+    }
+    if (!tryLockForRead()) {
+        return false;
+    }
+    _occupancyMap->findContentInCube(cube, cubes);
+    unlock();
+    return true;
+}
+
 void VoxelTree::deleteVoxelAt(float x, float y, float z, float s) {
     deleteOctreeElementAt(x, y, z, s);
 }
@@ -18,12 +18,14 @@
 #include "VoxelEditPacketSender.h"
 
 class ReadCodeColorBufferToTreeArgs;
+class VoxelOccupancyMap;
 
 class VoxelTree : public Octree {
     Q_OBJECT
 public:
 
     VoxelTree(bool shouldReaverage = false);
+    virtual ~VoxelTree();
 
     virtual VoxelTreeElement* createNewElement(unsigned char * octalCode = NULL);
     VoxelTreeElement* getRoot() { return static_cast<VoxelTreeElement*>(_rootElement); }
@@ -54,7 +56,9 @@ public:
 
     virtual bool getWantSVOfileVersions() const { return true; }
     virtual bool canProcessVersion(PacketVersion thisVersion) const { 
-                    return thisVersion == 0 || thisVersion == versionForPacketType(expectedDataPacketType()); }
+                    // files from before the compression change have the same contents, only packets differ
+                    return thisVersion == 0 || (thisVersion >= VERSION_VOXELS_HAS_FILE_BREAKS &&
+                        thisVersion <= versionForPacketType(expectedDataPacketType())); }
     virtual PacketVersion expectedVersion() const { return versionForPacketType(expectedDataPacketType()); }
 
     virtual PacketType expectedDataPacketType() const { return PacketTypeVoxelData; }
@@ -75,7 +79,31 @@ public:
 
     virtual void dumpTree();
 
+    /// Keeps a VoxelOccupancyMap of the colored voxels for the sphere, capsule, shape and content queries below. The
+    /// map follows edits through the element hooks, so it should be turned on before other threads edit the tree.
+    void setUseOccupancyMap(bool useOccupancyMap);
+    bool getUseOccupancyMap() const { return _occupancyMap != NULL; }
+    VoxelOccupancyMap* getOccupancyMap() const { return _occupancyMap; }
+
+    virtual bool findSpherePenetration(const glm::vec3& center, float radius, glm::vec3& penetration,
+                                    void** penetratedObject = NULL,
+                                    Octree::lockType lockType = Octree::TryLock, bool* accurateResult = NULL);
+
+    virtual bool findCapsulePenetration(const glm::vec3& start, const glm::vec3& end, float radius, glm::vec3& penetration,
+                                    Octree::lockType lockType = Octree::TryLock, bool* accurateResult = NULL);
+
+    virtual bool findShapeCollisions(const Shape* shape, CollisionList& collisions,
+                                    Octree::lockType = Octree::TryLock, bool* accurateResult = NULL);
+
+    virtual bool findContentInCube(const AACube& cube, CubeList& cubes);
+
 private:
+    /// takes the read lock the way the Octree queries do, returns false if a TryLock didn't get it
+    bool lockForQuery(Octree::lockType lockType, bool& gotLock, bool* accurateResult);
+    void unlockAfterQuery(bool gotLock, bool* accurateResult);
+
+    VoxelOccupancyMap* _occupancyMap;
+
     // helper functions for nudgeSubTree
     void recurseNodeForNudge(VoxelTreeElement* element, RecurseOctreeOperation operation, void* extraData);
     static bool nudgeCheck(OctreeElement* element, void* extraData);
@@ -0,0 +1,95 @@
+//
+//  AudioCodecTests.cpp
+//  tests/audio/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <math.h>
+
+#include "AudioRingBuffer.h"
+#include "SharedUtil.h"
+
+#include "AudioCodecTests.h"
+
+void AudioCodecTests::testRoundTrip(AudioCodec::Type type, int numChannels, float minSignalToNoiseDB) {
+    const int NUM_FRAMES = 20;
+    const float AMPLITUDE = 8000.0f;
+    const float FREQUENCY_STEP = 0.05f;
+
+    AudioCodec* encoder = AudioCodec::create(type);
+    AudioCodec* decoder = AudioCodec::create(type);
+
+    int numSamples = NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL * numChannels;
+    int16_t inputSamples[NETWORK_BUFFER_LENGTH_SAMPLES_STEREO];
+    int16_t outputSamples[NETWORK_BUFFER_LENGTH_SAMPLES_STEREO];
+    char encoded[NETWORK_BUFFER_LENGTH_BYTES_STEREO];
+
+    double signalEnergy = 0.0;
+    double noiseEnergy = 0.0;
+
+    for (int frame = 0; frame < NUM_FRAMES; frame++) {
+        for (int i = 0; i < numSamples; i++) {
+            int sampleIndex = frame * NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL + i / numChannels;
+            float channelFrequency = FREQUENCY_STEP * (1 + (i % numChannels));
+            inputSamples[i] = (int16_t)(AMPLITUDE * sinf(sampleIndex * channelFrequency));
+        }
+
+        int numBytes = encoder->encode(inputSamples, numSamples, numChannels, encoded);
+        if (numBytes != encoder->encodedBytesForSamples(numSamples, numChannels)) {
+            qDebug("codec %d wrote %d bytes, expected %d", type, numBytes,
+                   encoder->encodedBytesForSamples(numSamples, numChannels));
+        }
+
+        // every frame must decode on its own, so use a fresh decoder for odd frames
+        AudioCodec* frameDecoder = (frame % 2) ? AudioCodec::create(type) : decoder;
+        int numDecodedSamples = frameDecoder->decode(encoded, numBytes, numChannels, outputSamples);
+        if (frameDecoder != decoder) {
+            delete frameDecoder;
+        }
+
+        if (numDecodedSamples != numSamples) {
+            qDebug("codec %d decoded %d samples, expected %d", type, numDecodedSamples, numSamples);
+            break;
+        }
+
+        for (int i = 0; i < numSamples; i++) {
+            double error = inputSamples[i] - outputSamples[i];
+            signalEnergy += (double)inputSamples[i] * inputSamples[i];
+            noiseEnergy += error * error;
+        }
+    }
+
+    if (noiseEnergy > 0.0) {
+        float signalToNoiseDB = 10.0f * log10f(signalEnergy / noiseEnergy);
+        if (signalToNoiseDB < minSignalToNoiseDB) {
+            qDebug("codec %d with %d channels has SNR %f dB, expected at least %f dB",
+                   type, numChannels, signalToNoiseDB, minSignalToNoiseDB);
+        }
+    }
+
+    delete encoder;
+    delete decoder;
+}
+
+void AudioCodecTests::runAllTests() {
+    const float PCM_MIN_SNR_DB = 1000.0f; // PCM is lossless, any noise at all fails
+    const float ADPCM_MIN_SNR_DB = 30.0f;
+
+    testRoundTrip(AudioCodec::PCM, 1, PCM_MIN_SNR_DB);
+    testRoundTrip(AudioCodec::PCM, 2, PCM_MIN_SNR_DB);
+    testRoundTrip(AudioCodec::ADPCM, 1, ADPCM_MIN_SNR_DB);
+    testRoundTrip(AudioCodec::ADPCM, 2, ADPCM_MIN_SNR_DB);
+
+    if (AudioCodec::preferredTypeForMask(SUPPORTED_AUDIO_CODECS_MASK) != AudioCodec::ADPCM) {
+        qDebug("expected ADPCM to be preferred when the listener supports every codec");
+    }
+    if (AudioCodec::preferredTypeForMask(AudioCodec::maskForType(AudioCodec::PCM)) != AudioCodec::PCM) {
+        qDebug("expected PCM for a listener that does not support any codec");
+    }
+
+    qDebug() << "passed AudioCodecTests::runAllTests()";
+}
@@ -0,0 +1,23 @@
+//
+//  AudioCodecTests.h
+//  tests/audio/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_AudioCodecTests_h
+#define hifi_AudioCodecTests_h
+
+#include "AudioCodec.h"
+
+namespace AudioCodecTests {
+
+    void runAllTests();
+
+    void testRoundTrip(AudioCodec::Type type, int numChannels, float minSignalToNoiseDB);
+};
+
+#endif // hifi_AudioCodecTests_h
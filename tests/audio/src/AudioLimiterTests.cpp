@@ -0,0 +1,121 @@
+//
+//  AudioLimiterTests.cpp
+//  tests/audio/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <math.h>
+
+#include "AudioLimiter.h"
+#include "AudioRingBuffer.h"
+#include "SharedUtil.h"
+
+#include "AudioLimiterTests.h"
+
+void AudioLimiterTests::testSaturation() {
+    // an odd count so that both the batched and the leftover samples are covered
+    const int NUM_SAMPLES = 21;
+    float input[NUM_SAMPLES];
+    int16_t output[NUM_SAMPLES];
+    for (int i = 0; i < NUM_SAMPLES; i++) {
+        input[i] = (i - NUM_SAMPLES / 2) * 10000.0f + 0.25f;
+    }
+
+    AudioLimiter::render(input, output, NUM_SAMPLES, false);
+    for (int i = 0; i < NUM_SAMPLES; i++) {
+        int expected = (int)floorf(input[i] + 0.5f);
+        expected = qMax(MIN_SAMPLE_VALUE, qMin(MAX_SAMPLE_VALUE, expected));
+        if (output[i] != expected) {
+            qDebug("saturating %f gave %d, expected %d", input[i], output[i], expected);
+        }
+    }
+}
+
+void AudioLimiterTests::testSoftLimit() {
+    const int NUM_SAMPLES = 64;
+    const float MAX_INPUT = 8.0f * MAX_SAMPLE_VALUE;
+    float input[NUM_SAMPLES];
+    int16_t output[NUM_SAMPLES];
+    for (int i = 0; i < NUM_SAMPLES; i++) {
+        input[i] = MAX_INPUT * i / (NUM_SAMPLES - 1);
+    }
+
+    AudioLimiter::render(input, output, NUM_SAMPLES, true);
+
+    // quiet samples pass through, loud ones keep increasing but stay below full scale and above the threshold
+    float threshold = AudioLimiter::getSoftLimitThreshold();
+    for (int i = 0; i < NUM_SAMPLES; i++) {
+        if (input[i] <= threshold && output[i] != (int16_t)floorf(input[i] + 0.5f)) {
+            qDebug("soft limiter changed %f below the threshold to %d", input[i], output[i]);
+        }
+        if (i > 0 && output[i] < output[i - 1]) {
+            qDebug("soft limiter isn't monotonic at %f, %d after %d", input[i], output[i], output[i - 1]);
+        }
+        if (input[i] > threshold && (output[i] < threshold || output[i] >= MAX_SAMPLE_VALUE)) {
+            qDebug("soft limiter took %f to %d, outside of the knee", input[i], output[i]);
+        }
+    }
+
+    // and negative samples are limited the same way
+    float negative = -MAX_INPUT;
+    int16_t negativeOutput;
+    AudioLimiter::render(&negative, &negativeOutput, 1, true);
+    if (negativeOutput != -output[NUM_SAMPLES - 1]) {
+        qDebug("soft limiter took %f to %d, expected %d", negative, negativeOutput, -output[NUM_SAMPLES - 1]);
+    }
+}
+
+void AudioLimiterTests::testMixOrder() {
+    // two loud streams and one cancelling the first, added in both orders. Clipping every stream as it was added gave
+    // full scale minus a stream one way and a single stream the other, the float mix is a single stream either way.
+    const int NUM_STREAMS = 3;
+    const float AMPLITUDE = 30000.0f;
+    const float STREAM_SIGNS[NUM_STREAMS] = { 1.0f, 1.0f, -1.0f };
+    float mix[NETWORK_BUFFER_LENGTH_SAMPLES_STEREO] = { 0.0f };
+    float reverseMix[NETWORK_BUFFER_LENGTH_SAMPLES_STEREO] = { 0.0f };
+    int clippedMix[NETWORK_BUFFER_LENGTH_SAMPLES_STEREO] = { 0 };
+    int reverseClippedMix[NETWORK_BUFFER_LENGTH_SAMPLES_STEREO] = { 0 };
+    for (int stream = 0; stream < NUM_STREAMS; stream++) {
+        int reverseStream = NUM_STREAMS - 1 - stream;
+        for (int s = 0; s < NETWORK_BUFFER_LENGTH_SAMPLES_STEREO; s++) {
+            // alternate the polarity so that both ends of the range saturate
+            float polarity = (s % 2 == 0) ? 1.0f : -1.0f;
+            float sample = polarity * STREAM_SIGNS[stream] * AMPLITUDE;
+            float reverseSample = polarity * STREAM_SIGNS[reverseStream] * AMPLITUDE;
+            mix[s] += sample;
+            reverseMix[s] += reverseSample;
+            clippedMix[s] = qMax(MIN_SAMPLE_VALUE, qMin(MAX_SAMPLE_VALUE, clippedMix[s] + (int)sample));
+            reverseClippedMix[s] = qMax(MIN_SAMPLE_VALUE, qMin(MAX_SAMPLE_VALUE, reverseClippedMix[s] + (int)reverseSample));
+        }
+    }
+
+    // make sure these streams do tell the two ways of mixing apart, or the checks below prove nothing
+    if (clippedMix[0] == reverseClippedMix[0]) {
+        qDebug("clipping each stream gave %d in both orders, the streams don't saturate", clippedMix[0]);
+    }
+
+    int16_t output[NETWORK_BUFFER_LENGTH_SAMPLES_STEREO];
+    int16_t reverseOutput[NETWORK_BUFFER_LENGTH_SAMPLES_STEREO];
+    AudioLimiter::render(mix, output, NETWORK_BUFFER_LENGTH_SAMPLES_STEREO, false);
+    AudioLimiter::render(reverseMix, reverseOutput, NETWORK_BUFFER_LENGTH_SAMPLES_STEREO, false);
+    for (int s = 0; s < NETWORK_BUFFER_LENGTH_SAMPLES_STEREO; s++) {
+        int expected = (s % 2 == 0) ? (int)AMPLITUDE : -(int)AMPLITUDE;
+        if (output[s] != expected || reverseOutput[s] != expected) {
+            qDebug("mix sample %d depends on the stream order, %d and %d, expected %d", s, output[s], reverseOutput[s],
+                expected);
+            break;
+        }
+    }
+}
+
+void AudioLimiterTests::runAllTests() {
+    testSaturation();
+    testSoftLimit();
+    testMixOrder();
+
+    qDebug() << "passed AudioLimiterTests::runAllTests()";
+}
@@ -0,0 +1,332 @@
+//
+//  VoiceActivityDetectorTests.cpp
+//  tests/audio/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <math.h>
+
+#include <QVector>
+
+#include "AudioRingBuffer.h"
+#include "VoiceActivityDetector.h"
+
+#include "VoiceActivityDetectorTests.h"
+
+// the corpus is synthetic so that its labels are exact: a few seconds of background alone, then words of voiced
+// speech separated by pauses, mixed over the background
+const int CORPUS_SECONDS = 24;
+const int LEAD_IN_SAMPLES = 3 * SAMPLE_RATE;
+const int FRAME_SAMPLES = NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL;
+const int NUM_FRAMES = CORPUS_SECONDS * SAMPLE_RATE / FRAME_SAMPLES;
+
+const float MIN_SPEECH_RECALL = 0.95f;
+const float MAX_FALSE_TRANSMIT_RATE = 0.05f;
+const int MAX_ONSET_DELAY_FRAMES = 1;
+
+enum Background {
+    QUIET_ROOM,
+    FAN_NOISE,
+    MAINS_HUM
+};
+
+struct Corpus {
+    QVector<int16_t> samples;
+    QVector<bool> isSpeech;     // per sample
+};
+
+// a fixed generator, so that the corpus is the same on every platform
+class CorpusRandom {
+public:
+    CorpusRandom() : _state(12345) { }
+
+    float nextFloat() {
+        _state = _state * 1664525u + 1013904223u;
+        return (_state >> 8) / (float)(1 << 24);
+    }
+
+    // roughly gaussian with unit variance
+    float nextNoise() {
+        float sum = 0.0f;
+        for (int i = 0; i < 12; i++) {
+            sum += nextFloat();
+        }
+        return sum - 6.0f;
+    }
+
+private:
+    uint32_t _state;
+};
+
+static float formantGain(float frequency) {
+    const float FORMANTS[] = { 500.0f, 1500.0f, 2500.0f };
+    const float FORMANT_GAINS[] = { 1.0f, 0.5f, 0.25f };
+    const float FORMANT_WIDTH = 150.0f;
+    float gain = 0.02f;
+    for (int i = 0; i < 3; i++) {
+        float distance = (frequency - FORMANTS[i]) / FORMANT_WIDTH;
+        gain += FORMANT_GAINS[i] * expf(-0.5f * distance * distance);
+    }
+    return gain;
+}
+
+static Corpus makeCorpus(Background background, float speechRMS) {
+    Corpus corpus;
+    int numSamples = NUM_FRAMES * FRAME_SAMPLES;
+    corpus.samples.resize(numSamples);
+    corpus.isSpeech.fill(false, numSamples);
+
+    CorpusRandom random;
+    QVector<float> mix(numSamples, 0.0f);
+
+    // the background
+    const float QUIET_ROOM_RMS = 20.0f;
+    const float FAN_NOISE_RMS = 600.0f;
+    const float MAINS_HUM_AMPLITUDE = 1500.0f;
+    const float MAINS_FREQUENCY = 60.0f;
+    const int NUM_HUM_HARMONICS = 8;
+    float fanState = 0.0f;
+    for (int i = 0; i < numSamples; i++) {
+        float time = (float)i / SAMPLE_RATE;
+        switch (background) {
+            case QUIET_ROOM:
+                mix[i] = QUIET_ROOM_RMS * random.nextNoise();
+                break;
+            case FAN_NOISE:
+                // white noise with a bit of low end, like air moving
+                fanState = 0.9f * fanState + 0.3f * random.nextNoise();
+                mix[i] = FAN_NOISE_RMS * (0.7f * random.nextNoise() + fanState);
+                break;
+            case MAINS_HUM:
+                for (int h = 1; h <= NUM_HUM_HARMONICS; h++) {
+                    mix[i] += (MAINS_HUM_AMPLITUDE / (h * h)) * sinf(2.0f * (float)M_PI * MAINS_FREQUENCY * h * time);
+                }
+                mix[i] += QUIET_ROOM_RMS * random.nextNoise();
+                break;
+        }
+    }
+
+    // the words, voiced with a wandering pitch and syllables a quarter second apart
+    const float MIN_WORD_SECONDS = 0.2f;
+    const float MAX_WORD_SECONDS = 0.8f;
+    const float MIN_PAUSE_SECONDS = 0.3f;
+    const float MAX_PAUSE_SECONDS = 1.5f;
+    const float BASE_PITCH = 120.0f;
+    const float SYLLABLE_RATE = 4.0f;
+    const float ATTACK_SECONDS = 0.005f;
+    const float HIGHEST_HARMONIC_FREQUENCY = 3400.0f;
+    int start = LEAD_IN_SAMPLES;
+    while (true) {
+        int length = (int)((MIN_WORD_SECONDS + random.nextFloat() * (MAX_WORD_SECONDS - MIN_WORD_SECONDS)) * SAMPLE_RATE);
+        if (start + length > numSamples) {
+            break;
+        }
+        float pitch = BASE_PITCH * (0.8f + 0.4f * random.nextFloat());
+        float pitchDrift = 0.2f * (random.nextFloat() - 0.5f);
+        int numHarmonics = (int)(HIGHEST_HARMONIC_FREQUENCY / pitch);
+
+        // normalize the harmonics so that the word has the RMS asked for
+        float harmonicPower = 0.0f;
+        for (int h = 1; h <= numHarmonics; h++) {
+            harmonicPower += 0.5f * formantGain(h * pitch) * formantGain(h * pitch);
+        }
+        float scale = speechRMS / sqrtf(harmonicPower);
+
+        float phase = 0.0f;
+        for (int i = 0; i < length; i++) {
+            float time = (float)i / SAMPLE_RATE;
+            float wordTime = time / (length / (float)SAMPLE_RATE);
+            float frequency = pitch * (1.0f + pitchDrift * wordTime);
+            phase += 2.0f * (float)M_PI * frequency / SAMPLE_RATE;
+
+            float envelope = 0.6f + 0.4f * cosf(2.0f * (float)M_PI * SYLLABLE_RATE * time);
+            envelope *= qMin(1.0f, time / ATTACK_SECONDS) * qMin(1.0f, (length - i) / (ATTACK_SECONDS * SAMPLE_RATE));
+
+            float sample = 0.0f;
+            for (int h = 1; h <= numHarmonics; h++) {
+                sample += formantGain(h * frequency) * sinf(h * phase);
+            }
+            mix[start + i] += scale * envelope * sample;
+            corpus.isSpeech[start + i] = true;
+        }
+        start += length + (int)((MIN_PAUSE_SECONDS + random.nextFloat() * (MAX_PAUSE_SECONDS - MIN_PAUSE_SECONDS))
+            * SAMPLE_RATE);
+    }
+
+    for (int i = 0; i < numSamples; i++) {
+        corpus.samples[i] = (int16_t)qMax((float)MIN_SAMPLE_VALUE, qMin((float)MAX_SAMPLE_VALUE, mix[i]));
+    }
+    return corpus;
+}
+
+static void checkCorpus(const char* name, Background background, float speechRMS) {
+    Corpus corpus = makeCorpus(background, speechRMS);
+    VoiceActivityDetector detector(SAMPLE_RATE);
+    int hangoverFrames = (int)ceilf(detector.getHangoverMsecs() * SAMPLE_RATE / (1000.0f * FRAME_SAMPLES));
+
+    int speechFrames = 0;
+    int speechFramesSent = 0;
+    int noiseFrames = 0;
+    int noiseFramesSent = 0;
+    int framesSinceSpeech = hangoverFrames + 1;
+    int onsetFrame = -1;
+    bool wasSpeech = false;
+    for (int frame = 0; frame < NUM_FRAMES; frame++) {
+        const int16_t* samples = corpus.samples.constData() + frame * FRAME_SAMPLES;
+        bool isTransmitting = detector.processFrame(samples, FRAME_SAMPLES, 1);
+
+        // a frame is speech when any of it is
+        bool isSpeech = false;
+        for (int i = 0; i < FRAME_SAMPLES; i++) {
+            isSpeech = isSpeech || corpus.isSpeech[frame * FRAME_SAMPLES + i];
+        }
+
+        if (isSpeech) {
+            speechFrames++;
+            speechFramesSent += isTransmitting ? 1 : 0;
+            framesSinceSpeech = 0;
+
+            if (!wasSpeech) {
+                onsetFrame = frame;
+            }
+            if (onsetFrame != -1) {
+                if (isTransmitting) {
+                    onsetFrame = -1;
+                } else if (frame - onsetFrame >= MAX_ONSET_DELAY_FRAMES) {
+                    qDebug("%s: the word starting at frame %d wasn't sent in time", name, onsetFrame);
+                    onsetFrame = -1;
+                }
+            }
+        } else if (++framesSinceSpeech > hangoverFrames) {
+            // the hangover after a word is allowed to be sent
+            noiseFrames++;
+            noiseFramesSent += isTransmitting ? 1 : 0;
+        }
+        wasSpeech = isSpeech;
+    }
+
+    float recall = (float)speechFramesSent / speechFrames;
+    float falseTransmitRate = (float)noiseFramesSent / noiseFrames;
+    if (recall < MIN_SPEECH_RECALL) {
+        qDebug("%s: only %d of %d speech frames were sent", name, speechFramesSent, speechFrames);
+    }
+    if (falseTransmitRate > MAX_FALSE_TRANSMIT_RATE) {
+        qDebug("%s: %d of %d background frames were sent", name, noiseFramesSent, noiseFrames);
+    }
+}
+
+void VoiceActivityDetectorTests::testQuietRoom() {
+    const float SPEECH_RMS = 1500.0f;
+    checkCorpus("quiet room", QUIET_ROOM, SPEECH_RMS);
+}
+
+void VoiceActivityDetectorTests::testFanNoise() {
+    const float SPEECH_RMS = 3000.0f;
+    checkCorpus("fan noise", FAN_NOISE, SPEECH_RMS);
+}
+
+void VoiceActivityDetectorTests::testMainsHum() {
+    const float SPEECH_RMS = 1500.0f;
+    checkCorpus("mains hum", MAINS_HUM, SPEECH_RMS);
+}
+
+// feeds silence after whatever was last fed, and counts the frames sent after the detector stopped hearing speech
+static int countHangoverFrames(VoiceActivityDetector& detector, const int16_t* silence, int numChannels) {
+    int framesSent = 0;
+    for (int frame = 0; frame < NUM_FRAMES; frame++) {
+        if (!detector.processFrame(silence, FRAME_SAMPLES * numChannels, numChannels)) {
+            break;
+        }
+        // the band filters can ring into the first frame of silence
+        framesSent = detector.isSpeech() ? 0 : framesSent + 1;
+    }
+    return framesSent;
+}
+
+void VoiceActivityDetectorTests::testHangover() {
+    // a single loud frame is followed by exactly the hangover, then silent frames
+    const float TONE_FREQUENCY = 440.0f;
+    VoiceActivityDetector detector(SAMPLE_RATE);
+    int16_t silence[FRAME_SAMPLES * 2] = { 0 };
+    int16_t loud[FRAME_SAMPLES];
+    for (int i = 0; i < FRAME_SAMPLES; i++) {
+        loud[i] = (int16_t)(8000.0f * sinf(2.0f * (float)M_PI * TONE_FREQUENCY * i / SAMPLE_RATE));
+    }
+
+    for (int i = 0; i < 10; i++) {
+        if (detector.processFrame(silence, FRAME_SAMPLES, 1)) {
+            qDebug("digital silence was sent");
+        }
+    }
+    if (!detector.processFrame(loud, FRAME_SAMPLES, 1)) {
+        qDebug("a loud tone after silence wasn't sent");
+    }
+
+    int hangoverSamples = detector.getHangoverMsecs() * SAMPLE_RATE / 1000;
+    int expectedFrames = (hangoverSamples + FRAME_SAMPLES - 1) / FRAME_SAMPLES;
+    int framesSent = countHangoverFrames(detector, silence, 1);
+    if (framesSent != expectedFrames) {
+        qDebug("%d hangover frames were sent, expected %d", framesSent, expectedFrames);
+    }
+
+    // the same for stereo, where a frame has twice the samples but lasts as long
+    detector.reset();
+    int16_t loudStereo[FRAME_SAMPLES * 2];
+    for (int i = 0; i < FRAME_SAMPLES; i++) {
+        loudStereo[2 * i] = loudStereo[2 * i + 1] = loud[i];
+    }
+    detector.processFrame(silence, FRAME_SAMPLES * 2, 2);
+    detector.processFrame(loudStereo, FRAME_SAMPLES * 2, 2);
+    framesSent = countHangoverFrames(detector, silence, 2);
+    if (framesSent != expectedFrames) {
+        qDebug("%d stereo hangover frames were sent, expected %d", framesSent, expectedFrames);
+    }
+}
+
+void VoiceActivityDetectorTests::testQuietFrames() {
+    // silence and dither are quiet, a steady hum stays audible however long it goes on
+    const float HUM_FREQUENCY = 60.0f;
+    const int HUM_SECONDS = 10;
+    int16_t silence[FRAME_SAMPLES] = { 0 };
+    int16_t dither[FRAME_SAMPLES];
+    int16_t hum[FRAME_SAMPLES];
+    if (!VoiceActivityDetector::isQuietFrame(silence, FRAME_SAMPLES)) {
+        qDebug("digital silence wasn't quiet");
+    }
+    CorpusRandom random;
+    for (int i = 0; i < FRAME_SAMPLES; i++) {
+        dither[i] = (int16_t)(random.nextFloat() * 2.0f * VoiceActivityDetector::MAX_QUIET_SAMPLE) -
+            VoiceActivityDetector::MAX_QUIET_SAMPLE;
+    }
+    if (!VoiceActivityDetector::isQuietFrame(dither, FRAME_SAMPLES)) {
+        qDebug("dither wasn't quiet");
+    }
+    int humFrames = HUM_SECONDS * SAMPLE_RATE / FRAME_SAMPLES;
+    int quietHumFrames = 0;
+    for (int frame = 0; frame < humFrames; frame++) {
+        for (int i = 0; i < FRAME_SAMPLES; i++) {
+            float time = (float)(frame * FRAME_SAMPLES + i) / SAMPLE_RATE;
+            hum[i] = (int16_t)(500.0f * sinf(2.0f * (float)M_PI * HUM_FREQUENCY * time));
+        }
+        if (VoiceActivityDetector::isQuietFrame(hum, FRAME_SAMPLES)) {
+            quietHumFrames++;
+        }
+    }
+    if (quietHumFrames > 0) {
+        qDebug("%d of %d frames of a steady hum were quiet", quietHumFrames, humFrames);
+    }
+}
+
+void VoiceActivityDetectorTests::runAllTests() {
+    testQuietRoom();
+    testFanNoise();
+    testMainsHum();
+    testHangover();
+    testQuietFrames();
+
+    qDebug() << "passed VoiceActivityDetectorTests::runAllTests()";
+}
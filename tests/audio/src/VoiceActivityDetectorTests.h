@@ -0,0 +1,25 @@
+//
+//  VoiceActivityDetectorTests.h
+//  tests/audio/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_VoiceActivityDetectorTests_h
+#define hifi_VoiceActivityDetectorTests_h
+
+namespace VoiceActivityDetectorTests {
+
+    void runAllTests();
+
+    void testQuietRoom();
+    void testFanNoise();
+    void testMainsHum();
+    void testHangover();
+    void testQuietFrames();
+};
+
+#endif // hifi_VoiceActivityDetectorTests_h
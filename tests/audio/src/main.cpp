@@ -8,11 +8,17 @@
 //  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
 //
 
+#include "AudioCodecTests.h"
+#include "AudioLimiterTests.h"
 #include "AudioRingBufferTests.h"
+#include "VoiceActivityDetectorTests.h"
 #include <stdio.h>
 
 int main(int argc, char** argv) {
     AudioRingBufferTests::runAllTests();
+    AudioCodecTests::runAllTests();
+    AudioLimiterTests::runAllTests();
+    VoiceActivityDetectorTests::runAllTests();
     printf("all tests passed.  press enter to exit\n");
     getchar();
     return 0;
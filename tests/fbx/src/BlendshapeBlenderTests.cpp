@@ -0,0 +1,196 @@
+//
+//  BlendshapeBlenderTests.cpp
+//  tests/fbx/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <cfloat>
+
+#include <QDebug>
+#include <QFile>
+
+#include <BlendshapeBlender.h>
+#include <FBXReader.h>
+#include <SharedUtil.h>
+
+#include "BlendshapeBlenderTests.h"
+
+const char* BlendshapeBlenderTests::DEFAULT_FBX_PATH = "interface/resources/meshes/defaultAvatar/head.fbx";
+
+// the frames of made up faceshift input blended by each test, about half a minute of it
+const int BLEND_FRAMES = 1000;
+
+// faceshift holds some of the coefficients still from one frame to the next, like the ones of a closed mouth
+const float HELD_COEFFICIENT_CHANCE = 0.5f;
+
+// used when there's no FBX file with blendshapes around, about the size of the default avatar's head
+const int SYNTHETIC_VERTICES = 6000;
+const int SYNTHETIC_ENTRIES_PER_BLENDSHAPE = 600;
+
+const float MAXIMUM_ALLOWED_ERROR = 0.001f;
+
+static QVector<FBXMesh> getSyntheticMeshes() {
+    FBXMesh mesh;
+    for (int i = 0; i < SYNTHETIC_VERTICES; i++) {
+        mesh.vertices.append(glm::vec3(randFloatInRange(-10.0f, 10.0f), randFloatInRange(-10.0f, 10.0f),
+            randFloatInRange(-10.0f, 10.0f)));
+        mesh.normals.append(glm::vec3(0.0f, 0.0f, 1.0f));
+    }
+    for (int i = 0; i < NUM_FACESHIFT_BLENDSHAPES; i++) {
+        FBXBlendshape blendshape;
+        int index = randIntInRange(0, SYNTHETIC_VERTICES - SYNTHETIC_ENTRIES_PER_BLENDSHAPE);
+        for (int j = 0; j < SYNTHETIC_ENTRIES_PER_BLENDSHAPE; j++) {
+            blendshape.indices.append(index + j);
+            blendshape.vertices.append(glm::vec3(randFloatInRange(-1.0f, 1.0f), randFloatInRange(-1.0f, 1.0f),
+                randFloatInRange(-1.0f, 1.0f)));
+            blendshape.normals.append(glm::vec3(randFloatInRange(-1.0f, 1.0f), randFloatInRange(-1.0f, 1.0f), 0.0f));
+        }
+        mesh.blendshapes.append(blendshape);
+    }
+    mesh.sparseBlendshapes = getSparseBlendshapes(mesh.blendshapes);
+    return QVector<FBXMesh>() << mesh;
+}
+
+static QVector<FBXMesh> getMeshes(const char* fbxPath) {
+    QFile file(fbxPath);
+    if (file.open(QIODevice::ReadOnly)) {
+        try {
+            FBXGeometry geometry = readFBX(file.readAll(), QVariantHash());
+            if (geometry.hasBlendedMeshes()) {
+                qDebug() << "   blending" << fbxPath;
+                return geometry.meshes;
+            }
+        } catch (const QString& error) {
+            qDebug() << "   couldn't read" << fbxPath << ":" << error;
+        }
+    }
+    qDebug() << "   no blendshapes in" << fbxPath << "- blending made up ones";
+    return getSyntheticMeshes();
+}
+
+// faceshift-like input: most coefficients move a little every frame, the rest hold still for a while
+static QVector<QVector<float> > getCoefficientFrames() {
+    QVector<QVector<float> > frames;
+    QVector<float> coefficients(NUM_FACESHIFT_BLENDSHAPES, 0.0f);
+    for (int frame = 0; frame < BLEND_FRAMES; frame++) {
+        for (int i = 0; i < coefficients.size(); i++) {
+            if (randFloat() >= HELD_COEFFICIENT_CHANCE) {
+                coefficients[i] = glm::clamp(coefficients.at(i) + randFloatInRange(-0.1f, 0.1f), 0.0f, 1.0f);
+            }
+        }
+        frames.append(coefficients);
+    }
+    return frames;
+}
+
+// how the meshes were blended before, every blendshape from scratch for every blend
+static void fullBlend(const QVector<FBXMesh>& meshes, const QVector<float>& coefficients,
+        QVector<glm::vec3>& vertices, QVector<glm::vec3>& normals) {
+    vertices.clear();
+    normals.clear();
+    int offset = 0;
+    foreach (const FBXMesh& mesh, meshes) {
+        if (mesh.blendshapes.isEmpty()) {
+            continue;
+        }
+        vertices += mesh.vertices;
+        normals += mesh.normals;
+        glm::vec3* meshVertices = vertices.data() + offset;
+        glm::vec3* meshNormals = normals.data() + offset;
+        offset += mesh.vertices.size();
+        const float NORMAL_COEFFICIENT_SCALE = 0.01f;
+        for (int i = 0, n = qMin(coefficients.size(), mesh.blendshapes.size()); i < n; i++) {
+            float vertexCoefficient = coefficients.at(i);
+            if (vertexCoefficient < EPSILON) {
+                continue;
+            }
+            float normalCoefficient = vertexCoefficient * NORMAL_COEFFICIENT_SCALE;
+            const FBXBlendshape& blendshape = mesh.blendshapes.at(i);
+            for (int j = 0; j < blendshape.indices.size(); j++) {
+                int index = blendshape.indices.at(j);
+                meshVertices[index] += blendshape.vertices.at(j) * vertexCoefficient;
+                meshNormals[index] += blendshape.normals.at(j) * normalCoefficient;
+            }
+        }
+    }
+}
+
+static float maximumDifference(const QVector<glm::vec3>& a, const QVector<glm::vec3>& b) {
+    if (a.size() != b.size()) {
+        return FLT_MAX;
+    }
+    float difference = 0.0f;
+    for (int i = 0; i < a.size(); i++) {
+        glm::vec3 componentDifferences = glm::abs(a.at(i) - b.at(i));
+        difference = qMax(difference, qMax(componentDifferences.x, qMax(componentDifferences.y, componentDifferences.z)));
+    }
+    return difference;
+}
+
+void BlendshapeBlenderTests::blendMatchesFullBlendTest(const char* fbxPath) {
+    qDebug() << "******************************************************************************************";
+    qDebug() << "BlendshapeBlenderTests::blendMatchesFullBlendTest()";
+
+    QVector<FBXMesh> meshes = getMeshes(fbxPath);
+    QVector<QVector<float> > frames = getCoefficientFrames();
+
+    BlendshapeBlender blender;
+    float worstVertexDifference = 0.0f;
+    float worstNormalDifference = 0.0f;
+    for (int i = 0; i < frames.size(); i++) {
+        QVector<glm::vec3> expectedVertices, expectedNormals, vertices, normals;
+        fullBlend(meshes, frames.at(i), expectedVertices, expectedNormals);
+        blender.blend(meshes, frames.at(i), vertices, normals);
+        worstVertexDifference = qMax(worstVertexDifference, maximumDifference(vertices, expectedVertices));
+        worstNormalDifference = qMax(worstNormalDifference, maximumDifference(normals, expectedNormals));
+    }
+
+    if (worstVertexDifference <= MAXIMUM_ALLOWED_ERROR && worstNormalDifference <= MAXIMUM_ALLOWED_ERROR) {
+        qDebug() << "   test passed, largest differences from a full blend:" << worstVertexDifference
+            << worstNormalDifference;
+    } else {
+        qDebug() << "FAILED - largest differences from a full blend:" << worstVertexDifference << worstNormalDifference
+            << "allowed:" << MAXIMUM_ALLOWED_ERROR;
+    }
+}
+
+void BlendshapeBlenderTests::blendBenchmark(const char* fbxPath) {
+    qDebug() << "******************************************************************************************";
+    qDebug() << "BlendshapeBlenderTests::blendBenchmark()";
+
+    QVector<FBXMesh> meshes = getMeshes(fbxPath);
+    QVector<QVector<float> > frames = getCoefficientFrames();
+
+    quint64 start = usecTimestampNow();
+    for (int i = 0; i < frames.size(); i++) {
+        QVector<glm::vec3> vertices, normals;
+        fullBlend(meshes, frames.at(i), vertices, normals);
+    }
+    quint64 fullBlendUsecs = usecTimestampNow() - start;
+
+    BlendshapeBlender blender;
+    int blendshapesApplied = 0;
+    start = usecTimestampNow();
+    for (int i = 0; i < frames.size(); i++) {
+        QVector<glm::vec3> vertices, normals;
+        blender.blend(meshes, frames.at(i), vertices, normals);
+        blendshapesApplied += blender.getBlendshapesApplied();
+    }
+    quint64 blenderUsecs = usecTimestampNow() - start;
+
+    qDebug() << "   full blends:" << (float)fullBlendUsecs / frames.size() << "usecs per blend";
+    qDebug() << "   blender:" << (float)blenderUsecs / frames.size() << "usecs per blend,"
+        << (float)blendshapesApplied / frames.size() << "blendshapes applied per blend";
+    if (blenderUsecs > 0) {
+        qDebug() << "   speedup:" << (float)fullBlendUsecs / blenderUsecs;
+    }
+}
+
+void BlendshapeBlenderTests::runAllTests(const char* fbxPath) {
+    blendMatchesFullBlendTest(fbxPath);
+    blendBenchmark(fbxPath);
+}
@@ -0,0 +1,22 @@
+//
+//  BlendshapeBlenderTests.h
+//  tests/fbx/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_BlendshapeBlenderTests_h
+#define hifi_BlendshapeBlenderTests_h
+
+namespace BlendshapeBlenderTests {
+    extern const char* DEFAULT_FBX_PATH;
+
+    void blendMatchesFullBlendTest(const char* fbxPath);
+    void blendBenchmark(const char* fbxPath);
+    void runAllTests(const char* fbxPath);
+}
+
+#endif // hifi_BlendshapeBlenderTests_h
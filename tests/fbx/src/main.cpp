@@ -0,0 +1,17 @@
+//
+//  main.cpp
+//  tests/fbx/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "BlendshapeBlenderTests.h"
+
+int main(int argc, char** argv) {
+    // the blendshapes come from the FBX file given on the command line, or from the default avatar's head
+    BlendshapeBlenderTests::runAllTests(argc > 1 ? argv[1] : BlendshapeBlenderTests::DEFAULT_FBX_PATH);
+    return 0;
+}
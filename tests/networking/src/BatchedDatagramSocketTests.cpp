@@ -0,0 +1,137 @@
+//
+//  BatchedDatagramSocketTests.cpp
+//  tests/networking/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <cassert>
+#include <stdio.h>
+
+#include <QtCore/QElapsedTimer>
+
+#include <SharedUtil.h>
+
+#include "BatchedDatagramSocketTests.h"
+
+const int TEST_DATAGRAM_SIZE = 200;
+
+// gives up on datagrams that haven't shown up on the loopback interface after this long
+const qint64 RECEIVE_TIMEOUT_MSECS = 1000;
+
+void BatchedDatagramSocketTests::runAllTests() {
+    roundTripTest();
+    throughputBenchmark();
+}
+
+static QByteArray testDatagram(int index) {
+    QByteArray datagram(TEST_DATAGRAM_SIZE, (char)index);
+    memcpy(datagram.data(), &index, sizeof(int));
+    return datagram;
+}
+
+static int readAll(BatchedDatagramSocket& receiver, int expectedCount, bool checkContents) {
+    QByteArray datagram;
+    HifiSockAddr senderSockAddr;
+    int numReceived = 0;
+
+    QElapsedTimer timer;
+    timer.start();
+    while (numReceived < expectedCount && timer.elapsed() < RECEIVE_TIMEOUT_MSECS) {
+        while (receiver.readDatagram(datagram, senderSockAddr)) {
+            if (checkContents) {
+                assert(datagram == testDatagram(numReceived));
+            }
+            numReceived++;
+        }
+    }
+    return numReceived;
+}
+
+void BatchedDatagramSocketTests::roundTripTest() {
+    QUdpSocket senderSocket;
+    QUdpSocket receiverSocket;
+    senderSocket.bind(QHostAddress::LocalHost, 0);
+    receiverSocket.bind(QHostAddress::LocalHost, 0);
+
+    BatchedDatagramSocket sender(senderSocket);
+    BatchedDatagramSocket receiver(receiverSocket);
+    HifiSockAddr receiverSockAddr(QHostAddress::LocalHost, receiverSocket.localPort());
+
+    // more than one batch worth, with a partial batch at the end
+    const int NUM_DATAGRAMS = BatchedDatagramSocket::MAX_DATAGRAMS_PER_BATCH * 2 + 5;
+    for (int i = 0; i < NUM_DATAGRAMS; i++) {
+        sender.queueDatagram(testDatagram(i), receiverSockAddr);
+    }
+    sender.flushQueuedDatagrams();
+    assert(sender.getQueuedDatagramCount() == 0);
+
+    // loopback doesn't drop or reorder this few datagrams
+    int numReceived = readAll(receiver, NUM_DATAGRAMS, true);
+    assert(numReceived == NUM_DATAGRAMS);
+
+    QByteArray datagram;
+    HifiSockAddr senderSockAddr;
+    assert(!receiver.readDatagram(datagram, senderSockAddr));
+}
+
+void BatchedDatagramSocketTests::throughputBenchmark() {
+    QUdpSocket senderSocket;
+    QUdpSocket receiverSocket;
+    senderSocket.bind(QHostAddress::LocalHost, 0);
+    receiverSocket.bind(QHostAddress::LocalHost, 0);
+    HifiSockAddr receiverSockAddr(QHostAddress::LocalHost, receiverSocket.localPort());
+
+    // send in bursts small enough for the receive buffer, like a mixer frame going out to its listeners
+    const int DATAGRAMS_PER_BURST = 100;
+    const int NUM_BURSTS = 1000;
+    QByteArray datagram = testDatagram(0);
+
+    // one QUdpSocket call per datagram
+    QElapsedTimer timer;
+    timer.start();
+    int singleReceived = 0;
+    for (int burst = 0; burst < NUM_BURSTS; burst++) {
+        for (int i = 0; i < DATAGRAMS_PER_BURST; i++) {
+            senderSocket.writeDatagram(datagram, receiverSockAddr.getAddress(), receiverSockAddr.getPort());
+        }
+        QElapsedTimer burstTimer;
+        burstTimer.start();
+        int burstReceived = 0;
+        while (burstReceived < DATAGRAMS_PER_BURST && burstTimer.elapsed() < RECEIVE_TIMEOUT_MSECS) {
+            while (receiverSocket.hasPendingDatagrams()) {
+                QByteArray received(receiverSocket.pendingDatagramSize(), 0);
+                receiverSocket.readDatagram(received.data(), received.size());
+                burstReceived++;
+            }
+        }
+        singleReceived += burstReceived;
+    }
+    qint64 singleUsecs = timer.nsecsElapsed() / 1000;
+
+    // batched
+    BatchedDatagramSocket sender(senderSocket);
+    BatchedDatagramSocket receiver(receiverSocket);
+    timer.restart();
+    int batchedReceived = 0;
+    for (int burst = 0; burst < NUM_BURSTS; burst++) {
+        for (int i = 0; i < DATAGRAMS_PER_BURST; i++) {
+            sender.queueDatagram(datagram, receiverSockAddr);
+        }
+        sender.flushQueuedDatagrams();
+        batchedReceived += readAll(receiver, DATAGRAMS_PER_BURST, false);
+    }
+    qint64 batchedUsecs = timer.nsecsElapsed() / 1000;
+
+    const int NUM_DATAGRAMS = DATAGRAMS_PER_BURST * NUM_BURSTS;
+    printf("localhost throughput of %d datagrams of %d bytes\n", NUM_DATAGRAMS, TEST_DATAGRAM_SIZE);
+    printf("    one call per datagram: %lld usecs, %.0f datagrams per second, %d received\n",
+           singleUsecs, (float)singleReceived * USECS_PER_SECOND / singleUsecs, singleReceived);
+    printf("    batched:               %lld usecs, %.0f datagrams per second, %d received, "
+           "%.1f datagrams per read call, %.1f per write call\n",
+           batchedUsecs, (float)batchedReceived * USECS_PER_SECOND / batchedUsecs, batchedReceived,
+           receiver.getDatagramsPerReadCall(), sender.getDatagramsPerWriteCall());
+}
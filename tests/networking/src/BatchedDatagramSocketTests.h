@@ -0,0 +1,24 @@
+//
+//  BatchedDatagramSocketTests.h
+//  tests/networking/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_BatchedDatagramSocketTests_h
+#define hifi_BatchedDatagramSocketTests_h
+
+#include "BatchedDatagramSocket.h"
+
+namespace BatchedDatagramSocketTests {
+
+    void runAllTests();
+
+    void roundTripTest();
+    void throughputBenchmark();
+};
+
+#endif // hifi_BatchedDatagramSocketTests_h
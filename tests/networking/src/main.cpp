@@ -8,11 +8,17 @@
 //  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
 //
 
+#include <QtCore/QCoreApplication>
+
+#include "BatchedDatagramSocketTests.h"
 #include "SequenceNumberStatsTests.h"
 #include <stdio.h>
 
 int main(int argc, char** argv) {
+    QCoreApplication app(argc, argv);
+
     SequenceNumberStatsTests::runAllTests();
+    BatchedDatagramSocketTests::runAllTests();
     printf("tests passed! press enter to exit");
     getchar();
     return 0;
@@ -0,0 +1,246 @@
+//
+//  EditCoalescingTests.cpp
+//  tests/octree/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <QDebug>
+#include <QMutexLocker>
+#include <QVector>
+
+#include <EditPacketBuffer.h>
+#include <EntityEditPacketSender.h>
+#include <EntityItemProperties.h>
+#include <NodeList.h>
+#include <PacketHeaders.h>
+#include <SharedUtil.h>
+#include <VoxelEditPacketSender.h>
+
+#include "EditCoalescingTests.h"
+
+const xColor RED = { 255, 0, 0 };
+const xColor BLUE = { 0, 0, 255 };
+
+// with no servers known the senders leave what they pack in their pre-server queue, in order, where these can read it
+class TestEntityEditPacketSender : public EntityEditPacketSender {
+public:
+    void flush() {
+        QMutexLocker locker(&_coalescedEditsLock);
+        flushCoalescedEdits();
+    }
+    const QVector<EditPacketBuffer*>& getPackedMessages() const { return _preServerPackets; }
+};
+
+class TestVoxelEditPacketSender : public VoxelEditPacketSender {
+public:
+    void flush() {
+        QMutexLocker locker(&_coalescedEditsLock);
+        flushCoalescedEdits();
+    }
+    const QVector<EditPacketBuffer*>& getPackedMessages() const { return _preServerPackets; }
+};
+
+static void check(bool passed, const char* what, int& testsTaken, int& testsPassed, int& testsFailed, bool verbose) {
+    testsTaken++;
+    if (passed) {
+        testsPassed++;
+    } else {
+        testsFailed++;
+        if (verbose) {
+            qDebug() << "FAILED -" << what;
+        }
+    }
+}
+
+static bool sameColor(const xColor& a, const xColor& b) {
+    return a.red == b.red && a.green == b.green && a.blue == b.blue;
+}
+
+static bool decodeEdit(const EditPacketBuffer* message, EntityItemID& entityID, EntityItemProperties& properties) {
+    int processedBytes = 0;
+    return message->_currentType == PacketTypeEntityAddOrEdit
+        && EntityItemProperties::decodeEntityEditPacket(message->_currentBuffer, message->_currentSize, processedBytes,
+                                                        entityID, properties);
+}
+
+static void makeNodeList() {
+    // the senders look for servers in the node list, an agent's with no nodes in it has none
+    if (!NodeList::getInstance()) {
+        NodeList::createInstance(NodeType::Agent);
+    }
+}
+
+void EditCoalescingTests::propertyMergeTests(bool verbose) {
+    qDebug() << "******************************************************************************************";
+    qDebug() << "EditCoalescingTests::propertyMergeTests()";
+
+    int testsTaken = 0;
+    int testsPassed = 0;
+    int testsFailed = 0;
+
+    EntityItemProperties held;
+    held.setColor(RED);
+    held.setScript("first.js");
+
+    EntityItemProperties later;
+    later.setColor(BLUE);
+    later.setVisible(false);
+    held.merge(later);
+
+    EntityItemProperties latest;
+    latest.setScript("second.js");
+    held.merge(latest);
+
+    // each property takes the value of the last edit that set it, whatever else that edit set
+    check(sameColor(held.getColor(), BLUE), "later color wins", testsTaken, testsPassed, testsFailed, verbose);
+    check(!held.getVisible(), "property only the later edit set is merged in", testsTaken, testsPassed, testsFailed, verbose);
+    check(held.getScript() == "second.js", "latest script wins", testsTaken, testsPassed, testsFailed, verbose);
+    check(held.colorChanged() && held.getChangedProperties().getHasProperty(PROP_VISIBLE) && held.scriptChanged(),
+          "merged properties are changed",
+          testsTaken, testsPassed, testsFailed, verbose);
+    check(!held.positionChanged() && !held.rotationChanged(), "properties no edit set stay unchanged",
+          testsTaken, testsPassed, testsFailed, verbose);
+
+    qDebug() << "   tests passed:" << testsPassed << "out of" << testsTaken;
+}
+
+void EditCoalescingTests::entityEditTests(bool verbose) {
+    qDebug() << "******************************************************************************************";
+    qDebug() << "EditCoalescingTests::entityEditTests()";
+
+    int testsTaken = 0;
+    int testsPassed = 0;
+    int testsFailed = 0;
+
+    makeNodeList();
+
+    EntityItemID first(QUuid::createUuid(), 0, true);
+    EntityItemID second(QUuid::createUuid(), 0, true);
+    EntityItemID decodedID;
+
+    // edits to the same entity are merged and the entities are packed in the order of their first edit
+    {
+        TestEntityEditPacketSender sender;
+        EntityItemProperties firstEdit;
+        firstEdit.setColor(RED);
+        EntityItemProperties secondEdit;
+        secondEdit.setVisible(false);
+        EntityItemProperties thirdEdit;
+        thirdEdit.setColor(BLUE);
+        thirdEdit.setScript("moved.js");
+
+        sender.queueEditEntityMessage(PacketTypeEntityAddOrEdit, first, firstEdit);
+        sender.queueEditEntityMessage(PacketTypeEntityAddOrEdit, second, secondEdit);
+        sender.queueEditEntityMessage(PacketTypeEntityAddOrEdit, first, thirdEdit);
+        check(sender.getPackedMessages().isEmpty(), "edits are held for the window",
+              testsTaken, testsPassed, testsFailed, verbose);
+
+        sender.flush();
+        const QVector<EditPacketBuffer*>& messages = sender.getPackedMessages();
+        check(messages.size() == 2, "one edit per entity", testsTaken, testsPassed, testsFailed, verbose);
+        check(sender.getCoalescedEditCount() == 1, "merged edit is counted", testsTaken, testsPassed, testsFailed, verbose);
+        if (messages.size() == 2) {
+            EntityItemProperties firstPacked;
+            EntityItemProperties secondPacked;
+            check(decodeEdit(messages[0], decodedID, firstPacked) && decodedID.id == first.id,
+                  "first edited entity packed first", testsTaken, testsPassed, testsFailed, verbose);
+            check(sameColor(firstPacked.getColor(), BLUE) && firstPacked.getScript() == "moved.js",
+                  "packed edit has the latest values", testsTaken, testsPassed, testsFailed, verbose);
+            check(decodeEdit(messages[1], decodedID, secondPacked) && decodedID.id == second.id
+                  && !secondPacked.getVisible(), "second edited entity packed second",
+                  testsTaken, testsPassed, testsFailed, verbose);
+        }
+    }
+
+    // an erase drops what is held for the entity and goes out right away
+    {
+        TestEntityEditPacketSender sender;
+        EntityItemProperties edit;
+        edit.setColor(RED);
+        sender.queueEditEntityMessage(PacketTypeEntityAddOrEdit, first, edit);
+        sender.queueEraseEntityMessage(first);
+        sender.flush();
+
+        const QVector<EditPacketBuffer*>& messages = sender.getPackedMessages();
+        check(messages.size() == 1 && messages[0]->_currentType == PacketTypeEntityErase, "erase drops held edit",
+              testsTaken, testsPassed, testsFailed, verbose);
+        check(sender.getCoalescedEditCount() == 1, "dropped edit is counted", testsTaken, testsPassed, testsFailed, verbose);
+    }
+
+    // without a window every edit is packed as it is queued
+    {
+        TestEntityEditPacketSender sender;
+        sender.setEditCoalescingWindow(0);
+        EntityItemProperties edit;
+        edit.setColor(RED);
+        sender.queueEditEntityMessage(PacketTypeEntityAddOrEdit, first, edit);
+        sender.queueEditEntityMessage(PacketTypeEntityAddOrEdit, first, edit);
+        check(sender.getPackedMessages().size() == 2, "no window packs right away",
+              testsTaken, testsPassed, testsFailed, verbose);
+        check(sender.getCoalescedEditCount() == 0, "nothing merged without a window",
+              testsTaken, testsPassed, testsFailed, verbose);
+    }
+
+    qDebug() << "   tests passed:" << testsPassed << "out of" << testsTaken;
+}
+
+void EditCoalescingTests::voxelEditTests(bool verbose) {
+    qDebug() << "******************************************************************************************";
+    qDebug() << "EditCoalescingTests::voxelEditTests()";
+
+    int testsTaken = 0;
+    int testsPassed = 0;
+    int testsFailed = 0;
+
+    makeNodeList();
+
+    const float PARENT_SIZE = 1.0f / 256.0f;
+    VoxelDetail parent = { 0.5f, 0.5f, 0.5f, PARENT_SIZE, 0, 0, 0 };
+    VoxelDetail child = { 0.5f, 0.5f, 0.5f, PARENT_SIZE / 2.0f, 255, 0, 0 };
+    VoxelDetail recoloredChild = child;
+    recoloredChild.green = 255;
+
+    // a set to the same voxel replaces the one held
+    {
+        TestVoxelEditPacketSender sender;
+        sender.queueVoxelEditMessages(PacketTypeVoxelSetDestructive, 1, &child);
+        sender.queueVoxelEditMessages(PacketTypeVoxelSetDestructive, 1, &recoloredChild);
+        sender.flush();
+
+        const QVector<EditPacketBuffer*>& messages = sender.getPackedMessages();
+        check(messages.size() == 1 && messages[0]->_currentBuffer[messages[0]->_currentSize - 2] == 255,
+              "repeated set packs the latest color", testsTaken, testsPassed, testsFailed, verbose);
+    }
+
+    // a set inside a held erase can't be merged into a set held before the erase, or the erase would land after it
+    {
+        TestVoxelEditPacketSender sender;
+        sender.queueVoxelEditMessages(PacketTypeVoxelSetDestructive, 1, &child);
+        sender.queueVoxelEditMessages(PacketTypeVoxelErase, 1, &parent);
+        sender.queueVoxelEditMessages(PacketTypeVoxelSetDestructive, 1, &recoloredChild);
+        sender.flush();
+
+        const QVector<EditPacketBuffer*>& messages = sender.getPackedMessages();
+        check(messages.size() == 3, "set inside held erase isn't merged", testsTaken, testsPassed, testsFailed, verbose);
+        if (messages.size() == 3) {
+            check(messages[0]->_currentType == PacketTypeVoxelSetDestructive
+                  && messages[1]->_currentType == PacketTypeVoxelErase
+                  && messages[2]->_currentType == PacketTypeVoxelSetDestructive,
+                  "set, erase and set go out in order", testsTaken, testsPassed, testsFailed, verbose);
+            check(messages[2]->_currentBuffer[messages[2]->_currentSize - 2] == 255, "last set has its own color",
+                  testsTaken, testsPassed, testsFailed, verbose);
+        }
+    }
+
+    qDebug() << "   tests passed:" << testsPassed << "out of" << testsTaken;
+}
+
+void EditCoalescingTests::runAllTests(bool verbose) {
+    propertyMergeTests(verbose);
+    entityEditTests(verbose);
+    voxelEditTests(verbose);
+}
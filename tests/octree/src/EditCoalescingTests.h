@@ -0,0 +1,21 @@
+//
+//  EditCoalescingTests.h
+//  tests/octree/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_EditCoalescingTests_h
+#define hifi_EditCoalescingTests_h
+
+namespace EditCoalescingTests {
+    void propertyMergeTests(bool verbose);
+    void entityEditTests(bool verbose);
+    void voxelEditTests(bool verbose);
+    void runAllTests(bool verbose);
+}
+
+#endif // hifi_EditCoalescingTests_h
@@ -0,0 +1,224 @@
+//
+//  FrustumCullingTests.cpp
+//  tests/octree/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <QDebug>
+
+#include <glm/gtc/quaternion.hpp>
+
+#include <AACube.h>
+#include <SharedUtil.h>
+#include <ViewFrustum.h>
+
+#include "FrustumCullingTests.h"
+
+// a full tree this deep below the root has 2.4 million elements, with the leaves 128 meters across
+const int SYNTHETIC_TREE_DEPTH = 7;
+
+// big enough to hold some of the elements near the camera completely
+const float LARGE_KEYHOLE_RADIUS = 1000.0f;
+
+const int BENCHMARK_RUNS = 5;
+
+static void setUpFrustum(ViewFrustum& viewFrustum, const glm::vec3& position, const glm::quat& orientation,
+                         float keyholeRadius) {
+    viewFrustum.setPosition(position);
+    viewFrustum.setOrientation(orientation);
+    viewFrustum.setFieldOfView(DEFAULT_FIELD_OF_VIEW_DEGREES);
+    viewFrustum.setAspectRatio(DEFAULT_ASPECT_RATIO);
+    viewFrustum.setNearClip(DEFAULT_NEAR_CLIP);
+    viewFrustum.setFarClip(DEFAULT_FAR_CLIP);
+    viewFrustum.setKeyholeRadius(keyholeRadius);
+    viewFrustum.calculate();
+}
+
+static AACube childCube(const AACube& parentCube, int childIndex) {
+    float halfScale = parentCube.getScale() / 2.0f;
+    const glm::vec3& corner = parentCube.getCorner();
+    return AACube(glm::vec3((childIndex & 4) ? corner.x + halfScale : corner.x,
+                            (childIndex & 2) ? corner.y + halfScale : corner.y,
+                            (childIndex & 1) ? corner.z + halfScale : corner.z), halfScale);
+}
+
+class CullingCounts {
+public:
+    quint64 tested;
+    quint64 locations[3]; // indexed by ViewFrustum::location
+
+    CullingCounts() : tested(0) { locations[0] = locations[1] = locations[2] = 0; }
+
+    bool operator==(const CullingCounts& other) const {
+        return locations[0] == other.locations[0] && locations[1] == other.locations[1]
+            && locations[2] == other.locations[2];
+    }
+};
+
+// the way the octree was culled before, every child of an intersecting element tested against all six planes
+static void cullChildrenOneByOne(const ViewFrustum& viewFrustum, const AACube& cube, ViewFrustum::location location,
+                                 int depth, CullingCounts& counts) {
+    counts.locations[location]++;
+    if (depth == SYNTHETIC_TREE_DEPTH || location == ViewFrustum::OUTSIDE) {
+        return;
+    }
+    for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+        AACube child = childCube(cube, i);
+        ViewFrustum::location childLocation = ViewFrustum::INSIDE;
+        if (location == ViewFrustum::INTERSECT) {
+            childLocation = viewFrustum.cubeInFrustum(child);
+            counts.tested++;
+        }
+        cullChildrenOneByOne(viewFrustum, child, childLocation, depth + 1, counts);
+    }
+}
+
+static void cullChildrenAtOnce(const ViewFrustum& viewFrustum, const AACube& cube, ViewFrustum::location location,
+                               unsigned char planeMask, int depth, CullingCounts& counts) {
+    counts.locations[location]++;
+    if (depth == SYNTHETIC_TREE_DEPTH || location == ViewFrustum::OUTSIDE) {
+        return;
+    }
+    ViewFrustum::location childLocations[NUMBER_OF_CHILDREN];
+    unsigned char childPlaneMasks[NUMBER_OF_CHILDREN];
+    if (location == ViewFrustum::INTERSECT) {
+        viewFrustum.childrenInFrustum(cube, planeMask, childLocations, childPlaneMasks);
+        counts.tested += NUMBER_OF_CHILDREN;
+    } else {
+        for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+            childLocations[i] = ViewFrustum::INSIDE;
+            childPlaneMasks[i] = ALL_FRUSTUM_PLANES_INSIDE;
+        }
+    }
+
+    for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+        cullChildrenAtOnce(viewFrustum, childCube(cube, i), childLocations[i], childPlaneMasks[i], depth + 1, counts);
+    }
+}
+
+// compares each child found at once against the same child tested on its own, returns the number that differ
+static int compareChildren(const ViewFrustum& viewFrustum, const AACube& cube, unsigned char planeMask, int depth,
+                           bool verbose) {
+    if (depth == SYNTHETIC_TREE_DEPTH) {
+        return 0;
+    }
+    ViewFrustum::location childLocations[NUMBER_OF_CHILDREN];
+    unsigned char childPlaneMasks[NUMBER_OF_CHILDREN];
+    viewFrustum.childrenInFrustum(cube, planeMask, childLocations, childPlaneMasks);
+
+    int mismatches = 0;
+    for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+        AACube child = childCube(cube, i);
+        ViewFrustum::location expected = viewFrustum.cubeInFrustum(child);
+        if (childLocations[i] != expected) {
+            if (verbose) {
+                qDebug() << "child" << i << "of" << cube << "is" << childLocations[i] << "expected" << expected;
+            }
+            mismatches++;
+        }
+        if (childLocations[i] == ViewFrustum::INTERSECT) {
+            mismatches += compareChildren(viewFrustum, child, childPlaneMasks[i], depth + 1, verbose);
+        }
+    }
+    return mismatches;
+}
+
+void FrustumCullingTests::childrenMatchCubeTests(bool verbose) {
+    qDebug() << "******************************************************************************************";
+    qDebug() << "FrustumCullingTests::childrenMatchCubeTests()";
+
+    int testsTaken = 0;
+    int testsPassed = 0;
+    int testsFailed = 0;
+
+    AACube rootCube(glm::vec3(0.0f, 0.0f, 0.0f), (float)TREE_SCALE);
+    glm::vec3 positions[] = { glm::vec3(TREE_SCALE / 2.0f), glm::vec3(100.0f, 20.0f, 300.0f),
+                              glm::vec3(-500.0f, TREE_SCALE / 4.0f, TREE_SCALE + 10.0f) };
+    glm::quat orientations[] = { glm::quat(), glm::quat(glm::vec3(0.3f, 2.0f, 0.1f)),
+                                 glm::quat(glm::vec3(-0.7f, -2.5f, 0.0f)) };
+    float keyholeRadii[] = { DEFAULT_KEYHOLE_RADIUS, LARGE_KEYHOLE_RADIUS };
+
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 2; j++) {
+            ViewFrustum viewFrustum;
+            setUpFrustum(viewFrustum, positions[i], orientations[i], keyholeRadii[j]);
+
+            unsigned char planeMask = NO_FRUSTUM_PLANES_INSIDE;
+            ViewFrustum::location rootLocation = viewFrustum.cubeInFrustum(rootCube, planeMask);
+
+            testsTaken++;
+            int mismatches = (rootLocation == ViewFrustum::INTERSECT)
+                ? compareChildren(viewFrustum, rootCube, planeMask, 0, verbose) : 0;
+            if (mismatches == 0) {
+                testsPassed++;
+            } else {
+                testsFailed++;
+                qDebug() << "FAILED - Test" << testsTaken << ":" << mismatches << "children culled differently at once";
+            }
+        }
+    }
+
+    qDebug() << "   tests passed:" << testsPassed << "out of" << testsTaken;
+    if (testsFailed > 0) {
+        qDebug() << "   tests failed:" << testsFailed;
+    }
+}
+
+void FrustumCullingTests::cullingBenchmark(bool verbose) {
+    qDebug() << "******************************************************************************************";
+    qDebug() << "FrustumCullingTests::cullingBenchmark()";
+
+    AACube rootCube(glm::vec3(0.0f, 0.0f, 0.0f), (float)TREE_SCALE);
+    ViewFrustum viewFrustum;
+    setUpFrustum(viewFrustum, glm::vec3(TREE_SCALE / 2.0f), glm::quat(glm::vec3(0.3f, 2.0f, 0.1f)), DEFAULT_KEYHOLE_RADIUS);
+
+    unsigned char rootPlaneMask = NO_FRUSTUM_PLANES_INSIDE;
+    ViewFrustum::location rootLocation = viewFrustum.cubeInFrustum(rootCube, rootPlaneMask);
+
+    quint64 oneByOneUsecs = 0;
+    quint64 atOnceUsecs = 0;
+    CullingCounts oneByOneCounts;
+    CullingCounts atOnceCounts;
+
+    for (int run = 0; run < BENCHMARK_RUNS; run++) {
+        oneByOneCounts = CullingCounts();
+        quint64 start = usecTimestampNow();
+        cullChildrenOneByOne(viewFrustum, rootCube, rootLocation, 0, oneByOneCounts);
+        oneByOneUsecs += usecTimestampNow() - start;
+
+        atOnceCounts = CullingCounts();
+        start = usecTimestampNow();
+        cullChildrenAtOnce(viewFrustum, rootCube, rootLocation, rootPlaneMask, 0, atOnceCounts);
+        atOnceUsecs += usecTimestampNow() - start;
+    }
+
+    quint64 elementsVisited = oneByOneCounts.locations[0] + oneByOneCounts.locations[1] + oneByOneCounts.locations[2];
+    qDebug() << "   elements visited:" << elementsVisited << "inside:" << oneByOneCounts.locations[ViewFrustum::INSIDE]
+        << "intersect:" << oneByOneCounts.locations[ViewFrustum::INTERSECT]
+        << "outside:" << oneByOneCounts.locations[ViewFrustum::OUTSIDE];
+
+    if (!(oneByOneCounts == atOnceCounts)) {
+        qDebug() << "FAILED - culling the children at once visited inside:" << atOnceCounts.locations[ViewFrustum::INSIDE]
+            << "intersect:" << atOnceCounts.locations[ViewFrustum::INTERSECT]
+            << "outside:" << atOnceCounts.locations[ViewFrustum::OUTSIDE];
+    }
+
+    float oneByOneMsecs = (float)oneByOneUsecs / BENCHMARK_RUNS / USECS_PER_MSEC;
+    float atOnceMsecs = (float)atOnceUsecs / BENCHMARK_RUNS / USECS_PER_MSEC;
+    qDebug() << "   one child at a time:" << oneByOneMsecs << "msecs per tree," << oneByOneCounts.tested << "cubes tested,"
+        << (oneByOneUsecs > 0 ? (float)oneByOneCounts.tested * BENCHMARK_RUNS / oneByOneUsecs : 0.0f) << "cubes per usec";
+    qDebug() << "   all children at once:" << atOnceMsecs << "msecs per tree," << atOnceCounts.tested << "cubes tested,"
+        << (atOnceUsecs > 0 ? (float)atOnceCounts.tested * BENCHMARK_RUNS / atOnceUsecs : 0.0f) << "cubes per usec";
+    if (atOnceUsecs > 0) {
+        qDebug() << "   speedup:" << (float)oneByOneUsecs / atOnceUsecs;
+    }
+}
+
+void FrustumCullingTests::runAllTests(bool verbose) {
+    childrenMatchCubeTests(verbose);
+    cullingBenchmark(verbose);
+}
@@ -0,0 +1,20 @@
+//
+//  FrustumCullingTests.h
+//  tests/octree/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_FrustumCullingTests_h
+#define hifi_FrustumCullingTests_h
+
+namespace FrustumCullingTests {
+    void childrenMatchCubeTests(bool verbose);
+    void cullingBenchmark(bool verbose);
+    void runAllTests(bool verbose);
+}
+
+#endif // hifi_FrustumCullingTests_h
@@ -14,17 +14,29 @@
 
 #include <QDebug>
 
+#include <DeletedEntityLog.h>
 #include <EntityItem.h>
 #include <EntityTree.h>
 #include <EntityTreeElement.h>
+#include <LimitedNodeList.h>
 #include <Octree.h>
 #include <OctreeConstants.h>
+#include <PacketHeaders.h>
 #include <PropertyFlags.h>
 #include <SharedUtil.h>
 
 //#include "EntityTests.h"
 #include "ModelTests.h" // needs to be EntityTests.h soon
 
+// the number of IDs in an erase packet made by EntityTree::encodeEntitiesDeletedSince()
+static int countDeletedEntityIDs(const unsigned char* packet) {
+    const unsigned char* numberOfIDsAt = packet + numBytesForPacketHeader(reinterpret_cast<const char*>(packet)) +
+        sizeof(OCTREE_PACKET_FLAGS) + sizeof(OCTREE_PACKET_SEQUENCE) + sizeof(OCTREE_PACKET_SENT_TIME);
+    uint16_t numberOfIDs;
+    memcpy(&numberOfIDs, numberOfIDsAt, sizeof(numberOfIDs));
+    return numberOfIDs;
+}
+
 void EntityTests::entityTreeTests(bool verbose) {
 
     bool extraVerbose = false;
@@ -511,6 +523,146 @@ void EntityTests::entityTreeTests(bool verbose) {
                         << "elapsed Find=" << elapsedInMSecsFind << "msecs";
     }
 
+    {
+        testsTaken++;
+        QString testName = "edits in a burst land where they do without one";
+        if (verbose) {
+            qDebug() << "Test" << testsTaken <<":" << qPrintable(testName);
+        }
+
+        const int BURST_ENTITIES = 100;
+        const int BURST_EDITS = 3;
+        EntityTree plainTree;
+        EntityTree burstTree;
+        QVector<EntityItemID> burstIDs;
+        for (int i = 0; i < BURST_ENTITIES; i++) {
+            EntityItemID burstID(QUuid::createUuid());
+            burstID.isKnownID = false;
+            EntityItemProperties burstProperties;
+            burstProperties.setPosition(glm::vec3(randFloatInRange(0.0f, (float)TREE_SCALE),
+                randFloatInRange(0.0f, (float)TREE_SCALE), randFloatInRange(0.0f, (float)TREE_SCALE)));
+            plainTree.addEntity(burstID, burstProperties);
+            burstTree.addEntity(burstID, burstProperties);
+            burstID.isKnownID = true;
+            burstIDs << burstID;
+        }
+
+        // some of the edits nudge an entity within its element, the others send it across the domain, and each entity
+        // is edited more than once in the burst
+        burstTree.startEditBurst();
+        for (int j = 0; j < BURST_EDITS; j++) {
+            for (int i = 0; i < BURST_ENTITIES; i++) {
+                const EntityItem* entity = plainTree.findEntityByEntityItemID(burstIDs.at(i));
+                glm::vec3 newPosition = entity->getPosition() * (float)TREE_SCALE;
+                if (i % 2 == 0) {
+                    newPosition += glm::vec3(oneMeter * 0.001f);
+                } else {
+                    newPosition = glm::vec3(randFloatInRange(0.0f, (float)TREE_SCALE),
+                        randFloatInRange(0.0f, (float)TREE_SCALE), randFloatInRange(0.0f, (float)TREE_SCALE));
+                }
+                EntityItemProperties burstProperties;
+                burstProperties.setPosition(newPosition);
+                plainTree.updateEntity(burstIDs.at(i), burstProperties);
+                burstTree.updateEntity(burstIDs.at(i), burstProperties);
+            }
+        }
+        burstTree.finishEditBurst();
+
+        int entitiesPassed = 0;
+        for (int i = 0; i < BURST_ENTITIES; i++) {
+            const EntityItem* plainEntity = plainTree.findEntityByEntityItemID(burstIDs.at(i));
+            const EntityItem* burstEntity = burstTree.findEntityByEntityItemID(burstIDs.at(i));
+            EntityTreeElement* plainElement = plainTree.getContainingElement(burstIDs.at(i));
+            EntityTreeElement* burstElement = burstTree.getContainingElement(burstIDs.at(i));
+            if (plainEntity && burstEntity && plainElement && burstElement &&
+                    plainEntity->getPosition() == burstEntity->getPosition() &&
+                    plainElement->getAACube() == burstElement->getAACube() &&
+                    burstElement->getEntityWithEntityItemID(burstIDs.at(i)) == burstEntity) {
+                entitiesPassed++;
+            } else if (extraVerbose) {
+                qDebug() << "FAILED - Test" << testsTaken <<":" << qPrintable(testName) << "entity:" << i;
+            }
+        }
+
+        bool passed = entitiesPassed == BURST_ENTITIES;
+        if (passed) {
+            testsPassed++;
+        } else {
+            testsFailed++;
+            qDebug() << "FAILED - Test" << testsTaken <<":" << qPrintable(testName);
+        }
+    }
+
+    {
+        testsTaken++;
+        QString testName = "deleted entities are read once through each cursor";
+        if (verbose) {
+            qDebug() << "Test" << testsTaken <<":" << qPrintable(testName);
+        }
+
+        // enough deletions to fill several blocks of the log
+        const int DELETED_ENTITIES = DeletedEntityLog::BLOCK_SIZE * 3 + 10;
+        EntityTree serverTree;
+        serverTree.setIsServer(true);
+        QVector<EntityItemID> deletedIDs;
+        for (int i = 0; i < DELETED_ENTITIES; i++) {
+            EntityItemID deletedID(QUuid::createUuid());
+            deletedID.isKnownID = true; // the server tree only takes entities with known IDs
+            EntityItemProperties deletedProperties;
+            deletedProperties.setPosition(positionAtCenterInMeters);
+            serverTree.addEntity(deletedID, deletedProperties);
+            deletedIDs << deletedID;
+        }
+
+        DeletedEntityCursor earlyCursor;
+        DeletedEntityCursor lateCursor;
+        bool passed = !serverTree.hasEntitiesDeletedSince(earlyCursor);
+
+        unsigned char outputBuffer[MAX_PACKET_SIZE];
+        size_t packetLength = 0;
+        int earlyCount = 0;
+        for (int i = 0; i < DELETED_ENTITIES; i++) {
+            serverTree.deleteEntity(deletedIDs.at(i));
+
+            // the early cursor keeps up as the deletions come in
+            if (i % 100 == 0) {
+                bool hasMoreToSend = true;
+                while (hasMoreToSend) {
+                    hasMoreToSend = serverTree.encodeEntitiesDeletedSince(0, earlyCursor, outputBuffer, MAX_PACKET_SIZE,
+                                                                          packetLength);
+                    earlyCount += countDeletedEntityIDs(outputBuffer);
+                }
+            }
+        }
+
+        // nothing the late cursor hasn't read can be forgotten
+        serverTree.forgetEntitiesDeletedBefore(lateCursor.getSequence());
+
+        int lateCount = 0;
+        while (serverTree.hasEntitiesDeletedSince(lateCursor)) {
+            serverTree.encodeEntitiesDeletedSince(0, lateCursor, outputBuffer, MAX_PACKET_SIZE, packetLength);
+            lateCount += countDeletedEntityIDs(outputBuffer);
+        }
+        while (serverTree.hasEntitiesDeletedSince(earlyCursor)) {
+            serverTree.encodeEntitiesDeletedSince(0, earlyCursor, outputBuffer, MAX_PACKET_SIZE, packetLength);
+            earlyCount += countDeletedEntityIDs(outputBuffer);
+        }
+        // once both cursors are through, nothing is left to forget even though the last block is kept
+        bool hadDeletedEntities = serverTree.hasAnyDeletedEntities();
+        serverTree.forgetEntitiesDeletedBefore(qMin(earlyCursor.getSequence(), lateCursor.getSequence()));
+
+        passed = passed && earlyCount == DELETED_ENTITIES && lateCount == DELETED_ENTITIES &&
+            earlyCursor.getSequence() == (quint64)DELETED_ENTITIES &&
+            lateCursor.getSequence() == (quint64)DELETED_ENTITIES && hadDeletedEntities && !serverTree.hasAnyDeletedEntities();
+        if (passed) {
+            testsPassed++;
+        } else {
+            testsFailed++;
+            qDebug() << "FAILED - Test" << testsTaken <<":" << qPrintable(testName)
+                << "earlyCount=" << earlyCount << "lateCount=" << lateCount;
+        }
+    }
+
     qDebug() << "   tests passed:" << testsPassed << "out of" << testsTaken;
     if (verbose) {
         qDebug() << "******************************************************************************************";
@@ -0,0 +1,178 @@
+//
+//  OctreeElementIndexTests.cpp
+//  tests/octree/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <QDebug>
+#include <QVector>
+
+#include <OctalCode.h>
+#include <SharedUtil.h>
+#include <VoxelTree.h>
+
+#include "OctreeElementIndexTests.h"
+
+// a block of voxels at a depth like the ones edit scripts work at
+const int VOXELS_PER_SIDE = 24;
+const float BLOCK_CORNER = 0.5f;
+const float VOXEL_SIZE = 1.0f / 2048.0f;
+const int LOOKUP_PASSES = 20;
+
+class VoxelPoint {
+public:
+    float x, y, z;
+};
+
+static void buildBlock(VoxelTree& tree, QVector<VoxelPoint>& points) {
+    for (int i = 0; i < VOXELS_PER_SIDE; i++) {
+        for (int j = 0; j < VOXELS_PER_SIDE; j++) {
+            for (int k = 0; k < VOXELS_PER_SIDE; k++) {
+                VoxelPoint point = { BLOCK_CORNER + i * VOXEL_SIZE, BLOCK_CORNER + j * VOXEL_SIZE,
+                                     BLOCK_CORNER + k * VOXEL_SIZE };
+                tree.createVoxel(point.x, point.y, point.z, VOXEL_SIZE, i * 10, j * 10, k * 10);
+                points.append(point);
+            }
+        }
+    }
+}
+
+static bool sameElement(OctreeElement* indexed, OctreeElement* walked) {
+    if (!indexed || !walked) {
+        return indexed == walked;
+    }
+    return compareOctalCodes(indexed->getOctalCode(), walked->getOctalCode()) == EXACT_MATCH;
+}
+
+static void check(bool passed, const char* what, int& testsTaken, int& testsPassed, int& testsFailed, bool verbose) {
+    testsTaken++;
+    if (passed) {
+        testsPassed++;
+    } else {
+        testsFailed++;
+        if (verbose) {
+            qDebug() << "FAILED -" << what;
+        }
+    }
+}
+
+void OctreeElementIndexTests::lookupTests(bool verbose) {
+    qDebug() << "******************************************************************************************";
+    qDebug() << "OctreeElementIndexTests::lookupTests()";
+
+    int testsTaken = 0;
+    int testsPassed = 0;
+    int testsFailed = 0;
+
+    // keys of codes of different lengths don't collide, and long codes have none
+    unsigned char rootCode[] = { 0 };
+    unsigned char firstChild[] = { 1, 0x00 };
+    unsigned char lastChild[] = { 1, 0xE0 };
+    unsigned char firstGrandchild[] = { 2, 0x00 };
+    check(octalCodeToKey(rootCode) == ROOT_OCTAL_CODE_KEY, "root key", testsTaken, testsPassed, testsFailed, verbose);
+    check(octalCodeToKey(firstChild) == 8 && octalCodeToKey(lastChild) == 15, "child keys",
+          testsTaken, testsPassed, testsFailed, verbose);
+    check(octalCodeToKey(firstGrandchild) == 64, "grandchild key", testsTaken, testsPassed, testsFailed, verbose);
+    unsigned char* deepCode = pointToOctalCode(0.3f, 0.6f, 0.9f, 1.0f / (1 << 24));
+    check(octalCodeToKey(deepCode) == INVALID_OCTAL_CODE_KEY, "deep code has no key",
+          testsTaken, testsPassed, testsFailed, verbose);
+    delete[] deepCode;
+
+    // the same edits on a tree with the index and one without find the same elements
+    VoxelTree indexedTree;
+    VoxelTree walkedTree;
+    walkedTree.setUseElementIndex(false);
+    QVector<VoxelPoint> points;
+    buildBlock(indexedTree, points);
+    points.clear();
+    buildBlock(walkedTree, points);
+
+    for (int pass = 0; pass < 2; pass++) {
+        bool allFound = true;
+        bool allCreated = true;
+        for (int i = 0; i < points.size(); i++) {
+            const VoxelPoint& point = points[i];
+            allFound = allFound && sameElement(indexedTree.getOctreeElementAt(point.x, point.y, point.z, VOXEL_SIZE),
+                                               walkedTree.getOctreeElementAt(point.x, point.y, point.z, VOXEL_SIZE));
+            allCreated = allCreated && sameElement(
+                indexedTree.getOrCreateChildElementAt(point.x, point.y, point.z, VOXEL_SIZE),
+                walkedTree.getOrCreateChildElementAt(point.x, point.y, point.z, VOXEL_SIZE));
+        }
+        check(allFound, pass == 0 ? "lookups filling the index" : "lookups from the index",
+              testsTaken, testsPassed, testsFailed, verbose);
+        check(allCreated, pass == 0 ? "get or create filling the index" : "get or create from the index",
+              testsTaken, testsPassed, testsFailed, verbose);
+    }
+
+    // deleted voxels leave the index, and aren't found again
+    bool allDeleted = true;
+    for (int i = 0; i < points.size(); i += 2) {
+        const VoxelPoint& point = points[i];
+        indexedTree.deleteVoxelAt(point.x, point.y, point.z, VOXEL_SIZE);
+        walkedTree.deleteVoxelAt(point.x, point.y, point.z, VOXEL_SIZE);
+    }
+    for (int i = 0; i < points.size(); i++) {
+        const VoxelPoint& point = points[i];
+        allDeleted = allDeleted && sameElement(indexedTree.getOctreeElementAt(point.x, point.y, point.z, VOXEL_SIZE),
+                                               walkedTree.getOctreeElementAt(point.x, point.y, point.z, VOXEL_SIZE));
+    }
+    check(allDeleted, "lookups after deletes", testsTaken, testsPassed, testsFailed, verbose);
+
+    indexedTree.eraseAllOctreeElements();
+    VoxelPoint first = points[0];
+    check(!indexedTree.getOctreeElementAt(first.x, first.y, first.z, VOXEL_SIZE), "lookup after erasing the tree",
+          testsTaken, testsPassed, testsFailed, verbose);
+
+    qDebug() << "   tests passed:" << testsPassed << "out of" << testsTaken;
+    if (testsFailed > 0) {
+        qDebug() << "   tests failed:" << testsFailed;
+    }
+}
+
+static quint64 timeLookups(VoxelTree& tree, const QVector<VoxelPoint>& points) {
+    quint64 start = usecTimestampNow();
+    for (int pass = 0; pass < LOOKUP_PASSES; pass++) {
+        for (int i = 0; i < points.size(); i++) {
+            tree.getOctreeElementAt(points[i].x, points[i].y, points[i].z, VOXEL_SIZE);
+            tree.getOrCreateChildElementAt(points[i].x, points[i].y, points[i].z, VOXEL_SIZE);
+        }
+    }
+    return usecTimestampNow() - start;
+}
+
+void OctreeElementIndexTests::lookupBenchmark(bool verbose) {
+    qDebug() << "******************************************************************************************";
+    qDebug() << "OctreeElementIndexTests::lookupBenchmark()";
+
+    QVector<VoxelPoint> points;
+    VoxelTree walkedTree;
+    walkedTree.setUseElementIndex(false);
+    quint64 start = usecTimestampNow();
+    buildBlock(walkedTree, points);
+    quint64 walkedInsertUsecs = usecTimestampNow() - start;
+
+    points.clear();
+    VoxelTree indexedTree;
+    start = usecTimestampNow();
+    buildBlock(indexedTree, points);
+    quint64 indexedInsertUsecs = usecTimestampNow() - start;
+
+    qDebug() << "   voxels:" << points.size();
+    qDebug() << "   inserts without index:" << walkedInsertUsecs << "usecs, with index:" << indexedInsertUsecs << "usecs";
+
+    quint64 walkedUsecs = timeLookups(walkedTree, points);
+    quint64 indexedUsecs = timeLookups(indexedTree, points);
+    int lookups = points.size() * LOOKUP_PASSES * 2;
+    qDebug() << "   lookups:" << lookups;
+    qDebug() << "   from the root:" << walkedUsecs << "usecs, from the index:" << indexedUsecs << "usecs"
+        << "(" << (indexedUsecs > 0 ? (float)walkedUsecs / indexedUsecs : 0.0f) << "x )";
+}
+
+void OctreeElementIndexTests::runAllTests(bool verbose) {
+    lookupTests(verbose);
+    lookupBenchmark(verbose);
+}
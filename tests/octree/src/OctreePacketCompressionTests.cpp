@@ -0,0 +1,223 @@
+//
+//  OctreePacketCompressionTests.cpp
+//  tests/octree/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <string.h>
+
+#include <QByteArray>
+#include <QDebug>
+#include <QVector>
+
+#include <OctreePacketData.h>
+#include <SharedUtil.h>
+#include <VoxelTree.h>
+
+#include "OctreePacketCompressionTests.h"
+
+// a room of voxels with walls of a few colors and grey clutter, about what a small scene sends
+const int VOXELS_PER_WALL_SIDE = 32;
+const float ROOM_CORNER = 0.25f;
+const float VOXEL_SIZE = 1.0f / 4096.0f;
+const int CLUTTER_VOXELS = 4000;
+
+// what the packets used to be compressed with
+const int LEGACY_COMPRESSION_LEVEL = 9;
+
+static void buildRoom(VoxelTree& tree) {
+    float roomSize = VOXELS_PER_WALL_SIDE * VOXEL_SIZE;
+    for (int i = 0; i < VOXELS_PER_WALL_SIDE; i++) {
+        for (int j = 0; j < VOXELS_PER_WALL_SIDE; j++) {
+            float u = ROOM_CORNER + i * VOXEL_SIZE;
+            float v = ROOM_CORNER + j * VOXEL_SIZE;
+            float farSide = ROOM_CORNER + roomSize;
+            unsigned char shade = (i + j) % 2 == 0 ? 255 : 200;
+            tree.createVoxel(u, v, ROOM_CORNER - VOXEL_SIZE, VOXEL_SIZE, shade, 0, 0);
+            tree.createVoxel(u, v, farSide, VOXEL_SIZE, shade, 0, 0);
+            tree.createVoxel(u, ROOM_CORNER - VOXEL_SIZE, v, VOXEL_SIZE, 0, shade, 0);
+            tree.createVoxel(u, farSide, v, VOXEL_SIZE, 0, shade, 0);
+            tree.createVoxel(ROOM_CORNER - VOXEL_SIZE, u, v, VOXEL_SIZE, 0, 0, shade);
+            tree.createVoxel(farSide, u, v, VOXEL_SIZE, 0, 0, shade);
+        }
+    }
+    for (int i = 0; i < CLUTTER_VOXELS; i++) {
+        float clutterSize = VOXEL_SIZE / 4.0f;
+        unsigned char grey = randIntInRange(96, 160);
+        tree.createVoxel(ROOM_CORNER + randIntInRange(0, 4 * VOXELS_PER_WALL_SIDE - 1) * clutterSize,
+                         ROOM_CORNER + randIntInRange(0, 4 * VOXELS_PER_WALL_SIDE - 1) * clutterSize,
+                         ROOM_CORNER + randIntInRange(0, 4 * VOXELS_PER_WALL_SIDE - 1) * clutterSize,
+                         clutterSize, grey, grey, grey);
+    }
+}
+
+// encodes the whole tree the way the send task does, and keeps the uncompressed and finalized form of every packet
+static void encodeTree(VoxelTree& tree, QVector<QByteArray>& uncompressedPackets, QVector<QByteArray>& finalizedPackets) {
+    OctreeElementBag elementBag;
+    elementBag.insert(tree.getRoot());
+    OctreePacketData packetData(true);
+
+    while (!elementBag.isEmpty()) {
+        OctreeElement* subTree = elementBag.extract();
+        EncodeBitstreamParams params(INT_MAX, IGNORE_VIEW_FRUSTUM, WANT_COLOR, NO_EXISTS_BITS);
+        int bytesWritten = tree.encodeTreeBitstream(subTree, &packetData, elementBag, params);
+
+        bool packetIsFull = bytesWritten == 0 && params.stopReason == EncodeBitstreamParams::DIDNT_FIT;
+        if (packetIsFull || elementBag.isEmpty()) {
+            if (packetData.hasContent()) {
+                uncompressedPackets.append(QByteArray((const char*)packetData.getUncompressedData(),
+                                                      packetData.getUncompressedSize()));
+                finalizedPackets.append(QByteArray((const char*)packetData.getFinalizedData(),
+                                                   packetData.getFinalizedSize()));
+            }
+            packetData.reset();
+        }
+        if (packetIsFull) {
+            elementBag.insert(subTree);
+        }
+    }
+}
+
+static bool loadsAs(const QByteArray& finalized, const QByteArray& uncompressed) {
+    OctreePacketData packetData(true);
+    packetData.loadFinalizedContent((const unsigned char*)finalized.constData(), finalized.size());
+    return packetData.getUncompressedSize() == uncompressed.size()
+        && memcmp(packetData.getUncompressedData(), uncompressed.constData(), uncompressed.size()) == 0;
+}
+
+void OctreePacketCompressionTests::roundTripTests(bool verbose) {
+    qDebug() << "******************************************************************************************";
+    qDebug() << "OctreePacketCompressionTests::roundTripTests()";
+
+    int testsTaken = 0;
+    int testsPassed = 0;
+    int testsFailed = 0;
+
+    VoxelTree tree;
+    buildRoom(tree);
+    QVector<QByteArray> uncompressedPackets;
+    QVector<QByteArray> finalizedPackets;
+    encodeTree(tree, uncompressedPackets, finalizedPackets);
+
+    for (int i = 0; i < finalizedPackets.size(); i++) {
+        // packets compressed as they were written, and packets from servers that still use qCompress
+        QByteArray legacyPacket = qCompress(uncompressedPackets[i], LEGACY_COMPRESSION_LEVEL);
+        bool passed[] = { loadsAs(finalizedPackets[i], uncompressedPackets[i]),
+                          loadsAs(legacyPacket, uncompressedPackets[i]) };
+        for (int j = 0; j < 2; j++) {
+            testsTaken++;
+            if (passed[j]) {
+                testsPassed++;
+            } else {
+                testsFailed++;
+                if (verbose) {
+                    qDebug() << "FAILED - packet" << i << (j == 0 ? "incremental" : "legacy")
+                        << "uncompressed size:" << uncompressedPackets[i].size();
+                }
+            }
+        }
+    }
+
+    // a subtree that is rewritten after it was committed makes the packet compress again from the start
+    OctreePacketData packetData(true);
+    packetData.startSubTree();
+    packetData.appendValue((uint32_t)0);
+    packetData.appendValue(QString("http://public.highfidelity.io/models/attachments/fedora_hat.fst"));
+    packetData.endSubTree();
+    packetData.startSubTree();
+    packetData.appendValue(1.0f);
+    packetData.endSubTree();
+    uint32_t replacement = 0xAABBCCDD;
+    packetData.updatePriorBytes(0, (const unsigned char*)&replacement, sizeof(replacement));
+    QByteArray rewritten((const char*)packetData.getUncompressedData(), packetData.getUncompressedSize());
+    QByteArray finalized((const char*)packetData.getFinalizedData(), packetData.getFinalizedSize());
+    testsTaken++;
+    if (loadsAs(finalized, rewritten)) {
+        testsPassed++;
+    } else {
+        testsFailed++;
+        if (verbose) {
+            qDebug() << "FAILED - rewritten packet didn't load as it was written";
+        }
+    }
+
+    // a packet that is reset after part of it went to the compressor must not leak into the next one
+    packetData.reset();
+    packetData.startSubTree();
+    packetData.appendValue(QString("http://public.highfidelity.io/models/attachments/fedora_hat.fst"));
+    packetData.endSubTree();
+    packetData.reset();
+    packetData.startSubTree();
+    packetData.appendValue((uint32_t)0x11223344);
+    packetData.appendValue(2.0f);
+    packetData.endSubTree();
+    QByteArray afterReset((const char*)packetData.getUncompressedData(), packetData.getUncompressedSize());
+    QByteArray finalizedAfterReset((const char*)packetData.getFinalizedData(), packetData.getFinalizedSize());
+    testsTaken++;
+    if (loadsAs(finalizedAfterReset, afterReset)) {
+        testsPassed++;
+    } else {
+        testsFailed++;
+        if (verbose) {
+            qDebug() << "FAILED - packet written after a reset didn't load as it was written";
+        }
+    }
+
+    qDebug() << "   packets:" << finalizedPackets.size();
+    qDebug() << "   tests passed:" << testsPassed << "out of" << testsTaken;
+    if (testsFailed > 0) {
+        qDebug() << "   tests failed:" << testsFailed;
+    }
+}
+
+void OctreePacketCompressionTests::compressionBenchmark(bool verbose) {
+    qDebug() << "******************************************************************************************";
+    qDebug() << "OctreePacketCompressionTests::compressionBenchmark()";
+
+    VoxelTree tree;
+    buildRoom(tree);
+
+    // the old path: compress every packet whole with qCompress once it is finalized
+    QVector<QByteArray> uncompressedPackets;
+    QVector<QByteArray> finalizedPackets;
+    encodeTree(tree, uncompressedPackets, finalizedPackets);
+    int uncompressedBytes = 0;
+    int legacyBytes = 0;
+    quint64 start = usecTimestampNow();
+    for (int i = 0; i < uncompressedPackets.size(); i++) {
+        legacyBytes += qCompress(uncompressedPackets[i], LEGACY_COMPRESSION_LEVEL).size();
+        uncompressedBytes += uncompressedPackets[i].size();
+    }
+    quint64 legacyUsecs = usecTimestampNow() - start;
+    qDebug() << "   packets:" << uncompressedPackets.size() << "uncompressed bytes:" << uncompressedBytes;
+    qDebug() << "   qCompress level" << LEGACY_COMPRESSION_LEVEL << ":" << legacyBytes << "bytes in" << legacyUsecs << "usecs";
+
+    // the new path at a few levels, its time is counted while the packets are written and when they are finalized
+    const int LEVELS[] = { 1, OctreePacketCompressor::DEFAULT_COMPRESSION_LEVEL, 9 };
+    int previousLevel = OctreePacketData::getCompressionLevel();
+    for (unsigned int i = 0; i < sizeof(LEVELS) / sizeof(LEVELS[0]); i++) {
+        OctreePacketData::setCompressionLevel(LEVELS[i]);
+        QVector<QByteArray> levelUncompressedPackets;
+        QVector<QByteArray> levelFinalizedPackets;
+        quint64 timeBefore = OctreePacketData::getCompressContentTime();
+        encodeTree(tree, levelUncompressedPackets, levelFinalizedPackets);
+        quint64 levelUsecs = OctreePacketData::getCompressContentTime() - timeBefore;
+
+        int levelBytes = 0;
+        for (int j = 0; j < levelFinalizedPackets.size(); j++) {
+            levelBytes += levelFinalizedPackets[j].size();
+        }
+        qDebug() << "   incremental level" << LEVELS[i] << ":" << levelBytes << "bytes in" << levelUsecs << "usecs"
+            << "(" << (legacyBytes > 0 ? 100.0f * levelBytes / legacyBytes : 0.0f) << "% of qCompress bytes )";
+    }
+    OctreePacketData::setCompressionLevel(previousLevel);
+}
+
+void OctreePacketCompressionTests::runAllTests(bool verbose) {
+    roundTripTests(verbose);
+    compressionBenchmark(verbose);
+}
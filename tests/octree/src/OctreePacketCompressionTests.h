@@ -0,0 +1,20 @@
+//
+//  OctreePacketCompressionTests.h
+//  tests/octree/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_OctreePacketCompressionTests_h
+#define hifi_OctreePacketCompressionTests_h
+
+namespace OctreePacketCompressionTests {
+    void roundTripTests(bool verbose);
+    void compressionBenchmark(bool verbose);
+    void runAllTests(bool verbose);
+}
+
+#endif // hifi_OctreePacketCompressionTests_h
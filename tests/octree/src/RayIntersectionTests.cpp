@@ -0,0 +1,114 @@
+//
+//  RayIntersectionTests.cpp
+//  tests/octree/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <QDebug>
+
+#include <SharedUtil.h>
+#include <VoxelTree.h>
+
+#include "RayIntersectionTests.h"
+
+// a room of voxels about 100 meters across, with some clutter inside
+const int VOXELS_PER_WALL_SIDE = 16;
+const float ROOM_CORNER = 0.25f;
+const float VOXEL_SIZE = 1.0f / 2048.0f;
+const int CLUTTER_VOXELS = 2000;
+
+// enough rays for the batch to be spread over the thread pool
+const int RAY_COUNT = 4096;
+
+static void buildRoom(VoxelTree& tree) {
+    float roomSize = VOXELS_PER_WALL_SIDE * VOXEL_SIZE;
+    for (int i = 0; i < VOXELS_PER_WALL_SIDE; i++) {
+        for (int j = 0; j < VOXELS_PER_WALL_SIDE; j++) {
+            float u = ROOM_CORNER + i * VOXEL_SIZE;
+            float v = ROOM_CORNER + j * VOXEL_SIZE;
+            float farSide = ROOM_CORNER + roomSize;
+            tree.createVoxel(u, v, ROOM_CORNER - VOXEL_SIZE, VOXEL_SIZE, 255, 0, 0);
+            tree.createVoxel(u, v, farSide, VOXEL_SIZE, 255, 0, 0);
+            tree.createVoxel(u, ROOM_CORNER - VOXEL_SIZE, v, VOXEL_SIZE, 0, 255, 0);
+            tree.createVoxel(u, farSide, v, VOXEL_SIZE, 0, 255, 0);
+            tree.createVoxel(ROOM_CORNER - VOXEL_SIZE, u, v, VOXEL_SIZE, 0, 0, 255);
+            tree.createVoxel(farSide, u, v, VOXEL_SIZE, 0, 0, 255);
+        }
+    }
+    for (int i = 0; i < CLUTTER_VOXELS; i++) {
+        float clutterSize = VOXEL_SIZE / 4.0f;
+        tree.createVoxel(ROOM_CORNER + randIntInRange(0, 4 * VOXELS_PER_WALL_SIDE - 1) * clutterSize,
+                         ROOM_CORNER + randIntInRange(0, 4 * VOXELS_PER_WALL_SIDE - 1) * clutterSize,
+                         ROOM_CORNER + randIntInRange(0, 4 * VOXELS_PER_WALL_SIDE - 1) * clutterSize,
+                         clutterSize, 128, 128, 128);
+    }
+}
+
+void RayIntersectionTests::batchMatchesSingleRayTests(bool verbose) {
+    qDebug() << "******************************************************************************************";
+    qDebug() << "RayIntersectionTests::batchMatchesSingleRayTests()";
+
+    VoxelTree tree;
+    buildRoom(tree);
+
+    // rays from a few spots inside the room in every direction, the way the audio reflector casts them
+    float roomSize = VOXELS_PER_WALL_SIDE * VOXEL_SIZE * TREE_SCALE;
+    glm::vec3 roomCorner = glm::vec3(ROOM_CORNER * TREE_SCALE);
+    QVector<OctreeRayQuery> rays;
+    for (int i = 0; i < RAY_COUNT; i++) {
+        glm::vec3 origin = roomCorner + glm::vec3(randFloatInRange(0.1f, 0.9f), randFloatInRange(0.1f, 0.9f),
+                                                  randFloatInRange(0.1f, 0.9f)) * roomSize;
+        glm::vec3 direction = glm::normalize(glm::vec3(randFloatInRange(-1.0f, 1.0f), randFloatInRange(-1.0f, 1.0f),
+                                                       randFloatInRange(-1.0f, 1.0f)));
+        rays.append(OctreeRayQuery(origin, direction));
+    }
+
+    quint64 start = usecTimestampNow();
+    QVector<OctreeRayQuery> singleResults = rays;
+    for (int i = 0; i < singleResults.size(); i++) {
+        OctreeRayQuery& ray = singleResults[i];
+        ray.intersects = tree.findRayIntersection(ray.origin, ray.direction, ray.element, ray.distance, ray.face,
+                                                  &ray.intersectedObject, Octree::Lock);
+    }
+    quint64 singleUsecs = usecTimestampNow() - start;
+
+    start = usecTimestampNow();
+    tree.findRayIntersections(rays, Octree::Lock);
+    quint64 batchUsecs = usecTimestampNow() - start;
+
+    int testsTaken = 0;
+    int testsPassed = 0;
+    int testsFailed = 0;
+    int hits = 0;
+    for (int i = 0; i < rays.size(); i++) {
+        const OctreeRayQuery& single = singleResults[i];
+        const OctreeRayQuery& batched = rays[i];
+        testsTaken++;
+        if (single.intersects == batched.intersects && (!single.intersects || (single.element == batched.element
+                && single.distance == batched.distance && single.face == batched.face))) {
+            testsPassed++;
+            hits += single.intersects ? 1 : 0;
+        } else {
+            testsFailed++;
+            if (verbose) {
+                qDebug() << "FAILED - ray" << i << "single intersects:" << single.intersects << "distance:" << single.distance
+                    << "batched intersects:" << batched.intersects << "distance:" << batched.distance;
+            }
+        }
+    }
+
+    qDebug() << "   rays:" << rays.size() << "hits:" << hits;
+    qDebug() << "   one ray at a time:" << singleUsecs << "usecs, batched:" << batchUsecs << "usecs";
+    qDebug() << "   tests passed:" << testsPassed << "out of" << testsTaken;
+    if (testsFailed > 0) {
+        qDebug() << "   tests failed:" << testsFailed;
+    }
+}
+
+void RayIntersectionTests::runAllTests(bool verbose) {
+    batchMatchesSingleRayTests(verbose);
+}
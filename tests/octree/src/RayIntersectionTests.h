@@ -0,0 +1,19 @@
+//
+//  RayIntersectionTests.h
+//  tests/octree/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_RayIntersectionTests_h
+#define hifi_RayIntersectionTests_h
+
+namespace RayIntersectionTests {
+    void batchMatchesSingleRayTests(bool verbose);
+    void runAllTests(bool verbose);
+}
+
+#endif // hifi_RayIntersectionTests_h
@@ -0,0 +1,223 @@
+//
+//  VoxelOccupancyMapTests.cpp
+//  tests/octree/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <QDebug>
+
+#include <CollisionInfo.h>
+#include <SharedUtil.h>
+#include <SphereShape.h>
+#include <VoxelDetail.h>
+#include <VoxelOccupancyMap.h>
+#include <VoxelTree.h>
+
+#include "VoxelOccupancyMapTests.h"
+
+// a patch of ground one meter voxels thick, with some larger blocks on it
+const int GROUND_SIDE = 64;
+const float GROUND_CORNER = 0.5f;
+const float VOXEL_SIZE = 1.0f / TREE_SCALE;
+const int BLOCK_COUNT = 16;
+const int QUERY_COUNT = 500;
+const int BENCHMARK_PASSES = 20;
+
+static void buildGround(VoxelTree& tree) {
+    for (int i = 0; i < GROUND_SIDE; i++) {
+        for (int k = 0; k < GROUND_SIDE; k++) {
+            int height = (i * 7 + k * 3) % 5;
+            tree.createVoxel(GROUND_CORNER + i * VOXEL_SIZE, GROUND_CORNER + height * VOXEL_SIZE,
+                             GROUND_CORNER + k * VOXEL_SIZE, VOXEL_SIZE, i * 4, height * 50, k * 4);
+        }
+    }
+    for (int i = 0; i < BLOCK_COUNT; i++) {
+        float scale = VOXEL_SIZE * (1 << randIntInRange(1, 4));
+        tree.createVoxel(GROUND_CORNER + randIntInRange(0, GROUND_SIDE / 16 - 1) * 16 * VOXEL_SIZE,
+                         GROUND_CORNER + 8 * VOXEL_SIZE, GROUND_CORNER + randIntInRange(0, GROUND_SIDE / 16 - 1) * 16 * VOXEL_SIZE,
+                         scale, 255, 0, 0);
+    }
+}
+
+static glm::vec3 randomPointNearGround() {
+    float meters = GROUND_SIDE;
+    return glm::vec3(GROUND_CORNER * TREE_SCALE + randFloatInRange(-4.0f, meters + 4.0f),
+                     GROUND_CORNER * TREE_SCALE + randFloatInRange(-2.0f, 12.0f),
+                     GROUND_CORNER * TREE_SCALE + randFloatInRange(-4.0f, meters + 4.0f));
+}
+
+static bool sameDetails(VoxelDetail* mapped, VoxelDetail* walked) {
+    if (!mapped || !walked) {
+        return mapped == walked;
+    }
+    return mapped->x == walked->x && mapped->y == walked->y && mapped->z == walked->z && mapped->s == walked->s &&
+        mapped->red == walked->red && mapped->green == walked->green && mapped->blue == walked->blue;
+}
+
+static bool sameCollisions(CollisionList& mapped, CollisionList& walked) {
+    if (mapped.size() != walked.size()) {
+        return false;
+    }
+    for (int i = 0; i < mapped.size(); i++) {
+        if (mapped[i]->_penetration != walked[i]->_penetration || mapped[i]->_contactPoint != walked[i]->_contactPoint) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// runs each query through the map and through the tree, and counts the ones that differ
+static int countMismatches(VoxelTree& tree) {
+    int mismatches = 0;
+    for (int i = 0; i < QUERY_COUNT; i++) {
+        glm::vec3 center = randomPointNearGround();
+        float radius = randFloatInRange(0.1f, 3.0f);
+
+        glm::vec3 mappedPenetration, walkedPenetration;
+        VoxelDetail* mappedDetails = NULL;
+        VoxelDetail* walkedDetails = NULL;
+        bool mappedFound = tree.findSpherePenetration(center, radius, mappedPenetration, (void**)&mappedDetails);
+        bool walkedFound = tree.Octree::findSpherePenetration(center, radius, walkedPenetration, (void**)&walkedDetails);
+        if (mappedFound != walkedFound || mappedPenetration != walkedPenetration ||
+                !sameDetails(mappedDetails, walkedDetails)) {
+            mismatches++;
+        }
+        delete mappedDetails;
+        delete walkedDetails;
+
+        glm::vec3 end = center + glm::vec3(randFloatInRange(-2.0f, 2.0f), randFloatInRange(-2.0f, 2.0f), 0.0f);
+        mappedFound = tree.findCapsulePenetration(center, end, radius, mappedPenetration);
+        walkedFound = tree.Octree::findCapsulePenetration(center, end, radius, walkedPenetration);
+        if (mappedFound != walkedFound || mappedPenetration != walkedPenetration) {
+            mismatches++;
+        }
+
+        const int MAX_COLLISIONS = 256;
+        CollisionList mappedCollisions(MAX_COLLISIONS);
+        CollisionList walkedCollisions(MAX_COLLISIONS);
+        SphereShape sphere(radius, center);
+        mappedFound = tree.findShapeCollisions(&sphere, mappedCollisions);
+        walkedFound = tree.Octree::findShapeCollisions(&sphere, walkedCollisions);
+        if (mappedFound != walkedFound || !sameCollisions(mappedCollisions, walkedCollisions)) {
+            mismatches++;
+        }
+
+        AACube cube(center - glm::vec3(radius, radius, radius), 2.0f * radius);
+        CubeList mappedCubes, walkedCubes;
+        tree.findContentInCube(cube, mappedCubes);
+        tree.Octree::findContentInCube(cube, walkedCubes);
+        if (mappedCubes.keys().toSet() != walkedCubes.keys().toSet()) {
+            mismatches++;
+        }
+    }
+    return mismatches;
+}
+
+static void check(bool passed, const char* what, int& testsTaken, int& testsPassed, int& testsFailed, bool verbose) {
+    testsTaken++;
+    if (passed) {
+        testsPassed++;
+    } else {
+        testsFailed++;
+        if (verbose) {
+            qDebug() << "FAILED -" << what;
+        }
+    }
+}
+
+void VoxelOccupancyMapTests::queryTests(bool verbose) {
+    qDebug() << "******************************************************************************************";
+    qDebug() << "VoxelOccupancyMapTests::queryTests()";
+
+    int testsTaken = 0;
+    int testsPassed = 0;
+    int testsFailed = 0;
+
+    srand(0);
+    VoxelTree tree;
+    buildGround(tree);
+    tree.setUseOccupancyMap(true);
+    check(countMismatches(tree) == 0, "queries after building the map", testsTaken, testsPassed, testsFailed, verbose);
+
+    // edits after the map was built reach it through the element hooks
+    for (int i = 0; i < GROUND_SIDE; i += 3) {
+        for (int k = 0; k < GROUND_SIDE; k += 2) {
+            int height = (i * 7 + k * 3) % 5;
+            tree.deleteVoxelAt(GROUND_CORNER + i * VOXEL_SIZE, GROUND_CORNER + height * VOXEL_SIZE,
+                               GROUND_CORNER + k * VOXEL_SIZE, VOXEL_SIZE);
+        }
+    }
+    check(countMismatches(tree) == 0, "queries after deletes", testsTaken, testsPassed, testsFailed, verbose);
+
+    for (int i = 0; i < GROUND_SIDE; i += 5) {
+        tree.createVoxel(GROUND_CORNER + i * VOXEL_SIZE, GROUND_CORNER + 6 * VOXEL_SIZE, GROUND_CORNER + i * VOXEL_SIZE,
+                         VOXEL_SIZE / 2.0f, 0, 255, 0);
+        tree.createVoxel(GROUND_CORNER, GROUND_CORNER, GROUND_CORNER + i * VOXEL_SIZE, 4.0f * VOXEL_SIZE, 0, 0, 255, true);
+    }
+    check(countMismatches(tree) == 0, "queries after creates", testsTaken, testsPassed, testsFailed, verbose);
+
+    tree.eraseAllOctreeElements();
+    glm::vec3 penetration;
+    check(!tree.findSpherePenetration(randomPointNearGround(), 10.0f, penetration), "nothing found after erasing",
+          testsTaken, testsPassed, testsFailed, verbose);
+    buildGround(tree);
+    check(countMismatches(tree) == 0, "queries after erasing and rebuilding", testsTaken, testsPassed, testsFailed, verbose);
+
+    qDebug() << "   tests passed:" << testsPassed << "out of" << testsTaken;
+    if (testsFailed > 0) {
+        qDebug() << "   tests failed:" << testsFailed;
+    }
+}
+
+void VoxelOccupancyMapTests::queryBenchmark(bool verbose) {
+    qDebug() << "******************************************************************************************";
+    qDebug() << "VoxelOccupancyMapTests::queryBenchmark()";
+
+    srand(0);
+    VoxelTree tree;
+    buildGround(tree);
+    tree.setUseOccupancyMap(true);
+
+    QVector<glm::vec3> centers;
+    for (int i = 0; i < QUERY_COUNT; i++) {
+        centers.append(randomPointNearGround());
+    }
+    const float RADIUS = 1.0f;
+    glm::vec3 penetration;
+
+    // the first query builds the map
+    quint64 start = usecTimestampNow();
+    tree.findSpherePenetration(centers[0], RADIUS, penetration);
+    quint64 buildUsecs = usecTimestampNow() - start;
+
+    start = usecTimestampNow();
+    for (int pass = 0; pass < BENCHMARK_PASSES; pass++) {
+        for (int i = 0; i < centers.size(); i++) {
+            tree.Octree::findSpherePenetration(centers[i], RADIUS, penetration);
+        }
+    }
+    quint64 walkedUsecs = usecTimestampNow() - start;
+
+    start = usecTimestampNow();
+    for (int pass = 0; pass < BENCHMARK_PASSES; pass++) {
+        for (int i = 0; i < centers.size(); i++) {
+            tree.findSpherePenetration(centers[i], RADIUS, penetration);
+        }
+    }
+    quint64 mappedUsecs = usecTimestampNow() - start;
+
+    qDebug() << "   voxels:" << (int)OctreeElement::getNodeCount() << "map bricks:" << tree.getOccupancyMap()->getBrickCount()
+        << "boxes:" << tree.getOccupancyMap()->getBoxCount() << "built in" << buildUsecs << "usecs";
+    qDebug() << "   sphere queries:" << centers.size() * BENCHMARK_PASSES;
+    qDebug() << "   through the tree:" << walkedUsecs << "usecs, through the map:" << mappedUsecs << "usecs"
+        << "(" << (mappedUsecs > 0 ? (float)walkedUsecs / mappedUsecs : 0.0f) << "x )";
+}
+
+void VoxelOccupancyMapTests::runAllTests(bool verbose) {
+    queryTests(verbose);
+    queryBenchmark(verbose);
+}
@@ -0,0 +1,20 @@
+//
+//  VoxelOccupancyMapTests.h
+//  tests/octree/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_VoxelOccupancyMapTests_h
+#define hifi_VoxelOccupancyMapTests_h
+
+namespace VoxelOccupancyMapTests {
+    void queryTests(bool verbose);
+    void queryBenchmark(bool verbose);
+    void runAllTests(bool verbose);
+}
+
+#endif // hifi_VoxelOccupancyMapTests_h
@@ -9,9 +9,15 @@
 //
 
 #include "AABoxCubeTests.h"
+#include "EditCoalescingTests.h"
+#include "FrustumCullingTests.h"
 #include "ModelTests.h" // needs to be EntityTests.h soon
+#include "OctreeElementIndexTests.h"
+#include "OctreePacketCompressionTests.h"
 #include "OctreeTests.h"
+#include "RayIntersectionTests.h"
 #include "SharedUtil.h"
+#include "VoxelOccupancyMapTests.h"
 
 int main(int argc, const char* argv[]) {
     const char* VERBOSE = "--verbose";
@@ -20,5 +26,11 @@ int main(int argc, const char* argv[]) {
     //OctreeTests::runAllTests(verbose);
     //AABoxCubeTests::runAllTests(verbose);
     EntityTests::runAllTests(verbose);
+    EditCoalescingTests::runAllTests(verbose);
+    FrustumCullingTests::runAllTests(verbose);
+    OctreeElementIndexTests::runAllTests(verbose);
+    OctreePacketCompressionTests::runAllTests(verbose);
+    RayIntersectionTests::runAllTests(verbose);
+    VoxelOccupancyMapTests::runAllTests(verbose);
     return 0;
 }
@@ -0,0 +1,267 @@
+//
+//  PhysicsSimulationTests.cpp
+//  tests/physics/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <iostream>
+
+#include <glm/glm.hpp>
+
+#include <DistanceConstraint.h>
+#include <PhysicsEntity.h>
+#include <PhysicsSimulation.h>
+#include <Ragdoll.h>
+#include <ShapeCollider.h>
+#include <SharedUtil.h>
+#include <SphereShape.h>
+#include <StreamUtils.h>
+#include <VerletCapsuleShape.h>
+#include <VerletSphereShape.h>
+
+#include "PhysicsSimulationTests.h"
+
+const float DELTA_TIME = 1.0f / 60.0f;
+const float MIN_ERROR = 0.0001f;
+const int MAX_ITERATIONS = 8;
+const quint64 MAX_USECS = 1000000;
+
+const int POINTS_PER_CHAIN = 12;
+const float POINT_SPACING = 0.2f;
+const float SPHERE_RADIUS = 0.15f;
+const float CAPSULE_RADIUS = 0.05f;
+
+/// a chain of verlet points held together by distance constraints
+class ChainRagdoll : public Ragdoll {
+public:
+    ChainRagdoll(const glm::vec3& start, const glm::vec3& direction, const glm::vec3& velocity) :
+        _start(start), _direction(direction), _velocity(velocity) {
+        setTransform(start, glm::quat());
+        initPoints();
+        buildConstraints();
+    }
+
+    virtual void initPoints() {
+        _points.resize(POINTS_PER_CHAIN);
+        for (int i = 0; i < POINTS_PER_CHAIN; ++i) {
+            _points[i].initPosition(_start + (i * POINT_SPACING) * _direction);
+            // everything but the root drifts, the root is put back at the end of each step
+            if (i > 0) {
+                _points[i]._lastPosition -= _velocity * DELTA_TIME;
+            }
+        }
+        _translationInSimulationFrame = _start;
+    }
+
+    virtual void buildConstraints() {
+        for (int i = 1; i < POINTS_PER_CHAIN; ++i) {
+            _boneConstraints.push_back(new DistanceConstraint(&_points[i - 1], &_points[i]));
+        }
+    }
+
+private:
+    glm::vec3 _start;
+    glm::vec3 _direction;
+    glm::vec3 _velocity;
+};
+
+/// verlet spheres on each point of a chain and verlet capsules between them, as in VerletShapeTests
+class ChainEntity : public PhysicsEntity {
+public:
+    ChainEntity(ChainRagdoll* ragdoll) : _ragdoll(ragdoll) {
+        buildShapes();
+    }
+    virtual ~ChainEntity() {
+        clearShapes();
+    }
+
+    virtual void buildShapes() {
+        QVector<VerletPoint>& points = _ragdoll->getPoints();
+        for (int i = 0; i < points.size(); ++i) {
+            _shapes.push_back(new VerletSphereShape(SPHERE_RADIUS, &points[i]));
+            if (i > 0) {
+                _shapes.push_back(new VerletCapsuleShape(CAPSULE_RADIUS, &points[i - 1], &points[i]));
+            }
+        }
+        setShapeBackPointers();
+        disableCurrentSelfCollisions();
+    }
+
+private:
+    ChainRagdoll* _ragdoll;
+};
+
+/// a scattering of fixed spheres, like the shapes of voxels around an avatar
+class SphereCloudEntity : public PhysicsEntity {
+public:
+    SphereCloudEntity(const glm::vec3& center, int numSpheres) : _center(center), _numSpheres(numSpheres) {
+        buildShapes();
+    }
+    virtual ~SphereCloudEntity() {
+        clearShapes();
+    }
+
+    virtual void buildShapes() {
+        for (int i = 0; i < _numSpheres; ++i) {
+            glm::vec3 offset(randFloatInRange(-1.0f, 1.0f), randFloatInRange(-1.0f, 1.0f), randFloatInRange(-1.0f, 1.0f));
+            _shapes.push_back(new SphereShape(randFloatInRange(0.1f, 0.3f), _center + offset));
+        }
+        setShapeBackPointers();
+    }
+
+private:
+    glm::vec3 _center;
+    int _numSpheres;
+};
+
+/// A main chain that sweeps through a row of other chains, with clouds of spheres around them. The other chains cross
+/// the main one so that some of them collide with it and some never do.
+class ChainWorld {
+public:
+    ChainWorld(int numOtherChains, int numClouds, bool useBroadphase) :
+        _mainRagdoll(glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f)),
+        _mainEntity(&_mainRagdoll) {
+        srand(0);
+        _simulation.setUseBroadphase(useBroadphase);
+        _simulation.setRagdoll(&_mainRagdoll);
+        _simulation.setEntity(&_mainEntity);
+        for (int i = 0; i < numOtherChains; ++i) {
+            glm::vec3 start(0.5f + 0.4f * (i % 6), -1.0f, 0.4f * (i / 6));
+            ChainRagdoll* ragdoll = new ChainRagdoll(start, glm::vec3(0.0f, 1.0f, 0.0f),
+                                                     glm::vec3(0.0f, 0.0f, -0.5f));
+            ChainEntity* entity = new ChainEntity(ragdoll);
+            _otherRagdolls.push_back(ragdoll);
+            _otherEntities.push_back(entity);
+            _simulation.addRagdoll(ragdoll);
+            _simulation.addEntity(entity);
+        }
+        for (int i = 0; i < numClouds; ++i) {
+            SphereCloudEntity* cloud = new SphereCloudEntity(glm::vec3(3.0f * (i % 8) - 6.0f, 2.0f,
+                                                                       3.0f * (i / 8) - 3.0f), 8);
+            _otherEntities.push_back(cloud);
+            _simulation.addEntity(cloud);
+        }
+    }
+
+    ~ChainWorld() {
+        for (int i = 0; i < _otherEntities.size(); ++i) {
+            delete _otherEntities[i];
+        }
+        for (int i = 0; i < _otherRagdolls.size(); ++i) {
+            delete _otherRagdolls[i];
+        }
+        _simulation.clear();
+    }
+
+    void stepForward() {
+        _simulation.stepForward(DELTA_TIME, MIN_ERROR, MAX_ITERATIONS, MAX_USECS);
+    }
+
+    ChainRagdoll& getMainRagdoll() { return _mainRagdoll; }
+    ChainRagdoll* getOtherRagdoll(int index) { return _otherRagdolls[index]; }
+
+private:
+    PhysicsSimulation _simulation;
+    ChainRagdoll _mainRagdoll;
+    ChainEntity _mainEntity;
+    QVector<ChainRagdoll*> _otherRagdolls;
+    QVector<PhysicsEntity*> _otherEntities;
+};
+
+static bool samePoints(Ragdoll& ragdollA, Ragdoll& ragdollB) {
+    const QVector<VerletPoint>& pointsA = ragdollA.getPoints();
+    const QVector<VerletPoint>& pointsB = ragdollB.getPoints();
+    for (int i = 0; i < pointsA.size(); ++i) {
+        if (pointsA[i]._position != pointsB[i]._position) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void PhysicsSimulationTests::broadphaseFindsSameCollisions() {
+    const int NUM_OTHER_CHAINS = 12;
+    const int NUM_CLOUDS = 16;
+    const int NUM_STEPS = 30;
+    ChainWorld prunedWorld(NUM_OTHER_CHAINS, NUM_CLOUDS, true);
+    ChainWorld fullWorld(NUM_OTHER_CHAINS, NUM_CLOUDS, false);
+
+    for (int step = 0; step < NUM_STEPS; ++step) {
+        prunedWorld.stepForward();
+        fullWorld.stepForward();
+        if (!samePoints(prunedWorld.getMainRagdoll(), fullWorld.getMainRagdoll())) {
+            std::cout << __FILE__ << ":" << __LINE__
+                << " ERROR: main ragdoll differs with the broadphase at step " << step << std::endl;
+            return;
+        }
+        for (int i = 0; i < NUM_OTHER_CHAINS; ++i) {
+            if (!samePoints(*prunedWorld.getOtherRagdoll(i), *fullWorld.getOtherRagdoll(i))) {
+                std::cout << __FILE__ << ":" << __LINE__
+                    << " ERROR: ragdoll " << i << " differs with the broadphase at step " << step << std::endl;
+                return;
+            }
+        }
+    }
+}
+
+void PhysicsSimulationTests::settledIslandsStaySettled() {
+    // a chain far from everything settles, and once it has nothing moves it
+    PhysicsSimulation simulation;
+    ChainRagdoll mainRagdoll(glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f));
+    ChainEntity mainEntity(&mainRagdoll);
+    ChainRagdoll farRagdoll(glm::vec3(100.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f));
+    ChainEntity farEntity(&farRagdoll);
+    simulation.setRagdoll(&mainRagdoll);
+    simulation.setEntity(&mainEntity);
+    simulation.addRagdoll(&farRagdoll);
+    simulation.addEntity(&farEntity);
+
+    const int NUM_STEPS = 10;
+    for (int step = 0; step < NUM_STEPS; ++step) {
+        simulation.stepForward(DELTA_TIME, MIN_ERROR, MAX_ITERATIONS, MAX_USECS);
+    }
+    const QVector<VerletPoint>& points = farRagdoll.getPoints();
+    for (int i = 0; i < points.size(); ++i) {
+        glm::vec3 expectedPosition = glm::vec3(100.0f, 0.0f, 0.0f) + (i * POINT_SPACING) * glm::vec3(0.0f, 1.0f, 0.0f);
+        if (glm::distance(points[i]._position, expectedPosition) > EPSILON) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: point " << i << " of a settled ragdoll moved to "
+                << points[i]._position << std::endl;
+        }
+    }
+    simulation.clear();
+}
+
+static quint64 timeSteps(ChainWorld& world, int numSteps) {
+    quint64 start = usecTimestampNow();
+    for (int step = 0; step < numSteps; ++step) {
+        world.stepForward();
+    }
+    return usecTimestampNow() - start;
+}
+
+void PhysicsSimulationTests::stepForwardBenchmark() {
+    const int NUM_OTHER_CHAINS = 15;
+    const int NUM_CLOUDS = 48;
+    const int NUM_STEPS = 200;
+    ChainWorld prunedWorld(NUM_OTHER_CHAINS, NUM_CLOUDS, true);
+    ChainWorld fullWorld(NUM_OTHER_CHAINS, NUM_CLOUDS, false);
+
+    quint64 fullUsecs = timeSteps(fullWorld, NUM_STEPS);
+    quint64 prunedUsecs = timeSteps(prunedWorld, NUM_STEPS);
+    std::cout << "PhysicsSimulation::stepForward() with " << NUM_OTHER_CHAINS << " other ragdolls and "
+        << NUM_CLOUDS << " sphere clouds, " << NUM_STEPS << " steps:" << std::endl;
+    std::cout << "    every pair: " << fullUsecs << " usecs, broadphase: " << prunedUsecs << " usecs ("
+        << (prunedUsecs > 0 ? (float)fullUsecs / (float)prunedUsecs : 0.0f) << "x)" << std::endl;
+}
+
+void PhysicsSimulationTests::runAllTests() {
+    ShapeCollider::initDispatchTable();
+
+    broadphaseFindsSameCollisions();
+    settledIslandsStaySettled();
+    stepForwardBenchmark();
+}
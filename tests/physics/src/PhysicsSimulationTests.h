@@ -0,0 +1,22 @@
+//
+//  PhysicsSimulationTests.h
+//  tests/physics/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_PhysicsSimulationTests_h
+#define hifi_PhysicsSimulationTests_h
+
+namespace PhysicsSimulationTests {
+    void broadphaseFindsSameCollisions();
+    void settledIslandsStaySettled();
+    void stepForwardBenchmark();
+
+    void runAllTests();
+}
+
+#endif // hifi_PhysicsSimulationTests_h
@@ -16,10 +16,12 @@
 #include <glm/glm.hpp>
 #include <glm/gtx/quaternion.hpp>
 
+#include <AACube.h>
 #include <AACubeShape.h>
 #include <CapsuleShape.h>
 #include <CollisionInfo.h>
 #include <PlaneShape.h>
+#include <ShapeBatch.h>
 #include <ShapeCollider.h>
 #include <SharedUtil.h>
 #include <SphereShape.h>
@@ -2477,6 +2479,182 @@ void ShapeColliderTests::rayMissesAACube() {
 
 }
 
+// a mix of shapes scattered through a box of the given size, with a few gaps
+static void makeRandomShapes(int numShapes, float boxSize, QVector<Shape*>& shapes) {
+    for (int i = 0; i < numShapes; ++i) {
+        glm::vec3 position(randFloatInRange(0.0f, boxSize), randFloatInRange(0.0f, boxSize), randFloatInRange(0.0f, boxSize));
+        float radius = randFloatInRange(0.05f, 0.5f);
+        int kind = rand() % 10;
+        if (kind < 4) {
+            shapes.push_back(new SphereShape(radius, position));
+        } else if (kind < 8) {
+            glm::vec3 axis(randFloatInRange(-1.0f, 1.0f), randFloatInRange(-1.0f, 1.0f), randFloatInRange(-1.0f, 1.0f));
+            shapes.push_back(new CapsuleShape(radius, position - axis, position + axis));
+        } else if (kind < 9) {
+            shapes.push_back(new AACubeShape(2.0f * radius, position));
+        } else if (rand() % 4 == 0) {
+            shapes.push_back(new PlaneShape(glm::vec4(0.0f, 1.0f, 0.0f, -randFloatInRange(0.0f, boxSize))));
+        } else {
+            shapes.push_back(NULL);
+        }
+    }
+}
+
+static bool sameCollisions(CollisionList& listA, CollisionList& listB) {
+    if (listA.size() != listB.size()) {
+        return false;
+    }
+    for (int i = 0; i < listA.size(); ++i) {
+        CollisionInfo* a = listA[i];
+        CollisionInfo* b = listB[i];
+        if (a->_shapeA != b->_shapeA || a->_shapeB != b->_shapeB ||
+                a->_penetration != b->_penetration || a->_contactPoint != b->_contactPoint) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void ShapeColliderTests::batchFindsSameCollisions() {
+    const int NUM_TRIALS = 20;
+    const int MAX_COLLISIONS[] = { 8, 512 };
+    for (int trial = 0; trial < NUM_TRIALS; ++trial) {
+        QVector<Shape*> shapesA;
+        QVector<Shape*> shapesB;
+        makeRandomShapes(10, 5.0f, shapesA);
+        makeRandomShapes(100, 5.0f, shapesB);
+
+        for (int i = 0; i < 2; ++i) {
+            // one shape at a time through the dispatch table is the reference
+            CollisionList expected(MAX_COLLISIONS[i]);
+            for (int j = 0; j < shapesA.size(); ++j) {
+                if (shapesA.at(j) && ShapeCollider::collideShapeWithShapes(shapesA.at(j), shapesB, 0, expected) &&
+                        expected.isFull()) {
+                    break;
+                }
+            }
+            CollisionList collisions(MAX_COLLISIONS[i]);
+            bool touching = ShapeCollider::collideShapesWithShapes(shapesA, shapesB, collisions);
+            if (touching != (expected.size() > 0)) {
+                std::cout << __FILE__ << ":" << __LINE__ << " ERROR: batch reports touching = " << touching
+                    << " with " << expected.size() << " expected collisions" << std::endl;
+            }
+            if (!sameCollisions(expected, collisions)) {
+                std::cout << __FILE__ << ":" << __LINE__ << " ERROR: batch found " << collisions.size()
+                    << " collisions, expected " << expected.size() << " matching the single pair collisions" << std::endl;
+            }
+        }
+
+        // the bounds test alone never drops a shape that touches
+        ShapeBatch batch;
+        batch.addShapes(shapesB);
+        for (int j = 0; j < shapesA.size(); ++j) {
+            glm::vec3 center;
+            float radius;
+            if (!shapesA.at(j) || !ShapeBatch::computeBoundingSphere(shapesA.at(j), center, radius)) {
+                continue;
+            }
+            for (int k = 0; k < batch.size(); ++k) {
+                CollisionList pairCollisions(16);
+                bool inBlock = batch.findCandidates(k / SHAPE_BATCH_BLOCK_SIZE, center, radius) &
+                    (1 << (k % SHAPE_BATCH_BLOCK_SIZE));
+                if (inBlock != batch.isCandidate(k, center, radius)) {
+                    std::cout << __FILE__ << ":" << __LINE__ << " ERROR: block and single tests disagree on shape "
+                        << k << std::endl;
+                }
+                if (shapesB.at(k) && ShapeCollider::collideShapes(shapesA.at(j), shapesB.at(k), pairCollisions) &&
+                        !inBlock) {
+                    std::cout << __FILE__ << ":" << __LINE__ << " ERROR: batch dropped touching shape " << k << std::endl;
+                }
+            }
+        }
+
+        qDeleteAll(shapesA);
+        qDeleteAll(shapesB);
+    }
+}
+
+void ShapeColliderTests::aaCubeBatchFindsSameCollisions() {
+    const int NUM_TRIALS = 20;
+    const int NUM_CUBES = 200;
+    const float BOX_SIZE = 5.0f;
+    for (int trial = 0; trial < NUM_TRIALS; ++trial) {
+        AACubeBatch batch;
+        QVector<AACube> cubes;
+        for (int i = 0; i < NUM_CUBES; ++i) {
+            AACube cube(glm::vec3(randFloatInRange(0.0f, BOX_SIZE), randFloatInRange(0.0f, BOX_SIZE),
+                randFloatInRange(0.0f, BOX_SIZE)), randFloatInRange(0.1f, 1.0f));
+            cubes.push_back(cube);
+            batch.addCube(cube);
+        }
+        QVector<Shape*> shapes;
+        makeRandomShapes(20, BOX_SIZE, shapes);
+        foreach (Shape* shape, shapes) {
+            if (!shape) {
+                continue;
+            }
+            CollisionList expected(NUM_CUBES);
+            bool expectedTouching = false;
+            foreach (const AACube& cube, cubes) {
+                if (cube.expandedContains(shape->getTranslation(), shape->getBoundingRadius()) &&
+                        ShapeCollider::collideShapeWithAACubeLegacy(shape, cube.calcCenter(), cube.getScale(), expected)) {
+                    expectedTouching = true;
+                }
+            }
+            CollisionList collisions(NUM_CUBES);
+            bool touching = ShapeCollider::collideShapeWithAACubesLegacy(shape, batch, collisions);
+            if (touching != expectedTouching || !sameCollisions(expected, collisions)) {
+                std::cout << __FILE__ << ":" << __LINE__ << " ERROR: cube batch found " << collisions.size()
+                    << " collisions, expected " << expected.size() << std::endl;
+            }
+        }
+        qDeleteAll(shapes);
+    }
+}
+
+void ShapeColliderTests::aaCubeBatchFindsSegments() {
+    const int NUM_TRIALS = 20;
+    const int NUM_CUBES = 201;
+    const int NUM_SEGMENTS = 50;
+    const float BOX_SIZE = 5.0f;
+    for (int trial = 0; trial < NUM_TRIALS; ++trial) {
+        AACubeBatch batch;
+        QVector<AACube> cubes;
+        for (int i = 0; i < NUM_CUBES; ++i) {
+            AACube cube(glm::vec3(randFloatInRange(0.0f, BOX_SIZE), randFloatInRange(0.0f, BOX_SIZE),
+                randFloatInRange(0.0f, BOX_SIZE)), randFloatInRange(0.1f, 1.0f));
+            cubes.push_back(cube);
+            batch.addCube(cube);
+        }
+        for (int j = 0; j < NUM_SEGMENTS; ++j) {
+            glm::vec3 start(randFloatInRange(0.0f, BOX_SIZE), randFloatInRange(0.0f, BOX_SIZE),
+                randFloatInRange(0.0f, BOX_SIZE));
+            glm::vec3 end(randFloatInRange(0.0f, BOX_SIZE), randFloatInRange(0.0f, BOX_SIZE),
+                randFloatInRange(0.0f, BOX_SIZE));
+            if (j % 5 == 0) {
+                // segments along an axis
+                end.y = start.y;
+                end.z = start.z;
+            }
+            float expansion = randFloatInRange(0.0f, 0.5f);
+            for (int k = 0; k < NUM_CUBES; ++k) {
+                bool inBlock = batch.findIntersectingSegment(k / SHAPE_BATCH_BLOCK_SIZE, start, end, expansion) &
+                    (1 << (k % SHAPE_BATCH_BLOCK_SIZE));
+                if (cubes.at(k).expandedIntersectsSegment(start, end, expansion) && !inBlock) {
+                    std::cout << __FILE__ << ":" << __LINE__ << " ERROR: cube batch dropped cube " << k
+                        << " that the segment hits" << std::endl;
+                }
+            }
+            int unused = batch.getBlockCount() * SHAPE_BATCH_BLOCK_SIZE - NUM_CUBES;
+            if (unused > 0 && batch.findIntersectingSegment(batch.getBlockCount() - 1, start, end, expansion) >>
+                    (SHAPE_BATCH_BLOCK_SIZE - unused)) {
+                std::cout << __FILE__ << ":" << __LINE__ << " ERROR: cube batch hit a place past the last cube"
+                    << std::endl;
+            }
+        }
+    }
+}
+
 void ShapeColliderTests::measureTimeOfCollisionDispatch() {
     /* KEEP for future manual testing
     // create two non-colliding spheres
@@ -2539,4 +2717,8 @@ void ShapeColliderTests::runAllTests() {
 
     rayHitsAACube();
     rayMissesAACube();
+
+    batchFindsSameCollisions();
+    aaCubeBatchFindsSameCollisions();
+    aaCubeBatchFindsSegments();
 }
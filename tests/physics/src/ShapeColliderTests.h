@@ -41,6 +41,10 @@ namespace ShapeColliderTests {
     void rayHitsAACube();
     void rayMissesAACube();
 
+    void batchFindsSameCollisions();
+    void aaCubeBatchFindsSameCollisions();
+    void aaCubeBatchFindsSegments();
+
     void measureTimeOfCollisionDispatch();
 
     void runAllTests(); 
@@ -8,11 +8,13 @@
 //  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
 //
 
+#include "PhysicsSimulationTests.h"
 #include "ShapeColliderTests.h"
 #include "VerletShapeTests.h"
 
 int main(int argc, char** argv) {
     ShapeColliderTests::runAllTests();
     VerletShapeTests::runAllTests();
+    PhysicsSimulationTests::runAllTests();
     return 0;
 }
@@ -0,0 +1,106 @@
+//
+//  OctalCodeKeyTests.cpp
+//  tests/shared/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <iostream>
+
+#include <OctalCodeKey.h>
+#include <SharedUtil.h>
+
+#include "OctalCodeKeyTests.h"
+
+const int NUM_RANDOM_POINTS = 10000;
+
+static float randUnit() {
+    return (float)rand() / ((float)RAND_MAX + 1.0f);
+}
+
+void OctalCodeKeyTests::testByteFormRoundTrip() {
+    for (int i = 0; i < NUM_RANDOM_POINTS; i++) {
+        float x = randUnit();
+        float y = randUnit();
+        float z = randUnit();
+        float s = (i % 2 == 0) ? randUnit() : 1.0f / (1 << (i % (MAX_OCTAL_CODE_KEY_SECTIONS + 3)));
+
+        unsigned char* code = pointToOctalCode(x, y, z, s);
+        OctalCodeKey key = OctalCodeKey::fromPoint(x, y, z, s);
+        if (key != OctalCodeKey::fromOctalCode(code)) {
+            std::cout << __FILE__ << ":" << __LINE__
+                << " ERROR: fromPoint() should match pointToOctalCode() for " << x << "," << y << "," << z
+                << " scale " << s << std::endl;
+        }
+        if (key.isValid()) {
+            unsigned char written[MAX_OCTAL_CODE_KEY_BYTES];
+            int bytes = key.writeOctalCode(written);
+            if (bytes != (int)bytesRequiredForCodeLength(*code) || memcmp(written, code, bytes) != 0) {
+                std::cout << __FILE__ << ":" << __LINE__
+                    << " ERROR: writeOctalCode() should write the code it was made from" << std::endl;
+            }
+
+            int chopLevels = i % (key.getDepth() + 2);
+            unsigned char* chopped = chopOctalCode(code, chopLevels);
+            OctalCodeKey expected = chopped ? OctalCodeKey::fromOctalCode(chopped) : OctalCodeKey::root();
+            if (key.getChopped(chopLevels) != expected) {
+                std::cout << __FILE__ << ":" << __LINE__
+                    << " ERROR: getChopped() should match chopOctalCode() for " << chopLevels << " levels" << std::endl;
+            }
+            delete[] chopped;
+        } else if (numberOfThreeBitSectionsInCode(code) <= MAX_OCTAL_CODE_KEY_SECTIONS) {
+            std::cout << __FILE__ << ":" << __LINE__
+                << " ERROR: only codes deeper than a key can hold should have invalid keys" << std::endl;
+        }
+        delete[] code;
+    }
+}
+
+void OctalCodeKeyTests::testFamily() {
+    OctalCodeKey root = OctalCodeKey::root();
+    if (root.getDepth() != 0 || root.getParent() != root) {
+        std::cout << __FILE__ << ":" << __LINE__ << " ERROR: the root should be at depth 0 and its own parent" << std::endl;
+    }
+
+    OctalCodeKey key = root;
+    for (int depth = 1; depth <= MAX_OCTAL_CODE_KEY_SECTIONS; depth++) {
+        int childIndex = depth % 8;
+        OctalCodeKey child = key.getChild(childIndex);
+        if (child.getDepth() != depth || child.getParent() != key) {
+            std::cout << __FILE__ << ":" << __LINE__
+                << " ERROR: a child should be one level down from its parent at depth " << depth << std::endl;
+        }
+        if (!key.isAncestorOf(child) || child.isAncestorOf(key) || !root.isAncestorOf(child)) {
+            std::cout << __FILE__ << ":" << __LINE__
+                << " ERROR: a parent should be an ancestor of its child at depth " << depth << std::endl;
+        }
+        if (root.getBranchTowards(child) != 1 || key.getBranchTowards(child) != childIndex) {
+            std::cout << __FILE__ << ":" << __LINE__
+                << " ERROR: getBranchTowards() should pick the child on the way at depth " << depth << std::endl;
+        }
+        if (child.getAncestor(1) != root.getChild(1)) {
+            std::cout << __FILE__ << ":" << __LINE__
+                << " ERROR: getAncestor() should find the first level ancestor at depth " << depth << std::endl;
+        }
+        key = child;
+    }
+    if (key.getChild(0).isValid()) {
+        std::cout << __FILE__ << ":" << __LINE__
+            << " ERROR: a key shouldn't go deeper than " << MAX_OCTAL_CODE_KEY_SECTIONS << " levels" << std::endl;
+    }
+
+    OctalCodeKey sibling = root.getChild(1).getChild(2);
+    OctalCodeKey cousin = root.getChild(2).getChild(1);
+    if (sibling.isAncestorOf(cousin) || root.getChild(1).isAncestorOf(cousin)) {
+        std::cout << __FILE__ << ":" << __LINE__
+            << " ERROR: keys on different branches shouldn't be ancestors of each other" << std::endl;
+    }
+}
+
+void OctalCodeKeyTests::runAllTests() {
+    testByteFormRoundTrip();
+    testFamily();
+}
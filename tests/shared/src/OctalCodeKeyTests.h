@@ -0,0 +1,20 @@
+//
+//  OctalCodeKeyTests.h
+//  tests/shared/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_OctalCodeKeyTests_h
+#define hifi_OctalCodeKeyTests_h
+
+namespace OctalCodeKeyTests {
+    void testByteFormRoundTrip();
+    void testFamily();
+    void runAllTests();
+}
+
+#endif // hifi_OctalCodeKeyTests_h
@@ -11,11 +11,13 @@
 #include "AngularConstraintTests.h"
 #include "MovingPercentileTests.h"
 #include "MovingMinMaxAvgTests.h"
+#include "OctalCodeKeyTests.h"
 
 int main(int argc, char** argv) {
     MovingMinMaxAvgTests::runAllTests();
     MovingPercentileTests::runAllTests();
     AngularConstraintTests::runAllTests();
+    OctalCodeKeyTests::runAllTests();
     printf("tests complete, press enter to exit\n");
     getchar();
     return 0;
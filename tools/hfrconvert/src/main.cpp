@@ -0,0 +1,48 @@
+//
+//  main.cpp
+//  tools/hfrconvert/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+
+#include <iostream>
+
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QSharedPointer>
+
+#include <Recording.h>
+
+using namespace std;
+
+int main (int argc, char** argv) {
+    // need the core application for recordings that have to be downloaded
+    QCoreApplication app(argc, argv);
+    
+    if (argc < 3) {
+        cerr << "Usage: hfrconvert inputfile outputfile" << endl;
+        cerr << "Converts a .rec or .hfr recording to the current, chunked .hfr format" << endl;
+        return 0;
+    }
+    QString inputFilename = argv[1];
+    QString outputFilename = argv[2];
+    
+    // chunked recordings are read from the input file while the output is written
+    if (QFileInfo(inputFilename).absoluteFilePath() == QFileInfo(outputFilename).absoluteFilePath()) {
+        cerr << "The output file has to be different from the input file" << endl;
+        return 1;
+    }
+    
+    RecordingPointer recording = readRecordingFromFile(RecordingPointer(new Recording()), inputFilename);
+    if (!recording || recording->isEmpty()) {
+        cerr << "Failed to read recording: " << argv[1] << endl;
+        return 1;
+    }
+    
+    writeRecordingToFile(recording, outputFilename);
+    cout << "Converted " << recording->getFrameNumber() << " frames to " << argv[2] << endl;
+    
+    return 0;
+}